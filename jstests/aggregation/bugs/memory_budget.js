@@ -0,0 +1,39 @@
+// Aggregation stages report their memory use and charge it to a server-wide pool.
+
+var t = db.agg_memory_budget;
+t.drop();
+for (var i = 0; i < 100; i++) {
+    t.insert({_id: i, a: i % 10, s: "some padding for the sort"});
+}
+
+function memoryMetrics() {
+    return db.serverStatus().metrics.aggregation.memory;
+}
+
+// explain reports the per-stage limits and peaks
+var res = t.runCommand("aggregate", {explain: true,
+                                     pipeline: [{$sort: {s: 1}},
+                                                {$group: {_id: "$a", n: {$sum: 1}}}]});
+assert.commandWorked(res);
+printjson(res);
+// each stage reports "memory" next to its spec
+assert.eq(100*1024*1024, res.stages[0].memory.limitBytes);
+var sortStage = res.stages[1];
+assert.eq(100*1024*1024, sortStage.memory.limitBytes);
+var groupStage = res.stages[2];
+assert.eq(100*1024*1024, groupStage.memory.limitBytes);
+assert.eq(0, groupStage.memory.spills);
+
+// running pipelines leave nothing reserved behind
+assert.eq(10, t.aggregate([{$sort: {s: 1}}, {$group: {_id: "$a", n: {$sum: 1}}}]).itcount());
+assert.eq(0, memoryMetrics().reservedBytes);
+
+// a tiny pool still lets small stages run, since they are below the minimum a stage may hold
+assert.commandWorked(db.adminCommand({setParameter: 1, internalAggregationMemoryPoolBytes: 1}));
+try {
+    assert.eq(10, t.aggregate([{$group: {_id: "$a", n: {$sum: 1}}}]).itcount());
+}
+finally {
+    assert.commandWorked(db.adminCommand({setParameter: 1,
+                                          internalAggregationMemoryPoolBytes: 0}));
+}
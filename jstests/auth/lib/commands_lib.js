@@ -1341,6 +1341,22 @@ var authCommandsLib = {
                 }
             ]
         },
+        {
+            testname: "hotChunks",
+            command: {hotChunks: 1},
+            skipStandalone: true,
+            testcases: [
+                {
+                    runOnDb: adminDbName,
+                    roles: roles_monitoring,
+                    privileges: [
+                        { resource: {cluster: true}, actions: ["serverStatus"] }
+                    ]
+                },
+                { runOnDb: firstDbName, roles: {} },
+                { runOnDb: secondDbName, roles: {} }
+            ]
+        },
 /*      temporarily removed see SERVER-13555 
         {
             testname: "indexStats",
@@ -0,0 +1,23 @@
+// Compiled function cache counters are reported under metrics.scripting.functionCache
+
+t = db.function_cache;
+t.drop();
+t.save( { a : 1 } );
+
+function cacheStats() {
+    return db.serverStatus().metrics.scripting.functionCache;
+}
+
+// use a $where body that has not been seen before so the first run is a miss
+var marker = new Date().getTime() + Math.random();
+var where = "this.a == 1 || " + marker + " == 0";
+
+var before = cacheStats();
+assert.eq( 1, t.find( { $where : where } ).itcount() );
+var afterMiss = cacheStats();
+assert.lt( before.misses, afterMiss.misses, "expected a cache miss" );
+
+assert.eq( 1, t.find( { $where : where } ).itcount() );
+var afterHit = cacheStats();
+assert.lt( afterMiss.hits, afterHit.hits, "expected a cache hit" );
+assert.gte( afterHit.compileMicros, before.compileMicros );
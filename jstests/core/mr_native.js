@@ -0,0 +1,46 @@
+// Simple map/reduce functions run natively and give the same results as the js engine
+
+t = db.mr_native;
+t.drop();
+
+for ( var i = 0; i < 100; i++ ) {
+    t.insert( { a : i % 7 , b : { c : "x" + ( i % 3 ) } , n : i , d : NumberInt( i ) } );
+}
+t.insert( { n : 5 , b : {} } );
+t.insert( { a : null , b : 5 , n : NumberLong( 3 ) } );
+
+function runBoth( map , reduce , expectNative ) {
+    var cmd = { mapreduce : "mr_native" , map : map , reduce : reduce , out : { inline : 1 } ,
+                verbose : true };
+    var nat = t.runCommand( cmd );
+    assert.commandWorked( nat );
+    assert.eq( expectNative ? "native" : "mixed" , nat.timing.mode , tojson( nat ) );
+
+    cmd.nativeMode = false;
+    var js = t.runCommand( cmd );
+    assert.commandWorked( js );
+    assert.eq( "mixed" , js.timing.mode );
+
+    assert.eq( js.counts , nat.counts );
+    assert.eq( js.results , nat.results );
+}
+
+runBoth( function() { emit( this.a , 1 ); } ,
+         function( k , vals ) { return Array.sum( vals ); } , true );
+runBoth( function() { emit( this.b.c , this.n ); } ,
+         function( k , vals ) { return Array.sum( vals ); } , true );
+runBoth( function() { emit( this.a , this.d ); } ,
+         function( k , vals ) { return Array.sum( vals ); } , true );
+runBoth( function() { emit( this.a , this.n ); } ,
+         function( k , vals ) { var s = 0; vals.forEach( function( v ) { s += v; } ); return s; } ,
+         false );
+
+// output to a collection with a finalizer
+res = t.mapReduce( function() { emit( this.a , 1 ); } ,
+                   function( k , vals ) { return Array.sum( vals ); } ,
+                   { out : "mr_native_out" , finalize : function( k , v ) { return v * 2; } } );
+assert.commandWorked( res );
+var total = 0;
+db.mr_native_out.find().forEach( function( z ) { total += z.value; } );
+assert.eq( 204 , total );
+db.mr_native_out.drop();
@@ -0,0 +1,60 @@
+// mapThreads splits the map phase over several threads without changing the results
+
+t = db.mr_parallel;
+t.drop();
+
+var bulk = t.initializeUnorderedBulkOp();
+for ( var i = 0; i < 20000; i++ ) {
+    bulk.insert( { a : i % 101 , s : "x" + ( i % 13 ) , pad : new Array( 100 ).join( "p" ) } );
+}
+assert.writeOK( bulk.execute() );
+
+function map() {
+    emit( this.a , { count : 1 , s : this.s } );
+}
+
+function reduce( k , vals ) {
+    var r = { count : 0 , s : "" };
+    vals.forEach( function( v ) {
+        r.count += v.count;
+        if ( v.s > r.s )
+            r.s = v.s;
+    } );
+    return r;
+}
+
+function sorted( res ) {
+    return res.results.sort( function( x , y ) { return x._id - y._id; } );
+}
+
+var serial = t.runCommand( { mapreduce : "mr_parallel" , map : map , reduce : reduce ,
+                             out : { inline : 1 } } );
+assert.commandWorked( serial );
+
+var parallel = t.runCommand( { mapreduce : "mr_parallel" , map : map , reduce : reduce ,
+                               out : { inline : 1 } , mapThreads : 4 , verbose : true } );
+assert.commandWorked( parallel );
+assert.eq( 4 , parallel.timing.mapThreads , tojson( parallel.timing ) );
+assert.lte( 1 , parallel.timing.mapWorkers.length , tojson( parallel.timing ) );
+
+assert.eq( serial.counts.input , parallel.counts.input );
+assert.eq( serial.counts.emit , parallel.counts.emit );
+assert.eq( sorted( serial ) , sorted( parallel ) );
+
+// output to a collection
+var res = t.mapReduce( map , reduce , { out : "mr_parallel_out" , mapThreads : 3 } );
+assert.commandWorked( res );
+assert.eq( 101 , db.mr_parallel_out.count() );
+var total = 0;
+db.mr_parallel_out.find().forEach( function( z ) { total += z.value.count; } );
+assert.eq( 20000 , total );
+
+// map functions can't reach the database from worker threads
+assert.commandFailed( t.runCommand( { mapreduce : "mr_parallel" ,
+                                      map : function() { db.foo.findOne(); emit( 1 , 1 ); } ,
+                                      reduce : reduce , out : { inline : 1 } ,
+                                      mapThreads : 2 } ) );
+
+assert.commandFailed( t.runCommand( { mapreduce : "mr_parallel" , map : map , reduce : reduce ,
+                                      out : { inline : 1 } , mapThreads : 0 } ) );
+db.mr_parallel_out.drop();
@@ -0,0 +1,38 @@
+// Check that mongos reports chunk manager reload cost in serverStatus and that reloads after a
+// split only fetch the changed chunks.
+
+var st = new ShardingTest({ shards : 1, mongos : 1 });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var ns = "test.foo";
+
+assert.commandWorked( admin.runCommand({ enableSharding : "test" }) );
+assert.commandWorked( admin.runCommand({ shardCollection : ns, key : { _id : 1 } }) );
+
+for ( var i = 0; i < 20; i++ ) {
+    assert.commandWorked( admin.runCommand({ split : ns, middle : { _id : i * 10 } }) );
+}
+
+var getStats = function() {
+    return mongos.getDB( "admin" ).serverStatus().metrics.chunkManager;
+};
+
+var before = getStats();
+printjson( before );
+assert( before.loads.num > 0, "no chunk manager loads recorded" );
+assert( before.chunksFetched > 0, "no chunks fetched" );
+
+// One more split reloads from the previous manager, which hands its chunks over as they are;
+// only the two halves should be fetched
+assert.commandWorked( admin.runCommand({ split : ns, middle : { _id : 1000 } }) );
+mongos.getCollection( ns ).findOne({ _id : 1001 });
+
+var after = getStats();
+printjson( after );
+assert.gt( after.loads.num, before.loads.num );
+assert.gte( after.chunksReused - before.chunksReused, 21 );
+assert.lt( after.chunksFetched - before.chunksFetched, 21 );
+
+st.stop();
@@ -0,0 +1,40 @@
+//
+// Tests that mongos splits a chunk that receives a high rate of operations, even though it holds
+// little data, and that the hotChunks command reports it
+//
+
+var st = new ShardingTest({ shards : 1, mongos : 1 })
+
+var mongos = st.s0
+var admin = mongos.getDB( "admin" )
+var config = mongos.getDB( "config" )
+var coll = mongos.getCollection( "foo.bar" )
+
+assert.commandWorked( admin.runCommand({ enableSharding : coll.getDB() + "" }) )
+assert.commandWorked( admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }) )
+
+// Any chunk doing more than one operation per second is hot
+assert.commandWorked( admin.runCommand({ setParameter : 1, chunkLoadSplitOpsPerSec : 1 }) )
+
+for( var i = 0; i < 1000; i++ ){
+    coll.insert({ _id : i })
+}
+assert.gleSuccess( coll.getDB() )
+
+var hot = admin.runCommand({ hotChunks : 1, ns : coll + "" })
+printjson( hot )
+assert.commandWorked( hot )
+
+// Exact shard key reads also count toward the chunk's load
+assert.soon( function(){
+    for( var i = 0; i < 100; i++ ){
+        coll.findOne({ _id : Random.randInt( 1000 ) })
+    }
+    return config.chunks.find({ ns : coll + "" }).count() > 1
+}, "hot chunk was never split" )
+
+st.printShardingStatus()
+
+jsTestLog( "Done!" )
+
+st.stop()
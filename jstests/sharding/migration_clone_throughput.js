@@ -0,0 +1,66 @@
+// Check that moveChunk changelog entries record clone throughput on both sides, and that
+// indexes deferred on an empty recipient are built once the clone finishes, while the shard
+// key index is there before the recipient cleans up the incoming range.
+
+var st = new ShardingTest({ shards : 2, mongos : 1 });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var coll = mongos.getCollection( "test.foo" );
+var config = mongos.getDB( "config" );
+
+assert.commandWorked( admin.runCommand({ enableSharding : "test" }) );
+assert.commandWorked( admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }) );
+coll.ensureIndex({ x : 1 });
+
+var bulk = coll.initializeUnorderedBulkOp();
+for ( var i = 0; i < 5000; i++ ) {
+    bulk.insert({ _id : i, x : i % 100, pad : new Array( 100 ).join( "x" ) });
+}
+assert.writeOK( bulk.execute() );
+
+assert.commandWorked( admin.runCommand({ moveChunk : coll + "",
+                                         find : { _id : 0 },
+                                         to : st.getOther( st.getServer( "test" ) ).name,
+                                         _waitForDelete : true }) );
+
+var from = config.changelog.find({ what : "moveChunk.from" }).sort({ time : -1 }).next();
+var to = config.changelog.find({ what : "moveChunk.to" }).sort({ time : -1 }).next();
+printjson( from );
+printjson( to );
+
+assert.eq( 5000, from.details.clone.docs );
+assert.eq( 5000, to.details.clone.docs );
+assert.gt( to.details.clone.bytes, 0 );
+assert( to.details.clone.hasOwnProperty( "docsPerSec" ) );
+assert( to.details.clone.hasOwnProperty( "bytesPerSec" ) );
+
+// The { x : 1 } index was built after the data arrived on the recipient
+var recipientColl = st.getOther( st.getServer( "test" ) ).getCollection( coll + "" );
+assert.eq( 2, recipientColl.getIndexes().length );
+assert.eq( 50, recipientColl.find({ x : 7 }).hint({ x : 1 }).itcount() );
+
+// First migration of a collection sharded on something other than _id to a fresh shard
+var other = mongos.getCollection( "test.bar" );
+assert.commandWorked( admin.runCommand({ shardCollection : other + "", key : { sk : 1 } }) );
+other.ensureIndex({ y : 1 });
+other.ensureIndex({ u : 1 }, { unique : true });
+
+bulk = other.initializeUnorderedBulkOp();
+for ( var i = 0; i < 1000; i++ ) {
+    bulk.insert({ _id : i, sk : i, y : i % 10, u : i });
+}
+assert.writeOK( bulk.execute() );
+
+assert.commandWorked( admin.runCommand({ moveChunk : other + "",
+                                         find : { sk : 0 },
+                                         to : st.getOther( st.getServer( "test" ) ).name,
+                                         _waitForDelete : true }) );
+
+var recipientOther = st.getOther( st.getServer( "test" ) ).getCollection( other + "" );
+assert.eq( 1000, recipientOther.count() );
+assert.eq( 4, recipientOther.getIndexes().length );
+assert.eq( 100, recipientOther.find({ y : 3 }).hint({ y : 1 }).itcount() );
+
+st.stop();
@@ -0,0 +1,62 @@
+//
+// Tests that mongos reads shard cursors over shared, multiplexed connections when
+// connPoolMultiplexedConnsPerHost is set, and reports them in connPoolStats
+//
+
+var options = { mongosOptions : { setParameter : "connPoolMultiplexedConnsPerHost=2" } };
+
+var st = new ShardingTest({ shards : 2, mongos : 1, other : options });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB("admin");
+var coll = mongos.getCollection("foo.bar");
+var shards = mongos.getDB("config").shards.find().toArray();
+
+assert.commandWorked(admin.runCommand({ enableSharding : coll.getDB().getName() }));
+printjson(admin.runCommand({ movePrimary : coll.getDB().getName(), to : shards[0]._id }));
+assert.commandWorked(admin.runCommand({ shardCollection : coll.getFullName(), key : { _id : 1 } }));
+assert.commandWorked(admin.runCommand({ split : coll.getFullName(), middle : { _id : 0 } }));
+assert.commandWorked(admin.runCommand({ moveChunk : coll.getFullName(),
+                                        find : { _id : 0 },
+                                        to : shards[1]._id }));
+
+var numDocs = 1000;
+for (var i = -numDocs / 2; i < numDocs / 2; i++) {
+    coll.insert({ _id : i });
+}
+assert.eq(null, coll.getDB().getLastError());
+
+// Interleave several sorted cursors with small batches, so each needs many getMores
+var cursors = [];
+var expected = [];
+for (var i = 0; i < 5; i++) {
+    cursors.push(coll.find().sort({ _id : 1 }).batchSize(10));
+    expected.push(-numDocs / 2);
+}
+
+var open = cursors.length;
+while (open > 0) {
+    open = 0;
+    for (var i = 0; i < cursors.length; i++) {
+        if (!cursors[i].hasNext()) continue;
+        open++;
+        assert.eq(expected[i]++, cursors[i].next()._id);
+    }
+}
+
+for (var i = 0; i < cursors.length; i++) {
+    assert.eq(numDocs / 2, expected[i]);
+}
+
+var stats = admin.runCommand({ connPoolStats : 1 });
+assert.commandWorked(stats);
+printjson(stats.multiplexed);
+
+assert.gt(stats.multiplexed.totalConnections, 0);
+assert.eq(0, stats.multiplexed.totalInFlight);
+for (var host in stats.multiplexed.hosts) {
+    assert.lte(stats.multiplexed.hosts[host].connections, 2);
+}
+
+st.stop();
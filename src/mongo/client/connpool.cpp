@@ -35,6 +35,7 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/client/connpool.h"
+#include "mongo/client/multiplexed_connection.h"
 #include "mongo/client/replica_set_monitor.h"
 #include "mongo/client/syncclusterconnection.h"
 #include "mongo/util/log.h"
@@ -528,6 +529,7 @@ namespace mongo {
 
     void ScopedDbConnection::clearPool() {
         pool.clear();
+        multiplexedPool.clear();
     }
 
     AtomicInt32 AScopedConnection::_numConnections;
@@ -34,6 +34,7 @@
 #include "mongo/client/dbclientcursor.h"
 
 #include "mongo/client/connpool.h"
+#include "mongo/client/multiplexed_connection.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/s/shard.h"
@@ -150,18 +151,45 @@ namespace mongo {
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        if ( _prefetchConn ) {
+            // prefetchMore() already sent the getMore, only the reply is left to read
+            scoped_ptr<ScopedDbConnection> conn( _prefetchConn );
+            _prefetchConn = NULL;
+
+            auto_ptr<Message> response(new Message());
+            if ( !conn->get()->recv( *response ) ) {
+                uasserted( 18914, str::stream() << "recv failed while reading ahead cursor from "
+                                                << _scopedHost );
+            }
+            // conn is destroyed on the way out, so _client must not point at it afterwards
+            _client = conn->get();
+            this->batch.m = response;
+            try {
+                dataReceived();
+            }
+            catch ( ... ) {
+                _client = 0;
+                throw;
+            }
+            _client = 0;
+            conn->done();
+            return;
+        }
+
+        if ( _prefetchShared ) {
+            MultiplexedConnectionPtr shared = _prefetchShared;
+            _prefetchShared.reset();
+            _receiveShared( shared.get(), _prefetchId );
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
         }
-        BufBuilder b;
-        b.appendNum(opts);
-        b.appendStr(ns);
-        b.appendNum(nextBatchSize());
-        b.appendNum(cursorId);
 
         Message toSend;
-        toSend.setData(dbGetMore, b.buf(), b.len());
+        _assembleGetMore( toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
@@ -171,6 +199,18 @@ namespace mongo {
         }
         else {
             verify( _scopedHost.size() );
+
+            // A tailable getMore may wait on the server for data, and the server answers a
+            // connection's requests one at a time, so it would hold up every other cursor on a
+            // shared connection
+            MultiplexedConnectionPtr shared;
+            if ( ! ( opts & ( QueryOption_CursorTailable | QueryOption_Exhaust ) ) )
+                shared = multiplexedPool.get( _scopedHost );
+            if ( shared ) {
+                _receiveShared( shared.get(), shared->send( toSend ) );
+                return;
+            }
+
             ScopedDbConnection conn(_scopedHost);
             conn->call( toSend , *response );
             _client = conn.get();
@@ -181,6 +221,71 @@ namespace mongo {
         }
     }
 
+    void DBClientCursor::_receiveShared( MultiplexedConnection* conn, MSGID id ) {
+        auto_ptr<Message> response(new Message());
+        if ( !conn->recv( id, *response ) ) {
+            uasserted( 18916, str::stream() << "multiplexed connection to " << _scopedHost
+                                            << " failed while reading cursor" );
+        }
+
+        // _client must not outlive this call, the connection is shared with other threads
+        _client = conn->conn();
+        this->batch.m = response;
+        try {
+            dataReceived();
+        }
+        catch ( ... ) {
+            _client = 0;
+            throw;
+        }
+        _client = 0;
+    }
+
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(nextBatchSize());
+        b.appendNum(cursorId);
+        toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
+    bool DBClientCursor::prefetchMore() {
+        if ( isPrefetching() )
+            return true;
+
+        // Never read ahead on a connection we don't own, the caller may send other requests on
+        // it before our reply has been read.  Limited cursors size each getMore from the batch
+        // before it, so they can't ask early either.
+        if ( _client || _scopedHost.empty() || cursorId == 0 || haveLimit ||
+             ( opts & ( QueryOption_CursorTailable | QueryOption_Exhaust ) ) ) {
+            return false;
+        }
+
+        try {
+            Message toSend;
+            _assembleGetMore( toSend );
+
+            if ( MultiplexedConnectionPtr shared = multiplexedPool.get( _scopedHost ) ) {
+                _prefetchId = shared->send( toSend );
+                _prefetchShared = shared;
+                return true;
+            }
+
+            auto_ptr<ScopedDbConnection> conn( new ScopedDbConnection( _scopedHost ) );
+            conn->get()->say( toSend );
+            _prefetchConn = conn.release();
+        }
+        catch ( DBException& e ) {
+            // requestMore() will retry the normal way and report any real problem
+            LOG(1) << "could not read ahead cursor " << cursorId << " from " << _scopedHost
+                   << causedBy( e ) << endl;
+            return false;
+        }
+
+        return true;
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -352,6 +457,18 @@ namespace mongo {
     DBClientCursor::~DBClientCursor() {
         DESTRUCTOR_GUARD (
 
+        if ( _prefetchConn ) {
+            // the reply to the read-ahead was never read, so the connection can't be reused
+            _prefetchConn->kill();
+            delete _prefetchConn;
+            _prefetchConn = NULL;
+        }
+
+        if ( _prefetchShared ) {
+            _prefetchShared->forget( _prefetchId );
+            _prefetchShared.reset();
+        }
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
@@ -370,6 +487,9 @@ namespace mongo {
                     _client->say( m );
 
             }
+            else if ( MultiplexedConnectionPtr shared = multiplexedPool.get( _scopedHost ) ) {
+                shared->say( m );
+            }
             else {
                 verify( _scopedHost.size() );
                 ScopedDbConnection conn(_scopedHost);
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
 #include <stack>
 
 #include "mongo/client/dbclientinterface.h"
@@ -40,6 +41,8 @@
 namespace mongo {
 
     class AScopedConnection;
+    class MultiplexedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here
         @see DBClientMockCursor
@@ -68,6 +71,23 @@ namespace mongo {
         int objsLeftInBatch() const { _assertIfNull(); return _putBack.size() + batch.nReturned - batch.pos; }
         bool moreInCurrentBatch() { return objsLeftInBatch() > 0; }
 
+        /** number of objects the server returned in the batch currently buffered */
+        int objsInBatch() const { _assertIfNull(); return batch.nReturned; }
+
+        /**
+         * Sends the getMore for the next batch without waiting for the reply, so the more() that
+         * drains the current batch only has to receive it.  Only cursors attach()ed to a pooled
+         * connection can read ahead: the request goes out on a second connection from the pool,
+         * which is held until the reply is read.  Does nothing for tailable, exhaust or limited
+         * cursors.
+         *
+         * @return true if a getMore is outstanding for this cursor
+         */
+        bool prefetchMore();
+
+        /** true if a getMore sent by prefetchMore() has not been received yet */
+        bool isPrefetching() const { return _prefetchConn != NULL || _prefetchShared; }
+
         /** next
            @return next object in the result cursor.
            on an error at the remote server, you will get back:
@@ -149,7 +169,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _prefetchConn( NULL ),
+            _prefetchId( 0 ) {
             _finishConsInit();
         }
 
@@ -165,7 +187,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _prefetchConn(NULL),
+            _prefetchId(0) {
             _finishConsInit();
         }
 
@@ -239,6 +263,10 @@ namespace mongo {
         std::string _scopedHost;
         std::string _lazyHost;
         bool wasError;
+        // the connection a read-ahead getMore was sent on, see prefetchMore()
+        ScopedDbConnection* _prefetchConn; // owned
+        boost::shared_ptr<MultiplexedConnection> _prefetchShared;
+        MSGID _prefetchId;
 
         void dataReceived() { bool retry; std::string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, std::string& lazyHost );
@@ -254,6 +282,8 @@ namespace mongo {
 
         // init pieces
         void _assembleInit( Message& toSend );
+        void _assembleGetMore( Message& toSend );
+        void _receiveShared( MultiplexedConnection* conn, MSGID id );
     };
 
     /** iterate over objects in current batch only - will not cause a network call
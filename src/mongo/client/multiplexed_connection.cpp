@@ -0,0 +1,330 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetworking
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/client/multiplexed_connection.h"
+
+#include "mongo/client/connpool.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/ssl_options.h"
+
+namespace mongo {
+
+    MultiplexedConnectionPool multiplexedPool( &pool );
+
+    MultiplexedConnection::MultiplexedConnection( DBClientConnection* conn )
+        : _conn( conn ),
+          _sendMutex( "MultiplexedConnection::_sendMutex" ),
+          _mutex( "MultiplexedConnection::_mutex" ),
+          _reading( false ),
+          _failed( false ) {
+    }
+
+    MultiplexedConnection::~MultiplexedConnection() {
+    }
+
+    MSGID MultiplexedConnection::send( Message& toSend ) {
+        scoped_lock sendLk( _sendMutex );
+
+        {
+            scoped_lock lk( _mutex );
+            uassert( 18915, str::stream() << "multiplexed connection to "
+                                          << _conn->getServerAddress() << " has failed",
+                     ! _failed );
+        }
+
+        try {
+            _conn->port().say( toSend );
+        }
+        catch ( DBException& ) {
+            scoped_lock lk( _mutex );
+            _setFailed();
+            throw;
+        }
+
+        const MSGID id = toSend.header().getId();
+
+        // The reply may already have been read by another caller, don't clobber it
+        scoped_lock lk( _mutex );
+        _replies.insert( make_pair( id, boost::shared_ptr<Message>() ) );
+        return id;
+    }
+
+    void MultiplexedConnection::say( Message& toSend ) {
+        scoped_lock sendLk( _sendMutex );
+
+        try {
+            _conn->port().say( toSend );
+        }
+        catch ( DBException& ) {
+            scoped_lock lk( _mutex );
+            _setFailed();
+            throw;
+        }
+    }
+
+    bool MultiplexedConnection::recv( MSGID id, Message& response ) {
+        while ( true ) {
+            {
+                scoped_lock lk( _mutex );
+
+                while ( true ) {
+                    ReplyMap::iterator it = _replies.find( id );
+                    verify( it != _replies.end() );
+
+                    if ( it->second ) {
+                        response.reset();
+                        response = *it->second;
+                        _replies.erase( it );
+                        return true;
+                    }
+
+                    if ( _failed ) {
+                        _replies.erase( it );
+                        return false;
+                    }
+
+                    if ( ! _reading )
+                        break;
+
+                    _replyArrived.wait( lk.boost() );
+                }
+
+                _reading = true;
+            }
+
+            _readOne();
+        }
+    }
+
+    void MultiplexedConnection::forget( MSGID id ) {
+        scoped_lock lk( _mutex );
+
+        ReplyMap::iterator it = _replies.find( id );
+        if ( it == _replies.end() )
+            return;
+
+        if ( it->second || _failed ) {
+            _replies.erase( it );
+            return;
+        }
+
+        _forgotten.insert( id );
+    }
+
+    bool MultiplexedConnection::call( Message& toSend, Message& response ) {
+        return recv( send( toSend ), response );
+    }
+
+    void MultiplexedConnection::_readOne() {
+        Message reply;
+        bool ok = false;
+
+        try {
+            ok = _conn->port().recv( reply );
+        }
+        catch ( DBException& e ) {
+            LOG(1) << "multiplexed connection to " << _conn->getServerAddress()
+                   << " failed" << causedBy( e ) << endl;
+        }
+
+        scoped_lock lk( _mutex );
+        _reading = false;
+
+        if ( ! ok ) {
+            _setFailed();
+            return;
+        }
+
+        const MSGID id = reply.header().getResponseTo();
+
+        if ( _forgotten.erase( id ) ) {
+            _replies.erase( id );
+        }
+        else {
+            boost::shared_ptr<Message> stored( new Message() );
+            *stored = reply;
+            _replies[id] = stored;
+        }
+
+        _replyArrived.notify_all();
+    }
+
+    void MultiplexedConnection::_setFailed() {
+        _failed = true;
+
+        // Nobody will ever read these
+        for ( std::set<MSGID>::iterator it = _forgotten.begin(); it != _forgotten.end(); ++it )
+            _replies.erase( *it );
+        _forgotten.clear();
+
+        _replyArrived.notify_all();
+    }
+
+    int MultiplexedConnection::numInFlight() const {
+        scoped_lock lk( _mutex );
+        return _replies.size();
+    }
+
+    bool MultiplexedConnection::isFailed() const {
+        scoped_lock lk( _mutex );
+        return _failed;
+    }
+
+    // ------ MultiplexedConnectionPool ------
+
+    MultiplexedConnectionPool::MultiplexedConnectionPool( DBConnectionPool* hookSource )
+        : _hookSource( hookSource ),
+          _mutex( "MultiplexedConnectionPool::_mutex" ),
+          _connsPerHost( 0 ) {
+    }
+
+    void MultiplexedConnectionPool::setConnectionsPerHost( int connsPerHost ) {
+        scoped_lock lk( _mutex );
+        _connsPerHost = connsPerHost;
+    }
+
+    bool MultiplexedConnectionPool::isEnabled() const {
+        scoped_lock lk( _mutex );
+        return _connsPerHost > 0;
+    }
+
+    MultiplexedConnectionPtr MultiplexedConnectionPool::get( const std::string& host ) {
+        MultiplexedConnectionPtr best;
+        {
+            scoped_lock lk( _mutex );
+
+            if ( _connsPerHost <= 0 )
+                return MultiplexedConnectionPtr();
+
+#ifdef MONGO_SSL
+            // SSL reads and writes on one connection can't run concurrently
+            if ( sslGlobalParams.sslMode.load() != SSLGlobalParams::SSLMode_disabled )
+                return MultiplexedConnectionPtr();
+#endif
+
+            HostConnections& hc = _hosts[host];
+
+            // Drop connections which failed, their remaining users still hold a reference
+            for ( size_t i = 0; i < hc.conns.size(); ) {
+                if ( hc.conns[i]->isFailed() ) {
+                    hc.conns.erase( hc.conns.begin() + i );
+                    continue;
+                }
+
+                if ( ! best || hc.conns[i]->numInFlight() < best->numInFlight() )
+                    best = hc.conns[i];
+                i++;
+            }
+
+            if ( static_cast<int>( hc.conns.size() ) >= _connsPerHost ||
+                 ( best && best->numInFlight() == 0 ) ) {
+                return best;
+            }
+        }
+
+        // Connect without the lock, so that a slow host doesn't hold up lookups for the others.
+        // Only single servers can be multiplexed, a replica set connection may switch members.
+        string errmsg;
+        ConnectionString cs = ConnectionString::parse( host, errmsg );
+        if ( ! cs.isValid() || cs.type() != ConnectionString::MASTER )
+            return best;
+
+        DBClientBase* c = NULL;
+        try {
+            c = cs.connect( errmsg );
+            if ( c && c->type() == ConnectionString::MASTER ) {
+                _hookSource->onCreate( c );
+            }
+        }
+        catch ( DBException& e ) {
+            warning() << "could not open multiplexed connection to " << host << causedBy( e )
+                      << endl;
+            delete c;
+            return best;
+        }
+
+        if ( ! c || c->type() != ConnectionString::MASTER ) {
+            delete c;
+            return best;
+        }
+
+        MultiplexedConnectionPtr conn(
+                new MultiplexedConnection( static_cast<DBClientConnection*>( c ) ) );
+
+        scoped_lock lk( _mutex );
+        HostConnections& hc = _hosts[host];
+
+        // Other threads may have filled the host's slots in the meantime, in which case this
+        // connection only serves the caller and closes once it is done
+        if ( static_cast<int>( hc.conns.size() ) < _connsPerHost ) {
+            hc.conns.push_back( conn );
+            hc.created++;
+        }
+        return conn;
+    }
+
+    void MultiplexedConnectionPool::clear() {
+        scoped_lock lk( _mutex );
+        _hosts.clear();
+    }
+
+    void MultiplexedConnectionPool::appendInfo( BSONObjBuilder& b ) {
+        long long totalConns = 0;
+        long long totalInFlight = 0;
+
+        BSONObjBuilder hostsBuilder( b.subobjStart( "hosts" ) );
+        {
+            scoped_lock lk( _mutex );
+            for ( HostMap::iterator i = _hosts.begin(); i != _hosts.end(); ++i ) {
+                const HostConnections& hc = i->second;
+
+                int inFlight = 0;
+                for ( size_t j = 0; j < hc.conns.size(); j++ )
+                    inFlight += hc.conns[j]->numInFlight();
+
+                BSONObjBuilder temp( hostsBuilder.subobjStart( i->first ) );
+                temp.append( "connections" , static_cast<int>( hc.conns.size() ) );
+                temp.append( "inFlight" , inFlight );
+                temp.appendNumber( "created" , hc.created );
+                temp.done();
+
+                totalConns += hc.conns.size();
+                totalInFlight += inFlight;
+            }
+        }
+        hostsBuilder.done();
+
+        b.appendNumber( "totalConnections" , totalConns );
+        b.appendNumber( "totalInFlight" , totalInFlight );
+    }
+
+} // namespace mongo
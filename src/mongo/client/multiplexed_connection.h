@@ -0,0 +1,173 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/client/export_macros.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    class DBConnectionPool;
+
+    /**
+     * A connection to one server shared by any number of threads. Requests are pipelined on the
+     * socket without waiting for earlier replies, and each reply goes to the caller whose
+     * request id matches its responseTo. There is no reader thread: a waiting caller that finds
+     * the socket free reads replies for everyone until its own arrives.
+     *
+     * Only suitable for requests which don't depend on per-connection state on the server, such
+     * as getMore and killCursors, since any number of clients interleave on the connection.
+     */
+    class MONGO_CLIENT_API MultiplexedConnection : boost::noncopyable {
+    public:
+
+        /** takes ownership of conn */
+        explicit MultiplexedConnection( DBClientConnection* conn );
+        ~MultiplexedConnection();
+
+        /**
+         * Sends a request which expects a reply, without waiting for the reply.
+         * @return the id to pass to recv() or forget() for the reply
+         */
+        MSGID send( Message& toSend );
+
+        /** Sends a request which has no reply, like killCursors */
+        void say( Message& toSend );
+
+        /**
+         * Waits for the reply to a request sent with send().
+         * @return false if the connection failed before the reply arrived
+         */
+        bool recv( MSGID id, Message& response );
+
+        /** The reply to a request sent with send() will be dropped when it arrives */
+        void forget( MSGID id );
+
+        /** send() and wait for the reply */
+        bool call( Message& toSend, Message& response );
+
+        /** the underlying connection, never send or receive on it directly */
+        DBClientConnection* conn() { return _conn.get(); }
+
+        int numInFlight() const;
+        bool isFailed() const;
+
+    private:
+        // reads one reply from the socket and hands it to its caller
+        void _readOne();
+
+        // marks the connection failed and wakes up all waiters, _mutex must be held
+        void _setFailed();
+
+        boost::scoped_ptr<DBClientConnection> _conn;
+
+        // serializes writes to the socket
+        mongo::mutex _sendMutex;
+
+        // protects everything below
+        mutable mongo::mutex _mutex;
+        boost::condition _replyArrived;
+
+        // requests sent and not yet received, with their reply once it has arrived
+        typedef std::map<MSGID, boost::shared_ptr<Message> > ReplyMap;
+        ReplyMap _replies;
+
+        // requests whose reply nobody will wait for
+        std::set<MSGID> _forgotten;
+
+        // true while a caller is reading from the socket
+        bool _reading;
+        bool _failed;
+    };
+
+    typedef boost::shared_ptr<MultiplexedConnection> MultiplexedConnectionPtr;
+
+    /**
+     * A small, fixed number of MultiplexedConnections per host, shared by all threads. Each
+     * request goes to the connection to its host with the fewest requests in flight.
+     */
+    class MONGO_CLIENT_API MultiplexedConnectionPool : boost::noncopyable {
+    public:
+
+        /**
+         * @param hookSource new connections are set up by the hooks of this pool, as if that
+         *     pool had created them.
+         */
+        explicit MultiplexedConnectionPool( DBConnectionPool* hookSource );
+
+        /**
+         * Sets the number of connections to open per host. 0, the default, disables the pool.
+         */
+        void setConnectionsPerHost( int connsPerHost );
+        bool isEnabled() const;
+
+        /**
+         * Returns a shared connection to host, or an empty pointer if the pool is disabled or
+         * host can't be multiplexed, in which case the caller should use a regular pool.
+         */
+        MultiplexedConnectionPtr get( const std::string& host );
+
+        /** Closes all connections once their current users are done with them */
+        void clear();
+
+        void appendInfo( BSONObjBuilder& b );
+
+    private:
+        struct HostConnections {
+            HostConnections() : created( 0 ) {}
+
+            std::vector<MultiplexedConnectionPtr> conns;
+            long long created;
+        };
+
+        typedef std::map<std::string, HostConnections> HostMap;
+
+        DBConnectionPool* const _hookSource;
+
+        mutable mongo::mutex _mutex;
+        int _connsPerHost;
+        HostMap _hosts;
+    };
+
+    /**
+     * Shared connections for reading attached cursors, see DBClientCursor.  Disabled unless
+     * the connPoolMultiplexedConnsPerHost server parameter is set.
+     */
+    extern MONGO_CLIENT_API MultiplexedConnectionPool multiplexedPool;
+
+} // namespace mongo
@@ -252,6 +252,8 @@ namespace mongo {
         _numServers = _servers.size();
         _lastFrom = 0;
         _cursors = 0;
+        _mergeHeapInit = false;
+        _mergeRefill = -1;
 
         if( ! _qSpec.isEmpty() ){
             _needToSkip = _qSpec.ntoskip();
@@ -1412,6 +1414,19 @@ namespace mongo {
         _done = true;
     }
 
+    struct ParallelSortClusteredCursor::MergeHeadGreater {
+        MergeHeadGreater( const BSONObj& sortKey ) : _sortKey( sortKey ) {}
+
+        bool operator()( const MergeHead& a, const MergeHead& b ) const {
+            int comp = a.obj.woSortOrder( b.obj, _sortKey, true );
+            if ( comp != 0 )
+                return comp > 0;
+            return a.from > b.from;
+        }
+
+        const BSONObj& _sortKey;
+    };
+
     bool ParallelSortClusteredCursor::more() {
 
         if ( _needToSkip > 0 ) {
@@ -1426,6 +1441,11 @@ namespace mongo {
             _needToSkip = n;
         }
 
+        if ( ! _sortKey.isEmpty() ) {
+            _refillMergeHeap();
+            return ! _mergeHeap.empty();
+        }
+
         for ( int i=0; i<_numServers; i++ ) {
             if (_cursors[i].get() && _cursors[i].get()->more())
                 return true;
@@ -1434,6 +1454,23 @@ namespace mongo {
     }
 
     BSONObj ParallelSortClusteredCursor::next() {
+
+        if ( ! _sortKey.isEmpty() ) {
+            _refillMergeHeap();
+            uassert(10019, "no more elements", ! _mergeHeap.empty());
+
+            std::pop_heap( _mergeHeap.begin(), _mergeHeap.end(), MergeHeadGreater( _sortKey ) );
+            MergeHead best = _mergeHeap.back();
+            _mergeHeap.pop_back();
+
+            // The cursor's next result goes back in the heap on the following more() or next(),
+            // so we don't block on a shard's getMore until the caller actually wants more
+            _mergeRefill = best.from;
+            _lastFrom = best.from;
+
+            return _nextFrom( best.from, best.obj );
+        }
+
         BSONObj best = BSONObj();
         int bestFrom = -1;
 
@@ -1451,40 +1488,65 @@ namespace mongo {
                 continue;
             }
 
-            // We know we have at least one result in this cursor
-            BSONObj me = _cursors[i].get()->peekFirst();
-
-            // If this is the first non-empty cursor, save the result as best
-            if (bestFrom < 0) {
-                best = me;
-                bestFrom = i;
-                if( _sortKey.isEmpty() ) break;
-                continue;
-            }
-
-            // Otherwise compare the result to the current best result
-            int comp = best.woSortOrder( me , _sortKey , true );
-            if ( comp < 0 )
-                continue;
-
-            best = me;
+            // Unsorted, so the first non-empty cursor is as good as any
+            best = _cursors[i].get()->peekFirst();
             bestFrom = i;
+            break;
         }
 
         _lastFrom = bestFrom;
 
         uassert(10019, "no more elements", bestFrom >= 0);
-        _cursors[bestFrom].get()->next();
+        return _nextFrom( bestFrom, best );
+    }
+
+    void ParallelSortClusteredCursor::_refillMergeHeap() {
+        if ( ! _mergeHeapInit ) {
+            _mergeHeapInit = true;
+            for ( int i = 0; i < _numServers; i++ )
+                _pushMergeHead( i );
+        }
+        else if ( _mergeRefill >= 0 ) {
+            _pushMergeHead( _mergeRefill );
+        }
+
+        _mergeRefill = -1;
+    }
+
+    void ParallelSortClusteredCursor::_pushMergeHead( int i ) {
+        if (!_cursors[i].get() || !_cursors[i].get()->more()) {
+            if (_cursors[i].getMData())
+                _cursors[i].getMData()->pcState->done = true;
+            return;
+        }
+
+        _mergeHeap.push_back( MergeHead( _cursors[i].get()->peekFirst(), i ) );
+        std::push_heap( _mergeHeap.begin(), _mergeHeap.end(), MergeHeadGreater( _sortKey ) );
+    }
+
+    // Read ahead once a cursor is down to this fraction of its current batch
+    static const int readAheadFraction = 4;
+
+    BSONObj ParallelSortClusteredCursor::_nextFrom( int i, BSONObj obj ) {
+        DBClientCursor* cursor = _cursors[i].get();
+        cursor->next();
 
         // Make sure the result data won't go away after the next call to more()
-        if (!_cursors[bestFrom].get()->moreInCurrentBatch()) {
-            best = best.getOwned();
+        if ( ! cursor->moreInCurrentBatch() ) {
+            obj = obj.getOwned();
+        }
+
+        // Ask for the shard's next batch while we still have results buffered from it, so the
+        // merge rarely waits on a round trip.  The current batch stays valid until the reply
+        // is read.
+        if ( cursor->objsLeftInBatch() <= cursor->objsInBatch() / readAheadFraction ) {
+            cursor->prefetchMore();
         }
 
-        if (_cursors[bestFrom].getMData())
-            _cursors[bestFrom].getMData()->pcState->count++;
+        if (_cursors[i].getMData())
+            _cursors[i].getMData()->pcState->count++;
 
-        return best;
+        return obj;
     }
 
     void ParallelSortClusteredCursor::_explain( map< string,list<BSONObj> >& out ) {
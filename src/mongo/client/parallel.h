@@ -268,6 +268,24 @@ namespace mongo {
         DBClientCursorHolder * _cursors;
         int _needToSkip;
 
+        // Sorted results are merged through a min-heap holding the first unread result of each
+        // cursor, keyed on _sortKey
+        struct MergeHead {
+            MergeHead( const BSONObj& o, int f ) : obj( o ), from( f ) {}
+            BSONObj obj;
+            int from;
+        };
+        struct MergeHeadGreater;
+
+        std::vector<MergeHead> _mergeHeap;
+        bool _mergeHeapInit;
+        // cursor whose head was last returned and still has to be pushed back, or -1
+        int _mergeRefill;
+
+        void _refillMergeHeap();
+        void _pushMergeHead( int i );
+        BSONObj _nextFrom( int i, BSONObj obj );
+
         /**
          * Setups the shard version of the connection. When using a replica
          * set connection and the primary cannot be reached, the version
@@ -89,9 +89,17 @@ namespace mongo {
     struct CompactStats {
         CompactStats() {
             corruptDocuments = 0;
+            recordsMoved = 0;
+            extentsFreed = 0;
+            extentsRemaining = 0;
         }
 
         long long corruptDocuments;
+
+        // online compaction only
+        long long recordsMoved;
+        long long extentsFreed;
+        long long extentsRemaining; // still to be drained after the last batch
     };
 
     /**
@@ -204,6 +212,22 @@ namespace mongo {
 
         StatusWith<CompactStats> compact(OperationContext* txn, const CompactOptions* options);
 
+        /**
+         * One step of an online compaction, see RecordStore::compactOnlineBatch. Unlike
+         * compact() indexes are kept and updated for each record moved, so the caller can
+         * release the database lock between calls. Adds to *stats.
+         */
+        Status compactOnlineBatch( OperationContext* txn,
+                                   const CompactOptions* options,
+                                   int maxRecords,
+                                   CompactStats* stats,
+                                   bool* done );
+
+        /**
+         * Ends an online compaction that didn't finish, see RecordStore::compactOnlineAbandon.
+         */
+        void compactOnlineAbandon( OperationContext* txn );
+
         /**
          * removes all documents as fast as possible
          * indexes before and after will be the same
@@ -93,6 +93,34 @@ namespace mongo {
             MultiIndexBlock* _multiIndexBlock;
         };
 
+        /**
+         * For online compaction the indexes stay in place: the old location is unindexed by
+         * Collection::recordStoreGoingToMove and the new one is indexed here.
+         */
+        class OnlineCompactAdaptor : public RecordStoreCompactAdaptor {
+        public:
+            OnlineCompactAdaptor(OperationContext* txn, IndexCatalog* indexCatalog)
+                : _txn( txn ),
+                  _indexCatalog( indexCatalog ) {
+            }
+
+            virtual bool isDataValid( const RecordData& recData ) {
+                return recData.toBson().valid();
+            }
+
+            virtual size_t dataSize( const RecordData& recData ) {
+                return recData.toBson().objsize();
+            }
+
+            virtual void inserted( const RecordData& recData, const DiskLoc& newLocation ) {
+                _indexCatalog->indexRecord( _txn, recData.toBson(), newLocation );
+            }
+
+        private:
+            OperationContext* _txn;
+            IndexCatalog* _indexCatalog;
+        };
+
     }
 
 
@@ -175,4 +203,35 @@ namespace mongo {
         return StatusWith<CompactStats>( stats );
     }
 
+    Status Collection::compactOnlineBatch( OperationContext* txn,
+                                           const CompactOptions* compactOptions,
+                                           int maxRecords,
+                                           CompactStats* stats,
+                                           bool* done ) {
+        if ( !_recordStore->compactOnlineSupported() )
+            return Status( ErrorCodes::IllegalOperation,
+                           str::stream() <<
+                           "cannot compact online collection with record store: " <<
+                           _recordStore->name() );
+
+        if ( _indexCatalog.numIndexesInProgress( txn ) )
+            return Status( ErrorCodes::BadValue, "cannot compact when indexes in progress" );
+
+        OnlineCompactAdaptor adaptor( txn, &_indexCatalog );
+        Status status = _recordStore->compactOnlineBatch( txn,
+                                                          &adaptor,
+                                                          this,
+                                                          compactOptions,
+                                                          maxRecords,
+                                                          stats,
+                                                          done );
+        if ( stats->recordsMoved )
+            _infoCache.notifyOfWriteOp();
+        return status;
+    }
+
+    void Collection::compactOnlineAbandon( OperationContext* txn ) {
+        _recordStore->compactOnlineAbandon( txn );
+    }
+
 }  // namespace mongo
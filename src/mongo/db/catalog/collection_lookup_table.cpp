@@ -0,0 +1,197 @@
+// collection_lookup_table.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/collection_lookup_table.h"
+
+#include <cstring>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    namespace {
+        uint32_t hashNamespace( const StringData& ns ) {
+            return static_cast<uint32_t>( StringMapDefaultHash()( ns ) );
+        }
+    }
+
+    /**
+     * One immutable generation of the table.  Slots are sized to a power of two at least twice
+     * the number of entries, so probes stay short; a slot with keyLen == 0 ends a probe
+     * sequence (namespaces are never empty).  remove() leaves the key behind with a NULL
+     * Collection so that later probes still pass over it.
+     */
+    class CollectionLookupTable::Snapshot : boost::noncopyable {
+    public:
+        explicit Snapshot( const StringMap<Collection*>& collections )
+            : _live( 0 ), _removed( 0 ) {
+            size_t capacity = 16;
+            while ( capacity < collections.size() * 2 )
+                capacity *= 2;
+            _slots.resize( capacity );
+            _mask = capacity - 1;
+
+            size_t keyBytes = 0;
+            for ( StringMap<Collection*>::const_iterator i = collections.begin();
+                  i != collections.end();
+                  ++i ) {
+                keyBytes += i->first.size();
+            }
+            _keys.reserve( keyBytes );
+
+            for ( StringMap<Collection*>::const_iterator i = collections.begin();
+                  i != collections.end();
+                  ++i ) {
+                if ( !i->second )
+                    continue;
+                const std::string& ns = i->first;
+                invariant( !ns.empty() );
+
+                uint32_t hash = hashNamespace( ns );
+                size_t pos = hash & _mask;
+                while ( _slots[pos].keyLen != 0 )
+                    pos = ( pos + 1 ) & _mask;
+
+                Slot& slot = _slots[pos];
+                slot.collection = i->second;
+                slot.hash = hash;
+                slot.keyOffset = _keys.size();
+                slot.keyLen = ns.size();
+                _keys.insert( _keys.end(), ns.begin(), ns.end() );
+                _live++;
+            }
+        }
+
+        Collection* find( const StringData& ns, uint32_t hash ) const {
+            const Slot* slot = _find( ns, hash );
+            return slot ? slot->collection : NULL;
+        }
+
+        void remove( const StringData& ns, uint32_t hash ) {
+            Slot* slot = const_cast<Slot*>( _find( ns, hash ) );
+            if ( !slot || !slot->collection )
+                return;
+            slot->collection = NULL;
+            _live--;
+            _removed++;
+        }
+
+        size_t live() const { return _live; }
+        size_t removed() const { return _removed; }
+
+    private:
+        struct Slot {
+            Slot() : collection( NULL ), hash( 0 ), keyOffset( 0 ), keyLen( 0 ) {}
+            Collection* collection;
+            uint32_t hash;
+            uint32_t keyOffset;
+            uint32_t keyLen;
+        };
+
+        const Slot* _find( const StringData& ns, uint32_t hash ) const {
+            size_t pos = hash & _mask;
+            while ( true ) {
+                const Slot& slot = _slots[pos];
+                if ( slot.keyLen == 0 )
+                    return NULL;
+                if ( slot.hash == hash &&
+                     slot.keyLen == ns.size() &&
+                     memcmp( &_keys[slot.keyOffset], ns.rawData(), ns.size() ) == 0 ) {
+                    return &slot;
+                }
+                pos = ( pos + 1 ) & _mask;
+            }
+        }
+
+        std::vector<Slot> _slots;
+        size_t _mask;
+        std::vector<char> _keys;
+        size_t _live;
+        size_t _removed;
+    };
+
+    CollectionLookupTable::CollectionLookupTable() : _snapshot( 0 ) {
+    }
+
+    CollectionLookupTable::~CollectionLookupTable() {
+        reclaim();
+        delete _current();
+    }
+
+    CollectionLookupTable::Snapshot* CollectionLookupTable::_current() const {
+        return reinterpret_cast<Snapshot*>( _snapshot.load() );
+    }
+
+    Collection* CollectionLookupTable::find( const StringData& ns ) const {
+        const Snapshot* snapshot = _current();
+        if ( !snapshot )
+            return NULL;
+        return snapshot->find( ns, hashNamespace( ns ) );
+    }
+
+    bool CollectionLookupTable::needsRebuild( size_t numEntries ) const {
+        const Snapshot* snapshot = _current();
+        if ( !snapshot )
+            return numEntries > 0;
+
+        // entries the snapshot is missing or still carries as tombstones
+        size_t live = snapshot->live();
+        size_t stale = snapshot->removed() + ( numEntries > live ? numEntries - live : 0 );
+        return stale > live / 4;
+    }
+
+    void CollectionLookupTable::rebuild( const StringMap<Collection*>& collections ) {
+        Snapshot* next = new Snapshot( collections );
+        Snapshot* prev = _current();
+        _snapshot.store( reinterpret_cast<uintptr_t>( next ) );
+        if ( prev )
+            _retired.push_back( prev );
+    }
+
+    void CollectionLookupTable::remove( const StringData& ns ) {
+        Snapshot* snapshot = _current();
+        if ( snapshot )
+            snapshot->remove( ns, hashNamespace( ns ) );
+    }
+
+    void CollectionLookupTable::reclaim() {
+        for ( size_t i = 0; i < _retired.size(); i++ )
+            delete _retired[i];
+        _retired.clear();
+    }
+
+    size_t CollectionLookupTable::size() const {
+        const Snapshot* snapshot = _current();
+        return snapshot ? snapshot->live() : 0;
+    }
+
+} // namespace mongo
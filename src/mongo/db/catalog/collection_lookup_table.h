@@ -0,0 +1,107 @@
+// collection_lookup_table.h
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    class Collection;
+
+    /**
+     * Read-optimized namespace -> Collection* index used by Database::getCollection.
+     *
+     * Lookups probe an immutable open-addressing snapshot (linear probing, hashes stored in the
+     * slots, all keys packed into one buffer) and take no locks.  Writers build a new snapshot
+     * from the authoritative StringMap and publish it with a single atomic store.
+     *
+     * The caller provides the synchronization for everything but find():
+     *   - rebuild() must be serialized by the caller (Database::_collectionLock).
+     *   - remove() and reclaim() may only be called when no reader can be inside find(), i.e.
+     *     with the database locked exclusively.  Collections are only ever deleted under that
+     *     lock, so this is when a stale pointer has to be cleared anyway.
+     *
+     * Snapshots replaced while readers may still be probing them are retired, not freed, until
+     * the next reclaim().  Rebuilds happen geometrically, so this costs at most a small multiple
+     * of the live snapshot.
+     */
+    class CollectionLookupTable : boost::noncopyable {
+    public:
+        CollectionLookupTable();
+        ~CollectionLookupTable();
+
+        /**
+         * @return the Collection for 'ns' in the current snapshot, or NULL if the snapshot
+         * doesn't have it (the caller falls back to the locked map).  Does not lock.
+         */
+        Collection* find( const StringData& ns ) const;
+
+        /**
+         * @return true if the snapshot has fallen far enough behind a map holding 'numEntries'
+         * collections that it should be rebuilt.
+         */
+        bool needsRebuild( size_t numEntries ) const;
+
+        /**
+         * Builds a snapshot of 'collections' and publishes it.  Entries with a NULL Collection
+         * are skipped.
+         */
+        void rebuild( const StringMap<Collection*>& collections );
+
+        /**
+         * Clears 'ns' in the current snapshot in place.  Readers must be excluded.
+         */
+        void remove( const StringData& ns );
+
+        /**
+         * Frees retired snapshots.  Readers must be excluded.
+         */
+        void reclaim();
+
+        /** number of live entries in the current snapshot */
+        size_t size() const;
+
+    private:
+        class Snapshot;
+
+        Snapshot* _current() const;
+
+        AtomicWord<uintptr_t> _snapshot; // Snapshot*, owned
+        std::vector<Snapshot*> _retired; // owned
+    };
+
+} // namespace mongo
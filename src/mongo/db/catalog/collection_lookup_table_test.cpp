@@ -0,0 +1,181 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/collection_lookup_table.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    namespace {
+
+        // the table never dereferences its values, so any distinct non-NULL pointer will do
+        Collection* fakeCollection( size_t i ) {
+            return reinterpret_cast<Collection*>( ( i + 1 ) * 8 );
+        }
+
+        std::string collectionName( size_t i ) {
+            return str::stream() << "test.coll" << i;
+        }
+
+    }
+
+    TEST( CollectionLookupTable, Empty ) {
+        CollectionLookupTable table;
+        ASSERT( table.find( "test.foo" ) == NULL );
+        ASSERT_EQUALS( 0U, table.size() );
+
+        StringMap<Collection*> map;
+        ASSERT( table.needsRebuild( 0 ) == false );
+        table.rebuild( map );
+        ASSERT( table.find( "test.foo" ) == NULL );
+    }
+
+    TEST( CollectionLookupTable, FindAfterRebuild ) {
+        StringMap<Collection*> map;
+        for ( size_t i = 0; i < 100; i++ )
+            map[collectionName( i )] = fakeCollection( i );
+        map["test.pending"] = NULL;
+
+        CollectionLookupTable table;
+        ASSERT( table.needsRebuild( map.size() ) );
+        table.rebuild( map );
+        ASSERT_EQUALS( 100U, table.size() );
+        ASSERT( !table.needsRebuild( map.size() ) );
+
+        for ( size_t i = 0; i < 100; i++ )
+            ASSERT_EQUALS( fakeCollection( i ), table.find( collectionName( i ) ) );
+        ASSERT( table.find( "test.pending" ) == NULL );
+        ASSERT( table.find( "test.coll100" ) == NULL );
+        ASSERT( table.find( "test.coll" ) == NULL );
+        ASSERT( table.find( "test.coll10x" ) == NULL );
+    }
+
+    TEST( CollectionLookupTable, RemoveLeavesProbeChainIntact ) {
+        StringMap<Collection*> map;
+        for ( size_t i = 0; i < 1000; i++ )
+            map[collectionName( i )] = fakeCollection( i );
+
+        CollectionLookupTable table;
+        table.rebuild( map );
+
+        // with 1000 keys in 2048 slots some of these sit in the middle of a probe sequence
+        for ( size_t i = 0; i < 1000; i += 2 )
+            table.remove( collectionName( i ) );
+        table.remove( "test.missing" );
+
+        ASSERT_EQUALS( 500U, table.size() );
+        for ( size_t i = 0; i < 1000; i++ ) {
+            if ( i % 2 == 0 )
+                ASSERT( table.find( collectionName( i ) ) == NULL );
+            else
+                ASSERT_EQUALS( fakeCollection( i ), table.find( collectionName( i ) ) );
+        }
+
+        for ( size_t i = 0; i < 1000; i += 2 )
+            map.erase( map.find( collectionName( i ) ) );
+        ASSERT( table.needsRebuild( map.size() ) );
+        table.rebuild( map );
+        table.reclaim();
+        ASSERT_EQUALS( 500U, table.size() );
+        ASSERT( !table.needsRebuild( map.size() ) );
+    }
+
+    TEST( CollectionLookupTable, GrowsGeometrically ) {
+        StringMap<Collection*> map;
+        CollectionLookupTable table;
+
+        int rebuilds = 0;
+        for ( size_t i = 0; i < 10000; i++ ) {
+            map[collectionName( i )] = fakeCollection( i );
+            if ( table.needsRebuild( map.size() ) ) {
+                table.rebuild( map );
+                rebuilds++;
+            }
+        }
+
+        // entries added since the last rebuild are only in the map
+        ASSERT_LESS_THAN( rebuilds, 60 );
+        ASSERT_GREATER_THAN_OR_EQUALS( table.size() + table.size() / 4, map.size() );
+        table.reclaim();
+    }
+
+    TEST( CollectionLookupTable, LookupThroughput10k ) {
+        const size_t numCollections = 10000;
+        const size_t numLookups = 2000000;
+
+        std::vector<std::string> names;
+        StringMap<Collection*> map;
+        for ( size_t i = 0; i < numCollections; i++ ) {
+            names.push_back( collectionName( i ) );
+            map[names.back()] = fakeCollection( i );
+        }
+
+        CollectionLookupTable table;
+        table.rebuild( map );
+
+        // what Database::getCollection did before: StringMap under its mutex
+        mongo::mutex lock( "CollectionLookupTable::LookupThroughput10k" );
+        size_t found = 0;
+        Timer mapTimer;
+        for ( size_t i = 0; i < numLookups; i++ ) {
+            scoped_lock lk( lock );
+            StringMap<Collection*>::const_iterator it =
+                map.find( names[( i * 7919 ) % numCollections] );
+            if ( it != map.end() )
+                found++;
+        }
+        long long mapMicros = mapTimer.micros();
+
+        Timer tableTimer;
+        for ( size_t i = 0; i < numLookups; i++ ) {
+            if ( table.find( names[( i * 7919 ) % numCollections] ) )
+                found++;
+        }
+        long long tableMicros = tableTimer.micros();
+
+        ASSERT_EQUALS( numLookups * 2, found );
+
+        mongo::unittest::log() << "CollectionLookupTable 10k collections, " << numLookups
+                               << " lookups: locked StringMap "
+                               << ( numLookups * 1000000.0 / std::max( mapMicros, 1LL ) )
+                               << "/s, lookup table "
+                               << ( numLookups * 1000000.0 / std::max( tableMicros, 1LL ) )
+                               << "/s" << std::endl;
+    }
+
+} // namespace mongo
@@ -372,13 +372,25 @@ namespace mongo {
         if ( it == _collections.end() )
             return;
 
+        // only called with the database locked exclusively, so no reader is probing the
+        // lookup table and snapshots replaced since the last DDL can be freed too
+        _collectionLookup.remove( fullns );
+
         delete it->second; // this also deletes all cursors + runners
         _collections.erase( it );
+
+        if ( _collectionLookup.needsRebuild( _collections.size() ) )
+            _collectionLookup.rebuild( _collections );
+        _collectionLookup.reclaim();
     }
 
     Collection* Database::getCollection( OperationContext* txn, const StringData& ns ) {
         invariant( _name == nsToDatabaseSubstring( ns ) );
 
+        Collection* found = _collectionLookup.find( ns );
+        if ( found )
+            return found;
+
         scoped_lock lk( _collectionLock );
 
         CollectionMap::const_iterator it = _collections.find( ns );
@@ -395,6 +407,8 @@ namespace mongo {
 
         Collection* c = new Collection( txn, ns, catalogEntry.release(), rs.release(), this );
         _collections[ns] = c;
+        if ( _collectionLookup.needsRebuild( _collections.size() ) )
+            _collectionLookup.rebuild( _collections );
         return c;
     }
 
@@ -32,6 +32,7 @@
 
 #include "mongo/base/string_data.h"
 #include "mongo/bson/bsonobj.h"
+#include "mongo/db/catalog/collection_lookup_table.h"
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/storage_options.h"
@@ -150,6 +151,10 @@ namespace mongo {
         CollectionMap _collections;
         mongo::mutex _collectionLock;
 
+        // lock-free view of _collections that getCollection tries first, see
+        // collection_lookup_table.h; rebuilt under _collectionLock
+        CollectionLookupTable _collectionLookup;
+
         friend class Collection;
         friend class NamespaceDetails;
         friend class IndexCatalog;
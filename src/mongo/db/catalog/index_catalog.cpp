@@ -472,7 +472,7 @@ namespace {
             double v = vElt.Number();
             // note (one day) we may be able to fresh build less versions than we can use
             // isASupportedIndexVersionNumber() is what we can use
-            if ( v != 0 && v != 1 ) {
+            if ( v != 0 && v != 1 && v != 2 ) {
                 return Status( ErrorCodes::CannotCreateIndex,
                                str::stream() << "this version of mongod cannot build new indexes "
                                              << "of version number " << v );
@@ -321,6 +321,7 @@ namespace mongo {
 }
 
 #include "mongo/client/connpool.h"
+#include "mongo/client/multiplexed_connection.h"
 
 namespace mongo {
 
@@ -366,6 +367,11 @@ namespace mongo {
         }
         virtual bool run(OperationContext* txn, const string&, mongo::BSONObj&, int, std::string&, mongo::BSONObjBuilder& result, bool) {
             pool.appendInfo( result );
+            {
+                BSONObjBuilder temp( result.subobjStart( "multiplexed" ) );
+                multiplexedPool.appendInfo( temp );
+                temp.done();
+            }
             result.append( "numDBClientConnection" , DBClientConnection::getNumConnections() );
             result.append( "numAScopedConnection" , AScopedConnection::getNumConnections() );
             return true;
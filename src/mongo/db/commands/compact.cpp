@@ -28,6 +28,7 @@
 *    it in the license file.
 */
 
+#include <boost/scoped_ptr.hpp>
 #include <string>
 #include <vector>
 
@@ -45,6 +46,8 @@
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/util/log.h"
+#include "mongo/util/progress_meter.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -65,9 +68,11 @@ namespace mongo {
             help << "compact collection\n"
                 "warning: this operation locks the database and is slow. you can cancel with killOp()\n"
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
-                "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
+                "  [paddingFactor:<num>], [paddingBytes:<num>], [online:<bool>], [batchSize:<num>] }\n"
                 "  force - allows to run on a replica set primary\n"
-                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
+                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n"
+                "  online - only move records out of extents less than half full, batchSize records per lock\n"
+                "           acquisition, keeping the indexes. other operations run between batches\n";
         }
         CompactCmd() : Command("compact") { }
 
@@ -89,9 +94,12 @@ namespace mongo {
                 return false;
             }
 
+            const bool online = cmdObj["online"].trueValue();
+
             repl::ReplicationCoordinator* replCoord = repl::getGlobalReplicationCoordinator();
             if (replCoord->getReplicationMode() == repl::ReplicationCoordinator::modeReplSet
                     && replCoord->getCurrentMemberState().primary()
+                    && !online
                     && !cmdObj["force"].trueValue()) {
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
@@ -143,6 +151,18 @@ namespace mongo {
             if ( cmdObj.hasElement("validate") )
                 compactOptions.validateDocuments = cmdObj["validate"].trueValue();
 
+            if ( online ) {
+                int batchSize = 100;
+                if ( cmdObj.hasElement("batchSize") ) {
+                    batchSize = cmdObj["batchSize"].numberInt();
+                    if ( batchSize < 1 || batchSize > 100000 ) {
+                        errmsg = "invalid batchSize";
+                        return false;
+                    }
+                }
+                return runOnline( txn, ns, compactOptions, batchSize, errmsg, result );
+            }
+
 
             Lock::DBLock lk(txn->lockState(), db, newlm::MODE_X);
             BackgroundOperation::assertNoBgOpInProgForNs(ns.ns());
@@ -176,6 +196,117 @@ namespace mongo {
 
             return true;
         }
+
+    private:
+        /**
+         * Compacts by moving at most batchSize records per acquisition of the database lock,
+         * which is released in between. Progress is reported through CurOp: extents drained
+         * out of those to drain, and storage reclaimed so far.
+         */
+        bool runOnline(OperationContext* txn,
+                       const NamespaceString& ns,
+                       const CompactOptions& compactOptions,
+                       int batchSize,
+                       string& errmsg,
+                       BSONObjBuilder& result) {
+            log() << "compact " << ns << " online begin, batchSize: " << batchSize
+                  << " options: " << compactOptions.toString();
+
+            // keeps index builds, drops and other compactions off the collection between batches
+            boost::scoped_ptr<BackgroundOperation> bgOp;
+            boost::scoped_ptr<ProgressMeterHolder> pm;
+
+            CompactStats stats;
+            long long initialStorageSize = 0;
+            long long bytesReclaimed = 0;
+            bool done = false;
+            while ( !done ) {
+                try {
+                    txn->checkForInterrupt();
+                    {
+                        Lock::DBLock lk(txn->lockState(), ns.db(), newlm::MODE_X);
+                        Client::Context ctx(txn, ns);
+
+                        Collection* collection = ctx.db()->getCollection(txn, ns.ns());
+                        if ( !collection ) {
+                            errmsg = "namespace does not exist";
+                            return false;
+                        }
+
+                        if ( !bgOp ) {
+                            if ( collection->isCapped() ) {
+                                errmsg = "cannot compact a capped collection";
+                                return false;
+                            }
+                            BackgroundOperation::assertNoBgOpInProgForNs(ns.ns());
+                            bgOp.reset(new BackgroundOperation(ns.ns()));
+                            initialStorageSize = collection->getRecordStore()->storageSize(txn);
+                        }
+
+                        const long long extentsFreedBefore = stats.extentsFreed;
+                        Status status = collection->compactOnlineBatch(txn,
+                                                                       &compactOptions,
+                                                                       batchSize,
+                                                                       &stats,
+                                                                       &done);
+                        if ( !status.isOK() ) {
+                            collection->compactOnlineAbandon(txn);
+                            return appendCommandStatus( result, status );
+                        }
+
+                        bytesReclaimed =
+                            initialStorageSize - collection->getRecordStore()->storageSize(txn);
+
+                        const long long extentsTotal = stats.extentsFreed + stats.extentsRemaining;
+                        if ( !pm && extentsTotal > 0 ) {
+                            pm.reset(new ProgressMeterHolder(*txn->setMessage(
+                                                                "compact online",
+                                                                "Online Compaction Progress",
+                                                                extentsTotal)));
+                        }
+                        if ( pm ) {
+                            pm->hit( stats.extentsFreed - extentsFreedBefore );
+                            txn->getCurOp()->updateMessage(str::stream()
+                                                           << "compact online, "
+                                                           << bytesReclaimed << " bytes reclaimed");
+                        }
+                    }
+
+                    // let everyone else in before the next batch
+                    txn->getCurOp()->yielded();
+                    sleepmicros(1);
+                }
+                catch ( ... ) {
+                    // only give up on the compaction this run started, not another one's
+                    if ( bgOp )
+                        abandonOnline(txn, ns);
+                    throw;
+                }
+            }
+
+            if ( stats.corruptDocuments > 0 )
+                result.append("invalidObjects", stats.corruptDocuments );
+            result.appendNumber("recordsMoved", stats.recordsMoved);
+            result.appendNumber("extentsFreed", stats.extentsFreed);
+            result.appendNumber("bytesReclaimed", bytesReclaimed);
+
+            log() << "compact " << ns << " online end, moved " << stats.recordsMoved
+                  << " records, freed " << stats.extentsFreed << " extents, reclaimed "
+                  << bytesReclaimed << " bytes";
+            return true;
+        }
+
+        /**
+         * Ends the interrupted online compaction of ns, so that the extent it was draining
+         * takes deletes again.
+         */
+        static void abandonOnline(OperationContext* txn, const NamespaceString& ns) {
+            Lock::DBLock lk(txn->lockState(), ns.db(), newlm::MODE_X);
+            Client::Context ctx(txn, ns);
+            Collection* collection = ctx.db()->getCollection(txn, ns.ns());
+            if ( collection )
+                collection->compactOnlineAbandon(txn);
+        }
     };
     static CompactCmd compactCmd;
 
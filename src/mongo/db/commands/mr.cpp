@@ -34,6 +34,8 @@
 
 #include "mongo/db/commands/mr.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/connpool.h"
 #include "mongo/client/parallel.h"
 #include "mongo/db/auth/authorization_session.h"
@@ -43,6 +45,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/exec/multi_iterator.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/matcher/matcher.h"
@@ -59,6 +62,7 @@
 #include "mongo/s/d_state.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/stale_exception.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
 
@@ -245,6 +249,197 @@ namespace mongo {
             _reduce( x , key , endSizeEstimate );
         }
 
+        namespace {
+
+            /**
+             * Properties every js object inherits, which 'this.<field>' resolves to when the
+             * document has no such field.
+             */
+            bool isObjectPrototypeProperty( const StringData& field ) {
+                static const char* const names[] = { "constructor", "toString",
+                                                     "toLocaleString", "valueOf",
+                                                     "hasOwnProperty", "isPrototypeOf",
+                                                     "propertyIsEnumerable", "__proto__",
+                                                     "__defineGetter__", "__defineSetter__",
+                                                     "__lookupGetter__", "__lookupSetter__" };
+                for ( size_t i = 0; i < sizeof( names ) / sizeof( names[0] ); i++ ) {
+                    if ( field == names[i] )
+                        return true;
+                }
+                return false;
+            }
+
+            /**
+             * Looks up 'this.<path>' in a document.
+             * @return false if js could see something other than a plain field lookup,
+             *         e.g. an intermediate value is not an object
+             */
+            bool lookupThisPath( const BSONObj& o , const vector<string>& path ,
+                                 BSONElement* out ) {
+                BSONObj cur = o;
+                for ( size_t i = 0; i < path.size(); i++ ) {
+                    BSONElement e = cur.getField( path[i] );
+                    if ( e.eoo() && isObjectPrototypeProperty( path[i] ) )
+                        return false;
+                    if ( i + 1 == path.size() ) {
+                        *out = e;
+                        return true;
+                    }
+                    if ( e.type() != Object )
+                        return false;
+                    cur = e.embeddedObject();
+                }
+                return false;
+            }
+
+            /**
+             * Appends 'e' the way it comes back from a round trip through the js engine.
+             * Missing values are not handled here since emit treats keys and values differently.
+             * @return false if the conversion is not reproduced natively
+             */
+            bool appendAsFromJS( BSONObjBuilder& b , const StringData& name ,
+                                 const BSONElement& e ) {
+                switch ( e.type() ) {
+                case NumberInt:
+                case NumberDouble:
+                    // js numbers come back as doubles
+                    b.append( name , e.number() );
+                    return true;
+                case String:
+                case Symbol:
+                    b.append( name , e.valueStringData() );
+                    return true;
+                case Bool:
+                    b.appendBool( name , e.boolean() );
+                    return true;
+                case jstNULL:
+                case Undefined:
+                    b.appendNull( name );
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            /**
+             * @return true if the function has no scope that the native path would ignore
+             */
+            bool isPlainCode( const BSONElement& e ) {
+                return e.type() == Code || e.type() == String ||
+                        ( e.type() == CodeWScope && e.codeWScopeObject().isEmpty() );
+            }
+
+        } // namespace
+
+        void NativeMapper::init( State * state ) {
+            _fallback.init( state );
+            _state = state;
+        }
+
+        /**
+         * Emits {"0": key, "1": value} directly into the State, producing the same tuple
+         * fast_emit would have received from the js function.
+         */
+        void NativeMapper::map( const BSONObj& o ) {
+            BSONElement key;
+            BSONElement value;
+            if ( !lookupThisPath( o , _spec.keyPath , &key ) ||
+                    ( !_spec.valuePath.empty() && !lookupThisPath( o , _spec.valuePath , &value ) ) ) {
+                _fallback.map( o );
+                return;
+            }
+
+            BSONObjBuilder b;
+            if ( key.eoo() ) {
+                // fast_emit turns an undefined key into null
+                b.appendNull( "" );
+            }
+            else if ( !appendAsFromJS( b , "0" , key ) ) {
+                _fallback.map( o );
+                return;
+            }
+
+            if ( _spec.valuePath.empty() ) {
+                b.append( "1" , _spec.valueConstant );
+            }
+            else if ( value.eoo() ) {
+                b.appendUndefined( "1" );
+            }
+            else if ( !appendAsFromJS( b , "1" , value ) ) {
+                _fallback.map( o );
+                return;
+            }
+
+            BSONObj tuple = b.obj();
+            uassert( 13069 , "an emit can't be more than half max bson size" , tuple.objsize() < ( BSONObjMaxUserSize / 2 ) );
+            _state->emit( tuple );
+        }
+
+        bool NativeSumReducer::_sum( const BSONList& tuples , double* out ) const {
+            double sum = 0;
+            for ( size_t i = 0; i < tuples.size(); i++ ) {
+                BSONObjIterator it( tuples[i] );
+                it.next();
+                if ( !it.more() )
+                    return false;
+                BSONElement v = it.next();
+                if ( v.type() != NumberDouble && v.type() != NumberInt )
+                    return false;
+                // same evaluation order as Array.sum()
+                sum = ( i == 0 ) ? v.number() : sum + v.number();
+            }
+            *out = sum;
+            return true;
+        }
+
+        /**
+         * Reduces a list of tuples (key, value) to a single tuple {"0": key, "1": sum}
+         */
+        BSONObj NativeSumReducer::reduce( const BSONList& tuples ) {
+            if ( tuples.size() <= 1 )
+                return tuples[0];
+
+            double sum;
+            if ( !_sum( tuples , &sum ) ) {
+                long long before = _fallback.numReduces;
+                BSONObj res = _fallback.reduce( tuples );
+                numReduces += _fallback.numReduces - before;
+                return res;
+            }
+            ++numReduces;
+
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "0" );
+            b.append( "1" , sum );
+            return b.obj();
+        }
+
+        /**
+         * Reduces a list of tuples (key, value) to a single tuple {_id: key, value: sum}
+         * Also applies a finalizer method if present.
+         */
+        BSONObj NativeSumReducer::finalReduce( const BSONList& tuples , Finalizer * finalizer ) {
+            double sum;
+            if ( tuples.size() == 1 || !_sum( tuples , &sum ) ) {
+                long long before = _fallback.numReduces;
+                BSONObj res = _fallback.finalReduce( tuples , finalizer );
+                numReduces += _fallback.numReduces - before;
+                return res;
+            }
+            ++numReduces;
+
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "_id" );
+            b.append( "value" , sum );
+            BSONObj res = b.obj();
+
+            if ( finalizer ) {
+                res = finalizer->finalize( res );
+            }
+
+            return res;
+        }
+
         Config::Config( const string& _dbname , const BSONObj& cmdObj )
         {
             dbname = _dbname;
@@ -252,6 +447,12 @@ namespace mongo {
 
             verbose = cmdObj["verbose"].trueValue();
             jsMode = cmdObj["jsMode"].trueValue();
+            mapThreads = 1;
+            if (cmdObj.hasField("mapThreads")) {
+                mapThreads = cmdObj["mapThreads"].numberInt();
+                uassert(18910, "mapThreads has to be between 1 and 64",
+                        mapThreads >= 1 && mapThreads <= 64);
+            }
             splitInfo = 0;
             if (cmdObj.hasField("splitInfo"))
                 splitInfo = cmdObj["splitInfo"].Int();
@@ -282,22 +483,7 @@ namespace mongo {
                 incLong = tempNamespace + "_inc";
             }
 
-            {
-                // scope and code
-
-                if ( cmdObj["scope"].type() == Object )
-                    scopeSetup = cmdObj["scope"].embeddedObjectUserCheck();
-
-                mapper.reset( new JSMapper( cmdObj["map"] ) );
-                reducer.reset( new JSReducer( cmdObj["reduce"] ) );
-                if ( cmdObj["finalize"].type() && cmdObj["finalize"].trueValue() )
-                    finalizer.reset( new JSFinalizer( cmdObj["finalize"] ) );
-
-                if ( cmdObj["mapparams"].type() == Array ) {
-                    mapParams = cmdObj["mapparams"].embeddedObjectUserCheck();
-                }
-
-            }
+            _initFunctions( cmdObj );
 
             {
                 // query options
@@ -321,6 +507,70 @@ namespace mongo {
             }
         }
 
+        Config::Config( const Config& other , const BSONObj& cmdObj )
+            : dbname( other.dbname ),
+              ns( other.ns ),
+              verbose( other.verbose ),
+              jsMode( other.jsMode ),
+              nativeMode( other.nativeMode ),
+              mapThreads( other.mapThreads ),
+              splitInfo( other.splitInfo ),
+              filter( other.filter ),
+              sort( other.sort ),
+              limit( other.limit ),
+              outputOptions( other.outputOptions ),
+              jsMaxKeys( other.jsMaxKeys ),
+              reduceTriggerRatio( other.reduceTriggerRatio ),
+              maxInMemSize( other.maxInMemSize ),
+              shardedFirstPass( other.shardedFirstPass ) {
+            // the command's State does all of the output, workers have no temp collections
+            outputOptions.outType = INMEMORY;
+            _initFunctions( cmdObj );
+        }
+
+        void Config::_initFunctions( const BSONObj& cmdObj ) {
+            // scope and code
+
+            if ( cmdObj["scope"].type() == Object )
+                scopeSetup = cmdObj["scope"].embeddedObjectUserCheck();
+
+            // simple functions run without the js engine, unless disabled with
+            // nativeMode: false or the scope shadows the globals they depend on
+            const bool allowNative = ( cmdObj["nativeMode"].eoo() ||
+                                       cmdObj["nativeMode"].trueValue() ) &&
+                                     !scopeSetup.hasField( "emit" ) &&
+                                     !scopeSetup.hasField( "Array" );
+
+            NativeMapSpec mapSpec;
+            const bool nativeMap = allowNative && isPlainCode( cmdObj["map"] ) &&
+                    parseNativeMapFunction( cmdObj["map"]._asCode() , &mapSpec );
+            const bool nativeReduce = allowNative && isPlainCode( cmdObj["reduce"] ) &&
+                    isNativeSumReduceFunction( cmdObj["reduce"]._asCode() );
+
+            if ( nativeMap )
+                mapper.reset( new NativeMapper( mapSpec , cmdObj["map"] ) );
+            else
+                mapper.reset( new JSMapper( cmdObj["map"] ) );
+
+            if ( nativeReduce )
+                reducer.reset( new NativeSumReducer( cmdObj["reduce"] ) );
+            else
+                reducer.reset( new JSReducer( cmdObj["reduce"] ) );
+
+            nativeMode = nativeMap && nativeReduce;
+
+            // native emits go straight to the C++ map, which js mode doesn't use
+            if ( nativeMap )
+                jsMode = false;
+
+            if ( cmdObj["finalize"].type() && cmdObj["finalize"].trueValue() )
+                finalizer.reset( new JSFinalizer( cmdObj["finalize"] ) );
+
+            if ( cmdObj["mapparams"].type() == Array ) {
+                mapParams = cmdObj["mapparams"].embeddedObjectUserCheck();
+            }
+        }
+
         /**
          * Clean up the temporary and incremental collections
          */
@@ -1107,6 +1357,24 @@ namespace mongo {
             _size = nSize;
         }
 
+        void State::absorbInMemoryState( State* other ) {
+            verify( !_jsMode && !other->_jsMode );
+
+            for ( InMemory::iterator i=other->_temp->begin(); i!=other->_temp->end(); ++i ) {
+                BSONList& all = i->second;
+                for ( BSONList::iterator j=all.begin(); j!=all.end(); ++j )
+                    _size += _add( _temp.get(), *j );
+            }
+            other->_temp->clear();
+            other->_size = 0;
+            other->_dupCount = 0;
+
+            _numEmits += other->_numEmits;
+            other->_numEmits = 0;
+            _config.reducer->numReduces += other->_config.reducer->numReduces;
+            other->_config.reducer->numReduces = 0;
+        }
+
         /**
          * Dumps the entire in memory map to the inc collection.
          */
@@ -1233,6 +1501,310 @@ namespace mongo {
             return BSONObj();
         }
 
+        /**
+         * State shared between a mapReduce command and its parallel map workers.
+         */
+        struct ParallelMapShared {
+            ParallelMapShared( const BSONObj& c , State* s , const CollectionMetadataPtr& m )
+                : cmd( c ), state( s ), collMetadata( m ), mutex( "mrParallelMap" ) {
+                UserNameIterator it = ClientBasic::getCurrent()->getAuthorizationSession()
+                                                               ->getAuthenticatedUserNames();
+                while ( it.more() )
+                    userNames.push_back( it.next() );
+            }
+
+            const BSONObj cmd;
+            // the command's users, so that workers run user code and pool their Scopes as them
+            std::vector<UserName> userNames;
+            State* const state; // the command's State, guarded by 'mutex'
+            const CollectionMetadataPtr collMetadata;
+            mongo::mutex mutex;
+            AtomicUInt32 stop; // non-zero once the workers should give up
+            AtomicInt64 numInputs; // documents mapped by all workers
+        };
+
+        /**
+         * Maps one partition of a collection scan on its own thread, with its own Scope and
+         * in-memory map.  Tuples are moved into the command's State whenever the worker's map
+         * is still larger than Config::maxInMemSize after an in-memory reduce, and once the
+         * partition is exhausted.  Map functions can't access the database in this mode.
+         *
+         * Workers are authenticated as the command's users rather than internally, which also
+         * keeps their Scopes in the same pool as the command's.
+         */
+        class ParallelMapWorker : boost::noncopyable {
+        public:
+            /**
+             * Takes ownership of 'exec', which must have been saved by the caller.  The caller
+             * must hold a lock on the collection.
+             */
+            ParallelMapWorker( ParallelMapShared* shared , PlanExecutor* exec )
+                : _shared( shared ),
+                  _config( shared->state->config() , shared->cmd ),
+                  _exec( exec ),
+                  _registration( new ScopedExecutorRegistration( exec ) ),
+                  _status( Status::OK() ),
+                  _numInputs( 0 ),
+                  _mapTime( 0 ),
+                  _mergeTime( 0 ) {
+            }
+
+            void start() {
+                _thread.reset( new boost::thread( stdx::bind( &ParallelMapWorker::run , this ) ) );
+            }
+
+            /**
+             * @return true if the worker has finished
+             */
+            bool timedJoin( int millis ) {
+                return !_thread || _thread->timed_join( boost::posix_time::milliseconds( millis ) );
+            }
+
+            void join() {
+                if ( _thread )
+                    _thread->join();
+            }
+
+            const Status& status() const { return _status; }
+            long long mapTimeMicros() const { return _mapTime; }
+
+            void appendStats( BSONObjBuilder& b ) const {
+                b.appendNumber( "input" , _numInputs );
+                b.appendNumber( "mapTime" , _mapTime / 1000 );
+                b.appendNumber( "mergeTime" , _mergeTime / 1000 );
+            }
+
+        private:
+            void run() {
+                Client::initThread( "mrParallelMap" );
+
+                try {
+                    _run();
+                }
+                catch ( const DBException& e ) {
+                    _status = e.toStatus();
+                }
+                catch ( const std::exception& e ) {
+                    _status = Status( ErrorCodes::InternalError , e.what() );
+                }
+
+                if ( !_status.isOK() ) {
+                    // no point in the other workers carrying on
+                    _shared->stop.store( 1 );
+                }
+
+                cc().shutdown();
+            }
+
+            void _run() {
+                OperationContextImpl txn;
+
+                AuthorizationSession* authSession = cc().getAuthorizationSession();
+                for ( size_t i = 0; i < _shared->userNames.size(); i++ )
+                    uassertStatusOK( authSession->addAndAuthorizeUser( &txn ,
+                                                                       _shared->userNames[i] ) );
+
+                State state( &txn , _config );
+                state.init();
+                Scope::NoDBAccess no =
+                        state.scope()->disableDBAccess( "can't access db from a parallel map" );
+
+                const CollectionMetadataPtr& collMetadata = _shared->collMetadata;
+                scoped_ptr<KeyPattern> kp;
+                if ( collMetadata )
+                    kp.reset( new KeyPattern( collMetadata->getKeyPattern() ) );
+
+                scoped_ptr<Lock::DBRead> lock( new Lock::DBRead( txn.lockState() , _config.ns ) );
+                scoped_ptr<Client::Context> ctx( new Client::Context( &txn , _config.ns , false ) );
+
+                if ( _exec->restoreState( &txn ) ) {
+                    Timer mt;
+                    BSONObj o;
+                    while ( !_shared->stop.load() &&
+                            PlanExecutor::ADVANCED == _exec->getNext( &o , NULL ) ) {
+                        // skip documents we don't own yet because of a chunk migration
+                        if ( collMetadata &&
+                                !collMetadata->keyBelongsToMe( kp->extractShardKeyFromDoc( o ) ) ) {
+                            continue;
+                        }
+
+                        mt.reset();
+                        _config.mapper->map( o );
+                        _mapTime += mt.micros();
+
+                        _numInputs++;
+                        _shared->numInputs.fetchAndAdd( 1 );
+
+                        if ( _numInputs % 100 == 0 ) {
+                            _exec->saveState();
+                            ctx.reset();
+                            lock.reset();
+
+                            _reduceAndMergeIfNeeded( &state , false );
+
+                            lock.reset( new Lock::DBRead( txn.lockState() , _config.ns ) );
+                            ctx.reset( new Client::Context( &txn , _config.ns , false ) );
+                            if ( !_exec->restoreState( &txn ) )
+                                break;
+                        }
+                    }
+                    _exec->saveState();
+                }
+
+                ctx.reset();
+                lock.reset();
+                _reduceAndMergeIfNeeded( &state , true );
+            }
+
+            /**
+             * Reduces the worker's in-memory map and moves it into the command's State if it
+             * is still too large, or if 'final' is set.  No db locks may be held.
+             */
+            void _reduceAndMergeIfNeeded( State* state , bool final ) {
+                // an in memory State never spills, this only reduces
+                state->reduceAndSpillInMemoryStateIfNeeded();
+                if ( !final && state->inMemSize() <= state->config().maxInMemSize )
+                    return;
+
+                Timer t;
+                scoped_lock lk( _shared->mutex );
+                _shared->state->absorbInMemoryState( state );
+                _mergeTime += t.micros();
+            }
+
+            ParallelMapShared* _shared;
+            Config _config; // copied from the command's, with the worker's own functions
+            scoped_ptr<PlanExecutor> _exec;
+            scoped_ptr<ScopedExecutorRegistration> _registration;
+            scoped_ptr<boost::thread> _thread;
+
+            Status _status;
+            long long _numInputs;
+            long long _mapTime; // micros
+            long long _mergeTime; // micros
+        };
+
+        /**
+         * Runs the map phase of a job over a collection scan split with
+         * Collection::getManyIterators(), using up to Config::mapThreads ParallelMapWorkers.
+         * The command's thread writes out whatever the workers hand over as it waits.
+         */
+        class ParallelMapPhase : boost::noncopyable {
+        public:
+            ParallelMapPhase( OperationContext* txn , const BSONObj& cmd , State* state ,
+                              const CollectionMetadataPtr& collMetadata )
+                : _txn( txn ),
+                  _shared( cmd , state , collMetadata ),
+                  _spillTime( 0 ) {
+            }
+
+            ~ParallelMapPhase() {
+                _shared.stop.store( 1 );
+                for ( size_t i = 0; i < _workers.size(); i++ )
+                    _workers[i]->join();
+
+                // executors have to be deregistered under the lock
+                Lock::DBRead lock( _txn->lockState() , _shared.state->config().ns );
+                _workers.clear();
+            }
+
+            /**
+             * Maps every document in the collection.
+             * @return the number of documents mapped
+             */
+            long long run( ProgressMeterHolder& pm ) {
+                const Config& config = _shared.state->config();
+
+                {
+                    Lock::DBRead lock( _txn->lockState() , config.ns );
+                    Client::Context ctx( _txn , config.ns , false );
+                    Collection* collection =
+                            _shared.state->getCollectionOrUassert( ctx.db() , config.ns );
+
+                    OwnedPointerVector<RecordIterator> iterators(
+                            collection->getManyIterators( _txn ) );
+                    const size_t numWorkers =
+                            std::min( iterators.size() , static_cast<size_t>( config.mapThreads ) );
+                    if ( numWorkers == 0 )
+                        return 0;
+
+                    OwnedPointerVector<PlanExecutor> execs;
+                    for ( size_t i = 0; i < numWorkers; i++ ) {
+                        WorkingSet* ws = new WorkingSet();
+                        MultiIteratorStage* mis = new MultiIteratorStage( _txn , ws , collection );
+                        // Takes ownership of 'ws' and 'mis'.
+                        execs.push_back( new PlanExecutor( ws , mis , collection ) );
+                    }
+
+                    // distribute the partitions round-robin, as parallelCollectionScan does
+                    for ( size_t i = 0; i < iterators.size(); i++ ) {
+                        PlanExecutor* exec = execs[i % execs.size()];
+                        MultiIteratorStage* mis =
+                                static_cast<MultiIteratorStage*>( exec->getRootStage() );
+                        mis->addIterator( iterators.releaseAt( i ) );
+                    }
+
+                    for ( size_t i = 0; i < execs.size(); i++ ) {
+                        execs[i]->saveState();
+                        _workers.push_back( new ParallelMapWorker( &_shared , execs.releaseAt( i ) ) );
+                    }
+                }
+
+                for ( size_t i = 0; i < _workers.size(); i++ )
+                    _workers[i]->start();
+
+                long long reported = 0;
+                size_t joined = 0;
+                while ( joined < _workers.size() ) {
+                    if ( _workers[joined]->timedJoin( 100 ) )
+                        joined++;
+
+                    const long long numInputs = _shared.numInputs.load();
+                    pm.hit( static_cast<int>( numInputs - reported ) );
+                    reported = numInputs;
+
+                    _txn->checkForInterrupt();
+
+                    // write out the tuples handed over so far if they got too large
+                    Timer t;
+                    {
+                        scoped_lock lk( _shared.mutex );
+                        _shared.state->reduceAndSpillInMemoryStateIfNeeded();
+                    }
+                    _spillTime += t.micros();
+                }
+
+                for ( size_t i = 0; i < _workers.size(); i++ )
+                    uassertStatusOK( _workers[i]->status() );
+
+                return reported;
+            }
+
+            long long mapTimeMicros() const {
+                long long total = 0;
+                for ( size_t i = 0; i < _workers.size(); i++ )
+                    total += _workers[i]->mapTimeMicros();
+                return total;
+            }
+
+            void appendStats( BSONObjBuilder& timing ) const {
+                BSONArrayBuilder workers( timing.subarrayStart( "mapWorkers" ) );
+                for ( size_t i = 0; i < _workers.size(); i++ ) {
+                    BSONObjBuilder w( workers.subobjStart() );
+                    _workers[i]->appendStats( w );
+                    w.done();
+                }
+                workers.done();
+                timing.appendNumber( "spillTime" , _spillTime / 1000 );
+            }
+
+        private:
+            OperationContext* _txn;
+            ParallelMapShared _shared;
+            OwnedPointerVector<ParallelMapWorker> _workers;
+            long long _spillTime; // micros
+        };
+
         /**
          * This class represents a map/reduce command executed on a single server
          */
@@ -1335,7 +1907,23 @@ namespace mongo {
                     long long mapTime = 0;
                     long long reduceTime = 0;
                     long long numInputs = 0;
-                    {
+
+                    // unfiltered jobs can split the map phase over several threads
+                    scoped_ptr<ParallelMapPhase> parallelMap;
+                    if ( config.mapThreads > 1 && config.filter.isEmpty() &&
+                            config.sort.isEmpty() && config.limit == 0 && !state.jsMode() ) {
+                        parallelMap.reset(
+                                new ParallelMapPhase( txn, cmd, &state, collMetadata ) );
+                    }
+
+                    if ( parallelMap ) {
+                        numInputs = parallelMap->run( pm );
+                        mapTime = parallelMap->mapTimeMicros();
+                        timingBuilder.append( "mapThreads" , config.mapThreads );
+                        parallelMap->appendStats( timingBuilder );
+                        parallelMap.reset();
+                    }
+                    else {
                         // We've got a cursor preventing migrations off, now re-establish our useful cursor
 
                         // Need lock and context to use it
@@ -1446,7 +2034,8 @@ namespace mongo {
                     reduceTime += rt.micros();
                     countsBuilder.appendNumber( "reduce" , state.numReduces() );
                     timingBuilder.appendNumber("reduceTime", reduceTime / 1000);
-                    timingBuilder.append( "mode" , state.jsMode() ? "js" : "mixed" );
+                    timingBuilder.append( "mode" , config.nativeMode ? "native" :
+                                                   state.jsMode() ? "js" : "mixed" );
 
                     long long finalCount = state.postProcessCollection(txn, op, pm);
                     state.appendResults( result );
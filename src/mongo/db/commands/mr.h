@@ -156,6 +156,72 @@ namespace mongo {
 
         };
 
+        // ------------  native function implementations -----------
+
+        /**
+         * Describes a map function of the form
+         *     function() { emit(this.<keyPath>, <value>); }
+         * where <value> is either a numeric literal or this.<valuePath>.
+         */
+        struct NativeMapSpec {
+            NativeMapSpec() : valueConstant(0) {}
+
+            std::vector<std::string> keyPath;
+            std::vector<std::string> valuePath; // empty if valueConstant is emitted
+            double valueConstant;
+        };
+
+        /**
+         * Recognizes map functions which can run without the js engine.
+         * @return false if the code doesn't have a shape described by NativeMapSpec
+         */
+        bool parseNativeMapFunction( const StringData& code , NativeMapSpec* out );
+
+        /**
+         * Recognizes reduce functions of the form
+         *     function(key, values) { return Array.sum(values); }
+         */
+        bool isNativeSumReduceFunction( const StringData& code );
+
+        /**
+         * Evaluates a NativeMapSpec directly against the BSON document, falling back to the
+         * js function for any document whose fields would not survive the round trip through
+         * the js engine unchanged.
+         */
+        class NativeMapper : public Mapper {
+        public:
+            NativeMapper( const NativeMapSpec& spec , const BSONElement& code )
+                : _spec( spec ), _fallback( code ) {}
+            virtual void map( const BSONObj& o );
+            virtual void init( State * state );
+
+        private:
+            NativeMapSpec _spec;
+            JSMapper _fallback;
+            State * _state;
+        };
+
+        /**
+         * Sums numeric values in C++, matching Array.sum() in the js engine.  Lists containing
+         * anything other than NumberInt or NumberDouble values are reduced by the js function.
+         */
+        class NativeSumReducer : public Reducer {
+        public:
+            NativeSumReducer( const BSONElement& code ) : _fallback( code ) {}
+            virtual void init( State * state ) { _fallback.init( state ); }
+
+            virtual BSONObj reduce( const BSONList& tuples );
+            virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
+
+        private:
+            /**
+             * @return false if the values can't be summed natively
+             */
+            bool _sum( const BSONList& tuples , double* out ) const;
+
+            JSReducer _fallback;
+        };
+
         // -----------------
 
 
@@ -176,12 +242,23 @@ namespace mongo {
         public:
             Config( const std::string& _dbname , const BSONObj& cmdObj );
 
+            /**
+             * Copies the options of 'other' for a parallel map worker, which only buffers in
+             * memory.  Only the functions are built again from 'cmdObj', since they get bound to
+             * the worker's own Scope.
+             */
+            Config( const Config& other , const BSONObj& cmdObj );
+
             std::string dbname;
             std::string ns;
 
             // options
             bool verbose;
             bool jsMode;
+            // true when both map and reduce run without the js engine
+            bool nativeMode;
+            // number of threads, each with its own scope, used for the map phase
+            int mapThreads;
             int splitInfo;
 
             // query options
@@ -231,6 +308,9 @@ namespace mongo {
             bool shardedFirstPass;
 
             static AtomicUInt32 JOB_NUMBER;
+
+        private:
+            void _initFunctions( const BSONObj& cmdObj );
         }; // end MRsetup
 
         /**
@@ -274,6 +354,12 @@ namespace mongo {
              */
             void reduceInMemory();
 
+            /**
+             * Moves the in-memory tuples, emit and reduce counts accumulated by another State,
+             * such as one owned by a parallel map worker, into this one.
+             */
+            void absorbInMemoryState( State* other );
+
             /**
              * transfers in memory storage to temp collection
              */
@@ -329,6 +415,7 @@ namespace mongo {
             long long numEmits() const { if (_jsMode) return _scope->getNumberLongLong("_emitCt"); return _numEmits; }
             long long numReduces() const { if (_jsMode) return _scope->getNumberLongLong("_redCt"); return _config.reducer->numReduces; }
             long long numInMemKeys() const { if (_jsMode) return _scope->getNumberLongLong("_keyCt"); return _temp->size(); }
+            long inMemSize() const { return _size; }
 
             bool jsMode() {return _jsMode;}
             void switchMode(bool jsMode);
@@ -28,6 +28,9 @@
 
 #include "mongo/db/commands/mr.h"
 
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -41,6 +44,242 @@
 namespace mongo {
 
     namespace mr {
+
+        namespace {
+
+            /**
+             * Splits js source into identifier, number, string and punctuation tokens.  String
+             * tokens keep their opening quote so they can't be mistaken for identifiers.
+             *
+             * Only the small subset of js needed to recognize native map/reduce shapes is
+             * understood; comments, escapes, operators and so on make tokenizing fail, which
+             * just means the function is left to the js engine.
+             */
+            bool tokenizeJS(const StringData& code, std::vector<std::string>* tokens) {
+                size_t i = 0;
+                while (i < code.size()) {
+                    const char c = code[i];
+                    if (isspace(static_cast<unsigned char>(c))) {
+                        i++;
+                    }
+                    else if (isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '$') {
+                        const size_t start = i;
+                        while (i < code.size() &&
+                               (isalnum(static_cast<unsigned char>(code[i])) ||
+                                code[i] == '_' || code[i] == '$')) {
+                            i++;
+                        }
+                        tokens->push_back(code.substr(start, i - start).toString());
+                    }
+                    else if (isdigit(static_cast<unsigned char>(c)) ||
+                             (c == '.' && i + 1 < code.size() &&
+                              isdigit(static_cast<unsigned char>(code[i + 1])))) {
+                        const size_t start = i;
+                        while (i < code.size() &&
+                               (isalnum(static_cast<unsigned char>(code[i])) ||
+                                code[i] == '.' ||
+                                ((code[i] == '+' || code[i] == '-') &&
+                                 (code[i - 1] == 'e' || code[i - 1] == 'E')))) {
+                            i++;
+                        }
+                        tokens->push_back(code.substr(start, i - start).toString());
+                    }
+                    else if (c == '"' || c == '\'') {
+                        const size_t start = ++i;
+                        while (i < code.size() && code[i] != c) {
+                            if (code[i] == '\\' || code[i] == '\n')
+                                return false;
+                            i++;
+                        }
+                        if (i == code.size())
+                            return false;
+                        tokens->push_back('"' + code.substr(start, i - start).toString());
+                        i++;
+                    }
+                    else if (strchr("(){}[].,;-", c)) {
+                        tokens->push_back(std::string(1, c));
+                        i++;
+                    }
+                    else {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /**
+             * Cursor over the output of tokenizeJS().
+             */
+            class JSTokenStream {
+            public:
+                explicit JSTokenStream(const std::vector<std::string>& tokens)
+                    : _tokens(tokens), _pos(0) {}
+
+                bool done() const { return _pos == _tokens.size(); }
+
+                bool peek(const char* token) const {
+                    return !done() && _tokens[_pos] == token;
+                }
+
+                bool accept(const char* token) {
+                    if (!peek(token))
+                        return false;
+                    _pos++;
+                    return true;
+                }
+
+                bool acceptIdentifier(std::string* out) {
+                    if (done())
+                        return false;
+                    const std::string& t = _tokens[_pos];
+                    if (!(isalpha(static_cast<unsigned char>(t[0])) || t[0] == '_' || t[0] == '$'))
+                        return false;
+                    *out = t;
+                    _pos++;
+                    return true;
+                }
+
+                bool acceptString(std::string* out) {
+                    if (done() || _tokens[_pos][0] != '"')
+                        return false;
+                    *out = _tokens[_pos].substr(1);
+                    _pos++;
+                    return true;
+                }
+
+                /**
+                 * Accepts a decimal literal, optionally negated.  Literals with a leading zero
+                 * are rejected since js may treat them as octal.
+                 */
+                bool acceptNumber(double* out) {
+                    const size_t start = _pos;
+                    const bool negate = accept("-");
+                    if (done()) {
+                        _pos = start;
+                        return false;
+                    }
+                    const std::string& t = _tokens[_pos];
+                    if (!(isdigit(static_cast<unsigned char>(t[0])) || t[0] == '.') ||
+                        (t.size() > 1 && t[0] == '0' && isdigit(static_cast<unsigned char>(t[1])))) {
+                        _pos = start;
+                        return false;
+                    }
+                    char* end;
+                    const double d = strtod(t.c_str(), &end);
+                    if (*end != '\0') {
+                        _pos = start;
+                        return false;
+                    }
+                    *out = negate ? -d : d;
+                    _pos++;
+                    return true;
+                }
+
+                /**
+                 * Accepts 'this' followed by one or more .field or ["field"] accessors.
+                 */
+                bool acceptThisPath(std::vector<std::string>* path) {
+                    if (!accept("this"))
+                        return false;
+                    path->clear();
+                    while (true) {
+                        std::string field;
+                        if (accept(".")) {
+                            if (!acceptIdentifier(&field))
+                                return false;
+                        }
+                        else if (accept("[")) {
+                            if (!acceptString(&field) || !accept("]"))
+                                return false;
+                        }
+                        else {
+                            break;
+                        }
+                        path->push_back(field);
+                    }
+                    return !path->empty();
+                }
+
+                /**
+                 * Accepts 'function [name](' and returns the name, which may be empty.
+                 */
+                bool acceptFunctionStart(std::string* name) {
+                    if (!accept("function"))
+                        return false;
+                    name->clear();
+                    if (!peek("("))
+                        acceptIdentifier(name);
+                    return accept("(");
+                }
+
+                /**
+                 * Accepts the closing of a function body with an optional semicolon before and
+                 * after the brace, and requires that nothing follows.
+                 */
+                bool acceptFunctionEnd() {
+                    accept(";");
+                    if (!accept("}"))
+                        return false;
+                    accept(";");
+                    return done();
+                }
+
+            private:
+                const std::vector<std::string>& _tokens;
+                size_t _pos;
+            };
+
+        } // namespace
+
+        bool parseNativeMapFunction(const StringData& code, NativeMapSpec* out) {
+            std::vector<std::string> tokens;
+            if (!tokenizeJS(code, &tokens))
+                return false;
+
+            JSTokenStream ts(tokens);
+            std::string name;
+            if (!ts.acceptFunctionStart(&name) || name == "emit")
+                return false;
+            if (!ts.accept(")") || !ts.accept("{"))
+                return false;
+
+            NativeMapSpec spec;
+            if (!ts.accept("emit") || !ts.accept("("))
+                return false;
+            if (!ts.acceptThisPath(&spec.keyPath) || !ts.accept(","))
+                return false;
+            if (!ts.acceptNumber(&spec.valueConstant) && !ts.acceptThisPath(&spec.valuePath))
+                return false;
+            if (!ts.accept(")") || !ts.acceptFunctionEnd())
+                return false;
+
+            *out = spec;
+            return true;
+        }
+
+        bool isNativeSumReduceFunction(const StringData& code) {
+            std::vector<std::string> tokens;
+            if (!tokenizeJS(code, &tokens))
+                return false;
+
+            JSTokenStream ts(tokens);
+            std::string name;
+            std::string keyArg;
+            std::string valuesArg;
+            std::string summed;
+            if (!ts.acceptFunctionStart(&name) || name == "Array")
+                return false;
+            if (!ts.acceptIdentifier(&keyArg) || !ts.accept(",") ||
+                !ts.acceptIdentifier(&valuesArg) || !ts.accept(")") || !ts.accept("{"))
+                return false;
+            if (keyArg == "Array" || valuesArg == "Array" || keyArg == valuesArg)
+                return false;
+            if (!ts.accept("return") || !ts.accept("Array") || !ts.accept(".") ||
+                !ts.accept("sum") || !ts.accept("(") || !ts.acceptIdentifier(&summed) ||
+                !ts.accept(")"))
+                return false;
+            return summed == valuesArg && ts.acceptFunctionEnd();
+        }
         Config::OutputOptions Config::parseOutputOptions(const std::string& dbname,
                                                          const BSONObj& cmdObj) {
             Config::OutputOptions outputOptions;
@@ -158,4 +158,63 @@ namespace {
                                       "mydb2", "", "", false, mr::Config::INMEMORY);
     }
 
+    /**
+     * Tests for recognizing map/reduce functions that run without the js engine
+     */
+
+    TEST(NativeMapFunctionTest, ConstantValue) {
+        mr::NativeMapSpec spec;
+        ASSERT_TRUE(mr::parseNativeMapFunction("function() { emit(this.a, 1); }", &spec));
+        ASSERT_EQUALS(1U, spec.keyPath.size());
+        ASSERT_EQUALS("a", spec.keyPath[0]);
+        ASSERT_TRUE(spec.valuePath.empty());
+        ASSERT_EQUALS(1.0, spec.valueConstant);
+
+        ASSERT_TRUE(mr::parseNativeMapFunction("function m(){emit(this.a,-2.5)};", &spec));
+        ASSERT_EQUALS(-2.5, spec.valueConstant);
+    }
+
+    TEST(NativeMapFunctionTest, FieldValue) {
+        mr::NativeMapSpec spec;
+        ASSERT_TRUE(mr::parseNativeMapFunction(
+                "function() {\n    emit(this.a.b, this[\"c d\"])\n}\n", &spec));
+        ASSERT_EQUALS(2U, spec.keyPath.size());
+        ASSERT_EQUALS("a", spec.keyPath[0]);
+        ASSERT_EQUALS("b", spec.keyPath[1]);
+        ASSERT_EQUALS(1U, spec.valuePath.size());
+        ASSERT_EQUALS("c d", spec.valuePath[0]);
+    }
+
+    TEST(NativeMapFunctionTest, Unsupported) {
+        mr::NativeMapSpec spec;
+        // comments, multiple statements and expressions are left to the js engine
+        ASSERT_FALSE(mr::parseNativeMapFunction("// c\nfunction() { emit(this.a, 1); }", &spec));
+        ASSERT_FALSE(mr::parseNativeMapFunction("function() { emit(this.a, 1); emit(this.b, 1); }",
+                                                &spec));
+        ASSERT_FALSE(mr::parseNativeMapFunction("function() { emit(this.a, this.b * 2); }", &spec));
+        ASSERT_FALSE(mr::parseNativeMapFunction("function() { emit(this, 1); }", &spec));
+        ASSERT_FALSE(mr::parseNativeMapFunction("function(x) { emit(this.a, 1); }", &spec));
+        ASSERT_FALSE(mr::parseNativeMapFunction("function() { emit(this.a, 010); }", &spec));
+        ASSERT_FALSE(mr::parseNativeMapFunction("function emit() { emit(this.a, 1); }", &spec));
+        ASSERT_FALSE(mr::parseNativeMapFunction("function() { emit(this[\"a\\\"\"], 1); }",
+                                                &spec));
+        ASSERT_FALSE(mr::parseNativeMapFunction("emit(this.a, 1)", &spec));
+    }
+
+    TEST(NativeReduceFunctionTest, ArraySum) {
+        ASSERT_TRUE(mr::isNativeSumReduceFunction(
+                "function(key, values) { return Array.sum(values); }"));
+        ASSERT_TRUE(mr::isNativeSumReduceFunction(
+                "function r(k,v){\n    return Array.sum(v)\n}"));
+
+        ASSERT_FALSE(mr::isNativeSumReduceFunction(
+                "function(key, values) { return Array.sum(key); }"));
+        ASSERT_FALSE(mr::isNativeSumReduceFunction(
+                "function(Array, values) { return Array.sum(values); }"));
+        ASSERT_FALSE(mr::isNativeSumReduceFunction(
+                "function(key, values) { return Array.avg(values); }"));
+        ASSERT_FALSE(mr::isNativeSumReduceFunction(
+                "function(key, values) { return values.length; }"));
+    }
+
 }  // namespace
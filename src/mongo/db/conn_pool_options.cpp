@@ -31,12 +31,14 @@
 #include "mongo/base/init.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/client/connpool.h"
+#include "mongo/client/multiplexed_connection.h"
 #include "mongo/s/shard.h"
 
 namespace mongo {
 
     int ConnPoolOptions::maxConnsPerHost(200);
     int ConnPoolOptions::maxShardedConnsPerHost(200);
+    int ConnPoolOptions::multiplexedConnsPerHost(0);
 
     namespace {
 
@@ -54,6 +56,13 @@ namespace mongo {
                                         true,
                                         false /* can't change at runtime */);
 
+        ExportedServerParameter<int> //
+        multiplexedConnsPerHostParameter(ServerParameterSet::getGlobal(),
+                                         "connPoolMultiplexedConnsPerHost",
+                                         &ConnPoolOptions::multiplexedConnsPerHost,
+                                         true,
+                                         false /* can't change at runtime */);
+
         MONGO_INITIALIZER(InitializeConnectionPools)(InitializerContext* context) {
 
             // Initialize the sharded and unsharded outgoing connection pools
@@ -68,6 +77,8 @@ namespace mongo {
             shardConnectionPool.setName("sharded connection pool");
             shardConnectionPool.setMaxPoolSize(ConnPoolOptions::maxShardedConnsPerHost);
 
+            multiplexedPool.setConnectionsPerHost(ConnPoolOptions::multiplexedConnsPerHost);
+
             return Status::OK();
         }
     }
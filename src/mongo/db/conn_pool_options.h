@@ -49,6 +49,12 @@ namespace mongo {
          * Maximum connections per host the sharded conn pool should use
          */
         static int maxShardedConnsPerHost;
+
+        /**
+         * Connections per host shared by all threads for reading attached cursors, 0 to give
+         * each getMore a connection of its own from the regular pool
+         */
+        static int multiplexedConnsPerHost;
     };
 
 }
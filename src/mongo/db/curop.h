@@ -302,12 +302,15 @@ namespace mongo {
                                   unsigned long long progressMeterTotal = 0,
                                   int secondsBetween = 3);
         std::string getMessage() const { return _message.toString(); }
+        /** changes the message without resetting the progress meter started with it */
+        void updateMessage(const std::string& msg) { _message = msg; }
         ProgressMeter& getProgressMeter() { return _progressMeter; }
         CurOp *parent() const { return _wrapped; }
         void kill(); 
         bool killPendingStrict() const { return _killPending.load(); }
         bool killPending() const { return _killPending.loadRelaxed(); }
         int numYields() const { return _numYields; }
+        void yielded() { _numYields++; }
         void suppressFromCurop() { _suppressFromCurop = true; }
         
         long long getExpectedLatencyMs() const { return _expectedLatencyMs; }
@@ -262,6 +262,11 @@ namespace mongo {
             return;
         }
 
+        if (_indexCursor->restoredInPlace()) {
+            ++_specificStats.yieldRestoredInPlace;
+            return;
+        }
+
         if (!_savedKey.binaryEqual(_indexCursor->getKey())
             || _savedLoc != _indexCursor->getValue()) {
             // Our restored position isn't the same as the saved position.  When we call work()
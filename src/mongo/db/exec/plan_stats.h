@@ -380,6 +380,7 @@ namespace mongo {
     struct IndexScanStats : public SpecificStats {
         IndexScanStats() : isMultiKey(false),
                            yieldMovedCursor(0),
+                           yieldRestoredInPlace(0),
                            dupsTested(0),
                            dupsDropped(0),
                            seenInvalidated(0),
@@ -419,6 +420,11 @@ namespace mongo {
         bool isMultiKey;
 
         size_t yieldMovedCursor;
+
+        // How many restores after a yield found the cursor's position unchanged without
+        // searching the index, out of the stage's unyields.
+        size_t yieldRestoredInPlace;
+
         size_t dupsTested;
         size_t dupsDropped;
 
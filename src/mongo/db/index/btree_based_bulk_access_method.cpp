@@ -53,13 +53,13 @@ namespace mongo {
         BtreeExternalSortComparison(const BSONObj& ordering, int version)
             : _ordering(Ordering::make(ordering)),
               _version(version) {
-            invariant(version == 1 || version == 0);
+            invariant(version >= 0 && version <= 2);
         }
 
         typedef std::pair<BSONObj, DiskLoc> Data;
 
         int operator() (const Data& l, const Data& r) const {
-            int x = (_version == 1
+            int x = (_version >= 1
                         ? l.first.woCompare(r.first, _ordering, /*considerfieldname*/false)
                         : oldCompare(l.first, r.first, _ordering));
             if (x) { return x; }
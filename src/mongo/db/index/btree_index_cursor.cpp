@@ -133,6 +133,10 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool BtreeIndexCursor::restoredInPlace() const {
+        return _cursor->restoredInPlace();
+    }
+
     string BtreeIndexCursor::toString() {
         // TODO: is this ever called?
         return "I AM A BTREE INDEX CURSOR!\n";
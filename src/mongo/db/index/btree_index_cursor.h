@@ -85,6 +85,8 @@ namespace mongo {
 
         virtual Status restorePosition(OperationContext* txn);
 
+        virtual bool restoredInPlace() const;
+
         virtual std::string toString();
 
     private:
@@ -113,6 +113,12 @@ namespace mongo {
          */
         virtual Status restorePosition(OperationContext* txn) = 0;
 
+        /**
+         * Returns true if the last restorePosition() could keep the position without searching
+         * the index for it again.
+         */
+        virtual bool restoredInPlace() const { return false; }
+
         // Return a std::string describing the cursor.
         virtual std::string toString() = 0;
 
@@ -124,7 +124,9 @@ namespace mongo {
 
     bool WhereMatchExpression::matches( const MatchableDocument* doc, MatchDetails* details ) const {
         verify( _func );
-        BSONObj obj = doc->toBSON();
+        // Both "obj" and "this" wrap the document; make it owned once so that they share a
+        // buffer rather than each copying it.
+        BSONObj obj = doc->toBSON().getOwned();
 
         if ( ! _userScope.isEmpty() ) {
             _scope->init( &_userScope );
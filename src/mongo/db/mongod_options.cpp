@@ -195,6 +195,11 @@ namespace mongo {
                 "disable data file preallocation - will often hurt performance")
                                          .setSources(moe::SourceYAMLConfig);
 
+        general_options.addOptionChaining("storage.preallocDataFilesAhead",
+                "preallocDataFilesAhead", moe::Int,
+                "number of data files per database to allocate ahead of need")
+                                         .setDefault(moe::Value(1));
+
         general_options.addOptionChaining("storage.nsSize", "nssize", moe::Int,
                 ".ns file size (in MB) for new databases")
                                          .setDefault(moe::Value(16));
@@ -209,6 +214,12 @@ namespace mongo {
         general_options.addOptionChaining("storage.smallFiles", "smallfiles", moe::Switch,
                 "use a smaller default file size");
 
+        general_options.addOptionChaining("storage.numaInterleave", "numaInterleave",
+                moe::Switch, "interleave data file memory across all NUMA nodes");
+
+        general_options.addOptionChaining("storage.hugePages", "hugePages", moe::Switch,
+                "request transparent huge pages for data file mappings");
+
         general_options.addOptionChaining("storage.syncPeriodSecs", "syncdelay", moe::Double,
                 "seconds between disk syncs (0=never, but not recommended)")
                                          .setDefault(moe::Value(60.0));
@@ -279,6 +290,9 @@ namespace mongo {
         general_options.addOptionChaining("storage.journal.commitIntervalMs",
                 "journalCommitInterval", moe::Unsigned, "how often to group/batch commit (ms)");
 
+        general_options.addOptionChaining("storage.journal.numaNode", "journalNumaNode",
+                moe::Int, "NUMA node for the journal thread and the private views it writes");
+
         // Deprecated option that we don't want people to use for performance reasons
         options->addOptionChaining("nopreallocj", "nopreallocj", moe::Switch,
                 "don't preallocate journal files")
@@ -913,6 +927,13 @@ namespace mongo {
             storageGlobalParams.syncdelay = params["storage.syncPeriodSecs"].as<double>();
         }
 
+        if (params.count("storage.numaInterleave")) {
+            storageGlobalParams.numaInterleave = params["storage.numaInterleave"].as<bool>();
+        }
+        if (params.count("storage.hugePages")) {
+            storageGlobalParams.hugePages = params["storage.hugePages"].as<bool>();
+        }
+
         if (params.count("storage.directoryPerDB")) {
             storageGlobalParams.directoryperdb = params["storage.directoryPerDB"].as<bool>();
         }
@@ -951,6 +972,12 @@ namespace mongo {
                               "--journalCommitInterval out of allowed range (0-300ms)");
             }
         }
+        if (params.count("storage.journal.numaNode")) {
+            storageGlobalParams.journalNumaNode = params["storage.journal.numaNode"].as<int>();
+            if (storageGlobalParams.journalNumaNode < 0) {
+                return Status(ErrorCodes::BadValue, "--journalNumaNode must not be negative");
+            }
+        }
         if (params.count("storage.journal.debugFlags")) {
             storageGlobalParams.durOptions = params["storage.journal.debugFlags"].as<int>();
         }
@@ -971,6 +998,15 @@ namespace mongo {
             storageGlobalParams.prealloc = params["storage.preallocDataFiles"].as<bool>();
             cout << "note: noprealloc may hurt performance in many applications" << endl;
         }
+        if (params.count("storage.preallocDataFilesAhead")) {
+            storageGlobalParams.preallocFilesAhead =
+                params["storage.preallocDataFilesAhead"].as<int>();
+            if (storageGlobalParams.preallocFilesAhead < 0 ||
+                storageGlobalParams.preallocFilesAhead > 16) {
+                return Status(ErrorCodes::BadValue,
+                              "--preallocDataFilesAhead must be between 0 and 16");
+            }
+        }
         if (params.count("storage.smallFiles")) {
             storageGlobalParams.smallfiles = params["storage.smallFiles"].as<bool>();
         }
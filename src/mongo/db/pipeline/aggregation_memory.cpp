@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/aggregation_memory.h"
+
+#include <algorithm>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    // Limits on memory held by aggregation stages. 0 means unlimited.
+    MONGO_EXPORT_SERVER_PARAMETER(internalAggregationMemoryPoolBytes, long long, 0);
+    MONGO_EXPORT_SERVER_PARAMETER(internalAggregationPipelineMemoryBytes, long long, 0);
+
+namespace {
+
+    // Pipelines reserve from the server-wide pool in chunks of this size so that the shared
+    // counter is not touched for every document.
+    const long long kReservationChunkBytes = 1024 * 1024;
+
+    // A stage is not asked to release memory because of the shared budget while it holds less
+    // than this, so that pressure from other pipelines cannot turn a spilling stage into one
+    // tiny file per document.
+    const long long kMinStageBytes = 10 * 1024 * 1024;
+
+    AtomicInt64 poolReservedBytes;
+    Counter64 budgetExceededCounter;
+    Counter64 spillCounter;
+
+    class PoolReservedBytesMetric : public ServerStatusMetric {
+    public:
+        PoolReservedBytesMetric() : ServerStatusMetric("aggregation.memory.reservedBytes") {}
+
+        virtual void appendAtLeaf(BSONObjBuilder& b) const {
+            b.append(_leafName, poolReservedBytes.load());
+        }
+    } poolReservedBytesMetric;
+
+    ServerStatusMetricField<Counter64> displayBudgetExceeded("aggregation.memory.budgetExceeded",
+                                                             &budgetExceededCounter);
+    ServerStatusMetricField<Counter64> displaySpills("aggregation.memory.spills",
+                                                     &spillCounter);
+
+} // namespace
+
+    PipelineMemoryBudget::PipelineMemoryBudget()
+        : _maxBytes(internalAggregationPipelineMemoryBytes)
+        , _usedBytes(0)
+        , _peakBytes(0)
+        , _reservedBytes(0)
+        , _poolExhausted(false)
+    {}
+
+    PipelineMemoryBudget::~PipelineMemoryBudget() {
+        if (_reservedBytes)
+            poolReservedBytes.subtractAndFetch(_reservedBytes);
+    }
+
+    bool PipelineMemoryBudget::adjust(long long delta) {
+        _usedBytes += delta;
+        _peakBytes = std::max(_peakBytes, _usedBytes);
+
+        // Grow the reservation as soon as usage passes it, but only shrink it once usage has
+        // dropped well below so that a stage hovering at a chunk boundary doesn't thrash.
+        if (_usedBytes > _reservedBytes
+                || _usedBytes + 2 * kReservationChunkBytes < _reservedBytes) {
+            const long long wanted = std::max(0LL, (_usedBytes + kReservationChunkBytes - 1)
+                                                   / kReservationChunkBytes
+                                                   * kReservationChunkBytes);
+            const long long poolBytes = poolReservedBytes.addAndFetch(wanted - _reservedBytes);
+            _reservedBytes = wanted;
+
+            const long long poolLimit = internalAggregationMemoryPoolBytes;
+            _poolExhausted = poolLimit > 0 && poolBytes > poolLimit;
+        }
+
+        return !_poolExhausted && !(_maxBytes > 0 && _usedBytes > _maxBytes);
+    }
+
+    long long PipelineMemoryBudget::headroomBytes() const {
+        long long headroom = -1;
+
+        if (_maxBytes > 0)
+            headroom = std::max(0LL, _maxBytes - _usedBytes);
+
+        const long long poolLimit = internalAggregationMemoryPoolBytes;
+        if (poolLimit > 0) {
+            const long long poolHeadroom = std::max(0LL, poolLimit - poolReservedBytes.load());
+            headroom = headroom < 0 ? poolHeadroom : std::min(headroom, poolHeadroom);
+        }
+
+        return headroom;
+    }
+
+    StageMemoryTracker::StageMemoryTracker(PipelineMemoryBudget* budget, long long maxBytes)
+        : _budget(budget)
+        , _maxBytes(maxBytes)
+        , _currentBytes(0)
+        , _peakBytes(0)
+        , _spills(0)
+        , _overBudget(false)
+    {}
+
+    StageMemoryTracker::~StageMemoryTracker() {
+        if (_currentBytes)
+            _budget->adjust(-_currentBytes);
+    }
+
+    bool StageMemoryTracker::set(long long bytes) {
+        const bool withinBudget = _budget->adjust(bytes - _currentBytes);
+        _currentBytes = bytes;
+        _peakBytes = std::max(_peakBytes, bytes);
+
+        if (bytes > _maxBytes)
+            return false;
+
+        const bool overBudget = !withinBudget && bytes > kMinStageBytes;
+        if (overBudget && !_overBudget)
+            budgetExceededCounter.increment();
+        _overBudget = overBudget;
+        return !overBudget;
+    }
+
+    long long StageMemoryTracker::allowanceBytes() const {
+        const long long headroom = _budget->headroomBytes();
+        if (headroom < 0)
+            return _maxBytes;
+
+        return std::min(_maxBytes, std::max(kMinStageBytes, _currentBytes + headroom));
+    }
+
+    void StageMemoryTracker::noteSpill() {
+        _spills++;
+        spillCounter.increment();
+    }
+
+    Document StageMemoryTracker::serialize() const {
+        return DOC("limitBytes" << _maxBytes
+                << "peakBytes" << _peakBytes
+                << "spills" << _spills);
+    }
+
+} // namespace mongo
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/pipeline/document.h"
+
+namespace mongo {
+
+    /**
+     * Memory accounting shared by all stages of one pipeline, held by its ExpressionContext.
+     *
+     * Usage is charged to the pipeline and to a server-wide pool, so that concurrent pipelines
+     * together stay within internalAggregationMemoryPoolBytes.  The budget never refuses memory
+     * that a stage already holds; it only reports that a limit has been passed so the stage can
+     * spill (or fail if it cannot).  Not thread safe, like the rest of a pipeline.
+     */
+    class PipelineMemoryBudget {
+        MONGO_DISALLOW_COPYING(PipelineMemoryBudget);
+    public:
+        PipelineMemoryBudget();
+        ~PipelineMemoryBudget();
+
+        /**
+         * Adds delta bytes (which may be negative) to this pipeline's usage.
+         * Returns false if the pipeline or the server-wide pool is now over its limit.
+         */
+        bool adjust(long long delta);
+
+        /** Bytes that can still be added before a limit is passed, or -1 if unlimited. */
+        long long headroomBytes() const;
+
+        long long usedBytes() const { return _usedBytes; }
+        long long peakBytes() const { return _peakBytes; }
+
+    private:
+        const long long _maxBytes; // 0 means unlimited
+        long long _usedBytes;
+        long long _peakBytes;
+        long long _reservedBytes; // charged to the server-wide pool, a multiple of the chunk size
+        bool _poolExhausted;
+    };
+
+    /**
+     * Tracks the memory held by one stage against both the stage's own limit and its pipeline's
+     * budget, and keeps the peak for explain.  Returns everything it holds on destruction.
+     */
+    class StageMemoryTracker {
+        MONGO_DISALLOW_COPYING(StageMemoryTracker);
+    public:
+        StageMemoryTracker(PipelineMemoryBudget* budget, long long maxBytes);
+        ~StageMemoryTracker();
+
+        /**
+         * Records that the stage now holds 'bytes'.  Returns false if the stage should release
+         * memory: either it is over its own limit (see overStageLimit()) or the shared budget is
+         * exhausted and the stage holds more than a small minimum.
+         */
+        bool set(long long bytes);
+
+        /** True if the last set() was over the stage's own limit. */
+        bool overStageLimit() const { return _currentBytes > _maxBytes; }
+
+        /** Largest amount the stage should plan to hold given the current shared budget. */
+        long long allowanceBytes() const;
+
+        void noteSpill();
+
+        long long maxBytes() const { return _maxBytes; }
+        long long peakBytes() const { return _peakBytes; }
+
+        /** {limitBytes, peakBytes, spills} for explain output. */
+        Document serialize() const;
+
+    private:
+        PipelineMemoryBudget* const _budget;
+        const long long _maxBytes;
+        long long _currentBytes;
+        long long _peakBytes;
+        int _spills;
+        bool _overBudget;
+    };
+
+} // namespace mongo
@@ -418,6 +418,7 @@ namespace mongo {
         boost::optional<ParsedDeps> _dependencies;
         intrusive_ptr<DocumentSourceLimit> _limit;
         long long _docsAddedToBatches; // for _limit enforcement
+        StageMemoryTracker _batchMemory;
 
         const std::string _ns;
         boost::shared_ptr<PlanExecutor> _exec; // PipelineProxyStage holds a weak_ptr to this.
@@ -545,7 +546,7 @@ namespace mongo {
         bool _doingMerge;
         bool _spilled;
         const bool _extSortAllowed;
-        const int _maxMemoryUsageBytes;
+        StageMemoryTracker _memory;
         boost::scoped_ptr<Variables> _variables;
         std::vector<std::string> _idFieldNames; // used when id is a document
         std::vector<intrusive_ptr<Expression> > _idExpressions;
@@ -897,6 +898,8 @@ namespace mongo {
 
         intrusive_ptr<DocumentSourceLimit> limitSrc;
 
+        StageMemoryTracker _memory;
+
         bool _done;
         bool _mergingPresorted;
         scoped_ptr<MySorter::Iterator> _output;
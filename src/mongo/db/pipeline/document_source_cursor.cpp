@@ -69,6 +69,7 @@ namespace mongo {
         // will be called when an agg cursor is killed which would cause a deadlock.
         _exec.reset();
         _currentBatch.clear();
+        _batchMemory.set(0);
     }
 
     void DocumentSourceCursor::loadBatch() {
@@ -84,6 +85,9 @@ namespace mongo {
 
         _exec->restoreState(pExpCtx->opCtx);
 
+        // The previous batch has been consumed.
+        _batchMemory.set(0);
+
         int memUsageBytes = 0;
         BSONObj obj;
         PlanExecutor::ExecState state;
@@ -104,7 +108,7 @@ namespace mongo {
 
             memUsageBytes += _currentBatch.back().getApproximateSize();
 
-            if (memUsageBytes > MaxBytesToReturnToClientAtOnce) {
+            if (!_batchMemory.set(memUsageBytes)) {
                 // End this batch and prepare PlanExecutor for yielding.
                 _exec->saveState();
                 return;
@@ -194,7 +198,8 @@ namespace mongo {
             out["planError"] = Value(explainStatus.toString());
         }
 
-        return Value(DOC(getSourceName() << out.freezeToValue()));
+        return Value(DOC(getSourceName() << out.freezeToValue()
+                         << "memory" << _batchMemory.serialize()));
     }
 
     DocumentSourceCursor::DocumentSourceCursor(const string& ns,
@@ -202,6 +207,7 @@ namespace mongo {
                                                const intrusive_ptr<ExpressionContext> &pCtx)
         : DocumentSource(pCtx)
         , _docsAddedToBatches(0)
+        , _batchMemory(&pCtx->memoryBudget, MaxBytesToReturnToClientAtOnce)
         , _ns(ns)
         , _exec(exec)
     {}
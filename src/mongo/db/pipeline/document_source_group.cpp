@@ -113,6 +113,7 @@ namespace mongo {
         // free our resources
         GroupsMap().swap(groups);
         _sorterIterator.reset();
+        _memory.set(0);
 
         // make us look done
         groupsIterator = groups.end();
@@ -167,6 +168,13 @@ namespace mongo {
             insides["$doingMerge"] = Value(true);
         }
 
+        if (explain) {
+            // next to the spec rather than in it, where it could shadow an output field; the
+            // other stages report theirs at the same level
+            return Value(DOC(getSourceName() << insides.freeze()
+                             << "memory" << _memory.serialize()));
+        }
+
         return Value(DOC(getSourceName() << insides.freeze()));
     }
 
@@ -198,7 +206,7 @@ namespace mongo {
         , _doingMerge(false)
         , _spilled(false)
         , _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter)
-        , _maxMemoryUsageBytes(100*1024*1024)
+        , _memory(&pExpCtx->memoryBudget, 100*1024*1024)
     {}
 
     void DocumentSourceGroup::addAccumulator(
@@ -357,9 +365,12 @@ namespace mongo {
 
         // This loop consumes all input from pSource and buckets it based on pIdExpression.
         while (boost::optional<Document> input = pSource->getNext()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
+            if (!_memory.set(memoryUsageBytes)) {
                 uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
                                " Pass allowDiskUse:true to opt in.",
+                        _extSortAllowed || !_memory.overStageLimit());
+                uassert(18913, "Exceeded aggregation memory budget for $group, but didn't allow"
+                               " external sort. Pass allowDiskUse:true to opt in.",
                         _extSortAllowed);
                 sortedFiles.push_back(spill());
                 memoryUsageBytes = 0;
@@ -419,6 +430,8 @@ namespace mongo {
             }
         }
 
+        _memory.set(memoryUsageBytes);
+
         // These blocks do any final steps necessary to prepare to output results.
         if (!sortedFiles.empty()) {
             _spilled = true;
@@ -492,6 +505,8 @@ namespace mongo {
         }
 
         groups.clear();
+        _memory.set(0);
+        _memory.noteSpill();
 
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
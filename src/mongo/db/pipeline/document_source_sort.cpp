@@ -60,7 +60,8 @@ namespace mongo {
             array.push_back(Value(DOC(getSourceName() <<
                 DOC("sortKey" << serializeSortKey(explain)
                  << "mergePresorted" << (_mergingPresorted ? Value(true) : Value())
-                 << "limit" << (limitSrc ? Value(limitSrc->getLimit()) : Value())))));
+                 << "limit" << (limitSrc ? Value(limitSrc->getLimit()) : Value()))
+                << "memory" << _memory.serialize())));
         }
         else { // one Value for $sort and maybe a Value for $limit
             MutableDocument inner (serializeSortKey(explain));
@@ -76,12 +77,14 @@ namespace mongo {
 
     void DocumentSourceSort::dispose() {
         _output.reset();
+        _memory.set(0);
         pSource->dispose();
     }
 
     DocumentSourceSort::DocumentSourceSort(const intrusive_ptr<ExpressionContext> &pExpCtx)
         : DocumentSource(pExpCtx)
         , populated(false)
+        , _memory(&pExpCtx->memoryBudget, 100*1024*1024)
         , _mergingPresorted(false)
     {}
 
@@ -208,10 +211,14 @@ namespace mongo {
         if (limitSrc)
             opts.limit = limitSrc->getLimit();
 
-        opts.maxMemoryUsageBytes = 100*1024*1024;
+        opts.maxMemoryUsageBytes = _memory.maxBytes();
         if (pExpCtx->extSortAllowed && !pExpCtx->inRouter) {
             opts.extSortAllowed = true;
             opts.tempDir = pExpCtx->tempDir;
+
+            // The sorter spills on its own once it reaches its limit, so size that limit to
+            // what the shared memory budget can currently give this stage.
+            opts.maxMemoryUsageBytes = _memory.allowanceBytes();
         }
 
         return opts;
@@ -229,10 +236,19 @@ namespace mongo {
                 msgasserted(17196, "can only mergePresorted from MergeCursors and CommandShards");
             }
         } else {
-            scoped_ptr<MySorter> sorter (MySorter::make(makeSortOptions(), Comparator(*this)));
+            const SortOptions opts = makeSortOptions();
+            scoped_ptr<MySorter> sorter (MySorter::make(opts, Comparator(*this)));
             while (boost::optional<Document> next = pSource->getNext()) {
                 sorter->add(extractKey(*next), *next);
+
+                if (!_memory.set(sorter->memUsed()) && !_memory.overStageLimit()) {
+                    uassert(18912, "Exceeded aggregation memory budget for $sort, but didn't"
+                                   " allow external sort. Pass allowDiskUse:true to opt in.",
+                            opts.extSortAllowed);
+                }
             }
+            for (int i = 0; i < sorter->numFiles(); i++)
+                _memory.noteSpill();
             _output.reset(sorter->done());
         }
         populated = true;
@@ -32,6 +32,7 @@
 
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/pipeline/aggregation_memory.h"
 #include "mongo/util/intrusive_counter.h"
 
 namespace mongo {
@@ -67,5 +68,8 @@ namespace mongo {
         OperationContext* opCtx;
         static const int interruptCheckPeriod = 128;
         int interruptCounter; // when 0, check interruptStatus
+
+        // Memory held by all stages of the pipeline; stages report to it via StageMemoryTracker.
+        PipelineMemoryBudget memoryBudget;
     };
 }
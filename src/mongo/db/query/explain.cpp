@@ -341,6 +341,8 @@ namespace mongo {
                 bob->appendNumber("dupsDropped", spec->dupsDropped);
                 bob->appendNumber("seenInvalidated", spec->seenInvalidated);
                 bob->appendNumber("matchTested", spec->matchTested);
+                bob->appendNumber("yieldMovedCursor", spec->yieldMovedCursor);
+                bob->appendNumber("yieldRestoredInPlace", spec->yieldRestoredInPlace);
             }
         }
         else if (STAGE_OR == stats.stageType) {
@@ -0,0 +1,47 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/scripting/engine.h"
+
+namespace mongo {
+
+    /**
+     * Compiled function cache counters, shown under metrics.scripting.functionCache.
+     * compileMicros is the total time spent compiling functions on a cache miss.
+     */
+    static ServerStatusMetricField<Counter64> displayFunctionCacheHits(
+            "scripting.functionCache.hits", &functionCacheStats.hits );
+    static ServerStatusMetricField<Counter64> displayFunctionCacheMisses(
+            "scripting.functionCache.misses", &functionCacheStats.misses );
+    static ServerStatusMetricField<Counter64> displayFunctionCacheEvictions(
+            "scripting.functionCache.evictions", &functionCacheStats.evictions );
+    static ServerStatusMetricField<Counter64> displayFunctionCacheCompileMicros(
+            "scripting.functionCache.compileMicros", &functionCacheStats.compileMicros );
+
+} // namespace mongo
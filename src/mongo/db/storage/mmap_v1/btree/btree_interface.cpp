@@ -125,7 +125,8 @@ namespace mongo {
                   _btree(btree),
                   _direction(direction),
                   _bucket(btree->getHead(txn)), // XXX this shouldn't be nessisary, but is.
-                  _ofs(0) {
+                  _ofs(0),
+                  _restoredInPlace(false) {
             }
 
             virtual int getDirection() const { return _direction; }
@@ -202,20 +203,25 @@ namespace mongo {
                 if (!_bucket.isNull()) {
                     _savedKey = getKey().getOwned();
                     _savedLoc = getDiskLoc();
+                    _btree->saveBucket(_txn, _bucket, &_savedBucket);
                 }
             }
 
             virtual void restorePosition(OperationContext* txn) {
+                _restoredInPlace = false;
                 if (!_bucket.isNull()) {
-                    _btree->restorePosition(_txn,
-                                            _savedKey,
-                                            _savedLoc,
-                                            _direction,
-                                            &_bucket,
-                                            &_ofs);
+                    _restoredInPlace = _btree->restorePosition(_txn,
+                                                               _savedKey,
+                                                               _savedLoc,
+                                                               _savedBucket,
+                                                               _direction,
+                                                               &_bucket,
+                                                               &_ofs);
                 }
             }
 
+            virtual bool restoredInPlace() const { return _restoredInPlace; }
+
         private:
             OperationContext* _txn; // not owned
             const BtreeLogic<OnDiskFormat>* const _btree;
@@ -227,6 +233,9 @@ namespace mongo {
             // Only used by save/restorePosition() if _bucket is non-Null.
             BSONObj _savedKey;
             DiskLoc _savedLoc;
+            SavedBucket _savedBucket;
+
+            bool _restoredInPlace;
         };
 
         virtual Cursor* newCursor(OperationContext* txn, int direction) const {
@@ -255,14 +264,21 @@ namespace mongo {
                                                          indexName,
                                                          bucketDeletion);
         }
-        else {
-            invariant(1 == version);
+        else if (1 == version) {
             return new BtreeInterfaceImpl<BtreeLayoutV1>(headManager,
                                                          recordStore,
                                                          ordering,
                                                          indexName,
                                                          bucketDeletion);
         }
+        else {
+            invariant(2 == version);
+            return new BtreeInterfaceImpl<BtreeLayoutV2>(headManager,
+                                                         recordStore,
+                                                         ordering,
+                                                         indexName,
+                                                         bucketDeletion);
+        }
     }
 
 }  // namespace mongo
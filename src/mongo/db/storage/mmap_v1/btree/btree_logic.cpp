@@ -36,11 +36,34 @@
 #include "mongo/db/storage/mmap_v1/btree/btree_logic.h"
 #include "mongo/db/storage/mmap_v1/btree/key.h"
 #include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
+    namespace {
+        const int kBucketVersionBits = 14;
+        AtomicUInt32 bucketVersions[1 << kBucketVersionBits];
+    }
+
+    // static
+    size_t BucketVersions::_slot(const void* bucket) {
+        // Buckets are kilobytes apart, multiply so that neighbors don't land on neighbors.
+        unsigned long long addr = reinterpret_cast<uintptr_t>(bucket) >> 4;
+        return (addr * 0x9E3779B97F4A7C15ULL) >> (64 - kBucketVersionBits);
+    }
+
+    // static
+    unsigned BucketVersions::get(const void* bucket) {
+        return bucketVersions[_slot(bucket)].load();
+    }
+
+    // static
+    void BucketVersions::bump(const void* bucket) {
+        bucketVersions[_slot(bucket)].fetchAndAdd(1);
+    }
+
     // BtreeLogic::Builder algorithm
     //
     // Phase 1:
@@ -88,7 +111,7 @@ namespace mongo {
 
     template <class BtreeLayout>
     Status BtreeLogic<BtreeLayout>::Builder::addKey(const BSONObj& keyObj, const DiskLoc& loc) {
-        auto_ptr<KeyDataOwnedType> key(new KeyDataOwnedType(keyObj));
+        auto_ptr<KeyDataOwnedType> key(new KeyDataOwnedType(keyObj, _logic->_ordering));
 
         if (key->dataSize() > BtreeLayout::KeyMax) {
             string msg = str::stream() << "Btree::insert: key too large to index, failing "
@@ -221,6 +244,7 @@ namespace mongo {
     template <class BtreeLayout>
     void BtreeLogic<BtreeLayout>::markUnused(BucketType* bucket, int keyPos) {
         invariant(keyPos >= 0 && keyPos < bucket->n);
+        BucketVersions::bump(bucket);
         getKeyHeader(bucket, keyPos).setUnused();
     }
 
@@ -233,6 +257,7 @@ namespace mongo {
     typename BtreeLogic<BtreeLayout>::BucketType*
     BtreeLogic<BtreeLayout>::btreemod(OperationContext* txn, BucketType* bucket) {
         txn->recoveryUnit()->writingPtr(bucket, BtreeLayout::BucketSize);
+        BucketVersions::bump(bucket);
         return bucket;
     }
 
@@ -264,6 +289,7 @@ namespace mongo {
 
     template <class BtreeLayout>
     void BtreeLogic<BtreeLayout>::init(BucketType* bucket) {
+        BucketVersions::bump(bucket);
         BtreeLayout::initBucket(bucket);
         bucket->parent.Null();
         bucket->nextChild.Null();
@@ -308,6 +334,7 @@ namespace mongo {
         invariant(childLocForPos(bucket, keypos).isNull());
         invariant((mayEmpty && bucket->n > 0) || bucket->n > 1 || bucket->nextChild.isNull());
 
+        BucketVersions::bump(bucket);
         bucket->emptySize += sizeof(KeyHeaderType);
         bucket->n--;
 
@@ -337,6 +364,7 @@ namespace mongo {
         massert(17435,  "n==0 in btree popBack()", bucket->n > 0 );
 
         invariant(getKeyHeader(bucket, bucket->n - 1).isUsed());
+        BucketVersions::bump(bucket);
 
         FullKey kn = getFullKey(bucket, bucket->n - 1);
         *recordLocOut = kn.recordLoc;
@@ -380,6 +408,7 @@ namespace mongo {
             }
         }
 
+        BucketVersions::bump(bucket);
         bucket->emptySize -= sizeof(KeyHeaderType);
         KeyHeaderType& kn = getKeyHeader(bucket, bucket->n++);
         kn.prevChildBucket = prevChild;
@@ -422,6 +451,7 @@ namespace mongo {
         }
 
         invariant(getBucket(txn, bucketLoc) == bucket);
+        BucketVersions::bump(bucket);
 
         {
             // declare that we will write to [k(keypos),k(n)]
@@ -511,6 +541,9 @@ namespace mongo {
             return;
         }
 
+        // Unused keys are dropped, which moves the keys after them.
+        BucketVersions::bump(bucket);
+
         int tdz = totalDataSize(bucket);
         char temp[BtreeLayout::BucketSize];
         int ofs = tdz;
@@ -559,6 +592,7 @@ namespace mongo {
     void BtreeLogic<BtreeLayout>::truncateTo(BucketType* bucket,
                                               int N,
                                               int &refPos) {
+        BucketVersions::bump(bucket);
         bucket->n = N;
         setNotPacked(bucket);
         _packReadyForMod(bucket, refPos);
@@ -639,6 +673,7 @@ namespace mongo {
     void BtreeLogic<BtreeLayout>::dropFront(BucketType* bucket,
                                              int nDrop,
                                              int &refpos) {
+        BucketVersions::bump(bucket);
         for (int i = nDrop; i < bucket->n; ++i) {
             getKeyHeader(bucket, i - nDrop) = getKeyHeader(bucket, i);
         }
@@ -1090,7 +1125,7 @@ namespace mongo {
     Status BtreeLogic<BtreeLayout>::dupKeyCheck(OperationContext* txn,
                                                 const BSONObj& key,
                                                 const DiskLoc& loc) const {
-        KeyDataOwnedType theKey(key);
+        KeyDataOwnedType theKey(key, _ordering);
         if (!wouldCreateDup(txn, theKey, loc)) {
             return Status::OK();
         }
@@ -1165,9 +1200,18 @@ namespace mongo {
         int high = bucket->n - 1;
         int middle = (low + high) / 2;
 
+        // Leading key bytes every key in the bucket shares with the one we're looking for.
+        int skip = 0;
+        if (high > 0) {
+            FullKey first = getFullKey(bucket, 0);
+            FullKey last = getFullKey(bucket, high);
+            skip = std::min(BtreeLayout::commonKeyPrefix(first.data, last.data),
+                            BtreeLayout::commonKeyPrefix(key, first.data));
+        }
+
         while (low <= high) {
             FullKey fullKey = getFullKey(bucket, middle);
-            int cmp = key.woCompare(fullKey.data, _ordering);
+            int cmp = BtreeLayout::compareKeys(key, fullKey.data, _ordering, skip);
 
             // The key data is the same.
             if (0 == cmp) {
@@ -1270,15 +1314,26 @@ namespace mongo {
     void BtreeLogic<BtreeLayout>::deallocBucket(OperationContext* txn,
                                                 BucketType* bucket,
                                                 const DiskLoc bucketLoc) {
+        BucketVersions::bump(bucket);
         bucket->n = BtreeLayout::INVALID_N_SENTINEL;
         bucket->parent.Null();
         _recordStore->deleteRecord(txn, bucketLoc);
     }
 
     template <class BtreeLayout>
-    void BtreeLogic<BtreeLayout>::restorePosition(OperationContext* txn,
+    void BtreeLogic<BtreeLayout>::saveBucket(OperationContext* txn,
+                                             const DiskLoc& bucketLoc,
+                                             SavedBucket* savedBucketOut) const {
+        BucketType* bucket = getBucket(txn, bucketLoc);
+        savedBucketOut->bucket = bucket;
+        savedBucketOut->version = BucketVersions::get(bucket);
+    }
+
+    template <class BtreeLayout>
+    bool BtreeLogic<BtreeLayout>::restorePosition(OperationContext* txn,
                                                   const BSONObj& savedKey,
                                                   const DiskLoc& savedLoc,
+                                                  const SavedBucket& savedBucket,
                                                   int direction,
                                                   DiskLoc* bucketLocInOut,
                                                   int* keyOffsetInOut) const {
@@ -1289,29 +1344,37 @@ namespace mongo {
         // can hold on to a bucket for as long as we need it.
         if (-1 == *keyOffsetInOut) {
             locate(txn, savedKey, savedLoc, direction, keyOffsetInOut, bucketLocInOut);
-            return;
+            return false;
         }
 
         invariant(*keyOffsetInOut >= 0);
 
         BucketType* bucket = getBucket(txn, *bucketLocInOut);
         invariant(bucket);
+
+        // Nothing has written to the bucket since the position was saved, so the saved key is
+        // still where the cursor points.
+        if (bucket == savedBucket.bucket && BucketVersions::get(bucket) == savedBucket.version) {
+            return true;
+        }
+
         invariant(BtreeLayout::INVALID_N_SENTINEL != bucket->n);
 
         if (_keyIsAt(savedKey, savedLoc, bucket, *keyOffsetInOut)) {
             skipUnusedKeys(txn, bucketLocInOut, keyOffsetInOut, direction);
-            return;
+            return false;
         }
 
         if (*keyOffsetInOut > 0) {
             (*keyOffsetInOut)--;
             if (_keyIsAt(savedKey, savedLoc, bucket, *keyOffsetInOut)) {
                 skipUnusedKeys(txn, bucketLocInOut, keyOffsetInOut, direction);
-                return;
+                return false;
             }
         }
 
         locate(txn, savedKey, savedLoc, direction, keyOffsetInOut, bucketLocInOut);
+        return false;
     }
 
     template <class BtreeLayout>
@@ -1789,7 +1852,7 @@ namespace mongo {
                                           const DiskLoc& recordLoc) {
         int pos;
         bool found = false;
-        KeyDataOwnedType ownedKey(key);
+        KeyDataOwnedType ownedKey(key, _ordering);
 
         DiskLoc loc = _locate(txn, getRootLoc(txn), ownedKey, &pos, &found, recordLoc, 1);
         if (found) {
@@ -2212,7 +2275,7 @@ namespace mongo {
                                            const BSONObj& rawKey,
                                            const DiskLoc& value,
                                            bool dupsAllowed) {
-        KeyDataOwnedType key(rawKey);
+        KeyDataOwnedType key(rawKey, _ordering);
 
         if (key.dataSize() > BtreeLayout::KeyMax) {
             string msg = str::stream() << "Btree::insert: key too large to index, failing "
@@ -2259,6 +2322,7 @@ namespace mongo {
                 massert(17433, "_insert: reuse key but lchild is not null", leftChild.isNull());
                 massert(17434, "_insert: reuse key but rchild is not null", rightChild.isNull());
                 txn->recoveryUnit()->writing(&header)->setUsed();
+                BucketVersions::bump(bucket);
                 return Status::OK();
             }
             return Status(ErrorCodes::UniqueIndexViolation, "FIXME");
@@ -2374,7 +2438,7 @@ namespace mongo {
         *bucketLocOut = DiskLoc();
 
         bool found = false;
-        KeyDataOwnedType owned(key);
+        KeyDataOwnedType owned(key, _ordering);
 
         *bucketLocOut = _locate(txn, getRootLoc(txn), owned, posOut, &found, recordLoc, direction);
 
@@ -2508,4 +2572,7 @@ namespace mongo {
     template struct FixedWidthKey<DiskLoc56Bit>;
     template class BtreeLogic<BtreeLayoutV1>;
 
+    // V2 format.
+    template class BtreeLogic<BtreeLayoutV2>;
+
 }  // namespace mongo
@@ -47,6 +47,34 @@ namespace mongo {
     template <class BtreeLayout> class BtreeLogicTestBase;
     template <class BtreeLayout> class ArtificialTreeBuilder;
 
+    /**
+     * Change counters for btree buckets, which let a saved cursor tell whether the bucket it
+     * points into was modified while it was yielded.  Buckets map by address onto a fixed set of
+     * counters shared by every index.  Two buckets sharing a counter only costs their cursors the
+     * slower restore.
+     */
+    class BucketVersions {
+    public:
+        static unsigned get(const void* bucket);
+
+        /** Called for every change to the keys of a bucket, or to its place in the tree. */
+        static void bump(const void* bucket);
+
+    private:
+        static size_t _slot(const void* bucket);
+    };
+
+    /**
+     * Where a cursor was when it saved its position, as restorePosition() compares it.
+     */
+    struct SavedBucket {
+        SavedBucket() : bucket(NULL), version(0) { }
+
+        // Address of the bucket the cursor pointed into.  Only compared, never dereferenced.
+        const void* bucket;
+        unsigned version;
+    };
+
     /**
      * This is the logic for manipulating the Btree.  It is (mostly) independent of the on-disk
      * format.
@@ -210,9 +238,24 @@ namespace mongo {
                        const vector<bool>& keyEndInclusive,
                        int direction) const;
 
-        void restorePosition(OperationContext* txn,
+        /**
+         * Records the state of the bucket at 'bucketLoc' for a later restorePosition().
+         */
+        void saveBucket(OperationContext* txn,
+                        const DiskLoc& bucketLoc,
+                        SavedBucket* savedBucketOut) const;
+
+        /**
+         * Moves a saved cursor back to 'savedKey', or to the key after it if it's gone.  When the
+         * bucket has not changed since saveBucket(), the cursor is left where it is without
+         * looking at any keys.
+         *
+         * Returns true if the cursor was restored that way.
+         */
+        bool restorePosition(OperationContext* txn,
                              const BSONObj& savedKey,
                              const DiskLoc& savedLoc,
+                             const SavedBucket& savedBucket,
                              int direction,
                              DiskLoc* bucketInOut,
                              int* keyOffsetInOut) const;
@@ -949,11 +949,13 @@ namespace mongo {
         }
 
         static int bigSize() {
-            return typename BtreeLogicTestBase<OnDiskFormat>::KeyDataOwnedType(bigKey('a')).dataSize();
+            return typename BtreeLogicTestBase<OnDiskFormat>::KeyDataOwnedType(
+                bigKey('a'), Ordering::make(BSON("TheKey" << 1))).dataSize();
         }
 
         static int biggestSize() {
-            return typename BtreeLogicTestBase<OnDiskFormat>::KeyDataOwnedType(biggestKey('a')).dataSize();
+            return typename BtreeLogicTestBase<OnDiskFormat>::KeyDataOwnedType(
+                biggestKey('a'), Ordering::make(BSON("TheKey" << 1))).dataSize();
         }
 
         int _count;
@@ -2025,6 +2027,41 @@ namespace mongo {
         }
     };
 
+    template<class OnDiskFormat>
+    class RestoreUnchangedBucketInPlace : public BtreeLogicTestBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            this->insert(simpleKey('a'), this->_helper.dummyDiskLoc);
+            this->insert(simpleKey('c'), this->_helper.dummyDiskLoc);
+            this->insert(simpleKey('e'), this->_helper.dummyDiskLoc);
+
+            const BSONObj savedKey = simpleKey('c');
+            int pos;
+            DiskLoc bucketLoc;
+            ASSERT(this->_helper.btree.locate(&txn, savedKey, this->_helper.dummyDiskLoc, 1,
+                                              &pos, &bucketLoc));
+
+            SavedBucket saved;
+            this->_helper.btree.saveBucket(&txn, bucketLoc, &saved);
+            ASSERT(this->_helper.btree.restorePosition(&txn, savedKey, this->_helper.dummyDiskLoc,
+                                                       saved, 1, &bucketLoc, &pos));
+            ASSERT_EQUALS(1, pos);
+
+            // An insert before the saved key moves it, the cursor has to find it again.
+            this->_helper.btree.saveBucket(&txn, bucketLoc, &saved);
+            this->insert(simpleKey('b'), this->_helper.dummyDiskLoc);
+            ASSERT_FALSE(this->_helper.btree.restorePosition(&txn, savedKey,
+                                                             this->_helper.dummyDiskLoc, saved,
+                                                             1, &bucketLoc, &pos));
+            ASSERT_EQUALS(2, pos);
+            BSONObj restoredKey = this->_helper.btree.getKey(&txn, bucketLoc, pos);
+            ASSERT_EQUALS(0, savedKey.woCompare(restoredKey, BSONObj(), false));
+        }
+    };
+
     /* This test requires the entire server to be linked-in and it is better implemented using
        the JS framework. Disabling here and will put in jsCore.
 
@@ -2252,10 +2289,13 @@ namespace mongo {
 
             add< LocateEmptyForward<OnDiskFormat> >();
             add< LocateEmptyReverse<OnDiskFormat> >();
+
+            add< RestoreUnchangedBucketInPlace<OnDiskFormat> >();
         }
     };
 
-    // Test suite for both V0 and V1
+    // Test suite for V0, V1 and V2
     static BtreeLogicTestSuite<BtreeLayoutV0> SUITE_V0("BTreeLogicTests_V0");
     static BtreeLogicTestSuite<BtreeLayoutV1> SUITE_V1("BTreeLogicTests_V1");
+    static BtreeLogicTestSuite<BtreeLayoutV2> SUITE_V2("BTreeLogicTests_V2");
 }
@@ -341,6 +341,13 @@ namespace mongo {
             bucket->_wasSize = BucketSize;
             bucket->reserved = 0;
         }
+
+        // v0 keys are compared as BSON, so there is no byte prefix to skip
+        static int commonKeyPrefix(const KeyType& l, const KeyType& r) { return 0; }
+
+        static int compareKeys(const KeyType& l, const KeyType& r, const Ordering& o, int skip) {
+            return l.woCompare(r, o);
+        }
     };
 
     struct BtreeLayoutV1 {
@@ -360,6 +367,45 @@ namespace mongo {
         static const unsigned short INVALID_N_SENTINEL = 0xffff;
 
         static void initBucket(BucketType* bucket) { }
+
+        static int commonKeyPrefix(const KeyType& l, const KeyType& r) { return 0; }
+
+        static int compareKeys(const KeyType& l, const KeyType& r, const Ordering& o, int skip) {
+            return l.woCompare(r, o);
+        }
+    };
+
+    /**
+     * The v:2 layout is the v:1 bucket with keys that compare as bytes.  All the keys of a bucket
+     * lie between its first and last keys, so the bytes those two have in common are shared by
+     * every key in it and a search can skip over them.
+     */
+    struct BtreeLayoutV2 {
+        typedef FixedWidthKey<DiskLoc56Bit> FixedWidthKeyType;
+        typedef KeyV2 KeyType;
+        typedef KeyV2Owned KeyOwnedType;
+        typedef DiskLoc56Bit LocType;
+        typedef BtreeBucketV1 BucketType;
+
+        enum { BucketSize = 8192 - 16,  // The -16 is to leave room for the Record header
+               BucketBodySize = BucketSize - BucketType::HeaderSize 
+        };
+
+        static const int KeyMax = 1024;
+
+        // A sentinel value sometimes used to identify a deallocated bucket.
+        static const unsigned short INVALID_N_SENTINEL = 0xffff;
+
+        static void initBucket(BucketType* bucket) { }
+
+        static int commonKeyPrefix(const KeyType& l, const KeyType& r) {
+            return l.commonPrefix(r);
+        }
+
+        /** 'skip' leading bytes are known to be the same in both keys */
+        static int compareKeys(const KeyType& l, const KeyType& r, const Ordering& o, int skip) {
+            return l.woCompare(r, o, skip);
+        }
     };
 
 #pragma pack()
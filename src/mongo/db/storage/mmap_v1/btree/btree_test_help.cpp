@@ -110,7 +110,8 @@ namespace mongo {
                 bucket->nextChild = child;
             }
             else {
-                KeyDataOwnedType key(BSON("" << expectedKey(e.fieldName())));
+                KeyDataOwnedType key(BSON("" << expectedKey(e.fieldName())),
+                                     _helper->btree._ordering);
                 invariant(_helper->btree.pushBack(bucket, _helper->dummyDiskLoc, key, child));
             }
         }
@@ -127,7 +128,7 @@ namespace mongo {
     template <class OnDiskFormat>
     void ArtificialTreeBuilder<OnDiskFormat>::push(
                         const DiskLoc bucketLoc, const BSONObj& key, const DiskLoc child) {
-        KeyDataOwnedType k(key);
+        KeyDataOwnedType k(key, _helper->btree._ordering);
         BucketType* bucket = _helper->btree.getBucket(_txn, bucketLoc);
 
         invariant(_helper->btree.pushBack(bucket, _helper->dummyDiskLoc, k, child));
@@ -204,7 +205,8 @@ namespace mongo {
         BucketType* bucket = _helper->btree.getBucket(_txn, bucketLoc);
         ASSERT_EQUALS(0, bucket->n);
 
-        static const int bigSize = KeyDataOwnedType(simpleKey('a', 801)).dataSize();
+        static const int bigSize =
+            KeyDataOwnedType(simpleKey('a', 801), _helper->btree._ordering).dataSize();
 
         int size = 0;
         int keyCount = 0;
@@ -223,7 +225,7 @@ namespace mongo {
 
             push(bucketLoc, newKey, DiskLoc());
 
-            size += KeyDataOwnedType(newKey).dataSize() + 
+            size += KeyDataOwnedType(newKey, _helper->btree._ordering).dataSize() + 
                     sizeof(FixedWidthKeyType);
             keyCount += 1;
         }
@@ -244,4 +246,8 @@ namespace mongo {
     // V1 format.
     template struct BtreeLogicTestHelper<BtreeLayoutV1>;
     template class ArtificialTreeBuilder<BtreeLayoutV1>;
+
+    // V2 format.
+    template struct BtreeLogicTestHelper<BtreeLayoutV2>;
+    template class ArtificialTreeBuilder<BtreeLayoutV2>;
 }
@@ -28,6 +28,7 @@
 
 #include "mongo/db/storage/mmap_v1/btree/key.h"
 
+#include "mongo/base/data_view.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/platform/float_utils.h"
 #include "mongo/util/log.h"
@@ -255,6 +256,14 @@ namespace mongo {
 
     // fromBSON to Key format
     KeyV1Owned::KeyV1Owned(const BSONObj& obj) {
+        init(obj);
+    }
+
+    KeyV1Owned::KeyV1Owned(const BSONObj& obj, const Ordering& o) {
+        init(obj);
+    }
+
+    void KeyV1Owned::init(const BSONObj& obj) {
         BSONObj::iterator i(obj);
         unsigned char bits = 0;
         while( 1 ) { 
@@ -680,6 +689,385 @@ namespace mongo {
         return true;
     }
 
+    // KeyV2 is for V2 (version #2) indexes
+
+    // Every field of a compact KeyV2 starts with one of these, in the canonical type order.  They
+    // are all below 0x80, so the tag of a field inverted for a descending index field is not.
+    enum KeyV2Tags {
+        v2MinKey = 0x01,
+        v2Null = 0x0a,
+        v2Number = 0x14,
+        v2String = 0x1e,
+        v2BinData = 0x3c,
+        v2OID = 0x46,
+        v2False = 0x50,
+        v2True = 0x51,
+        v2Date = 0x5a,
+        v2MaxKey = 0x7f,
+        v2Descending = 0x80
+    };
+
+    // What a number was before it became a double in the ordered bytes; two bits per number in
+    // the type bytes, which are left off when all the numbers are plain doubles
+    enum KeyV2NumberTypes {
+        v2NumberDouble = 0,
+        v2NumberInt = 1,
+        v2NumberLong = 2,
+        v2NumberNegativeZero = 3
+    };
+
+    // the size bytes must not read as IsBSON, and a key fails KeyMax long before this anyway
+    const int KeyV2MaxOrderedSize = 0x7fff;
+
+    // one type byte holds 4 numbers and an index has at most 32 fields
+    const int KeyV2MaxTypeBytes = 8;
+
+    const unsigned long long KeyV2SignBit = 1ULL << 63;
+
+    template<class Builder>
+    static void appendBigEndian64(Builder& b, unsigned long long value) {
+        DataView(b.skip(sizeof(value))).writeBE(value);
+    }
+
+    /** @return the bits of 'd' as an integer which orders like the doubles do */
+    static unsigned long long orderedDoubleBits(double d) {
+        unsigned long long bits;
+        memcpy(&bits, &d, sizeof(bits));
+        return (bits & KeyV2SignBit) ? ~bits : (bits | KeyV2SignBit);
+    }
+
+    static double doubleFromOrderedBits(unsigned long long bits) {
+        bits = (bits & KeyV2SignBit) ? (bits & ~KeyV2SignBit) : ~bits;
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    /** copies 'len' bytes of a field, undoing the inversion of a descending field */
+    static void copyField(char* dest, const unsigned char* p, int len, unsigned char flip) {
+        for( int i = 0; i < len; i++ )
+            dest[i] = p[i] ^ flip;
+    }
+
+    void KeyV2Owned::traditional(const BSONObj& obj) {
+        b.reset();
+        b.appendUChar(IsBSON);
+        b.appendBuf(obj.objdata(), obj.objsize());
+        _keyData = (const unsigned char *) b.buf();
+    }
+
+    KeyV2Owned::KeyV2Owned(const KeyV2& rhs) {
+        b.appendBuf( rhs.data(), rhs.dataSize() );
+        _keyData = (const unsigned char *) b.buf();
+        dassert( b.len() == dataSize() ); // check datasize method is correct
+    }
+
+    KeyV2Owned::KeyV2Owned(const BSONObj& obj, const Ordering& o) {
+        unsigned char numberTypes[KeyV2MaxTypeBytes];
+        memset(numberTypes, 0, sizeof(numberTypes));
+        int numNumbers = 0;
+
+        b.skip(HeaderSize);
+
+        int field = 0;
+        BSONObjIterator i(obj);
+        while( i.more() ) {
+            BSONElement e = i.next();
+            const int fieldStart = b.len();
+
+            switch( e.type() ) {
+            case MinKey:
+                b.appendUChar(v2MinKey);
+                break;
+            case jstNULL:
+                b.appendUChar(v2Null);
+                break;
+            case MaxKey:
+                b.appendUChar(v2MaxKey);
+                break;
+            case Bool:
+                b.appendUChar(e.boolean() ? v2True : v2False);
+                break;
+            case NumberInt:
+            case NumberLong:
+            case NumberDouble:
+                {
+                    double d;
+                    int numberType;
+                    if( e.type() == NumberInt ) {
+                        d = e._numberInt();
+                        numberType = v2NumberInt;
+                    }
+                    else if( e.type() == NumberLong ) {
+                        long long n = e._numberLong();
+                        long long m = 2LL << 52;
+                        if( n >= m || n <= -m ) {
+                            // can't represent exactly as a double
+                            traditional(obj);
+                            return;
+                        }
+                        d = (double) n;
+                        numberType = v2NumberLong;
+                    }
+                    else {
+                        d = e._numberDouble();
+                        if( isNaN(d) ) {
+                            traditional(obj);
+                            return;
+                        }
+                        numberType = v2NumberDouble;
+                        if( d == 0 && (orderedDoubleBits(d) & KeyV2SignBit) == 0 ) {
+                            // -0 equals 0, so it must have the same ordered bytes
+                            d = 0;
+                            numberType = v2NumberNegativeZero;
+                        }
+                    }
+
+                    if( numNumbers == KeyV2MaxTypeBytes * 4 ) {
+                        traditional(obj);
+                        return;
+                    }
+                    numberTypes[numNumbers / 4] |= numberType << ((numNumbers % 4) * 2);
+                    numNumbers++;
+
+                    b.appendUChar(v2Number);
+                    appendBigEndian64(b, orderedDoubleBits(d));
+                    break;
+                }
+            case String:
+                {
+                    // A zero byte ends the string when followed by another, so that a string
+                    // sorts before every longer one it is a prefix of.  Zeros in the string are
+                    // followed by 0xff.
+                    b.appendUChar(v2String);
+                    const char* str = e.valuestr();
+                    const int len = e.valuestrsize() - 1;
+                    for( int j = 0; j < len; j++ ) {
+                        b.appendChar(str[j]);
+                        if( str[j] == 0 )
+                            b.appendUChar(0xff);
+                    }
+                    b.appendUChar(0);
+                    b.appendUChar(0);
+                    break;
+                }
+            case BinData:
+                {
+                    // BSON orders bindata by length first, then subtype and data
+                    const int len = e.valuestrsize();
+                    b.appendUChar(v2BinData);
+                    DataView(b.skip(sizeof(int))).writeBE(len);
+                    b.appendBuf(e.value() + sizeof(int), len + 1);
+                    break;
+                }
+            case jstOID:
+                b.appendUChar(v2OID);
+                b.appendBuf(e.__oid().view().view(), OID::kOIDSize);
+                break;
+            case Date:
+                // signed, so flipping the sign bit orders them as unsigned bytes
+                b.appendUChar(v2Date);
+                appendBigEndian64(b, e.date().millis ^ KeyV2SignBit);
+                break;
+            default:
+                // if other types involved, store as traditional BSON
+                traditional(obj);
+                return;
+            }
+
+            if( o.get(field) < 0 ) {
+                unsigned char* p = reinterpret_cast<unsigned char*>(b.buf());
+                for( int j = fieldStart; j < b.len(); j++ )
+                    p[j] = ~p[j];
+            }
+            field++;
+        }
+
+        const int orderedSize = b.len() - HeaderSize;
+        if( orderedSize > KeyV2MaxOrderedSize ) {
+            traditional(obj);
+            return;
+        }
+
+        int typeBytes = 0;
+        for( int j = 0; j < KeyV2MaxTypeBytes; j++ ) {
+            if( numberTypes[j] )
+                typeBytes = j + 1;
+        }
+        b.appendBuf(numberTypes, typeBytes);
+
+        unsigned char* header = reinterpret_cast<unsigned char*>(b.buf());
+        header[0] = orderedSize >> 8;
+        header[1] = orderedSize & 0xff;
+        header[2] = typeBytes;
+
+        _keyData = (const unsigned char *) b.buf();
+        dassert( b.len() == dataSize() ); // check datasize method is correct
+        dassert( isCompactFormat() );
+    }
+
+    BSONObj KeyV2::toBson() const {
+        verify( _keyData != 0 );
+        if( !isCompactFormat() )
+            return bson();
+
+        const unsigned char* p = orderedBytes();
+        const unsigned char* end = p + orderedSize();
+        const unsigned char* numberTypes = end;
+        const int typeBytes = _keyData[2];
+        int numNumbers = 0;
+
+        BSONObjBuilder b(512);
+        while( p < end ) {
+            // a descending field was inverted as a whole, its tag tells
+            const unsigned char flip = (*p & v2Descending) ? 0xff : 0;
+            const unsigned char tag = *p++ ^ flip;
+
+            switch( tag ) {
+            case v2MinKey: b.appendMinKey(""); break;
+            case v2Null:   b.appendNull(""); break;
+            case v2False:  b.appendBool("", false); break;
+            case v2True:   b.appendBool("", true); break;
+            case v2MaxKey: b.appendMaxKey(""); break;
+            case v2Number:
+                {
+                    char bytes[8];
+                    copyField(bytes, p, 8, flip);
+                    p += 8;
+                    const double d =
+                        doubleFromOrderedBits(ConstDataView(bytes).readBE<unsigned long long>());
+
+                    int numberType = v2NumberDouble;
+                    if( numNumbers / 4 < typeBytes )
+                        numberType = (numberTypes[numNumbers / 4] >> ((numNumbers % 4) * 2)) & 3;
+                    numNumbers++;
+
+                    switch( numberType ) {
+                    case v2NumberInt:
+                        b.append("", static_cast<int>(d));
+                        break;
+                    case v2NumberLong:
+                        b.append("", static_cast<long long>(d));
+                        break;
+                    case v2NumberNegativeZero:
+                        b.append("", -0.0);
+                        break;
+                    default:
+                        b.append("", d);
+                    }
+                    break;
+                }
+            case v2String:
+                {
+                    std::string str;
+                    while( 1 ) {
+                        char c = *p++ ^ flip;
+                        if( c == 0 ) {
+                            // either the end or an escaped zero
+                            if( (*p++ ^ flip) == 0 )
+                                break;
+                        }
+                        str += c;
+                    }
+                    b.append("", str);
+                    break;
+                }
+            case v2BinData:
+                {
+                    char lenBytes[sizeof(int)];
+                    copyField(lenBytes, p, sizeof(int), flip);
+                    p += sizeof(int);
+                    const int len = ConstDataView(lenBytes).readBE<int>();
+                    const int subtype = (unsigned char) (*p++ ^ flip);
+
+                    std::string data(len, '\0');
+                    if( len )
+                        copyField(&data[0], p, len, flip);
+                    p += len;
+                    b.appendBinData("", len, (BinDataType) subtype, data.data());
+                    break;
+                }
+            case v2OID:
+                {
+                    char bytes[OID::kOIDSize];
+                    copyField(bytes, p, OID::kOIDSize, flip);
+                    p += OID::kOIDSize;
+                    OID oid = OID::from(bytes);
+                    b.appendOID("", &oid);
+                    break;
+                }
+            case v2Date:
+                {
+                    char bytes[8];
+                    copyField(bytes, p, 8, flip);
+                    p += 8;
+                    unsigned long long millis = ConstDataView(bytes).readBE<unsigned long long>();
+                    b.appendDate("", Date_t(millis ^ KeyV2SignBit));
+                    break;
+                }
+            default:
+                verify(false);
+            }
+        }
+        return b.obj();
+    }
+
+    int KeyV2::dataSize() const {
+        if( !isCompactFormat() ) {
+            return bson().objsize() + 1;
+        }
+        return HeaderSize + orderedSize() + _keyData[2];
+    }
+
+    // at least one of this and right are traditional BSON format
+    int NOINLINE_DECL KeyV2::compareHybrid(const KeyV2& right, const Ordering& order) const {
+        BSONObj L = toBson();
+        BSONObj R = right.toBson();
+        return L.woCompare(R, order, /*considerfieldname*/false);
+    }
+
+    int KeyV2::woCompare(const KeyV2& right, const Ordering &order) const {
+        return woCompare(right, order, 0);
+    }
+
+    int KeyV2::woCompare(const KeyV2& right, const Ordering &order, int skip) const {
+        if( !isCompactFormat() || !right.isCompactFormat() )
+            return compareHybrid(right, order);
+
+        const int lsz = orderedSize();
+        const int rsz = right.orderedSize();
+        const int common = min(lsz, rsz);
+        dassert( skip <= common );
+
+        int res = memcmp(orderedBytes() + skip, right.orderedBytes() + skip, common - skip);
+        if( res )
+            return res;
+        // a key with more fields is the greater one
+        return lsz - rsz;
+    }
+
+    int KeyV2::commonPrefix(const KeyV2& right) const {
+        if( !isCompactFormat() || !right.isCompactFormat() )
+            return 0;
+
+        const unsigned char* l = orderedBytes();
+        const unsigned char* r = right.orderedBytes();
+        const int common = min(orderedSize(), right.orderedSize());
+        int i = 0;
+        while( i < common && l[i] == r[i] )
+            i++;
+        return i;
+    }
+
+    bool KeyV2::woEqual(const KeyV2& right) const {
+        if( !isCompactFormat() || !right.isCompactFormat() ) {
+            return toBson().equal(right.toBson());
+        }
+        // the type bytes don't matter, 1 and 1.0 are the same key
+        return orderedSize() == right.orderedSize() &&
+               memcmp(orderedBytes(), right.orderedBytes(), orderedSize()) == 0;
+    }
+
     struct CmpUnitTest : public StartupTest {
         void run() {
             char a[2];
@@ -38,13 +38,15 @@ namespace mongo {
 
         KeyBson is a legacy wrapper implementation for old BSONObj style keys for v:0 indexes.
 
-        KeyV1 is the new implementation.
+        KeyV1 is the implementation for v:1 indexes, KeyV2 for v:2 indexes.
     */
     class KeyBson /* "KeyV0" */ { 
     public:
         KeyBson() { }
         explicit KeyBson(const char *keyData) : _o(keyData) { }
         explicit KeyBson(const BSONObj& obj) : _o(obj) { }
+        /** the ordering is only applied when comparing */
+        KeyBson(const BSONObj& obj, const Ordering& o) : _o(obj) { }
         int woCompare(const KeyBson& r, const Ordering &o) const;
         BSONObj toBson() const { return _o; }
         std::string toString() const { return _o.toString(); }
@@ -119,9 +121,103 @@ namespace mongo {
         */
         KeyV1Owned(const BSONObj& obj);
 
+        /** the ordering is only applied when comparing */
+        KeyV1Owned(const BSONObj& obj, const Ordering& o);
+
         /** makes a copy (memcpy's the whole thing) */
         KeyV1Owned(const KeyV1& rhs);
 
+    private:
+        StackBufBuilder b;
+        void init(const BSONObj& obj);
+        void traditional(const BSONObj& obj); // store as traditional bson not as compact format
+    };
+
+    class KeyV2Owned;
+
+    /** Key format for v:2 indexes, where comparing two keys of an index is a memcmp.
+
+        Each field is a tag byte, in the order of the canonical BSON types, followed by the value
+        with its most significant byte first and its sign flipped.  The fields of descending index
+        fields have all their bytes inverted, so the ordering is part of the key and never looked
+        at when comparing.  Whether a number was an int, long or double doesn't affect the order;
+        that is kept after the ordered bytes only to give back the original BSON.
+
+        [ordered size, 2 bytes big endian][type bytes size][ordered bytes][type bytes]
+
+        Values with no such encoding (objects, regexes, NaN...) make the whole key stay BSON behind
+        an IsBSON byte, as for KeyV1, and are compared as BSON.
+    */
+    class KeyV2 {
+        void operator=(const KeyV2&); // disallowed just to make people be careful as we don't own the buffer
+        KeyV2(const KeyV2Owned&);     // disallowed as KeyV2Owned likely will go out of scope
+    public:
+        KeyV2() { _keyData = 0; }
+        ~KeyV2() { DEV _keyData = (const unsigned char *) 1; }
+
+        KeyV2(const KeyV2& rhs) : _keyData(rhs._keyData) {
+            dassert( _keyData > (const unsigned char *) 1 );
+        }
+
+        // explicit version of operator= to be safe
+        void assign(const KeyV2& rhs) {
+            _keyData = rhs._keyData;
+        }
+
+        explicit KeyV2(const char *keyData) : _keyData((unsigned char *) keyData) { }
+
+        /** @param o is only used if either key is BSON, compact keys already carry the ordering */
+        int woCompare(const KeyV2& r, const Ordering &o) const;
+
+        /** like woCompare, for keys already known to share their first 'skip' ordered bytes */
+        int woCompare(const KeyV2& r, const Ordering &o, int skip) const;
+
+        /** @return how many ordered bytes both keys start with, 0 if either is BSON */
+        int commonPrefix(const KeyV2& r) const;
+
+        bool woEqual(const KeyV2& r) const;
+        BSONObj toBson() const;
+        std::string toString() const { return toBson().toString(); }
+
+        /** get the key data we want to store in the btree bucket */
+        const char * data() const { return (const char *) _keyData; }
+
+        /** @return size of data() */
+        int dataSize() const;
+
+        bool isCompactFormat() const { return *_keyData != IsBSON; }
+
+        bool isValid() const { return _keyData > (const unsigned char*)1; }
+
+        enum { HeaderSize = 3 };
+
+    protected:
+        enum { IsBSON = 0xff };
+        const unsigned char *_keyData;
+        BSONObj bson() const {
+            dassert( !isCompactFormat() );
+            return BSONObj((const char *) _keyData+1);
+        }
+        int orderedSize() const {
+            dassert( isCompactFormat() );
+            return (_keyData[0] << 8) | _keyData[1];
+        }
+        const unsigned char* orderedBytes() const { return _keyData + HeaderSize; }
+    private:
+        int compareHybrid(const KeyV2& right, const Ordering& order) const;
+    };
+
+    class KeyV2Owned : public KeyV2 {
+        void operator=(const KeyV2Owned&);
+    public:
+        /** @obj a BSON object to be translated to KeyV2 format for an index with ordering 'o'.
+                 Stays BSON herein if some value has no compact form.
+        */
+        KeyV2Owned(const BSONObj& obj, const Ordering& o);
+
+        /** makes a copy (memcpy's the whole thing) */
+        KeyV2Owned(const KeyV2& rhs);
+
     private:
         StackBufBuilder b;
         void traditional(const BSONObj& obj); // store as traditional bson not as compact format
@@ -162,7 +162,8 @@ namespace mongo {
         void setMaxCappedDocs( OperationContext* txn, long long max );
 
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+            Flag_UseSizeClasses = 1 << 1
         };
 
         IndexDetails& idx(int idxNo, bool missingExpected = false );
@@ -35,6 +35,7 @@
 #include "mongo/db/instance.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mmap.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -44,10 +45,50 @@ namespace mongo {
         : ServerStatusSection( "backgroundFlushing" ),
           _total_time( 0 ),
           _flushes( 0 ),
-          _last() {
+          _last_time( 0 ),
+          _max_time( 0 ),
+          _last(),
+          _trickle_passes( 0 ),
+          _trickle_bytes( 0 ),
+          _trickle_micros( 0 ),
+          _trickle_bytes_since_flush( 0 ),
+          _trickle_last_MBps( 0 ) {
 
     }
 
+    namespace {
+        // how often the dirty ranges are trickled out between full flushes
+        const int TrickleIntervalMillis = 100;
+    }
+
+    void DataFileSync::_trickleUntil(unsigned long long until) {
+        while ( !inShutdown() ) {
+            const unsigned long long now = jsTime();
+            if ( now >= until )
+                break;
+
+            const int ms = static_cast<int>( std::min<unsigned long long>( until - now,
+                                                                           TrickleIntervalMillis ) );
+            sleepmillis( ms );
+
+            const int rate = storageGlobalParams.trickleFlushMBps;
+            if ( rate <= 0 || inShutdown() )
+                continue;
+
+            const unsigned long long budget = static_cast<unsigned long long>( rate ) * 1024 * 1024
+                                              * ms / 1000;
+            Timer t;
+            const unsigned long long bytes = MongoFile::trickleFlushAll( budget );
+            if ( bytes == 0 )
+                continue;
+
+            _trickle_passes++;
+            _trickle_bytes += bytes;
+            _trickle_bytes_since_flush += bytes;
+            _trickle_micros += t.micros();
+        }
+    }
+
     void DataFileSync::run() {
         Client::initThread( name().c_str() );
 
@@ -69,7 +110,12 @@ namespace mongo {
                 continue;
             }
 
-            sleepmillis((long long) std::max(0.0, (storageGlobalParams.syncdelay * 1000) - time_flushing));
+            // between full flushes, keep writing back what was dirtied so the flush below only
+            // has the tail of it left to do
+            const long long wait =
+                (long long) std::max(0.0, (storageGlobalParams.syncdelay * 1000) - time_flushing);
+            const unsigned long long intervalStart = jsTime();
+            _trickleUntil(intervalStart + wait);
 
             if ( inShutdown() ) {
                 // occasional issue trying to flush during shutdown when sleep interrupted
@@ -83,6 +129,13 @@ namespace mongo {
 
             _flushed(time_flushing);
 
+            const unsigned long long intervalMillis = jsTime() - intervalStart;
+            if ( intervalMillis > 0 ) {
+                _trickle_last_MBps = ( _trickle_bytes_since_flush / ( 1024.0 * 1024 ) )
+                                     / ( intervalMillis / 1000.0 );
+            }
+            _trickle_bytes_since_flush = 0;
+
             if( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1)) || time_flushing >= 10000 ) {
                 log() << "flushing mmaps took " << time_flushing << "ms " << " for " << numFiles << " files" << endl;
             }
@@ -95,7 +148,17 @@ namespace mongo {
         b.appendNumber( "total_ms" , _total_time );
         b.appendNumber( "average_ms" , (_flushes ? (_total_time / double(_flushes)) : 0.0) );
         b.appendNumber( "last_ms" , _last_time );
+        b.appendNumber( "max_ms" , _max_time );
         b.append("last_finished", _last);
+        {
+            BSONObjBuilder t( b.subobjStart( "trickle" ) );
+            t.appendNumber( "rate_limit_MBps" , storageGlobalParams.trickleFlushMBps );
+            t.appendNumber( "passes" , _trickle_passes );
+            t.appendNumber( "bytes" , _trickle_bytes );
+            t.appendNumber( "total_ms" , _trickle_micros / 1000 );
+            t.appendNumber( "last_MBps" , _trickle_last_MBps );
+            t.done();
+        }
         return b.obj();
     }
 
@@ -103,6 +166,7 @@ namespace mongo {
         _flushes++;
         _total_time += ms;
         _last_time = ms;
+        _max_time = std::max( _max_time, ms );
         _last = jsTime();
     }
 
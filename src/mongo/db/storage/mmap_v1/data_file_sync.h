@@ -50,11 +50,21 @@ namespace mongo {
     private:
         void _flushed(int ms);
 
+        /** trickles dirty data out at the configured rate until 'until' (millis) */
+        void _trickleUntil(unsigned long long until);
+
         long long _total_time;
         long long _flushes;
         int _last_time;
+        int _max_time;
         Date_t _last;
 
+        long long _trickle_passes;
+        long long _trickle_bytes;
+        long long _trickle_micros;
+        long long _trickle_bytes_since_flush;
+        double _trickle_last_MBps;  // trickle bandwidth over the last syncdelay interval
+
     };
 
     extern DataFileSync dataFileSync;
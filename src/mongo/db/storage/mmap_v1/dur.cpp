@@ -92,6 +92,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/server.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/stacktrace.h"
 #include "mongo/util/timer.h"
@@ -612,6 +613,18 @@ namespace mongo {
         static void durThread() {
             Client::initThread("journal");
 
+            if (storageGlobalParams.journalNumaNode >= 0) {
+                // the private views were placed on this node, see DurableMappedFile
+                if (ProcessInfo::bindThreadToNumaNode(storageGlobalParams.journalNumaNode)) {
+                    log() << "journal thread bound to numa node "
+                          << storageGlobalParams.journalNumaNode;
+                }
+                else {
+                    warning() << "could not bind journal thread to numa node "
+                              << storageGlobalParams.journalNumaNode;
+                }
+            }
+
             bool samePartition = true;
             try {
                 const std::string dbpathDir =
@@ -299,6 +299,7 @@ namespace mongo {
 
                 void* dest = (char*)mmf->view_write() + entry.e->ofs;
                 memcpy(dest, entry.e->srcData(), entry.e->len);
+                mmf->noteDirty(entry.e->ofs, entry.e->len);
                 stats.curr->_writeToDataFilesBytes += entry.e->len;
             }
             else {
@@ -45,11 +45,30 @@
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 
 using namespace mongoutils;
 
 namespace mongo {
 
+    namespace {
+        /** apply --hugePages and --journalNumaNode to a view that was just mapped */
+        void applyPlacementHints(const std::string& filename,
+                                 void* view,
+                                 unsigned long long len,
+                                 bool isPrivateView) {
+            if (storageGlobalParams.hugePages &&
+                !MemoryMappedFile::adviseHugePages(view, len)) {
+                LOG(1) << "huge pages not available for " << filename;
+            }
+            if (isPrivateView && storageGlobalParams.journalNumaNode >= 0 &&
+                !ProcessInfo::preferNumaNode(view, len, storageGlobalParams.journalNumaNode)) {
+                LOG(1) << "could not place private view of " << filename << " on numa node "
+                       << storageGlobalParams.journalNumaNode;
+            }
+        }
+    }
+
     void DurableMappedFile::remapThePrivateView() {
         verify(storageGlobalParams.dur);
 
@@ -62,6 +81,9 @@ namespace mongo {
         _view_private = remapPrivateView(_view_private);
         //privateViews.add(_view_private, this);
         fassert( 16112, _view_private == old );
+
+        // the remap replaces the mapping, and the advice given for it along with it
+        applyPlacementHints(filename(), _view_private, length(), true);
     }
 
     /** register view. threadsafe */
@@ -166,10 +188,12 @@ namespace mongo {
                     msgasserted(13636, str::stream() << "file " << filename() << " open/create failed in createPrivateMap (look in log for more information)");
                 }
                 privateViews.add(_view_private, this); // note that testIntent builds use this, even though it points to view_write then...
+                applyPlacementHints(filename(), _view_private, length(), true);
             }
             else {
                 _view_private = _view_write;
             }
+            applyPlacementHints(filename(), _view_write, length(), false);
             return true;
         }
         return false;
@@ -58,6 +58,11 @@ namespace mongo {
 
         void flush(bool sync)   { MemoryMappedFile::flush(sync); }
 
+        /** note a write to the write view, see MemoryMappedFile::noteDirty() */
+        void noteDirty(unsigned long long ofs, unsigned len) {
+            MemoryMappedFile::noteDirty(ofs, len);
+        }
+
         /* Creates with length if DNE, otherwise uses existing file length,
            passed length.
            @param sequentialHint if true will be sequentially accessed
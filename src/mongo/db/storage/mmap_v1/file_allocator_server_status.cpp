@@ -0,0 +1,60 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/util/file_allocator.h"
+
+namespace mongo {
+
+    /**
+     * Reports how data files are being allocated ahead of use, see FileAllocator, under
+     * storage.fileAllocator in serverStatus metrics.
+     */
+    class FileAllocatorServerStatusMetric : public ServerStatusMetric {
+    public:
+        FileAllocatorServerStatusMetric() : ServerStatusMetric("storage.fileAllocator") {}
+        virtual void appendAtLeaf( BSONObjBuilder& b ) const {
+            const FileAllocator* fa = FileAllocator::get();
+            const FileAllocator::Stats stats = fa->getStats();
+
+            BSONObjBuilder sub( b.subobjStart( _leafName ) );
+            sub.appendNumber( "queueDepth" , fa->queueDepth() );
+            sub.appendNumber( "allocations" , stats.allocations );
+            sub.appendNumber( "failures" , stats.failures );
+            sub.appendNumber( "total_ms" , stats.totalMicros / 1000 );
+            sub.appendNumber( "average_ms" , stats.allocations ?
+                              stats.totalMicros / 1000.0 / stats.allocations : 0.0 );
+            sub.appendNumber( "last_ms" , stats.lastMicros / 1000 );
+            sub.appendNumber( "max_ms" , stats.maxMicros / 1000 );
+            sub.done();
+        }
+
+    } fileAllocatorServerStatusMetric;
+}
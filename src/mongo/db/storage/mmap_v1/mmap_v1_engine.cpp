@@ -54,6 +54,7 @@
 #include "mongo/platform/process_id.h"
 #include "mongo/util/file_allocator.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/mmap.h"
 
 
@@ -293,6 +294,17 @@ namespace {
 
         acquirePathLock(this, storageGlobalParams.repair);
 
+        if (storageGlobalParams.numaInterleave) {
+            // must happen before the threads that fault data file pages in are started, as
+            // they inherit the policy of this one
+            if (ProcessInfo::interleaveAcrossNumaNodes()) {
+                log() << "interleaving data file memory across numa nodes";
+            }
+            else {
+                warning() << "--numaInterleave: could not set the numa memory policy";
+            }
+        }
+
         FileAllocator::get()->start();
 
         MONGO_ASSERT_ON_EXCEPTION_WITH_MSG( clearTmpFiles(), "clear tmp files" );
@@ -171,8 +171,11 @@ namespace mongo {
             string fullNameString = fullName.string();
             p = new DataFile(n);
             int minSize = 0;
-            if ( n != 0 && _files[ n - 1 ] )
-                minSize = _files[ n - 1 ]->getHeader()->fileLength;
+            // files preallocated further ahead than the next one are sized from the last one
+            // that is open
+            const int prev = std::min( n, numFiles() ) - 1;
+            if ( prev >= 0 && _files[ prev ] )
+                minSize = _files[ prev ]->getHeader()->fileLength;
             if ( sizeNeeded + DataFileHeader::HeaderSize > minSize )
                 minSize = sizeNeeded + DataFileHeader::HeaderSize;
             try {
@@ -201,8 +204,15 @@ namespace mongo {
         DEV txn->lockState()->assertWriteLocked(_dbname);
         int n = (int) _files.size();
         DataFile *ret = getFile( txn, n, sizeNeeded );
-        if ( preallocateNextFile )
-            getFile( txn, numFiles() , 0, true ); // preallocate a file
+        if ( preallocateNextFile ) {
+            // keep the next few files allocating in the background so that a burst of inserts
+            // doesn't have to wait for them
+            for ( int i = 0;
+                  i < storageGlobalParams.preallocFilesAhead && numFiles() + i < DiskLoc::MaxFiles;
+                  i++ ) {
+                getFile( txn, numFiles() + i, 0, true );
+            }
+        }
         return ret;
     }
 
@@ -313,7 +323,7 @@ namespace mongo {
         // no space in an existing file
         // allocate files until we either get one big enough or hit maxSize
         for ( int i = 0; i < 8; i++ ) {
-            DataFile* f = _addAFile( txn, size, false );
+            DataFile* f = _addAFile( txn, size, true );
 
             if ( f->getHeader()->unusedLength >= size ) {
                 return _createExtentInFile( txn, numFiles() - 1, f, size, enforceQuota );
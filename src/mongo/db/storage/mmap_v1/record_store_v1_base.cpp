@@ -854,7 +854,8 @@ namespace mongo {
 
         invariant( _details->paddingFactor() >= 1 );
 
-        if ( _details->isUserFlagSet( Flag_UsePowerOf2Sizes ) ) {
+        if ( _details->isUserFlagSet( Flag_UsePowerOf2Sizes ) ||
+             _details->isUserFlagSet( Flag_UseSizeClasses ) ) {
             // quantize to the nearest bucketSize (or nearest 1mb boundary for large sizes).
             return quantizePowerOf2AllocationSpace(minRecordSize);
         }
@@ -969,6 +970,24 @@ namespace mongo {
             return Status::OK();
         }
 
+        if ( str::equals( "useSizeClasses", option.fieldName() ) ) {
+            bool oldSizeClasses = _details->isUserFlagSet( Flag_UseSizeClasses );
+            bool newSizeClasses = option.trueValue();
+
+            if ( oldSizeClasses != newSizeClasses ) {
+                info->appendBool( "useSizeClasses_old", oldSizeClasses );
+
+                if ( newSizeClasses )
+                    _details->setUserFlag( txn, Flag_UseSizeClasses );
+                else
+                    _details->clearUserFlag( txn, Flag_UseSizeClasses );
+
+                info->appendBool( "useSizeClasses_new", newSizeClasses );
+            }
+
+            return Status::OK();
+        }
+
         return Status( ErrorCodes::InvalidOptions,
                        str::stream() << "no such option: " << option.fieldName() );
     }
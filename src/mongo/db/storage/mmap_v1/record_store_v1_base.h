@@ -106,7 +106,8 @@ namespace mongo {
         static const int bucketSizes[];
 
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+            Flag_UseSizeClasses = 1 << 1 // power of 2 sizes plus O(1) allocation and coalescing
         };
 
         // ------------
@@ -31,6 +31,7 @@
 #include "mongo/db/storage/mmap_v1/record_store_v1_capped.h"
 
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/storage/mmap_v1/record.h"
@@ -59,6 +60,8 @@
 
 namespace mongo {
 
+    MONGO_EXPORT_SERVER_PARAMETER(cappedBatchReclaim, bool, true);
+
     CappedRecordStoreV1::CappedRecordStoreV1( OperationContext* txn,
                                               CappedDocumentDeleteCallback* collection,
                                               const StringData& ns,
@@ -163,6 +166,16 @@ namespace mongo {
                     continue;
                 }
 
+                if ( cappedBatchReclaim ) {
+                    StatusWith<int> deleted = _deleteOldestRun( txn, lenToAlloc );
+                    if ( !deleted.isOK() )
+                        return StatusWith<DiskLoc>( deleted.getStatus() );
+                    if ( deleted.getValue() > 0 ) {
+                        passes += deleted.getValue();
+                        continue;
+                    }
+                }
+
                 DiskLoc fr = theCapExtent()->firstRecord;
                 Status status = _deleteCallback->aboutToDeleteCapped( txn, fr );
                 if ( !status.isOK() )
@@ -417,6 +430,100 @@ namespace mongo {
         return ret;
     }
 
+    StatusWith<int> CappedRecordStoreV1::_deleteOldestRun( OperationContext* txn, int len ) {
+        if ( _isSystemIndexes )
+            return StatusWith<int>( 0 );
+
+        Extent* e = theCapExtent();
+        const DiskLoc first = e->firstRecord;
+        invariant( !first.isNull() );
+
+        // the free space the newest records were appended into, ending where the oldest begins
+        DiskLoc hole;
+        for ( DiskLoc i = cappedFirstDeletedInCurExtent();
+              !i.isNull() && inCapExtent( i );
+              i = drec(i)->nextDeleted() ) {
+            if ( i.a() == first.a() &&
+                 i.getOfs() + drec(i)->lengthWithHeaders() == first.getOfs() ) {
+                hole = i;
+                break;
+            }
+        }
+        if ( hole.isNull() )
+            return StatusWith<int>( 0 );
+
+        // Collect the oldest records, stopping at the first one written on this pass through
+        // the extent or at a gap, until the hole is big enough (with room for a trailing
+        // DeletedRecord, see __capAlloc) and the max # objects limit allows the insert.
+        const int holeLen = drec(hole)->lengthWithHeaders();
+        const long long numRecords = _details->numRecords();
+        vector<DiskLoc> run;
+        int runLen = 0;
+        DiskLoc cur = first;
+        while ( !cur.isNull() && cur != _details->capFirstNewRecord() ) {
+            if ( holeLen + runLen >= len + 24 &&
+                 numRecords - static_cast<long long>( run.size() ) < _details->maxCappedDocs() )
+                break;
+
+            Record* r = recordFor( cur );
+            run.push_back( cur );
+            runLen += r->lengthWithHeaders();
+
+            if ( r->nextOfs() == DiskLoc::NullOfs ||
+                 r->nextOfs() != cur.getOfs() + r->lengthWithHeaders() )
+                break;
+            cur = DiskLoc( cur.a(), r->nextOfs() );
+        }
+
+        // Every record whose callback succeeded must go, even if a later one fails.
+        Status status = Status::OK();
+        size_t numDeleted = 0;
+        for ( ; numDeleted < run.size(); numDeleted++ ) {
+            status = _deleteCallback->aboutToDeleteCapped( txn, run[numDeleted] );
+            if ( !status.isOK() )
+                break;
+        }
+        if ( numDeleted == 0 )
+            return status.isOK() ? StatusWith<int>( 0 ) : StatusWith<int>( status );
+
+        // Drop the run from the front of the extent's record chain.
+        long long dataSize = 0;
+        int freedLen = 0;
+        for ( size_t i = 0; i < numDeleted; i++ ) {
+            Record* r = recordFor( run[i] );
+            dataSize += r->netLength();
+            freedLen += r->lengthWithHeaders();
+            // this is defensive so we can detect if we are still using a location
+            // that was deleted
+            memset( txn->recoveryUnit()->writingPtr( r->data(), 4 ), 0xee, 4 );
+        }
+
+        const Record* last = recordFor( run[numDeleted - 1] );
+        if ( last->nextOfs() == DiskLoc::NullOfs ) {
+            txn->recoveryUnit()->writing( &e->firstRecord )->Null();
+            txn->recoveryUnit()->writing( &e->lastRecord )->Null();
+        }
+        else {
+            DiskLoc next( first.a(), last->nextOfs() );
+            txn->recoveryUnit()->writingInt( recordFor( next )->prevOfs() ) = DiskLoc::NullOfs;
+            *txn->recoveryUnit()->writing( &e->firstRecord ) = next;
+        }
+
+        _details->incrementStats( txn, -dataSize, -static_cast<long long>( numDeleted ) );
+
+        // The freed records are contiguous with the hole, so it simply grows over them.
+        txn->recoveryUnit()->writingInt( drec(hole)->lengthWithHeaders() ) += freedLen;
+
+        // The run ended at a gap before freeing enough; let compact() merge the hole with any
+        // DeletedRecord in that gap, as deleting one record at a time would have.
+        if ( holeLen + freedLen < len + 24 )
+            compact(txn);
+
+        if ( !status.isOK() )
+            return StatusWith<int>( status );
+        return StatusWith<int>( static_cast<int>( numDeleted ) );
+    }
+
     void CappedRecordStoreV1::cappedTruncateLastDelUpdate(OperationContext* txn) {
         if ( _details->capExtent() == _details->firstExtent(txn) ) {
             // Only one extent of the collection is in use, so there
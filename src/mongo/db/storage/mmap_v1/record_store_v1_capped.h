@@ -38,6 +38,10 @@
 
 namespace mongo {
 
+    // When a looped capped collection needs room, drop the run of oldest records that follows
+    // the free space in the cap extent in one step instead of one record at a time.
+    extern bool cappedBatchReclaim;
+
     class CappedRecordStoreV1 : public RecordStoreV1Base {
     public:
         CappedRecordStoreV1( OperationContext* txn,
@@ -128,6 +132,16 @@ namespace mongo {
 
         // -- end copy from cap.cpp --
 
+        /**
+         * Deletes the oldest records of the cap extent that are physically contiguous with the
+         * DeletedRecord in front of them, until that DeletedRecord can hold 'len' bytes or the
+         * run ends, and folds their space into it without a compact().
+         *
+         * @return the number of records deleted; 0 if the cap extent isn't laid out as a ring
+         * at this point and the caller should delete one record the slow way.
+         */
+        StatusWith<int> _deleteOldestRun( OperationContext* txn, int len );
+
         CappedDocumentDeleteCallback* _deleteCallback;
 
         OwnedPointerVector<ExtentManager::CacheHint> _extentAdvice;
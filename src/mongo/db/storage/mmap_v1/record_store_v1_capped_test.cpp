@@ -37,6 +37,7 @@
 #include "mongo/db/storage/mmap_v1/record_store_v1_test_help.h"
 
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/timer.h"
 
 using namespace mongo;
 
@@ -422,6 +423,107 @@ namespace {
         }
     }
 
+    /**
+     * The oldest records behind the free space in the capExtent are dropped as one run.
+     */
+    TEST(CappedRecordStoreV1, DeleteOldestRunInOneStep) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( true, 0 );
+        DummyCappedDocumentDeleteCallback cb;
+        CappedRecordStoreV1 rs(&txn, &cb, "test.foo", md, &em, false);
+
+        {
+            LocAndSize records[] = {
+                {DiskLoc(0, 1250), 100}, // first old record
+                {DiskLoc(0, 1350), 100},
+                {DiskLoc(0, 1450), 100}, // last old record
+                {DiskLoc(0, 1000), 100}, // first new record
+                {DiskLoc(0, 1100), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1200), 50}, // gap after newest record
+                {DiskLoc(0, 1550), 50}, // gap at end of extent
+                {}
+            };
+            md->setCapExtent(&txn, DiskLoc(0, 0));
+            md->setCapFirstNewRecord(&txn, DiskLoc(0, 1000));
+            initializeV1RS(&txn, records, drecs, &em, md);
+        }
+
+        rs.insertRecord(&txn, zeros, 200 - Record::HeaderSize, false);
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1450), 100}, // old
+                {DiskLoc(0, 1000), 100}, // first new
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(0, 1200), 200},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1400), 50},
+                {DiskLoc(0, 1550), 50},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, &em, md);
+            ASSERT_EQUALS(md->capExtent(), DiskLoc(0, 0));
+            ASSERT_EQUALS(md->capFirstNewRecord(), DiskLoc(0, 1000));
+            ASSERT_EQUALS(2U, cb.deleted.size());
+            ASSERT_EQUALS(DiskLoc(0, 1250), cb.deleted[0]);
+            ASSERT_EQUALS(DiskLoc(0, 1350), cb.deleted[1]);
+        }
+    }
+
+    /**
+     * Inserts 'numInserts' records of varying size into a looping capped collection.
+     * @return the time it took in millis
+     */
+    long long cappedInsertBenchmark( bool batchReclaim, int numInserts, long long* numRecords,
+                                     long long* dataSize ) {
+        const bool oldBatchReclaim = cappedBatchReclaim;
+        cappedBatchReclaim = batchReclaim;
+
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( true, 0 );
+        DummyCappedDocumentDeleteCallback cb;
+        CappedRecordStoreV1 rs( &txn, &cb, "test.bench", md, &em, false );
+        for ( int i = 0; i < 4; i++ )
+            rs.increaseStorageSize( &txn, 1024 * 1024, false );
+
+        Timer t;
+        for ( int i = 0; i < numInserts; i++ ) {
+            int size = 50 + ( i * 37 ) % 400;
+            ASSERT_OK( rs.insertRecord( &txn, zeros, size, false ).getStatus() );
+        }
+        long long millis = t.millis();
+
+        *numRecords = md->numRecords();
+        *dataSize = md->dataSize();
+        cappedBatchReclaim = oldBatchReclaim;
+        return millis;
+    }
+
+    TEST(CappedRecordStoreV1, InsertThroughputBenchmark) {
+        const int numInserts = 200 * 1000;
+
+        long long slowRecords, slowSize;
+        long long slowMillis = cappedInsertBenchmark( false, numInserts, &slowRecords, &slowSize );
+
+        long long runRecords, runSize;
+        long long runMillis = cappedInsertBenchmark( true, numInserts, &runRecords, &runSize );
+
+        // both make room by dropping exactly the same oldest records
+        ASSERT_EQUALS( slowRecords, runRecords );
+        ASSERT_EQUALS( slowSize, runSize );
+
+        mongo::unittest::log() << "capped insert " << numInserts << " records: "
+                               << "one at a time " << slowMillis << "ms, "
+                               << "in runs " << runMillis << "ms" << std::endl;
+    }
+
     //
     // XXX The CappedRecordStoreV1Scrambler suite of tests describe existing behavior that is less
     // than ideal. Any improved implementation will need to be able to handle a collection that has
@@ -34,6 +34,9 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 
+#include <algorithm>
+#include <map>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/curop.h"
@@ -63,12 +66,38 @@ namespace mongo {
     static ServerStatusMetricField<Counter64> dFreelist3( "storage.freelist.search.scanned",
                                                           &freelistIterations );
 
+    static Counter64 sizeClassAllocs;
+    static Counter64 sizeClassCoalesced;
+
+    static ServerStatusMetricField<Counter64> dFreelist4( "storage.freelist.sizeClass.allocs",
+                                                          &sizeClassAllocs );
+
+    static ServerStatusMetricField<Counter64> dFreelist5( "storage.freelist.sizeClass.coalesced",
+                                                          &sizeClassCoalesced );
+
+    /**
+     * The free chunk map is kept in step with the deleted lists as they are written. A rollback
+     * restores the lists but not the map, so the map is dropped and rebuilt on next use.
+     */
+    class SimpleRecordStoreV1::FreeChunksRollback : public RecoveryUnit::Change {
+    public:
+        FreeChunksRollback( SimpleRecordStoreV1* rs ) : _rs( rs ) {}
+
+        virtual void commit() {}
+        virtual void rollback() { _rs->_invalidateFreeChunks(); }
+
+    private:
+        SimpleRecordStoreV1* _rs;
+    };
+
     SimpleRecordStoreV1::SimpleRecordStoreV1( OperationContext* txn,
                                               const StringData& ns,
                                               RecordStoreV1MetaData* details,
                                               ExtentManager* em,
                                               bool isSystemIndexes )
-        : RecordStoreV1Base( ns, details, em, isSystemIndexes ) {
+        : RecordStoreV1Base( ns, details, em, isSystemIndexes ),
+          _freeChunksMutex( "SimpleRecordStoreV1::_freeChunksMutex" ),
+          _freeChunksValid( false ) {
 
         invariant( !details->isCapped() );
         _normalCollection = NamespaceString::normal( ns );
@@ -86,6 +115,12 @@ namespace mongo {
 
     DiskLoc SimpleRecordStoreV1::_allocFromExistingExtents( OperationContext* txn,
                                                             int lenToAlloc ) {
+        if ( _details->isUserFlagSet( Flag_UseSizeClasses ) )
+            return _allocFromSizeClasses( txn, lenToAlloc );
+
+        // the search below relinks the deleted lists without maintaining the free chunk map
+        _invalidateFreeChunks();
+
         // align size up to a multiple of 4
         lenToAlloc = (lenToAlloc + (4-1)) & ~(4-1);
 
@@ -226,6 +261,71 @@ namespace mongo {
         return loc;
     }
 
+    DiskLoc SimpleRecordStoreV1::_allocFromSizeClasses( OperationContext* txn,
+                                                        int lenToAlloc ) {
+        // align size up to a multiple of 4
+        lenToAlloc = (lenToAlloc + (4-1)) & ~(4-1);
+
+        SimpleMutex::scoped_lock lk( _freeChunksMutex );
+        _loadFreeChunks();
+        txn->recoveryUnit()->registerChange( new FreeChunksRollback( this ) );
+
+        sizeClassAllocs.increment();
+
+        // Every entry on list b is at least bucketSizes[b-1] long, so the head of the first
+        // non-empty list starting from the one whose lower bound covers lenToAlloc always fits.
+        // Allocation sizes are powers of 2 under this flag, so that is normally bucket() itself.
+        int b = bucket(lenToAlloc);
+        if ( b > 0 && b < MaxBucket && bucketSizes[b-1] < lenToAlloc )
+            b++;
+
+        DiskLoc loc;
+        for ( ; b <= MaxBucket; b++ ) {
+            loc = _details->deletedListEntry(b);
+            if ( b == MaxBucket ) {
+                // the largest list has no upper bound so its entries have to be checked
+                while ( !loc.isNull() && drec(loc)->lengthWithHeaders() < lenToAlloc ) {
+                    loc = drec(loc)->nextDeleted();
+                }
+            }
+            if ( !loc.isNull() )
+                break;
+        }
+
+        if ( loc.isNull() )
+            return loc; // out of space, alloc a new extent
+
+        FreeChunkMap::iterator it = _freeChunks.find( loc );
+        invariant( it != _freeChunks.end() );
+
+        DeletedRecord* r = drec(loc);
+        const int regionlen = r->lengthWithHeaders();
+        const int extentOfs = r->extentOfs();
+        invariant( regionlen >= lenToAlloc );
+        invariant( extentOfs < loc.getOfs() );
+
+        _unlinkFreeChunk( txn, it );
+
+        const int left = regionlen - lenToAlloc;
+        if ( left < bucketSizes[0] ) {
+            // you get the whole thing.
+            return loc;
+        }
+
+        // Split off the tail. The chunk was already merged with its free neighbours, so the
+        // remainder cannot be adjacent to another free chunk.
+        txn->recoveryUnit()->writingInt(r->lengthWithHeaders()) = lenToAlloc;
+        DiskLoc newDelLoc = loc;
+        newDelLoc.inc(lenToAlloc);
+        DeletedRecord* newDelW = txn->recoveryUnit()->writing(drec(newDelLoc));
+        newDelW->extentOfs() = extentOfs;
+        newDelW->lengthWithHeaders() = left;
+        newDelW->nextDeleted().Null();
+
+        _pushFreeChunk( txn, newDelLoc );
+        return loc;
+    }
+
     StatusWith<DiskLoc> SimpleRecordStoreV1::allocRecord( OperationContext* txn,
                                                           int lengthWithHeaders,
                                                           bool enforceQuota ) {
@@ -272,6 +372,19 @@ namespace mongo {
     }
 
     void SimpleRecordStoreV1::addDeletedRec( OperationContext* txn, const DiskLoc& dloc ) {
+        if ( !_drainingExtent.isNull() &&
+             DiskLoc( dloc.a(), drec( dloc )->extentOfs() ) == _drainingExtent ) {
+            // freed along with the whole extent by compactOnlineBatch
+            return;
+        }
+
+        if ( _details->isUserFlagSet( Flag_UseSizeClasses ) ) {
+            _addDeletedRecCoalescing( txn, dloc );
+            return;
+        }
+
+        _invalidateFreeChunks();
+
         DeletedRecord* d = drec( dloc );
 
         DEBUGGING log() << "TEMP: add deleted rec " << dloc.toString() << ' ' << hex << d->extentOfs() << endl;
@@ -281,6 +394,171 @@ namespace mongo {
         _details->setDeletedListEntry(txn, b, dloc);
     }
 
+    void SimpleRecordStoreV1::_addDeletedRecCoalescing( OperationContext* txn,
+                                                        const DiskLoc& dloc ) {
+        SimpleMutex::scoped_lock lk( _freeChunksMutex );
+        _loadFreeChunks();
+        txn->recoveryUnit()->registerChange( new FreeChunksRollback( this ) );
+
+        DeletedRecord* d = drec( dloc );
+        const int extentOfs = d->extentOfs();
+        const int oldLength = d->lengthWithHeaders();
+
+        DiskLoc start = dloc;
+        int length = oldLength;
+
+        // merge with the free chunk right after us in the same extent
+        FreeChunkMap::iterator next = _freeChunks.find( DiskLoc( dloc.a(),
+                                                                 dloc.getOfs() + oldLength ) );
+        if ( next != _freeChunks.end() && drec( next->first )->extentOfs() == extentOfs ) {
+            length += next->second.length;
+            _unlinkFreeChunk( txn, next );
+            sizeClassCoalesced.increment();
+        }
+
+        // and with the one right before us
+        FreeChunkEndMap::const_iterator prevEnd = _freeChunkEnds.find( dloc );
+        if ( prevEnd != _freeChunkEnds.end() &&
+             drec( prevEnd->second )->extentOfs() == extentOfs ) {
+            FreeChunkMap::iterator prev = _freeChunks.find( prevEnd->second );
+            invariant( prev != _freeChunks.end() );
+            start = prev->first;
+            length += prev->second.length;
+            _unlinkFreeChunk( txn, prev );
+            sizeClassCoalesced.increment();
+        }
+
+        if ( start != dloc || length != oldLength ) {
+            txn->recoveryUnit()->writingInt( drec( start )->lengthWithHeaders() ) = length;
+        }
+
+        _pushFreeChunk( txn, start );
+    }
+
+    void SimpleRecordStoreV1::_loadFreeChunks() const {
+        if ( _freeChunksValid )
+            return;
+
+        _freeChunks.clear();
+        _freeChunkEnds.clear();
+        for ( int b = 0; b <= MaxBucket; b++ ) {
+            DiskLoc prev;
+            for ( DiskLoc cur = _details->deletedListEntry(b);
+                  !cur.isNull();
+                  cur = drec(cur)->nextDeleted() ) {
+                FreeChunk& chunk = _freeChunks[cur];
+                chunk.length = drec(cur)->lengthWithHeaders();
+                chunk.prevDeleted = prev;
+                _freeChunkEnds[DiskLoc( cur.a(), cur.getOfs() + chunk.length )] = cur;
+                prev = cur;
+            }
+        }
+        _freeChunksValid = true;
+    }
+
+    void SimpleRecordStoreV1::_pushFreeChunk( OperationContext* txn, const DiskLoc& loc ) {
+        DeletedRecord* d = drec( loc );
+        const int b = bucket( d->lengthWithHeaders() );
+        const DiskLoc head = _details->deletedListEntry(b);
+
+        *txn->recoveryUnit()->writing(&d->nextDeleted()) = head;
+        _details->setDeletedListEntry(txn, b, loc);
+
+        if ( !head.isNull() ) {
+            FreeChunkMap::iterator it = _freeChunks.find( head );
+            invariant( it != _freeChunks.end() );
+            it->second.prevDeleted = loc;
+        }
+
+        FreeChunk& chunk = _freeChunks[loc];
+        chunk.length = d->lengthWithHeaders();
+        chunk.prevDeleted = DiskLoc();
+        _freeChunkEnds[DiskLoc( loc.a(), loc.getOfs() + chunk.length )] = loc;
+    }
+
+    void SimpleRecordStoreV1::_unlinkFreeChunk( OperationContext* txn,
+                                                FreeChunkMap::iterator it ) {
+        DeletedRecord* d = drec( it->first );
+        const DiskLoc next = d->nextDeleted();
+        const DiskLoc prev = it->second.prevDeleted;
+
+        if ( prev.isNull() ) {
+            // should be the front of a free-list
+            const int b = bucket( d->lengthWithHeaders() );
+            invariant( _details->deletedListEntry(b) == it->first );
+            _details->setDeletedListEntry(txn, b, next);
+        }
+        else {
+            *txn->recoveryUnit()->writing(&drec(prev)->nextDeleted()) = next;
+        }
+
+        if ( !next.isNull() ) {
+            FreeChunkMap::iterator nextIt = _freeChunks.find( next );
+            invariant( nextIt != _freeChunks.end() );
+            nextIt->second.prevDeleted = prev;
+        }
+
+        *txn->recoveryUnit()->writing(&d->nextDeleted()) = DiskLoc().setInvalid(); // defensive.
+        _freeChunkEnds.erase( DiskLoc( it->first.a(), it->first.getOfs() + it->second.length ) );
+        _freeChunks.erase( it );
+    }
+
+    void SimpleRecordStoreV1::_invalidateFreeChunks() {
+        // Callers hold the database write lock, so _freeChunksValid can't become true under us
+        // and the usual case, a collection that never used size classes, costs no mutex.
+        if ( !_freeChunksValid )
+            return;
+
+        SimpleMutex::scoped_lock lk( _freeChunksMutex );
+        if ( !_freeChunksValid )
+            return;
+        _freeChunks.clear();
+        _freeChunkEnds.clear();
+        _freeChunksValid = false;
+    }
+
+    void SimpleRecordStoreV1::appendCustomStats( OperationContext* txn,
+                                                 BSONObjBuilder* result,
+                                                 double scale ) const {
+        RecordStoreV1Base::appendCustomStats( txn, result, scale );
+
+        if ( !_details->isUserFlagSet( Flag_UseSizeClasses ) )
+            return;
+
+        SimpleMutex::scoped_lock lk( _freeChunksMutex );
+        _loadFreeChunks();
+
+        long long freeBytes = 0;
+        int largestChunk = 0;
+        std::vector<long long> chunksPerClass( Buckets, 0 );
+        for ( FreeChunkMap::const_iterator it = _freeChunks.begin();
+              it != _freeChunks.end();
+              ++it ) {
+            freeBytes += it->second.length;
+            largestChunk = std::max( largestChunk, it->second.length );
+            chunksPerClass[bucket( it->second.length )]++;
+        }
+
+        BSONObjBuilder freeSpace( result->subobjStart( "freeSpace" ) );
+        freeSpace.appendNumber( "chunks", static_cast<long long>( _freeChunks.size() ) );
+        freeSpace.append( "bytes", freeBytes / scale );
+        freeSpace.append( "largestChunk", largestChunk / scale );
+        // 0 when all free space is one chunk, approaching 1 as it splinters into small ones
+        freeSpace.append( "fragmentation",
+                          freeBytes ? 1.0 - double(largestChunk) / freeBytes : 0.0 );
+
+        // chunk counts keyed by the smallest size on each list
+        BSONObjBuilder sizeClasses( freeSpace.subobjStart( "sizeClasses" ) );
+        for ( int b = 0; b <= MaxBucket; b++ ) {
+            if ( chunksPerClass[b] == 0 )
+                continue;
+            sizeClasses.appendNumber( BSONObjBuilder::numStr( b == 0 ? 0 : bucketSizes[b-1] ),
+                                      chunksPerClass[b] );
+        }
+        sizeClasses.doneFast();
+        freeSpace.doneFast();
+    }
+
     RecordIterator* SimpleRecordStoreV1::getIterator( OperationContext* txn,
                                                       const DiskLoc& start,
                                                       bool tailable,
@@ -333,6 +611,35 @@ namespace mongo {
         size_t _allocationSize;
     };
 
+    unsigned SimpleRecordStoreV1::_compactAllocationSize( const CompactOptions* compactOptions,
+                                                          const Record* recOld,
+                                                          unsigned minAllocationSize ) const {
+        unsigned allocationSize = minAllocationSize;
+        switch( compactOptions->paddingMode ) {
+        case CompactOptions::NONE: // no padding, unless using powerOf2Sizes/sizeClasses
+            if ( _details->isUserFlagSet(Flag_UsePowerOf2Sizes) ||
+                 _details->isUserFlagSet(Flag_UseSizeClasses) )
+                allocationSize = quantizePowerOf2AllocationSpace(minAllocationSize);
+            else
+                allocationSize = minAllocationSize;
+            break;
+
+        case CompactOptions::PRESERVE: // keep original padding
+            allocationSize = recOld->lengthWithHeaders();
+            break;
+
+        case CompactOptions::MANUAL: // user specified how much padding to use
+            allocationSize = compactOptions->computeRecordSize(minAllocationSize);
+            if (allocationSize < minAllocationSize
+                    || allocationSize > BSONObjMaxUserSize / 2 ) {
+                allocationSize = minAllocationSize;
+            }
+            break;
+        }
+        invariant(allocationSize >= minAllocationSize);
+        return allocationSize;
+    }
+
     void SimpleRecordStoreV1::_compactExtent(OperationContext* txn,
                                              const DiskLoc extentLoc,
                                              int extentNumber,
@@ -394,28 +701,9 @@ namespace mongo {
 
                     // Allocation sizes include the headers and possibly some padding.
                     const unsigned minAllocationSize = rawDataSize + Record::HeaderSize;
-                    unsigned allocationSize = minAllocationSize;
-                    switch( compactOptions->paddingMode ) {
-                    case CompactOptions::NONE: // no padding, unless using powerOf2Sizes
-                        if ( _details->isUserFlagSet(Flag_UsePowerOf2Sizes) )
-                            allocationSize = quantizePowerOf2AllocationSpace(minAllocationSize);
-                        else
-                            allocationSize = minAllocationSize;
-                        break;
-
-                    case CompactOptions::PRESERVE: // keep original padding
-                        allocationSize = recOld->lengthWithHeaders();
-                        break;
-
-                    case CompactOptions::MANUAL: // user specified how much padding to use
-                        allocationSize = compactOptions->computeRecordSize(minAllocationSize);
-                        if (allocationSize < minAllocationSize
-                                || allocationSize > BSONObjMaxUserSize / 2 ) {
-                            allocationSize = minAllocationSize;
-                        }
-                        break;
-                    }
-                    invariant(allocationSize >= minAllocationSize);
+                    const unsigned allocationSize = _compactAllocationSize( compactOptions,
+                                                                            recOld,
+                                                                            minAllocationSize );
 
                     // Copy the data to a new record. Because we orphaned the record freelist at the
                     // start of the compact, this insert will allocate a record in a new extent.
@@ -503,6 +791,11 @@ namespace mongo {
             // failure mode as no data will be lost.
             log() << "compact orphan deleted lists" << endl;
             _details->orphanDeletedList(txn);
+            _invalidateFreeChunks();
+
+            // this supersedes any online compaction that was interrupted part way
+            _extentsToDrain.clear();
+            _drainingExtent = DiskLoc();
 
             // Start over from scratch with our extent sizing and growth
             _details->setLastExtentSize( txn, 0 );
@@ -536,4 +829,190 @@ namespace mongo {
         return Status::OK();
     }
 
+
+    // extents at least this full are not worth draining online
+    static const double onlineCompactMaxDensity = 0.5;
+
+    void SimpleRecordStoreV1::_queueExtentsToDrain( OperationContext* txn ) {
+        // free space per extent, from the deleted lists
+        std::map<DiskLoc, long long> freeBytes;
+        for ( int b = 0; b <= MaxBucket; b++ ) {
+            for ( DiskLoc cur = _details->deletedListEntry(b);
+                  !cur.isNull();
+                  cur = drec(cur)->nextDeleted() ) {
+                const DeletedRecord* d = drec(cur);
+                freeBytes[DiskLoc( cur.a(), d->extentOfs() )] += d->lengthWithHeaders();
+            }
+        }
+
+        // The last extent is left alone as it is where new records are going.
+        std::vector<std::pair<double, DiskLoc> > sparse;
+        for ( DiskLoc extLoc = _details->firstExtent(txn);
+              extLoc != _details->lastExtent(txn);
+              extLoc = _extentManager->getExtent( extLoc )->xnext ) {
+            const Extent* e = _extentManager->getExtent( extLoc );
+            const double density = 1.0 - double( freeBytes[extLoc] ) /
+                                         ( e->length - Extent::HeaderSize() );
+            if ( density < onlineCompactMaxDensity )
+                sparse.push_back( std::make_pair( density, extLoc ) );
+        }
+        std::sort( sparse.begin(), sparse.end() );
+
+        _extentsToDrain.clear();
+        for ( size_t i = sparse.size(); i > 0; i-- ) {
+            _extentsToDrain.push_back( sparse[i - 1].second );
+        }
+    }
+
+    void SimpleRecordStoreV1::_orphanDeletedRecordsInExtent( OperationContext* txn,
+                                                             const DiskLoc& extentLoc ) {
+        _invalidateFreeChunks();
+
+        for ( int b = 0; b <= MaxBucket; b++ ) {
+            DiskLoc prev;
+            DiskLoc cur = _details->deletedListEntry(b);
+            while ( !cur.isNull() ) {
+                DeletedRecord* d = drec(cur);
+                const DiskLoc next = d->nextDeleted();
+                if ( DiskLoc( cur.a(), d->extentOfs() ) == extentLoc ) {
+                    if ( prev.isNull() )
+                        _details->setDeletedListEntry( txn, b, next );
+                    else
+                        *txn->recoveryUnit()->writing( &drec(prev)->nextDeleted() ) = next;
+                }
+                else {
+                    prev = cur;
+                }
+                cur = next;
+            }
+        }
+    }
+
+    void SimpleRecordStoreV1::_unlinkAndFreeExtent( OperationContext* txn,
+                                                    const DiskLoc& extentLoc ) {
+        Extent* e = _extentManager->getExtent( extentLoc );
+        invariant( e->firstRecord.isNull() );
+        invariant( e->lastRecord.isNull() );
+
+        if ( e->xprev.isNull() )
+            _details->setFirstExtent( txn, e->xnext );
+        else
+            *txn->recoveryUnit()->writing( &_extentManager->getExtent( e->xprev )->xnext ) =
+                e->xnext;
+
+        if ( e->xnext.isNull() )
+            _details->setLastExtent( txn, e->xprev );
+        else
+            *txn->recoveryUnit()->writing( &_extentManager->getExtent( e->xnext )->xprev ) =
+                e->xprev;
+
+        _extentManager->freeExtent( txn, extentLoc );
+    }
+
+    Status SimpleRecordStoreV1::compactOnlineBatch( OperationContext* txn,
+                                                    RecordStoreCompactAdaptor* adaptor,
+                                                    UpdateMoveNotifier* notifier,
+                                                    const CompactOptions* options,
+                                                    int maxRecords,
+                                                    CompactStats* stats,
+                                                    bool* done ) {
+        *done = false;
+
+        if ( _drainingExtent.isNull() ) {
+            if ( _extentsToDrain.empty() ) {
+                _queueExtentsToDrain( txn );
+                log() << "compact online " << _ns << ": " << _extentsToDrain.size()
+                      << " extents to drain";
+            }
+
+            if ( _extentsToDrain.empty() ) {
+                *done = true;
+                return Status::OK();
+            }
+
+            _drainingExtent = _extentsToDrain.back();
+            _extentsToDrain.pop_back();
+
+            // If we are interrupted from here on the orphaned space is only reclaimed when the
+            // compaction is resumed or the collection is compacted offline, the same as for
+            // compact().
+            WriteUnitOfWork wunit(txn);
+            _orphanDeletedRecordsInExtent( txn, _drainingExtent );
+            wunit.commit();
+        }
+
+        Extent* const extent = _extentManager->getExtent( _drainingExtent );
+        for ( int n = 0; n < maxRecords && !extent->firstRecord.isNull(); n++ ) {
+            WriteUnitOfWork wunit(txn);
+            const DiskLoc oldLoc = extent->firstRecord;
+            Record* recOld = recordFor( oldLoc );
+            RecordData oldData = recOld->toRecordData();
+
+            if ( options->validateDocuments && !adaptor->isDataValid( oldData ) ) {
+                // We can neither move nor unindex it, so this extent cannot be freed.
+                stats->corruptDocuments++;
+                _drainingExtent = DiskLoc();
+                _extentsToDrain.clear();
+                return Status( ErrorCodes::InvalidBSON,
+                               str::stream() << "corrupt document at " << oldLoc.toString()
+                                             << " in " << _ns
+                                             << ", run compact without online to remove it" );
+            }
+
+            const unsigned rawDataSize = adaptor->dataSize( oldData );
+            const unsigned minAllocationSize = rawDataSize + Record::HeaderSize;
+            CompactDocWriter writer( recOld,
+                                     rawDataSize,
+                                     _compactAllocationSize( options, recOld, minAllocationSize ) );
+            StatusWith<DiskLoc> newLoc = insertRecord( txn, &writer, false );
+            if ( !newLoc.isOK() )
+                return newLoc.getStatus();
+            invariant( _getExtentLocForRecord( txn, newLoc.getValue() ) != _drainingExtent );
+
+            Status status = notifier->recordStoreGoingToMove( txn,
+                                                              oldLoc,
+                                                              recOld->data(),
+                                                              recOld->netLength() );
+            if ( !status.isOK() )
+                return status;
+
+            deleteRecord( txn, oldLoc );
+            adaptor->inserted( dataFor( txn, newLoc.getValue() ), newLoc.getValue() );
+            wunit.commit();
+
+            stats->recordsMoved++;
+        }
+
+        if ( extent->firstRecord.isNull() ) {
+            const int length = extent->length;
+
+            WriteUnitOfWork wunit(txn);
+            _unlinkAndFreeExtent( txn, _drainingExtent );
+            wunit.commit();
+
+            LOG(1) << "compact online " << _ns << ": freed extent " << _drainingExtent
+                   << " of " << length << " bytes";
+
+            _drainingExtent = DiskLoc();
+            stats->extentsFreed++;
+            *done = _extentsToDrain.empty();
+        }
+
+        stats->extentsRemaining = _extentsToDrain.size() + ( _drainingExtent.isNull() ? 0 : 1 );
+        return Status::OK();
+    }
+
+    void SimpleRecordStoreV1::compactOnlineAbandon( OperationContext* txn ) {
+        if ( _drainingExtent.isNull() )
+            return;
+
+        log() << "compact online " << _ns << ": abandoned while draining extent "
+              << _drainingExtent;
+
+        // its orphaned space doesn't show on the deleted lists, so it would never look sparse
+        // enough to be queued again
+        _extentsToDrain.push_back( _drainingExtent );
+        _drainingExtent = DiskLoc();
+    }
+
 }
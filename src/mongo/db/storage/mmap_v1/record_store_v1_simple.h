@@ -30,8 +30,12 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_base.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -67,6 +71,33 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats );
 
+        virtual bool compactOnlineSupported() const { return true; }
+
+        /**
+         * Drains the extents that are less than half full one at a time, sparsest first.
+         * While an extent is being drained its free space is taken off the deleted lists, so
+         * moved and newly inserted records go elsewhere; it is freed once its last record has
+         * been moved.
+         */
+        virtual Status compactOnlineBatch( OperationContext* txn,
+                                           RecordStoreCompactAdaptor* adaptor,
+                                           UpdateMoveNotifier* notifier,
+                                           const CompactOptions* options,
+                                           int maxRecords,
+                                           CompactStats* stats,
+                                           bool* done );
+
+        /**
+         * Deletes in the extent being drained go back on the deleted lists. The extent stays
+         * first in line, so the next online compaction drains it and reclaims its orphaned
+         * space.
+         */
+        virtual void compactOnlineAbandon( OperationContext* txn );
+
+        virtual void appendCustomStats( OperationContext* txn,
+                                        BSONObjBuilder* result,
+                                        double scale ) const;
+
     protected:
         virtual bool isCapped() const { return false; }
 
@@ -77,9 +108,53 @@ namespace mongo {
         virtual void addDeletedRec(OperationContext* txn,
                                    const DiskLoc& dloc);
     private:
+        class FreeChunksRollback;
+
+        /**
+         * In-memory shadow of the deleted record lists, used when Flag_UseSizeClasses is set.
+         * Chunks are found by where they start and where they end, so the free chunks physically
+         * adjacent to a record can be found when it is deleted, and each holds its predecessor
+         * on its list so it can be unlinked without walking the list.
+         */
+        struct FreeChunk {
+            int length;
+            DiskLoc prevDeleted;
+        };
+        typedef unordered_map<DiskLoc, FreeChunk, DiskLoc::Hasher> FreeChunkMap;
+        typedef unordered_map<DiskLoc, DiskLoc, DiskLoc::Hasher> FreeChunkEndMap;
+
         DiskLoc _allocFromExistingExtents( OperationContext* txn,
                                            int lengthWithHeaders );
 
+        /**
+         * O(1) allocation for Flag_UseSizeClasses: takes the head of the first non-empty list
+         * whose every entry fits lengthWithHeaders.
+         */
+        DiskLoc _allocFromSizeClasses( OperationContext* txn,
+                                       int lengthWithHeaders );
+
+        /**
+         * Frees dloc, merging it with the free chunks immediately before and after it in the
+         * same extent.
+         */
+        void _addDeletedRecCoalescing( OperationContext* txn, const DiskLoc& dloc );
+
+        // The following require _freeChunksMutex.
+        void _loadFreeChunks() const;
+        void _pushFreeChunk( OperationContext* txn, const DiskLoc& loc );
+        void _unlinkFreeChunk( OperationContext* txn, FreeChunkMap::iterator it );
+
+        // Requires the database write lock, takes _freeChunksMutex only if there is a map to drop.
+        void _invalidateFreeChunks();
+
+        unsigned _compactAllocationSize( const CompactOptions* options,
+                                         const Record* recOld,
+                                         unsigned minAllocationSize ) const;
+
+        void _queueExtentsToDrain( OperationContext* txn );
+        void _orphanDeletedRecordsInExtent( OperationContext* txn, const DiskLoc& extentLoc );
+        void _unlinkAndFreeExtent( OperationContext* txn, const DiskLoc& extentLoc );
+
         void _compactExtent(OperationContext* txn,
                             const DiskLoc diskloc,
                             int extentNumber,
@@ -89,6 +164,15 @@ namespace mongo {
 
         bool _normalCollection;
 
+        mutable SimpleMutex _freeChunksMutex;
+        mutable FreeChunkMap _freeChunks;
+        mutable FreeChunkEndMap _freeChunkEnds; // end of each free chunk -> its start
+        mutable bool _freeChunksValid; // false until rebuilt from the deleted lists
+
+        // compactOnlineBatch progress, kept between calls under the database write lock
+        std::vector<DiskLoc> _extentsToDrain; // sparsest last
+        DiskLoc _drainingExtent; // deleted records in this extent are not put on the lists
+
         friend class SimpleRecordStoreV1Iterator;
     };
 
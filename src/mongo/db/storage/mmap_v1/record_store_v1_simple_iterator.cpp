@@ -28,13 +28,68 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple_iterator.h"
 
+#include <algorithm>
+#include <vector>
+
+#include "mongo/base/counter.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
+#include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
+#include "mongo/util/mmap.h"
+#include "mongo/util/processinfo.h"
 
 namespace mongo {
 
+    namespace {
+        int collectionScanReadAheadMB = 2;
+
+        ExportedServerParameter<int> CollectionScanReadAheadMBSetting(
+                ServerParameterSet::getGlobal(),
+                "collectionScanReadAheadMB",
+                &collectionScanReadAheadMB,
+                true,
+                true);
+
+        Counter64 readAheadRequests;
+        Counter64 readAheadPagesPrefetched;
+        Counter64 readAheadPagesFaulted;
+
+        ServerStatusMetricField<Counter64> displayReadAheadRequests(
+                "storage.readAhead.requests", &readAheadRequests );
+        // pages that were not in memory when they were advised
+        ServerStatusMetricField<Counter64> displayReadAheadPagesPrefetched(
+                "storage.readAhead.pagesPrefetched", &readAheadPagesPrefetched );
+        // pages advised earlier that were still not in memory once the scan had caught up to
+        // within half a window of them, so the scan is likely to fault on them anyway
+        ServerStatusMetricField<Counter64> displayReadAheadPagesFaulted(
+                "storage.readAhead.pagesFaulted", &readAheadPagesFaulted );
+
+        /** @return the number of pages of [from, to) that are not in memory */
+        long long pagesNotInMemory(const char* from, const char* to) {
+            if ( from >= to || !ProcessInfo::blockCheckSupported() )
+                return 0;
+
+            const size_t pageSize = ProcessInfo::getPageSize();
+            const char* start = static_cast<const char*>( ProcessInfo::alignToStartOfPage( from ) );
+            const size_t numPages = ( to - start + pageSize - 1 ) / pageSize;
+
+            std::vector<char> inMemory;
+            if ( !ProcessInfo::pagesInMemory( start, numPages, &inMemory ) )
+                return 0;
+
+            long long missing = 0;
+            for ( size_t i = 0; i < numPages; i++ ) {
+                if ( !( inMemory[i] & 0x1 ) )
+                    missing++;
+            }
+            return missing;
+        }
+    }
+
     //
     // Regular / non-capped collection traversal
     //
@@ -43,7 +98,11 @@ namespace mongo {
                                                              const SimpleRecordStoreV1* collection,
                                                              const DiskLoc& start,
                                                              const CollectionScanParams::Direction& dir)
-        : _txn(txn), _curr(start), _recordStore(collection), _direction(dir) {
+        : _txn(txn),
+          _curr(start),
+          _recordStore(collection),
+          _direction(dir),
+          _readAheadEnd(NULL) {
 
         if (_curr.isNull()) {
 
@@ -101,11 +160,85 @@ namespace mongo {
             else {
                 _curr = _recordStore->getPrevRecord( _txn, _curr );
             }
+
+            if (!isEOF()) {
+                _readAhead();
+            }
         }
 
         return ret;
     }
 
+    void SimpleRecordStoreV1Iterator::_adviseWillNeed(const char* from, const char* to) {
+        if ( from >= to )
+            return;
+        readAheadRequests.increment();
+        readAheadPagesPrefetched.increment( pagesNotInMemory( from, to ) );
+        MemoryMappedFile::adviseWillNeed( from, to - from );
+    }
+
+    void SimpleRecordStoreV1Iterator::_readAhead() {
+        const int windowMB = collectionScanReadAheadMB;
+        if ( windowMB <= 0 )
+            return;
+        const ptrdiff_t window = static_cast<ptrdiff_t>( windowMB ) * 1024 * 1024;
+        const bool forward = CollectionScanParams::FORWARD == _direction;
+
+        const Record* r = _recordStore->recordFor( _curr );
+        const char* pos = reinterpret_cast<const char*>( r );
+        const DiskLoc extentLoc( _curr.a(), r->extentOfs() );
+        const bool sameExtent = extentLoc == _readAheadExtent;
+
+        if ( sameExtent ) {
+            // still more than half a window advised ahead of us
+            const ptrdiff_t ahead = forward ? _readAheadEnd - pos : pos - _readAheadEnd;
+            if ( ahead > window / 2 )
+                return;
+
+            if ( ahead > 0 ) {
+                readAheadPagesFaulted.increment( forward ?
+                                                 pagesNotInMemory( pos, _readAheadEnd ) :
+                                                 pagesNotInMemory( _readAheadEnd, pos ) );
+            }
+        }
+
+        const ExtentManager* em = _recordStore->_extentManager;
+        const Extent* e = em->getExtent( extentLoc );
+        const char* extentStart = reinterpret_cast<const char*>( e );
+        const char* extentEnd = extentStart + e->length;
+
+        if ( forward ) {
+            const char* from = sameExtent ? std::max( pos, _readAheadEnd ) : pos;
+            const char* to = extentEnd - pos > window ? pos + window : extentEnd;
+            _adviseWillNeed( from, to );
+            _readAheadEnd = to;
+
+            if ( to == extentEnd && !e->xnext.isNull() ) {
+                // the window runs into the next extent
+                const Extent* next = em->getExtent( e->xnext );
+                const char* nextStart = reinterpret_cast<const char*>( next );
+                _adviseWillNeed( nextStart,
+                                 nextStart + std::min<ptrdiff_t>( window - ( to - pos ),
+                                                                  next->length ) );
+            }
+        }
+        else {
+            const char* from = pos - extentStart > window ? pos - window : extentStart;
+            const char* to = sameExtent ? std::min( pos, _readAheadEnd ) : pos;
+            _adviseWillNeed( from, to );
+            _readAheadEnd = from;
+
+            if ( from == extentStart && !e->xprev.isNull() ) {
+                const Extent* prev = em->getExtent( e->xprev );
+                const char* prevEnd = reinterpret_cast<const char*>( prev ) + prev->length;
+                _adviseWillNeed( prevEnd - std::min<ptrdiff_t>( window - ( pos - from ),
+                                                                prev->length ),
+                                 prevEnd );
+            }
+        }
+        _readAheadExtent = extentLoc;
+    }
+
     void SimpleRecordStoreV1Iterator::invalidate(const DiskLoc& dl) {
         // Just move past the thing being deleted.
         if (dl == _curr) {
@@ -120,6 +253,9 @@ namespace mongo {
 
     bool SimpleRecordStoreV1Iterator::restoreState(OperationContext* txn) {
         _txn = txn;
+        // extents may have been freed or reused while we yielded
+        _readAheadExtent = DiskLoc();
+        _readAheadEnd = NULL;
         // if the collection is dropped, then the cursor should be destroyed
         return true;
     }
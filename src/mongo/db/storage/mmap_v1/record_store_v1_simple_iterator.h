@@ -59,6 +59,16 @@ namespace mongo {
         virtual RecordData dataFor( const DiskLoc& loc ) const;
 
     private:
+        /**
+         * Asks the os to start reading the next collectionScanReadAheadMB of _curr's extent, and
+         * the start of the following extent when the window runs past its end.  The window is
+         * advanced once the scan is half way through it.
+         */
+        void _readAhead();
+
+        /** madvise [from, to) and count how much of it had still to be read */
+        static void _adviseWillNeed(const char* from, const char* to);
+
          // for getNext, not owned
         OperationContext* _txn;
 
@@ -68,6 +78,12 @@ namespace mongo {
         const SimpleRecordStoreV1* _recordStore;
 
         CollectionScanParams::Direction _direction;
+
+        // the extent _readAheadEnd points into; null until the first read ahead
+        DiskLoc _readAheadExtent;
+
+        // how far ahead of the scan (in _direction) the extent has been advised
+        const char* _readAheadEnd;
     };
 
 }  // namespace mongo
@@ -30,10 +30,14 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_test_help.h"
+#include "mongo/platform/random.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 using namespace mongo;
 
@@ -772,4 +776,436 @@ namespace {
             assertStateV1RS(&txn, recs, drecs, &em, md);
         }
     }
+
+    // -----------------
+
+    /**
+     * With Flag_UseSizeClasses an insert takes the head of the first list whose entries all fit,
+     * rather than searching for a better fit further down the list.
+     */
+    TEST( SimpleRecordStoreV1, SizeClassAllocTakesListHead ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData(
+                                                false,
+                                                RecordStoreV1Base::Flag_UseSizeClasses );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 2000), 600}, // head of the [512, 1024) list, taken
+                {DiskLoc(0, 4000), 520}, // better fit, but not looked at
+                {}
+            };
+            initializeV1RS(&txn, NULL, drecs, &em, md);
+        }
+
+        // quantized up to 512
+        rs.insertRecord(&txn, zeros, 300 - Record::HeaderSize, false);
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 2000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 2512), 88}, // the remainder
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 4000), 520},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, &em, md);
+        }
+    }
+
+    /**
+     * With Flag_UseSizeClasses a deleted record is merged with the free chunks on either side.
+     */
+    TEST( SimpleRecordStoreV1, SizeClassDeleteCoalesces ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData(
+                                                false,
+                                                RecordStoreV1Base::Flag_UseSizeClasses );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 2000), 100},
+                {DiskLoc(0, 2100), 100},
+                {DiskLoc(0, 2200), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1900), 100},
+                {DiskLoc(0, 2300), 100},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        // no free neighbours
+        rs.deleteRecord(&txn, DiskLoc(0, 2100));
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 2000), 100},
+                {DiskLoc(0, 2200), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 2100), 100},
+                {DiskLoc(0, 1900), 100},
+                {DiskLoc(0, 2300), 100},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        // merges with 1900 before and 2100 after
+        rs.deleteRecord(&txn, DiskLoc(0, 2000));
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 2200), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 2300), 100},
+                {DiskLoc(0, 1900), 300},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        rs.deleteRecord(&txn, DiskLoc(0, 2200));
+        {
+            LocAndSize recs[] = {
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1900), 500},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, &em, md);
+        }
+    }
+
+    /**
+     * appendCustomStats() reports the free space of a size class collection.
+     */
+    TEST( SimpleRecordStoreV1, SizeClassFreeSpaceStats ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData(
+                                                false,
+                                                RecordStoreV1Base::Flag_UseSizeClasses );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 2000), 300},
+                {}
+            };
+            initializeV1RS(&txn, NULL, drecs, &em, md);
+        }
+
+        BSONObjBuilder b;
+        rs.appendCustomStats( &txn, &b, 1 );
+        BSONObj stats = b.obj();
+        BSONObj freeSpace = stats["freeSpace"].Obj();
+
+        ASSERT_EQUALS( 2, freeSpace["chunks"].numberLong() );
+        ASSERT_EQUALS( 400, freeSpace["bytes"].numberLong() );
+        ASSERT_EQUALS( 300, freeSpace["largestChunk"].numberLong() );
+        ASSERT_EQUALS( 0.25, freeSpace["fragmentation"].numberDouble() );
+        ASSERT_EQUALS( BSON( "64" << 1LL << "256" << 1LL ), freeSpace["sizeClasses"].Obj() );
+    }
+
+    /**
+     * Churn benchmark: random inserts and deletes of mixed sizes, comparing the first-fit search
+     * of usePowerOf2Sizes with size classes. Prints the time taken and the resulting storage and
+     * fragmentation; checks that size classes never leave two free chunks side by side.
+     */
+    TEST( SimpleRecordStoreV1, SizeClassChurnBenchmark ) {
+        const int flags[] = { RecordStoreV1Base::Flag_UsePowerOf2Sizes,
+                              RecordStoreV1Base::Flag_UseSizeClasses };
+        const int numDocs = 5000;
+        const int numRounds = 20;
+
+        for ( int f = 0; f < 2; f++ ) {
+            OperationContextNoop txn;
+            DummyExtentManager em;
+            DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, flags[f] );
+            SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+            PseudoRandom rand( 17 );
+            std::vector<DiskLoc> locs;
+            Timer t;
+            for ( int round = 0; round < numRounds; round++ ) {
+                while ( static_cast<int>( locs.size() ) < numDocs ) {
+                    const int size = 20 + rand.nextInt32( 2000 );
+                    StatusWith<DiskLoc> loc = rs.insertRecord( &txn, zeros, size, false );
+                    ASSERT_OK( loc.getStatus() );
+                    locs.push_back( loc.getValue() );
+                }
+                for ( int i = 0; i < numDocs / 2; i++ ) {
+                    const size_t victim = rand.nextInt32( locs.size() );
+                    rs.deleteRecord( &txn, locs[victim] );
+                    locs[victim] = locs.back();
+                    locs.pop_back();
+                }
+            }
+            const long long micros = t.micros();
+
+            ASSERT_EQUALS( static_cast<long long>( locs.size() ), rs.numRecords( &txn ) );
+
+            BSONObjBuilder b;
+            rs.appendCustomStats( &txn, &b, 1 );
+            log() << "churn with userFlags " << flags[f] << ": " << micros / 1000 << "ms,"
+                  << " storageSize: " << rs.storageSize( &txn ) << ' ' << b.obj();
+
+            if ( flags[f] != RecordStoreV1Base::Flag_UseSizeClasses )
+                continue;
+
+            std::map<DiskLoc, int> freeChunks;
+            for ( int bucket = 0; bucket < RecordStoreV1Base::Buckets; bucket++ ) {
+                for ( DiskLoc loc = md->deletedListEntry( bucket );
+                      !loc.isNull();
+                      loc = em.recordForV1( loc )->asDeleted().nextDeleted() ) {
+                    freeChunks[loc] = em.recordForV1( loc )->asDeleted().lengthWithHeaders();
+                }
+            }
+            for ( std::map<DiskLoc, int>::iterator it = freeChunks.begin();
+                  it != freeChunks.end();
+                  ++it ) {
+                const DiskLoc after( it->first.a(), it->first.getOfs() + it->second );
+                ASSERT_EQUALS( 0U, freeChunks.count( after ) );
+            }
+        }
+    }
+
+    // -----------------
+
+    class RecordingCompactAdaptor : public RecordStoreCompactAdaptor {
+    public:
+        virtual bool isDataValid( const RecordData& recData ) { return true; }
+        virtual size_t dataSize( const RecordData& recData ) { return recData.size(); }
+        virtual void inserted( const RecordData& recData, const DiskLoc& newLocation ) {
+            inserts.push_back( newLocation );
+        }
+
+        std::vector<DiskLoc> inserts;
+    };
+
+    class RecordingMoveNotifier : public UpdateMoveNotifier {
+    public:
+        virtual Status recordStoreGoingToMove( OperationContext* txn,
+                                               const DiskLoc& oldLocation,
+                                               const char* oldBuffer,
+                                               size_t oldSize ) {
+            moves.push_back( oldLocation );
+            return Status::OK();
+        }
+
+        std::vector<DiskLoc> moves;
+    };
+
+    /**
+     * compactOnlineBatch() drains the extents less than half full, moving at most maxRecords
+     * records per call, and frees them once empty. Dense extents and the last extent are left
+     * alone.
+     */
+    TEST( SimpleRecordStoreV1, CompactOnlineBatch ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100}, // sparse, drained
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(1, 1000), 100}, // dense
+                {DiskLoc(1, 1100), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(2, 1000), 1000}, // last extent, where the records go
+                {DiskLoc(0, 1200), 6800},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        CompactOptions options;
+        CompactStats stats;
+        RecordingCompactAdaptor adaptor;
+        RecordingMoveNotifier notifier;
+        bool done = false;
+
+        ASSERT_OK( rs.compactOnlineBatch( &txn, &adaptor, &notifier, &options, 1, &stats, &done ) );
+        ASSERT_FALSE( done );
+        ASSERT_EQUALS( 1, stats.recordsMoved );
+        ASSERT_EQUALS( 0, stats.extentsFreed );
+        ASSERT_EQUALS( 1, stats.extentsRemaining );
+        {
+            // the free space in the extent being drained is no longer on the lists
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 1100), 100},
+                {DiskLoc(2, 1000), 104},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(2, 1104), 896},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        ASSERT_OK( rs.compactOnlineBatch( &txn, &adaptor, &notifier, &options, 1, &stats, &done ) );
+        ASSERT_TRUE( done );
+        ASSERT_EQUALS( 2, stats.recordsMoved );
+        ASSERT_EQUALS( 1, stats.extentsFreed );
+        ASSERT_EQUALS( 0, stats.extentsRemaining );
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 1100), 100},
+                {DiskLoc(2, 1000), 104},
+                {DiskLoc(2, 1104), 104},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(2, 1208), 792},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, &em, md);
+        }
+        ASSERT_EQUALS( DiskLoc(1, 0), md->firstExtent( &txn ) );
+
+        ASSERT_EQUALS( 2U, notifier.moves.size() );
+        ASSERT_EQUALS( DiskLoc(0, 1000), notifier.moves[0] );
+        ASSERT_EQUALS( DiskLoc(0, 1100), notifier.moves[1] );
+        ASSERT_EQUALS( 2U, adaptor.inserts.size() );
+        ASSERT_EQUALS( DiskLoc(2, 1000), adaptor.inserts[0] );
+        ASSERT_EQUALS( DiskLoc(2, 1104), adaptor.inserts[1] );
+
+        // nothing sparse is left
+        ASSERT_OK( rs.compactOnlineBatch( &txn, &adaptor, &notifier, &options, 1, &stats, &done ) );
+        ASSERT_TRUE( done );
+        ASSERT_EQUALS( 2, stats.recordsMoved );
+    }
+
+    /**
+     * Deletes in the extent being drained go back on the deleted lists once the compaction is
+     * abandoned, and the next one resumes with that extent.
+     */
+    TEST( SimpleRecordStoreV1, CompactOnlineAbandon ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 1100), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(2, 1000), 1000},
+                {DiskLoc(0, 1200), 6800},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        CompactOptions options;
+        CompactStats stats;
+        RecordingCompactAdaptor adaptor;
+        RecordingMoveNotifier notifier;
+        bool done = false;
+
+        ASSERT_OK( rs.compactOnlineBatch( &txn, &adaptor, &notifier, &options, 1, &stats, &done ) );
+        ASSERT_FALSE( done );
+        ASSERT_EQUALS( 1, stats.recordsMoved );
+
+        rs.compactOnlineAbandon( &txn );
+        rs.deleteRecord( &txn, DiskLoc(0, 1100) );
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 1100), 100},
+                {DiskLoc(2, 1000), 104},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(2, 1104), 896},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        ASSERT_OK( rs.compactOnlineBatch( &txn, &adaptor, &notifier, &options, 1, &stats, &done ) );
+        ASSERT_TRUE( done );
+        ASSERT_EQUALS( 1, stats.recordsMoved );
+        ASSERT_EQUALS( 1, stats.extentsFreed );
+        ASSERT_EQUALS( DiskLoc(1, 0), md->firstExtent( &txn ) );
+    }
+
+    /**
+     * Scans in both directions cross extent boundaries with read ahead enabled, skipping the
+     * empty extent in between.
+     */
+    TEST( SimpleRecordStoreV1, ScanWithReadAhead ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(2, 1000), 100},
+                {DiskLoc(2, 1100), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 1000), 1000},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        const DiskLoc expected[] = {
+            DiskLoc(0, 1000), DiskLoc(0, 1100), DiskLoc(2, 1000), DiskLoc(2, 1100)
+        };
+
+        {
+            scoped_ptr<RecordIterator> it( rs.getIterator( &txn, DiskLoc(), false,
+                                                           CollectionScanParams::FORWARD ) );
+            for ( int i = 0; i < 4; i++ ) {
+                ASSERT_FALSE( it->isEOF() );
+                ASSERT_EQUALS( expected[i], it->getNext() );
+            }
+            ASSERT_TRUE( it->isEOF() );
+        }
+
+        {
+            scoped_ptr<RecordIterator> it( rs.getIterator( &txn, DiskLoc(), false,
+                                                           CollectionScanParams::BACKWARD ) );
+            for ( int i = 3; i >= 0; i-- ) {
+                ASSERT_FALSE( it->isEOF() );
+                ASSERT_EQUALS( expected[i], it->getNext() );
+            }
+            ASSERT_TRUE( it->isEOF() );
+        }
+    }
 }
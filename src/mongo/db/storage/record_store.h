@@ -226,6 +226,35 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats ) = 0;
 
+        // does this RecordStore support compactOnlineBatch
+        virtual bool compactOnlineSupported() const { return false; }
+
+        /**
+         * One bounded step of an online compaction, which does not need the caller to hold its
+         * lock for the whole run. Moves at most maxRecords records out of the sparsest storage
+         * so that it can be freed. Each move is reported to notifier before the old record is
+         * deleted and to adaptor->inserted() afterwards, as for an update that moves a record.
+         * Progress is kept by the RecordStore between calls; *done is set when nothing is
+         * left to move.
+         */
+        virtual Status compactOnlineBatch( OperationContext* txn,
+                                           RecordStoreCompactAdaptor* adaptor,
+                                           UpdateMoveNotifier* notifier,
+                                           const CompactOptions* options,
+                                           int maxRecords,
+                                           CompactStats* stats,
+                                           bool* done ) {
+            return Status( ErrorCodes::IllegalOperation,
+                           "online compact not supported by this storage engine" );
+        }
+
+        /**
+         * Gives up on an online compaction that won't be resumed, e.g. because the command
+         * running it was interrupted. Storage it had already taken out of use may stay unused
+         * until the next compaction, as after an interrupted compact().
+         */
+        virtual void compactOnlineAbandon( OperationContext* txn ) {}
+
         /**
          * @param full - does more checks
          * @param scanData - scans each document
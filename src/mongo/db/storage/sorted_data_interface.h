@@ -178,6 +178,12 @@ namespace mongo {
             virtual void savePosition() = 0;
 
             virtual void restorePosition(OperationContext* txn) = 0;
+
+            /**
+             * Returns true if the last restorePosition() knew the cursor's position was still
+             * valid without having to look for the saved key.
+             */
+            virtual bool restoredInPlace() const { return false; }
         };
 
         /**
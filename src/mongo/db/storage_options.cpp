@@ -115,4 +115,10 @@ namespace mongo {
                                                      true,
                                                      true);
 
+    ExportedServerParameter<int> TrickleFlushMBpsSetting(ServerParameterSet::getGlobal(),
+                                                         "trickleFlushMBps",
+                                                         &storageGlobalParams.trickleFlushMBps,
+                                                         true,
+                                                         true);
+
 } // namespace mongo
@@ -50,8 +50,13 @@ namespace mongo {
             lenForNewNsFiles(16 * 1024 * 1024),
             preallocj(true),
             journalCommitInterval(0), // 0 means use default
+            preallocFilesAhead(1),
             quota(false), quotaFiles(8),
-            syncdelay(60)
+            syncdelay(60),
+            trickleFlushMBps(32),
+            numaInterleave(false),
+            hugePages(false),
+            journalNumaNode(-1)
         {
             repairpath = dbpath;
             dur = false;
@@ -78,6 +83,7 @@ namespace mongo {
 
         bool preallocj;        // --nopreallocj no preallocation of journal files
         bool prealloc;         // --noprealloc no preallocation of data files
+        int preallocFilesAhead; // --preallocDataFilesAhead data files kept allocated ahead of use
         bool smallfiles;       // --smallfiles allocate smaller data files
         bool noTableScan;      // --notablescan no table scans allowed
 
@@ -104,6 +110,15 @@ namespace mongo {
         int quotaFiles;        // --quotaFiles
 
         double syncdelay;      // seconds between fsyncs
+
+        // rate at which data written since the last fsync is trickled out between them, so
+        // that the fsync has less to do. 0 disables trickling.
+        int trickleFlushMBps;
+
+        bool numaInterleave;   // --numaInterleave interleave data file pages across numa nodes
+        bool hugePages;        // --hugePages ask for transparent huge pages for data file views
+        int journalNumaNode;   // --journalNumaNode run the journal and place private views on
+                               // this node; -1 leaves placement to the os
     };
 
     extern StorageGlobalParams storageGlobalParams;
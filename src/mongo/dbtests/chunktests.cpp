@@ -40,6 +40,7 @@ namespace mongo {
     public:
         void setShardKey( const BSONObj &keyPattern ) {
             const_cast<ShardKeyPattern&>(_key) = ShardKeyPattern( keyPattern );
+            _lineage.reset( new ChunkManagerLineage( _ns, _key ) );
         }
         void setSingleChunkForShards( const vector<BSONObj> &splitPoints ) {
             ChunkMap &chunkMap = const_cast<ChunkMap&>( _chunkMap );
@@ -141,6 +141,38 @@ namespace mongo {
 
 namespace JsobjTests {
 
+    /** the v:2 key of 'o' must give back 'o' and order like it under ascending and descending */
+    void keyV2Test(const BSONObj& o) {
+        static BSONObj last;
+
+        const Ordering asc = Ordering::make(BSONObj());
+        const Ordering desc = Ordering::make(BSON("a" << -1 << "b" << -1 << "c" << -1));
+
+        KeyV2Owned k(o, asc);
+        ASSERT_EQUALS( 0, o.woCompare(k.toBson(), BSONObj(), /*considerfieldname*/false) );
+        ASSERT( k.woEqual(k) );
+
+        if( !last.isEmpty() ) {
+            KeyV2Owned kLast(last, asc);
+            KeyV2Owned d(o, desc);
+            KeyV2Owned dLast(last, desc);
+
+            int r1 = o.woCompare(last, asc, false);
+            int r2 = k.woCompare(kLast, asc);
+            ASSERT( (r1<0 && r2<0) || (r1>0 && r2>0) || r1==r2 );
+            ASSERT_EQUALS( r2 == 0, k.woEqual(kLast) );
+
+            // the shared leading bytes don't change the answer
+            ASSERT_EQUALS( r2 < 0, k.woCompare(kLast, asc, k.commonPrefix(kLast)) < 0 );
+
+            r1 = o.woCompare(last, desc, false);
+            r2 = d.woCompare(dLast, desc);
+            ASSERT( (r1<0 && r2<0) || (r1>0 && r2>0) || r1==r2 );
+        }
+
+        last = o.getOwned();
+    }
+
     void keyTest(const BSONObj& o, bool mustBeCompact = false) {
         static KeyV1Owned *kLast;
         static BSONObj last;
@@ -196,6 +228,8 @@ namespace JsobjTests {
         delete kLast;
         kLast = key;
         last = o.getOwned();
+
+        keyV2Test(o);
     }
 
     class BufBuilderBasic {
@@ -27,6 +27,8 @@
 
 #include "mongo/dbtests/mock/mock_dbclient_connection.h"
 
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/dbtests/mock/mock_dbclient_cursor.h"
 #include "mongo/util/net/sock.h"
 #include "mongo/util/time_support.h"
@@ -162,7 +164,15 @@ namespace mongo {
     }
 
     void MockDBClientConnection::killCursor(long long cursorID) {
-        verify(false); // unimplemented
+        checkConnection();
+
+        try {
+            _remoteServer->killCursor(_remoteServerInstanceID, cursorID);
+        }
+        catch (const mongo::SocketException&) {
+            _isFailed = true;
+            throw;
+        }
     }
 
     bool MockDBClientConnection::callRead(mongo::Message& toSend , mongo::Message& response) {
@@ -174,21 +184,130 @@ namespace mongo {
             mongo::Message& response,
             bool assertOk,
             string* actualServer)  {
-        verify(false); // unimplemented
-        return false;
+        checkConnection();
+
+        try {
+            handleRequest(toSend, &response);
+        }
+        catch (const mongo::SocketException&) {
+            _isFailed = true;
+            if (assertOk) {
+                throw;
+            }
+            return false;
+        }
+
+        if (actualServer) {
+            *actualServer = getServerAddress();
+        }
+
+        return true;
     }
 
     void MockDBClientConnection::say(mongo::Message& toSend, bool isRetry, string* actualServer) {
-        verify(false); // unimplemented
+        checkConnection();
+
+        boost::shared_ptr<Message> reply(new Message());
+        try {
+            handleRequest(toSend, reply.get());
+        }
+        catch (const mongo::SocketException&) {
+            _isFailed = true;
+            throw;
+        }
+
+        if (!reply->empty()) {
+            _pendingReplies.push_back(reply);
+        }
+
+        if (actualServer) {
+            *actualServer = getServerAddress();
+        }
+    }
+
+    bool MockDBClientConnection::recv(mongo::Message& m) {
+        if (_pendingReplies.empty()) {
+            // A real connection would block forever
+            _isFailed = true;
+            return false;
+        }
+
+        m.reset();
+        m = *_pendingReplies.front();
+        _pendingReplies.pop_front();
+        return true;
     }
 
     void MockDBClientConnection::sayPiggyBack(mongo::Message& toSend) {
-        verify(false); // unimplemented
+        say(toSend);
     }
 
     bool MockDBClientConnection::lazySupported() const {
-        verify(false); // unimplemented
-        return false;
+        return true;
+    }
+
+    void MockDBClientConnection::handleRequest(mongo::Message& toSend, mongo::Message* response) {
+        DbMessage d(toSend);
+
+        vector<BSONObj> batch;
+        long long cursorId = 0;
+        int resultFlags = 0;
+
+        switch (toSend.operation()) {
+        case dbQuery: {
+            QueryMessage q(d);
+
+            if (NamespaceString(q.ns).isCommand()) {
+                BSONObj info;
+                _remoteServer->runCommand(_remoteServerInstanceID, nsToDatabase(q.ns), q.query,
+                        info, q.queryOptions);
+                replyToQuery(0, *response, info);
+                return;
+            }
+
+            cursorId = _remoteServer->openCursor(_remoteServerInstanceID, q.ns,
+                    std::abs(q.ntoreturn), &batch);
+            break;
+        }
+        case dbGetMore: {
+            d.getns();
+            const int nToReturn = d.pullInt();
+            cursorId = d.pullInt64();
+
+            if (!_remoteServer->getMore(_remoteServerInstanceID, &cursorId, nToReturn, &batch)) {
+                cursorId = 0;
+                resultFlags = ResultFlag_CursorNotFound;
+            }
+            break;
+        }
+        case dbKillCursors: {
+            d.pullInt(); // reserved
+            const int n = d.pullInt();
+            for (int i = 0; i < n; i++) {
+                _remoteServer->killCursor(_remoteServerInstanceID, d.pullInt64());
+            }
+            return;
+        }
+        default:
+            verify(false); // unimplemented
+        }
+
+        BufBuilder b;
+        b.skip(sizeof(QueryResult::Value));
+        for (vector<BSONObj>::const_iterator iter = batch.begin(); iter != batch.end(); ++iter) {
+            b.appendBuf(iter->objdata(), iter->objsize());
+        }
+
+        QueryResult::View qr = b.buf();
+        qr.setResultFlags(resultFlags);
+        qr.msgdata().setLen(b.len());
+        qr.msgdata().setOperation(opReply);
+        qr.setCursorId(cursorId);
+        qr.setStartingFrom(0);
+        qr.setNReturned(batch.size());
+        b.decouple();
+
+        response->setData(qr.view2ptr(), true);
     }
 
     double MockDBClientConnection::getSoTimeout() const {
@@ -28,6 +28,7 @@
 #pragma once
 
 #include <boost/shared_ptr.hpp>
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -109,20 +110,36 @@ namespace mongo {
                 int queryOptions = 0);
 
         //
-        // Unsupported methods (these are pure virtuals in the base class)
+        // Wire protocol methods. Queries, getMores, killCursors and commands are served by the
+        // cursors of the remote server, so a real DBClientCursor can run over this connection.
+        // Replies to messages sent with say are queued until read with recv.
         //
 
         void killCursor(long long cursorID);
-        bool callRead(mongo::Message& toSend , mongo::Message& response);
         bool call(mongo::Message& toSend, mongo::Message& response, bool assertOk = true,
                 std::string* actualServer = 0);
         void say(mongo::Message& toSend, bool isRetry = false, std::string* actualServer = 0);
+        bool recv(mongo::Message& m);
         void sayPiggyBack(mongo::Message& toSend);
         bool lazySupported() const;
 
+        //
+        // Unsupported methods (these are pure virtuals in the base class)
+        //
+
+        bool callRead(mongo::Message& toSend , mongo::Message& response);
+
     private:
         void checkConnection();
 
+        /**
+         * Runs a request against the remote server. Fills response with the reply if the
+         * operation has one.
+         */
+        void handleRequest(mongo::Message& toSend, mongo::Message* response);
+
+        std::deque<boost::shared_ptr<mongo::Message> > _pendingReplies;
+
         MockRemoteDBServer::InstanceID _remoteServerInstanceID;
         MockRemoteDBServer* _remoteServer;
         bool _isFailed;
@@ -64,8 +64,10 @@ namespace mongo {
             _isRunning(true),
             _hostAndPort(hostAndPort),
             _delayMilliSec(0),
+            _nextCursorId(1),
             _cmdCount(0),
             _queryCount(0),
+            _getMoreCount(0),
             _instanceID(0) {
         insert(IdentityNS, BSON(HostField(hostAndPort)), 0);
     }
@@ -198,6 +200,84 @@ namespace mongo {
         return BSONArray(result.obj());
     }
 
+    long long MockRemoteDBServer::openCursor(MockRemoteDBServer::InstanceID id,
+            const string& ns,
+            int batchSize,
+            vector<BSONObj>* batch) {
+        checkIfUp(id);
+
+        if (_delayMilliSec > 0) {
+            mongo::sleepmillis(_delayMilliSec);
+        }
+
+        checkIfUp(id);
+
+        scoped_spinlock sLock(_lock);
+        _queryCount++;
+
+        MockCursor cursor;
+        cursor.docs = _dataMgr[ns];
+        cursor.pos = 0;
+
+        // Like mongod, the first batch defaults to 101 documents
+        if (!fillBatch(&cursor, batchSize == 0 ? 101 : batchSize, batch)) {
+            return 0;
+        }
+
+        const long long cursorId = _nextCursorId++;
+        _cursors[cursorId] = cursor;
+        return cursorId;
+    }
+
+    bool MockRemoteDBServer::getMore(MockRemoteDBServer::InstanceID id,
+            long long* cursorId,
+            int batchSize,
+            vector<BSONObj>* batch) {
+        checkIfUp(id);
+
+        if (_delayMilliSec > 0) {
+            mongo::sleepmillis(_delayMilliSec);
+        }
+
+        checkIfUp(id);
+
+        scoped_spinlock sLock(_lock);
+        _getMoreCount++;
+
+        MockCursorMap::iterator iter = _cursors.find(*cursorId);
+        if (iter == _cursors.end()) {
+            return false;
+        }
+
+        if (!fillBatch(&iter->second, batchSize, batch)) {
+            _cursors.erase(iter);
+            *cursorId = 0;
+        }
+
+        return true;
+    }
+
+    void MockRemoteDBServer::killCursor(MockRemoteDBServer::InstanceID id, long long cursorId) {
+        checkIfUp(id);
+
+        scoped_spinlock sLock(_lock);
+        _cursors.erase(cursorId);
+    }
+
+    bool MockRemoteDBServer::fillBatch(MockCursor* cursor,
+            int batchSize,
+            vector<BSONObj>* batch) {
+        const size_t remaining = cursor->docs.size() - cursor->pos;
+        const size_t count = (batchSize <= 0) ? remaining :
+                std::min(remaining, static_cast<size_t>(batchSize));
+
+        for (size_t i = 0; i < count; i++) {
+            batch->push_back(cursor->docs[cursor->pos++]);
+        }
+
+        return cursor->pos < cursor->docs.size();
+    }
+
     mongo::ConnectionString::ConnectionType MockRemoteDBServer::type() const {
         return mongo::ConnectionString::CUSTOM;
     }
@@ -212,10 +292,21 @@ namespace mongo {
         return _queryCount;
     }
 
+    size_t MockRemoteDBServer::getGetMoreCount() const {
+        scoped_spinlock sLock(_lock);
+        return _getMoreCount;
+    }
+
     void MockRemoteDBServer::clearCounters() {
         scoped_spinlock sLock(_lock);
         _cmdCount = 0;
         _queryCount = 0;
+        _getMoreCount = 0;
+    }
+
+    size_t MockRemoteDBServer::getOpenCursorCount() const {
+        scoped_spinlock sLock(_lock);
+        return _cursors.size();
     }
 
     string MockRemoteDBServer::getServerAddress() const {
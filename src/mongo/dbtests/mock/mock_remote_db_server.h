@@ -163,6 +163,37 @@ namespace mongo {
                 int queryOptions = 0,
                 int batchSize = 0);
 
+        /**
+         * Opens a server side cursor over the documents in a collection and returns the first
+         * batch, like a query sent over the wire.
+         *
+         * @param ns the namespace to read.
+         * @param batchSize the maximum number of documents per batch, 0 for the server default.
+         * @param batch receives the documents of the first batch.
+         *
+         * @return the id of the cursor, or 0 if the first batch exhausted it.
+         */
+        long long openCursor(InstanceID id,
+                const std::string& ns,
+                int batchSize,
+                std::vector<mongo::BSONObj>* batch);
+
+        /**
+         * Returns the next batch of a cursor opened with openCursor.
+         *
+         * @param cursorId the cursor to read. Set to 0 when the cursor is exhausted.
+         * @param batchSize the maximum number of documents to return, 0 for all of them.
+         * @param batch receives the documents of the batch.
+         *
+         * @return false if there is no such cursor on this server.
+         */
+        bool getMore(InstanceID id,
+                long long* cursorId,
+                int batchSize,
+                std::vector<mongo::BSONObj>* batch);
+
+        void killCursor(InstanceID id, long long cursorId);
+
         //
         // Getters
         //
@@ -185,8 +216,14 @@ namespace mongo {
 
         size_t getCmdCount() const;
         size_t getQueryCount() const;
+        size_t getGetMoreCount() const;
         void clearCounters();
 
+        /**
+         * @return the number of cursors opened with openCursor that are still open
+         */
+        size_t getOpenCursorCount() const;
+
     private:
         /**
          * A very simple class for cycling through a set of BSONObj
@@ -214,6 +251,22 @@ namespace mongo {
         typedef unordered_map<std::string, boost::shared_ptr<CircularBSONIterator> > CmdToReplyObj;
         typedef unordered_map<std::string, std::vector<BSONObj> > MockDataMgr;
 
+        /**
+         * A snapshot of a collection being read through openCursor and getMore
+         */
+        struct MockCursor {
+            std::vector<BSONObj> docs;
+            size_t pos;
+        };
+
+        typedef unordered_map<long long, MockCursor> MockCursorMap;
+
+        /**
+         * Moves up to batchSize documents from the cursor to batch, all remaining ones if
+         * batchSize is 0. Returns true if the cursor has more documents.
+         */
+        static bool fillBatch(MockCursor* cursor, int batchSize, std::vector<BSONObj>* batch);
+
         bool _isRunning;
 
         const std::string _hostAndPort;
@@ -224,12 +277,15 @@ namespace mongo {
         //
         CmdToReplyObj _cmdMap;
         MockDataMgr _dataMgr;
+        MockCursorMap _cursors;
+        long long _nextCursorId;
 
         //
         // Op Counters
         //
         size_t _cmdCount;
         size_t _queryCount;
+        size_t _getMoreCount;
 
         // Unique id for every restart of this server used for rejecting requests from
         // connections that are still "connected" to the old instance
@@ -0,0 +1,231 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * Tests for reading ahead on DBClientCursor and for the merge in ParallelSortClusteredCursor,
+ * run against mock shards served through MockDBClientConnection's wire protocol methods.
+ */
+
+#include "mongo/client/connpool.h"
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/client/parallel.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/dbtests/mock/mock_conn_registry.h"
+#include "mongo/dbtests/mock/mock_remote_db_server.h"
+#include "mongo/s/shard.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+using mongo::BSONObj;
+using mongo::DBClientCursor;
+using mongo::MockConnRegistry;
+using mongo::MockRemoteDBServer;
+using mongo::ParallelSortClusteredCursor;
+using mongo::Query;
+using mongo::ScopedDbConnection;
+using mongo::ServerAndQuery;
+using mongo::ShardConnection;
+
+using std::set;
+using std::string;
+using std::vector;
+
+namespace mongo_test {
+
+    const string NS = "test.user";
+
+    /**
+     * Sets up a number of mock shards reachable through the connection pools.
+     *
+     * Warning: cannot run in parallel
+     */
+    class MockShardsFixture : public mongo::unittest::Test {
+    public:
+        void setUp() {
+            mongo::ConnectionString::setConnectionHook(MockConnRegistry::get()->getConnStrHook());
+        }
+
+        void tearDown() {
+            ShardConnection::clearPool();
+            ScopedDbConnection::clearPool();
+
+            for (vector<MockRemoteDBServer*>::iterator iter = _shards.begin();
+                    iter != _shards.end(); ++iter) {
+                MockConnRegistry::get()->removeServer((*iter)->getServerAddress());
+                delete *iter;
+            }
+
+            _shards.clear();
+        }
+
+        MockRemoteDBServer* addShard() {
+            MockRemoteDBServer* shard = new MockRemoteDBServer(
+                    mongo::str::stream() << "$shard" << _shards.size() << ":27017");
+            MockConnRegistry::get()->addServer(shard);
+            _shards.push_back(shard);
+            return shard;
+        }
+
+    private:
+        vector<MockRemoteDBServer*> _shards;
+    };
+
+    TEST_F(MockShardsFixture, ReadAheadBeforeBatchIsDrained) {
+        MockRemoteDBServer* shard = addShard();
+        for (int x = 0; x < 10; x++) {
+            shard->insert(NS, BSON("x" << x));
+        }
+
+        ScopedDbConnection conn(shard->getServerAddress());
+        DBClientCursor cursor(conn.get(), NS, BSONObj(), 0, 0, NULL, 0, 4);
+        ASSERT(cursor.init());
+        cursor.attach(&conn);
+
+        ASSERT_EQUALS(0, cursor.next()["x"].numberInt());
+        ASSERT_EQUALS(1, cursor.next()["x"].numberInt());
+
+        ASSERT(cursor.prefetchMore());
+        ASSERT(cursor.isPrefetching());
+        ASSERT_EQUALS(1U, shard->getGetMoreCount());
+
+        // The rest of the first batch is still readable while the getMore is outstanding
+        ASSERT_EQUALS(2, cursor.objsLeftInBatch());
+
+        int x = 2;
+        while (cursor.more()) {
+            ASSERT_EQUALS(x++, cursor.next()["x"].numberInt());
+        }
+
+        ASSERT_EQUALS(10, x);
+        ASSERT_FALSE(cursor.isPrefetching());
+        ASSERT_EQUALS(2U, shard->getGetMoreCount());
+        ASSERT_EQUALS(0U, shard->getOpenCursorCount());
+    }
+
+    TEST_F(MockShardsFixture, NoReadAheadOnCallersConnection) {
+        MockRemoteDBServer* shard = addShard();
+        for (int x = 0; x < 10; x++) {
+            shard->insert(NS, BSON("x" << x));
+        }
+
+        ScopedDbConnection conn(shard->getServerAddress());
+        {
+            DBClientCursor cursor(conn.get(), NS, BSONObj(), 0, 0, NULL, 0, 4);
+            ASSERT(cursor.init());
+
+            ASSERT_FALSE(cursor.prefetchMore());
+            ASSERT_EQUALS(0U, shard->getGetMoreCount());
+        }
+
+        conn.done();
+        ASSERT_EQUALS(0U, shard->getOpenCursorCount());
+    }
+
+    TEST_F(MockShardsFixture, KillCursorWithReadAheadOutstanding) {
+        MockRemoteDBServer* shard = addShard();
+        for (int x = 0; x < 20; x++) {
+            shard->insert(NS, BSON("x" << x));
+        }
+
+        {
+            ScopedDbConnection conn(shard->getServerAddress());
+            DBClientCursor cursor(conn.get(), NS, BSONObj(), 0, 0, NULL, 0, 4);
+            ASSERT(cursor.init());
+            cursor.attach(&conn);
+
+            ASSERT(cursor.prefetchMore());
+            ASSERT_EQUALS(1U, shard->getOpenCursorCount());
+        }
+
+        ASSERT_EQUALS(0U, shard->getOpenCursorCount());
+    }
+
+    TEST_F(MockShardsFixture, SortedMergeAcrossShards) {
+        const int numShards = 3;
+        const int docsPerShard = 300;
+
+        set<ServerAndQuery> servers;
+        vector<MockRemoteDBServer*> shards;
+        for (int i = 0; i < numShards; i++) {
+            MockRemoteDBServer* shard = addShard();
+            for (int x = i; x < numShards * docsPerShard; x += numShards) {
+                shard->insert(NS, BSON("x" << x));
+            }
+
+            servers.insert(ServerAndQuery(shard->getServerAddress()));
+            shards.push_back(shard);
+        }
+
+        ParallelSortClusteredCursor cursor(servers, NS, Query().sort(BSON("x" << 1)));
+        cursor.init();
+
+        int x = 0;
+        while (cursor.more()) {
+            ASSERT_EQUALS(x++, cursor.next()["x"].numberInt());
+        }
+
+        ASSERT_EQUALS(numShards * docsPerShard, x);
+
+        // Every shard returned a default sized first batch and the rest in one read ahead
+        for (vector<MockRemoteDBServer*>::iterator iter = shards.begin();
+                iter != shards.end(); ++iter) {
+            ASSERT_EQUALS(1U, (*iter)->getQueryCount());
+            ASSERT_EQUALS(1U, (*iter)->getGetMoreCount());
+            ASSERT_EQUALS(0U, (*iter)->getOpenCursorCount());
+        }
+    }
+
+    TEST_F(MockShardsFixture, UnsortedMergeAcrossShards) {
+        const int numShards = 3;
+        const int docsPerShard = 300;
+
+        set<ServerAndQuery> servers;
+        for (int i = 0; i < numShards; i++) {
+            MockRemoteDBServer* shard = addShard();
+            for (int x = 0; x < docsPerShard; x++) {
+                shard->insert(NS, BSON("x" << x));
+            }
+
+            servers.insert(ServerAndQuery(shard->getServerAddress()));
+        }
+
+        ParallelSortClusteredCursor cursor(servers, NS, Query());
+        cursor.init();
+
+        int count = 0;
+        while (cursor.more()) {
+            cursor.next();
+            count++;
+        }
+
+        ASSERT_EQUALS(numShards * docsPerShard, count);
+    }
+}
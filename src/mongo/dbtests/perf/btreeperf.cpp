@@ -29,8 +29,13 @@
 
 /**
  * Performance timing and space utilization testing for btree indexes.
+ *
+ * Pass --indexVersion N to build the _id index with index version N, e.g. to compare the size
+ * and lookup speed of v:1 and v:2 indexes on the same script.
  */
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include <boost/random/bernoulli_distribution.hpp>
@@ -332,6 +337,43 @@ private:
     variate_generator< mt19937&, bernoulli_distribution<> > _generator;
 };
 
+/**
+ * Remembers the _id of the most recently inserted documents, so that the lookup speed of the
+ * index can be measured on keys it is likely to contain.
+ */
+class RecentKeys {
+public:
+    RecentKeys() : _next( 0 ) {
+    }
+    void push( const BSONObj &inserted ) {
+        BSONObj key = inserted[ "_id" ].wrap().getOwned();
+        if ( _keys.size() < MaxKeys ) {
+            _keys.push_back( key );
+        }
+        else {
+            _keys[ _next ] = key;
+            _next = ( _next + 1 ) % MaxKeys;
+        }
+    }
+    /** @return the average microseconds taken to find each remembered key */
+    double timeLookups( DBClientConnection &conn ) const {
+        if ( _keys.empty() ) {
+            return 0;
+        }
+        Timer t;
+        for( vector< BSONObj >::const_iterator i = _keys.begin(); i != _keys.end(); ++i ) {
+            conn.findOne( ns, Query( *i ).hint( BSON( "_id" << 1 ) ) );
+        }
+        return double( t.micros() ) / _keys.size();
+    }
+private:
+    static const size_t MaxKeys = 1000;
+    vector< BSONObj > _keys;
+    size_t _next;
+};
+
+RecentKeys recentKeys;
+
 /** Runs a strategy on a connection, with specified mix of inserts and removes. */
 class InsertAndRemoveRunner {
 public:
@@ -345,7 +387,9 @@ public:
             _conn.remove( ns, _strategy.removeObj(), true );
         }
         else {
-            _conn.insert( ns, _strategy.insertObj() );
+            BSONObj obj = _strategy.insertObj();
+            _conn.insert( ns, obj );
+            recentKeys.push( obj );
         }
     }
 private:
@@ -403,6 +447,7 @@ public:
         }
         else {
             _conn.insert( ns, val );
+            recentKeys.push( val );
         }
     }
 private:
@@ -412,10 +457,22 @@ private:
 
 int main( int argc, const char **argv ) {
 
+    int indexVersion = -1;
+    for( int i = 1; i < argc; ++i ) {
+        if ( strcmp( argv[ i ], "--indexVersion" ) == 0 && i + 1 < argc ) {
+            indexVersion = atoi( argv[ ++i ] );
+        }
+    }
+
     DBClientConnection conn;
     conn.connect( "127.0.0.1:27017" );
     conn.dropCollection( ns );
 
+    // Build the _id index ourselves so that its version can be chosen.
+    BSONObj info;
+    conn.runCommand( db, BSON( "create" << "btreeperf" << "autoIndexId" << false ), info );
+    conn.ensureIndex( ns, BSON( "_id" << 1 ), false, "_id_", false, false, indexVersion );
+
 //    UniformInsertRangedUniformRemoveInteger strategy;
 //    UniformInsertUniformRemoveInteger strategy;
 //    UniformInsertRangedUniformRemoveString strategy;
@@ -430,7 +487,7 @@ int main( int argc, const char **argv ) {
     BSONObj statsCmd = BSON( "collstats" << index_collection );
 
     // Print header, unless we are generating a script (in that case, comment this out).
-    cout << "ops,milliseconds,docs,totalBucketSize" << endl;
+    cout << "ops,milliseconds,docs,totalBucketSize,keysPerBucket,lookupMicros" << endl;
 
     long long i = 0;
     long long n = 10000000000;
@@ -447,8 +504,12 @@ int main( int argc, const char **argv ) {
             conn.runCommand( db, statsCmd, result );
             // The total number of bytes used for all allocated 8K buckets of the
             // btree.
-            long long totalBucketSize = result.getField( "count" ).numberLong() * 8192;
-            cout << i << ',' << t.millis() << ',' << docs << ',' << totalBucketSize << endl;
+            long long buckets = result.getField( "count" ).numberLong();
+            long long totalBucketSize = buckets * 8192;
+            // Point lookups of recently inserted keys, timed apart from the writes.
+            double lookupMicros = recentKeys.timeLookups( conn );
+            cout << i << ',' << t.millis() << ',' << docs << ',' << totalBucketSize << ','
+                 << ( buckets ? double( docs ) / buckets : 0 ) << ',' << lookupMicros << endl;
         }
     }
 }
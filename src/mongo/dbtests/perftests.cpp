@@ -1042,6 +1042,28 @@ namespace PerfTests {
         }
     };
 
+    /** $where throughput on wide documents where the function reads a single field */
+    class Where50Fields : public B {
+    public:
+        virtual int howLongMillis() { return 3000; }
+        virtual unsigned batchSize() { return 1; }
+        string name() { return "where-50-fields"; }
+        void prep() {
+            for( int i = 0; i < 1000; i++ ) {
+                BSONObjBuilder b;
+                b.append( "_id", i );
+                b.append( "a", i % 10 );
+                for( int f = 0; f < 48; f++ )
+                    b.append( string( str::stream() << "f" << f ), "some string value" );
+                client()->insert( ns(), b.obj() );
+            }
+        }
+        void timed() {
+            long long n = client()->count( ns(), BSON( "$where" << "this.a > 5" ) );
+            verify( n == 400 );
+        }
+    };
+
     /** upserts about 32k records and then keeps updating them
         2 indexes
     */
@@ -1367,6 +1389,7 @@ namespace PerfTests {
                 add< Update1 >();
                 add< MoreIndexes<Update1> >();
                 add< InsertBig >();
+                add< Where50Fields >();
                 add< FailPointTest<false, false> >();
                 add< FailPointTest<true, false> >();
                 add< FailPointTest<true, true> >();
@@ -30,18 +30,24 @@
 
 #include "mongo/platform/basic.h"
 
+#include <boost/thread.hpp>
+
 #include "mongo/client/dbclientmockcursor.h"
 #include "mongo/client/parallel.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/dbtests/config_server_fixture.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/chunk_diff.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
 #include "mongo/s/type_chunk.h"
 #include "mongo/s/type_collection.h"
+#include "mongo/s/type_database.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace ShardingTests {
 
@@ -283,8 +289,157 @@ namespace ShardingTests {
             ASSERT( newManager.getVersion().toLong() == laterVersion.toLong() );
             ASSERT( newManager.getVersion().epoch() == laterVersion.epoch() );
             ASSERT( static_cast<int>( newManager.getChunkMap().size() ) == numChunks );
+
+            // Only the changed chunk and the one at the old max version are fetched again, the
+            // rest are taken over from the old manager as they are
+            const ChunkMap& oldChunks = manager->getChunkMap();
+            const ChunkMap& newChunks = newManager.getChunkMap();
+            int numReused = 0;
+            for( ChunkMap::const_iterator it = newChunks.begin(); it != newChunks.end(); ++it ){
+                ChunkMap::const_iterator old = oldChunks.find( it->first );
+                ASSERT( old != oldChunks.end() );
+                if( old->second == it->second ) numReused++;
+                ASSERT( it->second->getLineage()->getEpoch() == version.epoch() );
+            }
+            ASSERT_GREATER_THAN_OR_EQUALS( numReused, numChunks - 2 );
+            ASSERT_LESS_THAN( numReused, numChunks );
+        }
+
+    };
+
+    //
+    // Measures routing lookups from many threads while another thread keeps reloading the
+    // database and forcing chunk manager reloads.  Lookups read the published routing snapshot,
+    // so they should neither block on the reloads nor ever see the collection as unsharded.
+    //
+    class DBConfigConcurrentRoutingTest : public ChunkManagerCreateFullTest {
+    public:
+
+        static const int numReaders = 8;
+        static const int lookupsPerReader = 200 * 1000;
+
+        DBConfigConcurrentRoutingTest() : _config( nsGetDB( collName() ) ) {}
+
+        void run(){
+
+            string keyName = "_id";
+            createChunks( keyName );
+
+            BSONObj firstChunk = _client.findOne(ChunkType::ConfigNS, BSONObj()).getOwned();
+            ChunkVersion version = ChunkVersion::fromBSON(firstChunk,
+                                                          ChunkType::DEPRECATED_lastmod());
+
+            _client.insert(DatabaseType::ConfigNS,
+                           BSON(DatabaseType::name(nsGetDB(collName())) <<
+                                DatabaseType::primary(shard().getName()) <<
+                                DatabaseType::DEPRECATED_partitioned(true)));
+
+            BSONObjBuilder collDocBuilder;
+            collDocBuilder << CollectionType::ns(collName());
+            collDocBuilder << CollectionType::keyPattern(BSON( keyName << 1 ));
+            collDocBuilder << CollectionType::unique(false);
+            collDocBuilder << CollectionType::dropped(false);
+            collDocBuilder << CollectionType::DEPRECATED_lastmod(jsTime());
+            collDocBuilder << CollectionType::DEPRECATED_lastmodEpoch(version.epoch());
+            _client.insert(CollectionType::ConfigNS, collDocBuilder.obj());
+
+            ASSERT( _config.load() );
+            ASSERT( _config.isSharded( collName() ) );
+
+            _readersDone.store( 0 );
+            _numReloads.store( 0 );
+            _failures.store( 0 );
+
+            Timer t;
+
+            boost::thread reloader( stdx::bind( &DBConfigConcurrentRoutingTest::reload, this ) );
+
+            vector<boost::shared_ptr<boost::thread> > readers;
+            for( int i = 0; i < numReaders; i++ ){
+                readers.push_back( boost::shared_ptr<boost::thread>(
+                    new boost::thread( stdx::bind( &DBConfigConcurrentRoutingTest::lookup,
+                                                   this ) ) ) );
+            }
+
+            for( size_t i = 0; i < readers.size(); i++ ){
+                readers[i]->join();
+            }
+            reloader.join();
+
+            const long long millis = std::max( t.millis(), 1 );
+            mongo::unittest::log() << "DBConfigConcurrentRoutingTest: "
+                                   << numReaders * lookupsPerReader << " lookups from "
+                                   << numReaders << " threads with " << _numReloads.load()
+                                   << " concurrent reloads in " << millis << "ms ("
+                                   << numReaders * lookupsPerReader * 1000LL / millis
+                                   << "/sec)" << endl;
+
+            // checks in the threads can't ASSERT, an exception there would terminate the process
+            ASSERT_EQUALS( _failures.load(), 0 );
+            ASSERT_GREATER_THAN( _numReloads.load(), 0 );
+        }
+
+    private:
+
+        void check( bool ok, const char* what ){
+            if( ! ok ){
+                mongo::unittest::log() << "DBConfigConcurrentRoutingTest: " << what << endl;
+                _failures.fetchAndAdd( 1 );
+            }
+        }
+
+        void lookup(){
+            ChunkManagerPtr manager;
+            ShardPtr primary;
+
+            try {
+                for( int i = 0; i < lookupsPerReader; i++ ){
+                    if( i % 2 == 0 ){
+                        manager = _config.getChunkManager( collName() );
+                    }
+                    else {
+                        _config.getChunkManagerOrPrimary( collName(), manager, primary );
+                        check( ! primary, "lookup returned a primary for a sharded collection" );
+                    }
+                    check( manager.get() != NULL, "lookup returned no chunk manager" );
+                }
+            }
+            catch( const std::exception& e ){
+                check( false, e.what() );
+            }
+
+            // always counted, the reloader runs until every reader is done
+            _readersDone.fetchAndAdd( 1 );
+        }
+
+        void reload(){
+            Client::initThread( "dbconfigreload" );
+
+            // Alternate full database reloads with forced chunk manager reloads, which both swap
+            // in a new snapshot while the readers are running
+            try {
+                do {
+                    if( _numReloads.load() % 2 == 0 ){
+                        check( _config.load(), "database reload failed" );
+                    }
+                    else {
+                        check( _config.getChunkManager( collName(), false, true ).get() != NULL,
+                               "forced chunk manager reload returned nothing" );
+                    }
+                    _numReloads.fetchAndAdd( 1 );
+                } while( _readersDone.load() < numReaders );
+            }
+            catch( const std::exception& e ){
+                check( false, e.what() );
+            }
+
+            cc().shutdown();
         }
 
+        DBConfig _config;
+        AtomicInt32 _readersDone;
+        AtomicInt32 _numReloads;
+        AtomicInt32 _failures;
     };
 
     class ChunkDiffUnitTest {
@@ -659,6 +814,7 @@ namespace ShardingTests {
             add< ChunkManagerCreateBasicTest >();
             add< ChunkManagerCreateFullTest >();
             add< ChunkManagerLoadBasicTest >();
+            add< DBConfigConcurrentRoutingTest >();
             add< ChunkDiffUnitTestNormal >();
             add< ChunkDiffUnitTestInverse >();
         }
@@ -35,9 +35,11 @@
 #include "mongo/base/owned_pointer_map.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/db/write_concern_options.h"
 #include "mongo/s/chunk.h"
+#include "mongo/s/chunk_load_tracker.h"
 #include "mongo/s/cluster_write.h"
 #include "mongo/s/config.h"
 #include "mongo/s/config_server_checker_service.h"
@@ -51,6 +53,7 @@
 #include "mongo/s/type_mongos.h"
 #include "mongo/s/type_settings.h"
 #include "mongo/s/type_tags.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/timer.h"
@@ -60,6 +63,16 @@ namespace mongo {
 
     MONGO_FP_DECLARE(skipBalanceRound);
 
+    // Upper bound on the migrations issued in a round. Above 1 the migrations are picked between
+    // distinct pairs of shards and run concurrently.
+    MONGO_EXPORT_SERVER_PARAMETER(balancerMaxParallelMigrations, int, 1);
+
+    // Weigh chunks by their data size and recent operations instead of counting them.
+    MONGO_EXPORT_SERVER_PARAMETER(balancerDataSizeCost, bool, false);
+
+    // Share of a chunk's cost that comes from its operation count when balancerDataSizeCost is set.
+    MONGO_EXPORT_SERVER_PARAMETER(balancerOpsCostWeight, double, 0.5);
+
     Balancer balancer;
 
     Balancer::Balancer() : _balancedLastTime(0), _policy( new BalancerPolicy() ) {}
@@ -71,79 +84,114 @@ namespace mongo {
                               const WriteConcernOptions* writeConcern,
                               bool waitForDelete)
     {
-        int movedCount = 0;
+        AtomicInt32 movedCount;
 
+        if ( balancerMaxParallelMigrations <= 1 || candidateChunks->size() <= 1 ) {
+            _moveChunkList( candidateChunks, writeConcern, waitForDelete, &movedCount );
+            return movedCount.load();
+        }
+
+        // The candidates were picked between distinct pairs of shards, so the migrations of
+        // different collections can run at once. The donor holds the collection's distributed
+        // lock for the whole migration, so those of one collection still run one at a time.
+        map<string, vector<CandidateChunkPtr> > candidatesByNs;
         for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
-            const CandidateChunk& chunkInfo = *it->get();
+            candidatesByNs[(*it)->ns].push_back( *it );
+        }
 
-            // Changes to metadata, borked metadata, and connectivity problems should cause us to
-            // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
-            // TODO: Handle all these things more cleanly, since they're expected problems
-            try {
+        {
+            threadpool::ThreadPool migrationPool( candidatesByNs.size() );
+            for ( map<string, vector<CandidateChunkPtr> >::const_iterator it = candidatesByNs.begin();
+                  it != candidatesByNs.end(); ++it ) {
+                migrationPool.schedule( &Balancer::_moveChunkList, this, &it->second,
+                                        writeConcern, waitForDelete, &movedCount );
+            }
+            migrationPool.join();
+        }
 
-                DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
-                verify( cfg );
+        return movedCount.load();
+    }
 
-                // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-                // tried to do so once.
-                ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
-                verify( cm );
+    void Balancer::_moveChunkList(const vector<CandidateChunkPtr>* candidateChunks,
+                                  const WriteConcernOptions* writeConcern,
+                                  bool waitForDelete,
+                                  AtomicInt32* movedCount)
+    {
+        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
+            movedCount->fetchAndAdd( _moveChunk( *it->get(), writeConcern, waitForDelete ) );
+        }
+    }
 
-                ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                    // likely a split happened somewhere
-                    cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
-                    verify( cm );
+    int Balancer::_moveChunk(const CandidateChunk& chunkInfo,
+                             const WriteConcernOptions* writeConcern,
+                             bool waitForDelete)
+    {
+        // Changes to metadata, borked metadata, and connectivity problems should cause us to
+        // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
+        // TODO: Handle all these things more cleanly, since they're expected problems
+        try {
 
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                    if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                        log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
-                        continue;
-                    }
-                }
+            DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
+            verify( cfg );
 
-                BSONObj res;
-                if (c->moveAndCommit(Shard::make(chunkInfo.to),
-                                     Chunk::MaxChunkSize,
-                                     writeConcern,
-                                     waitForDelete,
-                                     0, /* maxTimeMS */
-                                     res)) {
-                    movedCount++;
-                    continue;
+            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+            // tried to do so once.
+            ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            verify( cm );
+
+            ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                // likely a split happened somewhere
+                cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
+                verify( cm );
+
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+                if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                    log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
+                    return 0;
                 }
+            }
 
-                // the move requires acquiring the collection metadata's lock, which can fail
-                log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
-                      << " chunk: " << chunkInfo.chunk << endl;
+            BSONObj res;
+            if (c->moveAndCommit(Shard::make(chunkInfo.to),
+                                 Chunk::MaxChunkSize,
+                                 writeConcern,
+                                 waitForDelete,
+                                 0, /* maxTimeMS */
+                                 res)) {
+                return 1;
+            }
 
-                if ( res["chunkTooBig"].trueValue() ) {
-                    // reload just to be safe
-                    cm = cfg->getChunkManager( chunkInfo.ns );
-                    verify( cm );
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            // the move requires acquiring the collection metadata's lock, which can fail
+            log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
+                  << " chunk: " << chunkInfo.chunk << endl;
 
-                    log() << "forcing a split because migrate failed for size reasons" << endl;
+            if ( res["chunkTooBig"].trueValue() ) {
+                // reload just to be safe
+                cm = cfg->getChunkManager( chunkInfo.ns );
+                verify( cm );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
 
-                    Status status = c->split(true /* atMedian */, NULL, NULL);
-                    log() << "forced split results: " << status << endl;
+                log() << "forcing a split because migrate failed for size reasons" << endl;
 
-                    if ( !status.isOK() ) {
-                        log() << "marking chunk as jumbo: " << c->toString() << endl;
-                        c->markAsJumbo();
-                        // we increment moveCount so we do another round right away
-                        movedCount++;
-                    }
+                Status status = c->split(true /* atMedian */, NULL, NULL);
+                log() << "forced split results: " << status << endl;
 
+                if ( !status.isOK() ) {
+                    log() << "marking chunk as jumbo: " << c->toString() << endl;
+                    c->markAsJumbo();
+                    // we increment moveCount so we do another round right away
+                    return 1;
                 }
-            }
-            catch( const DBException& ex ) {
-                warning() << "could not move chunk " << chunkInfo.chunk.toString()
-                          << ", continuing balancing round" << causedBy( ex ) << endl;
+
             }
         }
+        catch( const DBException& ex ) {
+            warning() << "could not move chunk " << chunkInfo.chunk.toString()
+                      << ", continuing balancing round" << causedBy( ex ) << endl;
+        }
 
-        return movedCount;
+        return 0;
     }
 
     void Balancer::_ping( bool waiting ) {
@@ -299,6 +347,32 @@ namespace mongo {
         }        
     }
 
+    /**
+     * Asks the owning shards for the data size of every chunk of the collection.  This costs a
+     * round trip per chunk, which is why the data size cost model is off by default.  Chunks
+     * whose shard can't answer are left out and cost as much as an average chunk.
+     *
+     * Sizes are not capped at the split threshold, oversized and jumbo chunks are the ones the
+     * model most needs to see.  Operation rates come from the chunkLoadTracker of this mongos,
+     * so they only cover operations routed through it, and only with chunkLoadTracking or
+     * load-based splitting on.
+     */
+    static void _loadChunkStats( const ChunkManager& cm, ChunkStatsMap* chunkStats ) {
+        const long long now = curTimeMillis64();
+        const ChunkMap& chunks = cm.getChunkMap();
+        for ( ChunkMap::const_iterator it = chunks.begin(); it != chunks.end(); ++it ) {
+            const ChunkPtr& c = it->second;
+            try {
+                (*chunkStats)[c->getMin()] =
+                    ChunkStats( c->getPhysicalSize( 0 ),
+                                chunkLoadTracker.getOpsPerSec( cm.getns(), c->getMin(), now ) );
+            }
+            catch ( const DBException& ex ) {
+                LOG(1) << "could not get the data size of " << c->toString() << causedBy( ex );
+            }
+        }
+    }
+
     void Balancer::_doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks ) {
         verify( candidateChunks );
 
@@ -357,6 +431,9 @@ namespace mongo {
 
         OCCASIONALLY warnOnMultiVersion( shardInfo );
 
+        // shards taking part in a migration picked this round, when migrations run in parallel
+        set<string> busyShards;
+
         //
         // 3. For each collection, check if the balancing policy recommends moving anything around.
         //
@@ -490,8 +567,31 @@ namespace mongo {
                 continue;
             }
 
-            CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime );
-            if ( p ) candidateChunks->push_back( CandidateChunkPtr( p ) );
+            ChunkStatsMap chunkStats;
+            scoped_ptr<ChunkCostModel> costModel;
+            if ( balancerDataSizeCost ) {
+                _loadChunkStats( *cm, &chunkStats );
+                costModel.reset( new DataSizeCostModel( chunkStats, balancerOpsCostWeight ) );
+                status.setCostModel( costModel.get() );
+            }
+
+            if ( balancerMaxParallelMigrations <= 1 ) {
+                CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime );
+                if ( p ) candidateChunks->push_back( CandidateChunkPtr( p ) );
+                continue;
+            }
+
+            const unsigned maxMigrations = balancerMaxParallelMigrations;
+            if ( candidateChunks->size() >= maxMigrations )
+                continue;
+
+            vector<MigrateInfo*> migrations;
+            _policy->balanceParallel( ns, status, _balancedLastTime,
+                                      maxMigrations - candidateChunks->size(),
+                                      &busyShards, &migrations );
+            for ( vector<MigrateInfo*>::const_iterator i = migrations.begin(); i != migrations.end(); ++i ) {
+                candidateChunks->push_back( CandidateChunkPtr( *i ) );
+            }
         }
     }
 
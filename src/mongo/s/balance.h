@@ -33,6 +33,7 @@
 #include "mongo/pch.h"
 
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/balancer_policy.h"
 #include "mongo/util/background.h"
 
@@ -47,7 +48,8 @@ namespace mongo {
      *
      * The balancer does act continuously but in "rounds". At a given round, it would decide if there is an imbalance by
      * checking the difference in chunks between the most and least loaded shards. It would issue a request for a chunk
-     * migration per round, if it found so.
+     * migration per round, if it found so. With balancerMaxParallelMigrations above 1 it issues several migrations per round,
+     * each between a pair of shards not involved in any other migration of the round.
      */
     class Balancer : public BackgroundJob {
     public:
@@ -95,7 +97,9 @@ namespace mongo {
         void _doBalanceRound( DBClientBase& conn, std::vector<CandidateChunkPtr>* candidateChunks );
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Issues chunk migration requests.  When parallel migrations are enabled the candidates
+         * of different collections are moved concurrently, those of the same collection still
+         * one at a time.
          *
          * @param candidateChunks possible chunks to move
          * @param writeConcern detailed write concern. NULL means the default write concern.
@@ -106,6 +110,24 @@ namespace mongo {
                         const WriteConcernOptions* writeConcern,
                         bool waitForDelete);
 
+        /**
+         * Moves the candidates one after another, adding the number of chunks effectively moved
+         * to 'movedCount'.
+         */
+        void _moveChunkList(const std::vector<CandidateChunkPtr>* candidateChunks,
+                            const WriteConcernOptions* writeConcern,
+                            bool waitForDelete,
+                            AtomicInt32* movedCount);
+
+        /**
+         * Issues a single chunk migration request.
+         *
+         * @return 1 if the balancer should count the chunk as moved, 0 otherwise
+         */
+        int _moveChunk(const CandidateChunk& chunkInfo,
+                       const WriteConcernOptions* writeConcern,
+                       bool waitForDelete);
+
         /**
          * Marks this balancer as being live on the config server(s).
          */
@@ -32,6 +32,7 @@
 #include "mongo/platform/basic.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "mongo/s/balancer_policy.h"
 #include "mongo/s/chunk.h"
@@ -48,9 +49,42 @@ namespace mongo {
         return str::stream() << min << " -->> " << max << "  on  " << tag;
     }
 
+    DataSizeCostModel::DataSizeCostModel( const ChunkStatsMap& stats, double opsWeight )
+        : _stats( stats ),
+          _opsWeight( std::min( 1.0, std::max( 0.0, opsWeight ) ) ),
+          _avgDataSize( 0 ),
+          _avgOps( 0 ) {
+
+        if ( _stats.empty() )
+            return;
+
+        for ( ChunkStatsMap::const_iterator i = _stats.begin(); i != _stats.end(); ++i ) {
+            _avgDataSize += i->second.dataSizeBytes;
+            _avgOps += i->second.opsPerSec;
+        }
+
+        _avgDataSize /= _stats.size();
+        _avgOps /= _stats.size();
+    }
+
+    double DataSizeCostModel::chunkCost( const ChunkType& chunk ) const {
+        ChunkStatsMap::const_iterator i = _stats.find( chunk.getMin() );
+        if ( i == _stats.end() )
+            return 1;
+
+        const double sizeCost =
+            _avgDataSize > 0 ? i->second.dataSizeBytes / _avgDataSize : 1;
+
+        if ( _avgOps <= 0 )
+            return sizeCost;
+
+        const double opsCost = i->second.opsPerSec / _avgOps;
+        return ( 1 - _opsWeight ) * sizeCost + _opsWeight * opsCost;
+    }
+
     DistributionStatus::DistributionStatus( const ShardInfoMap& shardInfo,
                                             const ShardToChunksMap& shardToChunksMap )
-        : _shardInfo( shardInfo ), _shardChunks( shardToChunksMap ) {
+        : _shardInfo( shardInfo ), _shardChunks( shardToChunksMap ), _costModel( NULL ) {
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
             _shards.insert( i->first );
@@ -100,9 +134,54 @@ namespace mongo {
         return total;
     }
 
-    string DistributionStatus::getBestReceieverShard( const string& tag ) const {
+    double DistributionStatus::chunkCost( const ChunkType& chunk ) const {
+        if ( !_costModel )
+            return 1;
+        return _costModel->chunkCost( chunk );
+    }
+
+    double DistributionStatus::shardLoad( const string& shard ) const {
+        if ( !_costModel )
+            return numberOfChunksInShard( shard );
+
+        ShardToChunksMap::const_iterator i = _shardChunks.find(shard);
+        if (i == _shardChunks.end()) {
+            return 0;
+        }
+
+        double total = 0;
+        const vector<ChunkType*>& chunkList = i->second->vector();
+        for (unsigned j = 0; j < chunkList.size(); j++) {
+            total += _costModel->chunkCost(*chunkList[j]);
+        }
+
+        return total;
+    }
+
+    double DistributionStatus::shardLoadWithTag( const string& shard, const string& tag ) const {
+        if ( !_costModel )
+            return numberOfChunksInShardWithTag( shard, tag );
+
+        ShardToChunksMap::const_iterator i = _shardChunks.find(shard);
+        if (i == _shardChunks.end()) {
+            return 0;
+        }
+
+        double total = 0;
+        const vector<ChunkType*>& chunkList = i->second->vector();
+        for (unsigned j = 0; j < chunkList.size(); j++) {
+            if (tag == getTagForChunk(*chunkList[j])) {
+                total += _costModel->chunkCost(*chunkList[j]);
+            }
+        }
+
+        return total;
+    }
+
+    string DistributionStatus::getBestReceieverShard( const string& tag,
+                                                      const set<string>* busyShards ) const {
         string best;
-        unsigned minChunks = numeric_limits<unsigned>::max();
+        double minLoad = numeric_limits<double>::max();
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
             if ( i->second.isSizeMaxed() ) {
@@ -120,30 +199,39 @@ namespace mongo {
                 continue;
             }
 
-            unsigned myChunks = numberOfChunksInShard( i->first );
-            if ( myChunks >= minChunks ) {
-                LOG(1) << i->first << " has more chunks me:" << myChunks << " best: " << best << ":" << minChunks << endl;
+            if ( busyShards && busyShards->count( i->first ) ) {
+                LOG(1) << i->first << " is already migrating this round" << endl;
+                continue;
+            }
+
+            double myLoad = shardLoad( i->first );
+            if ( myLoad >= minLoad ) {
+                LOG(1) << i->first << " has more load me:" << myLoad << " best: " << best << ":" << minLoad << endl;
                 continue;
             }
 
             best = i->first;
-            minChunks = myChunks;
+            minLoad = myLoad;
         }
 
         return best;
     }
 
-    string DistributionStatus::getMostOverloadedShard( const string& tag ) const {
+    string DistributionStatus::getMostOverloadedShard( const string& tag,
+                                                       const set<string>* busyShards ) const {
         string worst;
-        unsigned maxChunks = 0;
+        double maxLoad = 0;
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
-            unsigned myChunks = numberOfChunksInShardWithTag( i->first, tag );
-            if ( myChunks <= maxChunks )
+            if ( busyShards && busyShards->count( i->first ) )
+                continue;
+
+            double myLoad = shardLoadWithTag( i->first, tag );
+            if ( myLoad <= maxLoad )
                 continue;
 
             worst = i->first;
-            maxChunks = myChunks;
+            maxLoad = myLoad;
         }
 
         return worst;
@@ -312,7 +400,13 @@ namespace mongo {
     MigrateInfo* BalancerPolicy::balance( const string& ns,
                                           const DistributionStatus& distribution,
                                           int balancedLastTime ) {
+        return balance( ns, distribution, balancedLastTime, set<string>() );
+    }
 
+    MigrateInfo* BalancerPolicy::balance( const string& ns,
+                                          const DistributionStatus& distribution,
+                                          int balancedLastTime,
+                                          const set<string>& busyShards ) {
 
         // 1) check for shards that policy require to us to move off of:
         //    draining only
@@ -334,6 +428,9 @@ namespace mongo {
                 if ( distribution.numberOfChunksInShard( shard ) == 0 )
                     continue;
 
+                if ( busyShards.count( shard ) )
+                    continue;
+
                 // now we know we need to move to chunks off this shard
                 // we will if we are allowed
                 const vector<ChunkType* >& chunks = distribution.getChunks( shard );
@@ -348,7 +445,7 @@ namespace mongo {
                     }
 
                     string tag = distribution.getTagForChunk( chunkToMove );
-                    string to = distribution.getBestReceieverShard( tag );
+                    string to = distribution.getBestReceieverShard( tag, &busyShards );
 
                     if ( to.size() == 0 ) {
                         warning() << "want to move chunk: " << chunkToMove
@@ -381,6 +478,9 @@ namespace mongo {
                 string shard = *i;
                 const ShardInfo& info = distribution.shardInfo( shard );
 
+                if ( busyShards.count( shard ) )
+                    continue;
+
                 const vector<ChunkType *>& chunks = distribution.getChunks(shard);
                 for ( unsigned j = 0; j < chunks.size(); j++ ) {
                     const ChunkType& chunk = *chunks[j];
@@ -399,7 +499,7 @@ namespace mongo {
                         continue;
                     }
 
-                    string to = distribution.getBestReceieverShard( tag );
+                    string to = distribution.getBestReceieverShard( tag, &busyShards );
                     if ( to.size() == 0 ) {
                         log() << "no where to put it :(" << endl;
                         continue;
@@ -434,33 +534,38 @@ namespace mongo {
         for ( unsigned i=0; i<tags.size(); i++ ) {
             string tag = tags[i];
 
-            string from = distribution.getMostOverloadedShard( tag );
+            string from = distribution.getMostOverloadedShard( tag, &busyShards );
             if ( from.size() == 0 )
                 continue;
 
-            unsigned max = distribution.numberOfChunksInShardWithTag( from, tag );
-            if ( max == 0 )
+            const double max = distribution.shardLoadWithTag( from, tag );
+            if ( max <= 0 )
                 continue;
 
-            string to = distribution.getBestReceieverShard( tag );
+            string to = distribution.getBestReceieverShard( tag, &busyShards );
             if ( to.size() == 0 ) {
                 log() << "no available shards to take chunks for tag [" << tag << "]" << endl;
                 return NULL;
             }
 
-            unsigned min = distribution.numberOfChunksInShardWithTag( to, tag );
+            const double min = distribution.shardLoadWithTag( to, tag );
 
-            const int imbalance = max - min;
+            const double imbalance = max - min;
 
             LOG(1) << "collection : " << ns << endl;
-            LOG(1) << "donor      : " << from << " chunks on " << max << endl;
-            LOG(1) << "receiver   : " << to << " chunks on " << min << endl;
+            LOG(1) << "donor      : " << from << " load " << max << endl;
+            LOG(1) << "receiver   : " << to << " load " << min << endl;
             LOG(1) << "threshold  : " << threshold << endl;
 
             if ( imbalance < threshold )
                 continue;
 
+            // Moving a chunk of cost c leaves an imbalance of |imbalance - 2c|, so any chunk
+            // cheaper than the imbalance helps and one costing half of it helps the most.  When
+            // all chunks cost the same this picks the first movable one.
             const vector<ChunkType *>& chunks = distribution.getChunks(from);
+            const ChunkType* best = NULL;
+            double bestDistance = numeric_limits<double>::max();
             unsigned numJumboChunks = 0;
             for ( unsigned j = 0; j < chunks.size(); j++ ) {
                 const ChunkType& chunk = *chunks[j];
@@ -472,10 +577,22 @@ namespace mongo {
                     continue;
                 }
 
-                log() << " ns: " << ns << " going to move " << chunk
+                const double cost = distribution.chunkCost(chunk);
+                if ( cost >= imbalance )
+                    continue;
+
+                const double distance = fabs( imbalance / 2 - cost );
+                if ( distance < bestDistance ) {
+                    best = &chunk;
+                    bestDistance = distance;
+                }
+            }
+
+            if ( best ) {
+                log() << " ns: " << ns << " going to move " << *best
                       << " from: " << from << " to: " << to << " tag [" << tag << "]"
                       << endl;
-                return new MigrateInfo(ns, to, from, chunk.toBSON());
+                return new MigrateInfo(ns, to, from, best->toBSON());
             }
 
             if ( numJumboChunks ) {
@@ -486,13 +603,36 @@ namespace mongo {
                 continue;
             }
 
-            verify( false ); // should be impossible
+            LOG(1) << "shard: " << from << " ns: " << ns << " has no chunk small enough to "
+                   << "reduce an imbalance of " << imbalance << " with " << to << endl;
         }
 
         // Everything is balanced here!
         return NULL;
     }
 
+    void BalancerPolicy::balanceParallel( const string& ns,
+                                          const DistributionStatus& distribution,
+                                          int balancedLastTime,
+                                          unsigned maxMigrations,
+                                          set<string>* busyShards,
+                                          vector<MigrateInfo*>* migrations ) {
+        verify( busyShards );
+        verify( migrations );
+
+        // Every suggestion takes its donor and receiver out of the running, so the loop ends
+        // after at most shards / 2 moves.
+        while ( migrations->size() < maxMigrations ) {
+            MigrateInfo* m = balance( ns, distribution, balancedLastTime, *busyShards );
+            if ( !m )
+                return;
+
+            busyShards->insert( m->from );
+            busyShards->insert( m->to );
+            migrations->push_back( m );
+        }
+    }
+
 
     ShardInfo::ShardInfo( long long maxSize, long long currSize,
                           bool draining,
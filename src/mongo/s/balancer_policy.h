@@ -125,6 +125,63 @@ namespace mongo {
     typedef std::map< std::string,ShardInfo > ShardInfoMap;
     typedef std::map<std::string, OwnedPointerVector<ChunkType>* > ShardToChunksMap;
 
+    /**
+     * Load observed for a single chunk: bytes of data in its range and the decayed rate of
+     * operations that targeted it recently.
+     */
+    struct ChunkStats {
+        long long dataSizeBytes;
+        double opsPerSec;
+
+        ChunkStats() : dataSizeBytes( 0 ), opsPerSec( 0 ) {}
+
+        ChunkStats( long long a_dataSizeBytes, double a_opsPerSec )
+            : dataSizeBytes( a_dataSizeBytes ), opsPerSec( a_opsPerSec ) {}
+    };
+
+    // chunk min -> stats
+    typedef std::map<BSONObj, ChunkStats> ChunkStatsMap;
+
+    /**
+     * Decides what it costs a shard to own a chunk.  The balancer evens out the sum of chunk
+     * costs across shards, so costs are expressed in "average chunks": a chunk that is as big
+     * and as busy as the collection's average chunk costs 1.  This keeps the migration thresholds
+     * in BalancerPolicy meaningful whatever the model.  Without a model every chunk costs 1,
+     * i.e. the balancer evens out chunk counts.
+     */
+    class ChunkCostModel {
+    public:
+        virtual ~ChunkCostModel() {}
+
+        virtual double chunkCost( const ChunkType& chunk ) const = 0;
+
+        virtual std::string name() const = 0;
+    };
+
+    /**
+     * A chunk costs its data size relative to the average chunk, blended with its operation
+     * rate relative to the average chunk.  Chunks missing from the stats cost as much as an
+     * average chunk.  If no chunk saw any operation the size alone is used.
+     */
+    class DataSizeCostModel : public ChunkCostModel {
+    public:
+        /**
+         * @param stats must outlive this model
+         * @param opsWeight in [0, 1], how much of the cost comes from the operation rate
+         */
+        DataSizeCostModel( const ChunkStatsMap& stats, double opsWeight );
+
+        virtual double chunkCost( const ChunkType& chunk ) const;
+
+        virtual std::string name() const { return "dataSize"; }
+
+    private:
+        const ChunkStatsMap& _stats;
+        double _opsWeight;
+        double _avgDataSize;
+        double _avgOps;
+    };
+
     class DistributionStatus : boost::noncopyable {
     public:
         DistributionStatus( const ShardInfoMap& shardInfo,
@@ -137,19 +194,29 @@ namespace mongo {
          */
         bool addTagRange( const TagRange& range );
 
+        /**
+         * Weighs chunks with 'costModel' instead of counting them.  NULL goes back to counting.
+         * The model is not owned and must outlive this object.
+         */
+        void setCostModel( const ChunkCostModel* costModel ) { _costModel = costModel; }
+
         // ---- these methods might be better suiting in BalancerPolicy
         
         /**
          * @param forTag "" if you don't care, or a tag
-         * @return shard best suited to receive a chunk
+         * @param busyShards if not NULL, shards that may not be picked
+         * @return shard best suited to receive a chunk, the one with the lowest load
          */
-        std::string getBestReceieverShard( const std::string& forTag ) const;
+        std::string getBestReceieverShard( const std::string& forTag,
+                                           const std::set<std::string>* busyShards = NULL ) const;
 
         /**
-         * @return the shard with the most chunks
-         *         based on # of chunks with the given tag
+         * @param busyShards if not NULL, shards that may not be picked
+         * @return the shard with the highest load
+         *         based on the chunks with the given tag
          */
-        std::string getMostOverloadedShard( const std::string& forTag ) const;
+        std::string getMostOverloadedShard( const std::string& forTag,
+                                            const std::set<std::string>* busyShards = NULL ) const;
 
 
         // ---- basic accessors, counters, etc...
@@ -163,6 +230,15 @@ namespace mongo {
         /** @return number of chunks in this shard with the given tag */
         unsigned numberOfChunksInShardWithTag( const std::string& shard, const std::string& tag ) const;
 
+        /** @return cost of the chunk under the current cost model */
+        double chunkCost( const ChunkType& chunk ) const;
+
+        /** @return sum of the costs of the chunks in this shard */
+        double shardLoad( const std::string& shard ) const;
+
+        /** @return sum of the costs of the chunks in this shard with the given tag */
+        double shardLoadWithTag( const std::string& shard, const std::string& tag ) const;
+
         /** @return chunks for the shard */
         const std::vector<ChunkType*>& getChunks(const std::string& shard) const;
 
@@ -206,6 +282,7 @@ namespace mongo {
         std::map<BSONObj,TagRange> _tagRanges;
         std::set<std::string> _allTags;
         std::set<std::string> _shards;
+        const ChunkCostModel* _costModel;
     };
 
     class BalancerPolicy {
@@ -225,6 +302,31 @@ namespace mongo {
         static MigrateInfo* balance( const std::string& ns,
                                      const DistributionStatus& distribution,
                                      int balancedLastTime );
+
+        /**
+         * Like balance(), but never picks a donor or a receiver found in 'busyShards', so the
+         * suggested move can run alongside the migrations of those shards.
+         */
+        static MigrateInfo* balance( const std::string& ns,
+                                     const DistributionStatus& distribution,
+                                     int balancedLastTime,
+                                     const std::set<std::string>& busyShards );
+
+        /**
+         * Suggests up to 'maxMigrations' moves for a collection between distinct pairs of shards,
+         * all decided from the same 'distribution'.  No shard takes part in more than one of the
+         * moves, nor in any move already in 'busyShards', so they can all run at once.
+         *
+         * @param busyShards (IN/OUT) shards already migrating; the shards of the new moves are
+         *        added to it
+         * @param migrations (OUT) the suggested moves, owned by the caller
+         */
+        static void balanceParallel( const std::string& ns,
+                                     const DistributionStatus& distribution,
+                                     int balancedLastTime,
+                                     unsigned maxMigrations,
+                                     std::set<std::string>* busyShards,
+                                     std::vector<MigrateInfo*>* migrations );
     };
 
 
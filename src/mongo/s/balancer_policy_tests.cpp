@@ -582,5 +582,223 @@ namespace mongo {
                 }
             }
         }
+
+        TEST( BalancerPolicyTests, ParallelMigrationsUseDistinctShards ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 30, false );
+            addShard( chunks, 30, false );
+            addShard( chunks, 30, false );
+            addShard( chunks, 0, false );
+            addShard( chunks, 0, false );
+            addShard( chunks, 0, true );
+
+            ShardInfoMap shards;
+            for ( int i = 0; i < 6; i++ ) {
+                shards[str::stream() << "shard" << i] = ShardInfo(0, 0, false);
+            }
+
+            // shard5 is already taken by a migration of another collection
+            set<string> busyShards;
+            busyShards.insert( "shard5" );
+
+            DistributionStatus d(shards, chunks.map());
+            OwnedPointerVector<MigrateInfo> migrations;
+            BalancerPolicy::balanceParallel( "ns", d, 0, 10, &busyShards,
+                                             &migrations.mutableVector() );
+
+            // shard5 can't receive, so one of the donors has no partner
+            ASSERT_EQUALS( 2U, migrations.size() );
+
+            set<string> seen;
+            for ( unsigned i = 0; i < migrations.size(); i++ ) {
+                ASSERT( seen.insert( migrations[i]->from ).second );
+                ASSERT( seen.insert( migrations[i]->to ).second );
+                ASSERT_NOT_EQUALS( "shard5", migrations[i]->from );
+                ASSERT_NOT_EQUALS( "shard5", migrations[i]->to );
+            }
+
+            ASSERT_EQUALS( 5U, busyShards.size() );
+
+            // the cap is respected
+            busyShards.clear();
+            migrations.clear();
+            BalancerPolicy::balanceParallel( "ns", d, 0, 1, &busyShards,
+                                             &migrations.mutableVector() );
+            ASSERT_EQUALS( 1U, migrations.size() );
+        }
+
+        TEST( BalancerPolicyTests, DataSizeCostModel ) {
+            // same number of chunks everywhere, but shard0's chunks are ten times larger
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 10, false );
+            addShard( chunks, 10, true );
+
+            ChunkStatsMap stats;
+            const vector<ChunkType*>& shard0Chunks = chunks.map().find("shard0")->second->vector();
+            const vector<ChunkType*>& shard1Chunks = chunks.map().find("shard1")->second->vector();
+            for ( unsigned i = 0; i < 10; i++ ) {
+                stats[shard0Chunks[i]->getMin()] = ChunkStats( 10 * 1024 * 1024, 0 );
+                stats[shard1Chunks[i]->getMin()] = ChunkStats( 1024 * 1024, 0 );
+            }
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo(0, 0, false);
+            shards["shard1"] = ShardInfo(0, 0, false);
+
+            DistributionStatus d(shards, chunks.map());
+            ASSERT( !BalancerPolicy::balance( "ns", d, 0 ) );
+
+            DataSizeCostModel costModel( stats, 0 );
+            d.setCostModel( &costModel );
+            ASSERT_APPROX_EQUAL( 10 * 10 / 5.5, d.shardLoad( "shard0" ), 0.001 );
+            ASSERT_APPROX_EQUAL( 10 / 5.5, d.shardLoad( "shard1" ), 0.001 );
+
+            scoped_ptr<MigrateInfo> m( BalancerPolicy::balance( "ns", d, 0 ) );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard0", m->from );
+            ASSERT_EQUALS( "shard1", m->to );
+
+            // a busy chunk weighs more than an idle one of the same size
+            stats[shard1Chunks[0]->getMin()] = ChunkStats( 1024 * 1024, 1000 );
+            DataSizeCostModel opsModel( stats, 0.5 );
+            ASSERT_GREATER_THAN( opsModel.chunkCost( *shard1Chunks[0] ),
+                                 opsModel.chunkCost( *shard1Chunks[1] ) );
+        }
+
+        /**
+         * Runs balancing rounds until the policy has nothing left to move.  A round asks the
+         * policy for up to 'maxMigrations' moves between distinct shards and applies all of them,
+         * like the balancer does when it runs migrations in parallel.
+         *
+         * @return the number of rounds that moved something
+         */
+        int runRounds( OwnedShardToChunksMap& chunks,
+                       const ShardInfoMap& shards,
+                       const ChunkCostModel* costModel,
+                       unsigned maxMigrations ) {
+            int rounds = 0;
+            int movedLastTime = 0;
+            while ( true ) {
+                DistributionStatus d(shards, chunks.map());
+                d.setCostModel( costModel );
+
+                set<string> busyShards;
+                OwnedPointerVector<MigrateInfo> migrations;
+                BalancerPolicy::balanceParallel( "ns", d, movedLastTime, maxMigrations,
+                                                 &busyShards, &migrations.mutableVector() );
+                if ( migrations.empty() )
+                    return rounds;
+
+                for ( unsigned i = 0; i < migrations.size(); i++ ) {
+                    moveChunk( chunks, migrations[i] );
+                }
+
+                movedLastTime = migrations.size();
+                rounds++;
+
+                // every round moves a chunk towards balance, so this can't take forever
+                ASSERT_LESS_THAN( rounds, 100000 );
+            }
+        }
+
+        void addNewShardsScenario( OwnedShardToChunksMap* chunks, ShardInfoMap* shards ) {
+            // four full shards and four freshly added ones
+            for ( int i = 0; i < 8; i++ ) {
+                addShard( *chunks, i < 4 ? 40 : 0, i == 7 );
+                (*shards)[str::stream() << "shard" << i] = ShardInfo(0, 0, false);
+            }
+        }
+
+        TEST( BalancerPolicyTests, SimulationParallelConvergence ) {
+            OwnedShardToChunksMap serialChunks;
+            ShardInfoMap serialShards;
+            addNewShardsScenario( &serialChunks, &serialShards );
+            const int serialRounds = runRounds( serialChunks, serialShards, NULL, 1 );
+
+            OwnedShardToChunksMap parallelChunks;
+            ShardInfoMap parallelShards;
+            addNewShardsScenario( &parallelChunks, &parallelShards );
+            const int parallelRounds = runRounds( parallelChunks, parallelShards, NULL, 4 );
+
+            log() << "chunk count convergence: " << serialRounds << " rounds one migration at a "
+                  << "time, " << parallelRounds << " rounds with up to 4 parallel migrations";
+
+            // four donors and four receivers, so a round does up to four times as much
+            ASSERT_LESS_THAN_OR_EQUALS( parallelRounds * 3, serialRounds );
+
+            // both end up balanced to within the threshold
+            const OwnedShardToChunksMap::MapType& result = parallelChunks.map();
+            for ( OwnedShardToChunksMap::MapType::const_iterator i = result.begin();
+                  i != result.end(); ++i ) {
+                ASSERT_GREATER_THAN_OR_EQUALS( i->second->size(), 19U );
+                ASSERT_LESS_THAN_OR_EQUALS( i->second->size(), 21U );
+            }
+        }
+
+        TEST( BalancerPolicyTests, SimulationDataSizeConvergence ) {
+
+            // Hardcode seed here, make test deterministic.
+            int64_t seed = 1337;
+            PseudoRandom rng(seed);
+
+            for (int test = 0; test < 5; test++) {
+
+                // Same number of chunks per shard, with sizes anywhere from 1 to 64 MB
+                OwnedShardToChunksMap chunks;
+                ShardInfoMap shards;
+                const int numShards = 6;
+                for ( int i = 0; i < numShards; i++ ) {
+                    addShard( chunks, 50, i == numShards - 1 );
+                    shards[str::stream() << "shard" << i] = ShardInfo(0, 0, false);
+                }
+
+                ChunkStatsMap stats;
+                const OwnedShardToChunksMap::MapType& shardChunks = chunks.map();
+                for ( OwnedShardToChunksMap::MapType::const_iterator i = shardChunks.begin();
+                      i != shardChunks.end(); ++i ) {
+                    // skew the sizes so that lower numbered shards hold more data
+                    const int skew = numShards - atoi( i->first.c_str() + strlen( "shard" ) );
+                    for ( unsigned j = 0; j < i->second->size(); j++ ) {
+                        const long long size =
+                            ( 1 + rng.nextInt32( 64 / numShards ) * skew ) * 1024 * 1024;
+                        stats[i->second->vector()[j]->getMin()] = ChunkStats( size, 0 );
+                    }
+                }
+
+                DataSizeCostModel costModel( stats, 0 );
+
+                double maxChunkCost = 0;
+                for ( OwnedShardToChunksMap::MapType::const_iterator i = shardChunks.begin();
+                      i != shardChunks.end(); ++i ) {
+                    for ( unsigned j = 0; j < i->second->size(); j++ ) {
+                        maxChunkCost = std::max( maxChunkCost,
+                                                 costModel.chunkCost( *i->second->vector()[j] ) );
+                    }
+                }
+
+                // counting chunks, there is nothing to do
+                ASSERT_EQUALS( 0, runRounds( chunks, shards, NULL, numShards / 2 ) );
+
+                const int serialRounds = runRounds( chunks, shards, &costModel, 1 );
+
+                DistributionStatus d(shards, chunks.map());
+                d.setCostModel( &costModel );
+
+                double minLoad = std::numeric_limits<double>::max();
+                double maxLoad = 0;
+                for ( ShardInfoMap::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
+                    minLoad = std::min( minLoad, d.shardLoad( i->first ) );
+                    maxLoad = std::max( maxLoad, d.shardLoad( i->first ) );
+                }
+
+                log() << "data size convergence: " << serialRounds << " rounds, shard loads "
+                      << "between " << minLoad << " and " << maxLoad << " average chunks, "
+                      << "largest chunk " << maxChunkCost;
+
+                // Balancing stops once the spread is under the threshold, or when no chunk is
+                // small enough to shrink it
+                ASSERT_LESS_THAN_OR_EQUALS( maxLoad - minLoad, std::max( 2.0, maxChunkCost ) );
+            }
+        }
     }
 }
@@ -34,16 +34,21 @@
 
 #include "mongo/s/chunk.h"
 
+#include "mongo/base/counter.h"
 #include "mongo/base/owned_pointer_map.h"
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/query/lite_parsed_query.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/platform/random.h"
 #include "mongo/s/balancer_policy.h"
 #include "mongo/s/chunk_diff.h"
+#include "mongo/s/chunk_load_tracker.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/cluster_write.h"
@@ -84,15 +89,59 @@ namespace mongo {
     // Can be overridden from command line
     bool Chunk::ShouldAutoSplit = true;
 
+    // Record per-chunk operation rates in chunkLoadTracker for hotChunks even when load-based
+    // splitting is off.  Takes a global mutex on every routed operation, so off by default.
+    MONGO_EXPORT_SERVER_PARAMETER(chunkLoadTracking, bool, false);
+
+    // Split a chunk at its load median once it sees this many operations per second; 0 disables
+    // load-based splitting
+    MONGO_EXPORT_SERVER_PARAMETER(chunkLoadSplitOpsPerSec, double, 0);
+
+    // Fewest sampled accesses a load median is computed from
+    static const size_t kMinLoadSplitSample = 8;
+
+    // Load-based splits, reported under metrics.chunkLoad in serverStatus
+    static Counter64 chunkLoadSplits;
+    static ServerStatusMetricField<Counter64> displayChunkLoadSplits(
+            "chunkLoad.splits", &chunkLoadSplits );
+    static Counter64 chunkLoadSplitsFailed;
+    static ServerStatusMetricField<Counter64> displayChunkLoadSplitsFailed(
+            "chunkLoad.splitsFailed", &chunkLoadSplitsFailed );
+
+    /**
+     * The data size at which a chunk of a collection with 'nc' chunks is split.
+     */
+    static int desiredChunkSize( int nc ) {
+        // split faster in early chunks helps spread out an initial load better
+        const int minChunkSize = 1 << 20;  // 1 MBytes
+
+        int splitThreshold = Chunk::MaxChunkSize;
+
+        if ( nc <= 1 ) {
+            return 1024;
+        }
+        else if ( nc < 3 ) {
+            return minChunkSize / 2;
+        }
+        else if ( nc < 10 ) {
+            splitThreshold = max( splitThreshold / 4 , minChunkSize );
+        }
+        else if ( nc < 20 ) {
+            splitThreshold = max( splitThreshold / 2 , minChunkSize );
+        }
+
+        return splitThreshold;
+    }
+
     /**
      * Attempts to move the given chunk to another shard.
      *
      * Returns true if the chunk was actually moved.
      */
-    static bool tryMoveToOtherShard(const ChunkManager& manager, const ChunkType& chunk) {
+    static bool tryMoveToOtherShard(const ChunkManagerLineage& lineage, const ChunkType& chunk) {
         // reload sharding metadata before starting migration
         Shard::reloadShardInfo();
-        ChunkManagerPtr chunkMgr = manager.reload(false /* just reloaded in mulitsplit */);
+        ChunkManagerPtr chunkMgr = lineage.reload(false /* just reloaded in mulitsplit */);
 
         vector<Shard> allShards;
         Shard::getAllShards(allShards);
@@ -114,7 +163,7 @@ namespace mongo {
         const string configServerStr = configServer.getConnectionString().toString();
         StatusWith<string> tagStatus =
                 DistributionStatus::getTagForSingleChunk(configServerStr,
-                                                         manager.getns(),
+                                                         lineage.getns(),
                                                          chunk);
         if (!tagStatus.isOK()) {
             warning() << "Not auto-moving chunk because of an error encountered while "
@@ -155,13 +204,13 @@ namespace mongo {
                                       res));
 
         // update our config
-        manager.reload();
+        lineage.reload();
 
         return true;
     }
 
     Chunk::Chunk(const ChunkManager * manager, BSONObj from)
-        : _manager(manager), _lastmod(0, 0, OID()), _dataWritten(mkDataWritten())
+        : _lineage(manager->_lineage.get()), _lastmod(0, 0, OID()), _dataWritten(mkDataWritten())
     {
         string ns = from.getStringField(ChunkType::ns().c_str());
         _shard.reset(from.getStringField(ChunkType::shard().c_str()));
@@ -175,7 +224,7 @@ namespace mongo {
         _jumbo = from[ChunkType::jumbo()].trueValue();
 
         uassert( 10170 ,  "Chunk needs a ns" , ! ns.empty() );
-        uassert( 13327 ,  "Chunk ns must match server ns" , ns == _manager->getns() );
+        uassert( 13327 ,  "Chunk ns must match server ns" , ns == _lineage->getns() );
 
         uassert( 10171 ,  "Chunk needs a server" , _shard.ok() );
 
@@ -184,17 +233,17 @@ namespace mongo {
     }
 
     Chunk::Chunk(const ChunkManager * info , const BSONObj& min, const BSONObj& max, const Shard& shard, ChunkVersion lastmod)
-        : _manager(info), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
+        : _lineage(info->_lineage.get()), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
     {}
 
     int Chunk::mkDataWritten() {
         PseudoRandom r(static_cast<int64_t>(time(0)));
-        return r.nextInt32( MaxChunkSize / ChunkManager::SplitHeuristics::splitTestFactor );
+        return r.nextInt32( MaxChunkSize / ChunkManagerLineage::SplitHeuristics::splitTestFactor );
     }
 
     string Chunk::getns() const {
-        verify( _manager );
-        return _manager->getns();
+        verify( _lineage );
+        return _lineage->getns();
     }
 
     bool Chunk::containsPoint( const BSONObj& point ) const {
@@ -207,23 +256,23 @@ namespace mongo {
     }
 
     bool Chunk::minIsInf() const {
-        return _manager->getShardKey().globalMin().woCompare( getMin() ) == 0;
+        return _lineage->getShardKey().globalMin().woCompare( getMin() ) == 0;
     }
 
     bool Chunk::maxIsInf() const {
-        return _manager->getShardKey().globalMax().woCompare( getMax() ) == 0;
+        return _lineage->getShardKey().globalMax().woCompare( getMax() ) == 0;
     }
 
     BSONObj Chunk::_getExtremeKey( int sort ) const {
         Query q;
         if ( sort == 1 ) {
-            q.sort( _manager->getShardKey().key() );
+            q.sort( _lineage->getShardKey().key() );
         }
         else {
             // need to invert shard key pattern to sort backwards
             // TODO: make a helper in ShardKeyPattern?
 
-            BSONObj k = _manager->getShardKey().key();
+            BSONObj k = _lineage->getShardKey().key();
             BSONObjBuilder r;
 
             BSONObjIterator i(k);
@@ -237,11 +286,11 @@ namespace mongo {
         }
         // find the extreme key
         ScopedDbConnection conn(getShard().getConnString());
-        BSONObj end = conn->findOne(_manager->getns(), q);
+        BSONObj end = conn->findOne(_lineage->getns(), q);
         conn.done();
         if ( end.isEmpty() )
             return BSONObj();
-        return _manager->getShardKey().extractKeyFromQueryOrDoc( end );
+        return _lineage->getShardKey().extractKeyFromQueryOrDoc( end );
     }
 
     void Chunk::pickMedianKey( BSONObj& medianKey ) const {
@@ -249,8 +298,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
         BSONObjBuilder cmd;
-        cmd.append( "splitVector" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitVector" , _lineage->getns() );
+        cmd.append( "keyPattern" , _lineage->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.appendBool( "force" , true );
@@ -276,8 +325,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
         BSONObjBuilder cmd;
-        cmd.append( "splitVector" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitVector" , _lineage->getns() );
+        cmd.append( "keyPattern" , _lineage->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.append( "maxChunkSizeBytes" , chunkSize );
@@ -299,6 +348,33 @@ namespace mongo {
         conn.done();
     }
 
+    void Chunk::pickLoadMedianKey( const vector<BSONObj>& accessSample, BSONObj& medianKey ) const {
+        // Ask the mongod holding this chunk to find an existing key at the accesses' median.
+        ScopedDbConnection conn(getShard().getConnString());
+        BSONObj result;
+        BSONObjBuilder cmd;
+        cmd.append( "splitVector" , _lineage->getns() );
+        cmd.append( "keyPattern" , _lineage->getShardKey().key() );
+        cmd.append( "min" , getMin() );
+        cmd.append( "max" , getMax() );
+        cmd.append( "accessSample" , accessSample );
+        BSONObj cmdObj = cmd.obj();
+
+        if ( ! conn->runCommand( "admin" , cmdObj , result )) {
+            conn.done();
+            ostringstream os;
+            os << "splitVector command (load median key) failed: " << result;
+            uassert( 18917 , os.str() , 0 );
+        }
+
+        BSONObjIterator it( result.getObjectField( "splitKeys" ) );
+        if ( it.more() ) {
+            medianKey = it.next().Obj().getOwned();
+        }
+
+        conn.done();
+    }
+
     void Chunk::determineSplitPoints(bool atMedian, std::vector<BSONObj>* splitPoints) const {
         // if splitting is not obligatory we may return early if there are not enough data
         // we cap the number of objects that would fall in the first half (before the split point)
@@ -394,7 +470,7 @@ namespace mongo {
     Status Chunk::multiSplit(const vector<BSONObj>& m, BSONObj* res) const {
         const size_t maxSplitPoints = 8192;
 
-        uassert( 10165 , "can't split as shard doesn't have a manager" , _manager );
+        uassert( 10165 , "can't split as shard doesn't have a manager" , _lineage );
         uassert( 13332 , "need a split key to split chunk" , !m.empty() );
         uassert( 13333 , "can't split a chunk in that many parts", m.size() < maxSplitPoints );
         uassert( 13003 , "can't split a chunk with only one distinct value" , _min.woCompare(_max) );
@@ -402,15 +478,15 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
 
         BSONObjBuilder cmd;
-        cmd.append( "splitChunk" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitChunk" , _lineage->getns() );
+        cmd.append( "keyPattern" , _lineage->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.append( "from" , getShard().getName() );
         cmd.append( "splitKeys" , m );
         cmd.append( "shardId" , genID() );
         cmd.append( "configdb" , configServer.modelServer() );
-        cmd.append("epoch", _manager->getVersion().epoch());
+        cmd.append("epoch", _lineage->getEpoch());
         BSONObj cmdObj = cmd.obj();
 
         BSONObj dummy;
@@ -425,7 +501,7 @@ namespace mongo {
             conn.done();
 
             // Mark the minor version for *eventual* reload
-            _manager->markMinorForReload( this->_lastmod );
+            _lineage->markMinorForReload( this->_lastmod );
 
             return Status(ErrorCodes::SplitFailed, msg);
         }
@@ -433,7 +509,7 @@ namespace mongo {
         conn.done();
         
         // force reload of config
-        _manager->reload();
+        _lineage->reload();
 
         return Status::OK();
     }
@@ -446,14 +522,14 @@ namespace mongo {
                               BSONObj& res) const {
         uassert( 10167 ,  "can't move shard to its current location!" , getShard() != to );
 
-        log() << "moving chunk ns: " << _manager->getns() << " moving ( " << toString() << ") "
+        log() << "moving chunk ns: " << _lineage->getns() << " moving ( " << toString() << ") "
               << _shard.toString() << " -> " << to.toString() << endl;
 
         Shard from = _shard;
         ScopedDbConnection fromconn(from.getConnString());
 
         BSONObjBuilder builder;
-        builder.append("moveChunk", _manager->getns());
+        builder.append("moveChunk", _lineage->getns());
         builder.append("from", from.getAddress().toString());
         builder.append("to", to.getAddress().toString());
         // NEEDED FOR 2.0 COMPATIBILITY
@@ -482,7 +558,7 @@ namespace mongo {
 
         builder.append("waitForDelete", waitForDelete);
         builder.append(LiteParsedQuery::cmdOptionMaxTimeMS, maxTimeMS);
-        builder.append("epoch", _manager->getVersion().epoch());
+        builder.append("epoch", _lineage->getEpoch());
 
         bool worked = fromconn->runCommand("admin", builder.done(), res);
         fromconn.done();
@@ -492,7 +568,7 @@ namespace mongo {
         // if succeeded, needs to reload to pick up the new location
         // if failed, mongos may be stale
         // reload is excessive here as the failure could be simply because collection metadata is taken
-        _manager->reload();
+        _lineage->reload();
 
         return worked;
     }
@@ -503,19 +579,19 @@ namespace mongo {
 
         try {
             _dataWritten += dataWritten;
-            int splitThreshold = getManager()->getCurrentDesiredChunkSize();
+            int splitThreshold = _lineage->getCurrentDesiredChunkSize();
             if ( minIsInf() || maxIsInf() ) {
                 splitThreshold = (int) ((double)splitThreshold * .9);
             }
 
-            if ( _dataWritten < splitThreshold / ChunkManager::SplitHeuristics::splitTestFactor )
+            if ( _dataWritten < splitThreshold / ChunkManagerLineage::SplitHeuristics::splitTestFactor )
                 return false;
             
-            if ( ! getManager()->_splitHeuristics._splitTickets.tryAcquire() ) {
-                LOG(1) << "won't auto split because not enough tickets: " << getManager()->getns() << endl;
+            if ( ! _lineage->_splitHeuristics._splitTickets.tryAcquire() ) {
+                LOG(1) << "won't auto split because not enough tickets: " << getns() << endl;
                 return false;
             }
-            TicketHolderReleaser releaser( &(getManager()->_splitHeuristics._splitTickets) );
+            TicketHolderReleaser releaser( &(_lineage->_splitHeuristics._splitTickets) );
 
             // this is a bit ugly
             // we need it so that mongos blocks for the writes to actually be committed
@@ -551,9 +627,9 @@ namespace mongo {
             }
 
             const bool shouldBalance = grid.getConfigShouldBalance() &&
-                    grid.getCollShouldBalance(_manager->getns());
+                    grid.getCollShouldBalance(_lineage->getns());
 
-            log() << "autosplitted " << _manager->getns()
+            log() << "autosplitted " << _lineage->getns()
                   << " shard: " << toString()
                   << " into " << (splitCount + 1)
                   << " (splitThreshold " << splitThreshold << ")"
@@ -575,7 +651,7 @@ namespace mongo {
                 chunkToMove.setMin(range["min"].embeddedObject());
                 chunkToMove.setMax(range["max"].embeddedObject());
 
-                tryMoveToOtherShard(*_manager, chunkToMove);
+                tryMoveToOtherShard(*_lineage, chunkToMove);
             }
 
             return true;
@@ -588,26 +664,104 @@ namespace mongo {
             _dataWritten = mkDataWritten();
 
             // if the collection lock is taken (e.g. we're migrating), it is fine for the split to fail.
-            warning() << "could not autosplit collection " << _manager->getns() << causedBy( e ) << endl;
+            warning() << "could not autosplit collection " << _lineage->getns() << causedBy( e ) << endl;
             return false;
         }
     }
 
-    long Chunk::getPhysicalSize() const {
+    void Chunk::noteAccess( const BSONObj& shardKey, bool isWrite ) const {
+        const double splitOpsPerSec = chunkLoadSplitOpsPerSec;
+        if ( !chunkLoadTracking && !( splitOpsPerSec > 0 ) )
+            return;
+
+        const double opsPerSec = chunkLoadTracker.noteAccess( _lineage->getns(),
+                                                              _min,
+                                                              shardKey,
+                                                              isWrite,
+                                                              curTimeMillis64() );
+
+        if ( ShouldAutoSplit && splitOpsPerSec > 0 && opsPerSec >= splitOpsPerSec ) {
+            chunkLoadTracker.markHot( _lineage->getns(), _min );
+        }
+    }
+
+    bool Chunk::splitOnLoad() const {
+        dassert( ShouldAutoSplit );
+        LastError::Disabled d( lastError.get() );
+
+        const string& ns = _lineage->getns();
+
+        vector<BSONObj> accessSample;
+        chunkLoadTracker.getAccessSample( ns, _min, &accessSample );
+
+        // Start counting again either way, so that a chunk that can't be split isn't retried on
+        // every operation
+        chunkLoadTracker.forget( ns, _min );
+
+        if ( accessSample.size() < kMinLoadSplitSample ) {
+            return false;
+        }
+
+        try {
+            if ( ! _lineage->_splitHeuristics._splitTickets.tryAcquire() ) {
+                LOG(1) << "won't split hot chunk because not enough tickets: " << ns << endl;
+                return false;
+            }
+            TicketHolderReleaser releaser( &(_lineage->_splitHeuristics._splitTickets) );
+
+            if ( !isConfigServerConsistent() ) {
+                RARELY warning() << "will not perform load-based split because "
+                                 << "config servers are inconsistent" << endl;
+                return false;
+            }
+
+            BSONObj medianKey;
+            pickLoadMedianKey( accessSample, medianKey );
+
+            if ( medianKey.isEmpty() || _min == medianKey || _max == medianKey ) {
+                LOG(1) << "no load median to split hot chunk " << toString()
+                       << " on, accesses may all be to one key" << endl;
+                chunkLoadSplitsFailed.increment();
+                return false;
+            }
+
+            BSONObj res;
+            Status status = multiSplit( vector<BSONObj>( 1, medianKey ), &res );
+            if ( !status.isOK() ) {
+                chunkLoadSplitsFailed.increment();
+                warning() << "could not split hot chunk " << toString() << causedBy( status );
+                return false;
+            }
+
+            chunkLoadSplits.increment();
+            log() << "split hot chunk " << ns << " " << toString()
+                  << " at load median " << medianKey << endl;
+            return true;
+        }
+        catch ( DBException& e ) {
+            chunkLoadSplitsFailed.increment();
+
+            // if the collection lock is taken (e.g. we're migrating), it is fine for the split to fail.
+            warning() << "could not split hot chunk of " << ns << causedBy( e ) << endl;
+            return false;
+        }
+    }
+
+    long long Chunk::getPhysicalSize( long long maxSize ) const {
         ScopedDbConnection conn(getShard().getConnString());
 
         BSONObj result;
         uassert( 10169 ,  "datasize failed!" , conn->runCommand( "admin" ,
-                 BSON( "datasize" << _manager->getns()
-                       << "keyPattern" << _manager->getShardKey().key()
+                 BSON( "datasize" << _lineage->getns()
+                       << "keyPattern" << _lineage->getShardKey().key()
                        << "min" << getMin()
                        << "max" << getMax()
-                       << "maxSize" << ( MaxChunkSize + 1 )
+                       << "maxSize" << maxSize
                        << "estimate" << true
                      ) , result ) );
 
         conn.done();
-        return (long)result["size"].number();
+        return result["size"].numberLong();
     }
 
     void Chunk::appendShortVersion( const char * name , BSONObjBuilder& b ) const {
@@ -623,7 +777,7 @@ namespace mongo {
 
     void Chunk::serialize(BSONObjBuilder& to,ChunkVersion myLastMod) {
 
-        to.append( "_id" , genID( _manager->getns() , _min ) );
+        to.append( "_id" , genID( _lineage->getns() , _min ) );
 
         if ( myLastMod.isSet() ) {
             myLastMod.addToBSON(to, ChunkType::DEPRECATED_lastmod());
@@ -635,7 +789,7 @@ namespace mongo {
             verify(0);
         }
 
-        to << ChunkType::ns(_manager->getns());
+        to << ChunkType::ns(_lineage->getns());
         to << ChunkType::min(_min);
         to << ChunkType::max(_max);
         to << ChunkType::shard(_shard.getName());
@@ -656,7 +810,7 @@ namespace mongo {
 
     string Chunk::toString() const {
         stringstream ss;
-        ss << ChunkType::ns()                 << ": " << _manager->getns()   << ", "
+        ss << ChunkType::ns()                 << ": " << _lineage->getns()   << ", "
            << ChunkType::shard()              << ": " << _shard.toString()   << ", "
            << ChunkType::DEPRECATED_lastmod() << ": " << _lastmod.toString() << ", "
            << ChunkType::min()                << ": " << _min                << ", "
@@ -665,7 +819,7 @@ namespace mongo {
     }
 
     ShardKeyPattern Chunk::skey() const {
-        return _manager->getShardKey();
+        return _lineage->getShardKey();
     }
 
     void Chunk::markAsJumbo() const {
@@ -734,6 +888,7 @@ namespace mongo {
         _key( pattern ),
         _unique( unique ),
         _chunkRanges(),
+        _lineage( new ChunkManagerLineage( _ns, _key ) ),
         _mutex("ChunkManager"),
         _sequenceNumber(NextSequenceNumber.addAndFetch(1))
     {
@@ -753,6 +908,7 @@ namespace mongo {
                                                         BSONObj()),
         _unique(collDoc[CollectionType::unique()].trueValue()),
         _chunkRanges(),
+        _lineage( new ChunkManagerLineage( _ns, _key ) ),
         _mutex("ChunkManager"),
         // The shard versioning mechanism hinges on keeping track of the number of times we reloaded ChunkManager's.
         // Increasing this number here will prompt checkShardVersion() to refresh the connection-level versions to
@@ -770,11 +926,24 @@ namespace mongo {
         _version = ChunkVersion::fromBSON( collDoc );
     }
 
+    // Reload cost, reported under metrics.chunkManager in serverStatus
+    static TimerStats chunkManagerLoadStats;
+    static ServerStatusMetricField<TimerStats> displayChunkManagerLoads(
+            "chunkManager.loads", &chunkManagerLoadStats );
+    static Counter64 chunkManagerChunksReused;
+    static ServerStatusMetricField<Counter64> displayChunkManagerChunksReused(
+            "chunkManager.chunksReused", &chunkManagerChunksReused );
+    static Counter64 chunkManagerChunksFetched;
+    static ServerStatusMetricField<Counter64> displayChunkManagerChunksFetched(
+            "chunkManager.chunksFetched", &chunkManagerChunksFetched );
+
     ChunkManager::ChunkManager( ChunkManagerPtr oldManager ) :
         _ns( oldManager->getns() ),
         _key( oldManager->getShardKey() ),
         _unique( oldManager->isUnique() ),
         _chunkRanges(),
+        // replaced by the old manager's lineage if its chunks are taken over
+        _lineage( new ChunkManagerLineage( _ns, _key ) ),
         _mutex("ChunkManager"),
         _sequenceNumber(NextSequenceNumber.addAndFetch(1))
     {
@@ -798,7 +967,7 @@ namespace mongo {
 
             if( success ){
                 {
-                    int ms = t.millis();
+                    int ms = chunkManagerLoadStats.record( t );
                     log() << "ChunkManager: time to load chunks for " << _ns << ": " << ms << "ms"
                           << " sequenceNumber: " << _sequenceNumber
                           << " version: " << _version.toString()
@@ -816,6 +985,13 @@ namespace mongo {
                     const_cast<set<Shard>&>(_shards).swap(shards);
                     const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
                     const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
+                    _buildRoutingTable();
+
+                    // A lineage of our own isn't shared with anyone yet, so it can still be set
+                    if ( !_oldManager || _lineage != _oldManager->_lineage ) {
+                        _lineage->setEpoch( _version.epoch() );
+                    }
+                    _lineage->setNumChunks( _chunkMap.size() );
 
                     // Once we load data, clear reference to old manager
                     _oldManager.reset();
@@ -897,27 +1073,15 @@ namespace mongo {
             // Load a copy of the old versions
             shardVersions = oldManager->_shardVersions;
 
-            // Load a copy of the chunk map, replacing the chunk manager with our own
+            // Take over the old chunks as they are.  They only reference the lineage, which stays
+            // the same within an epoch, and the diff below replaces the ones that changed.
+            _lineage = oldManager->_lineage;
             const ChunkMap& oldChunkMap = oldManager->getChunkMap();
-
-            // Could be v.expensive
-            // TODO: If chunks were immutable and didn't reference the manager, we could do more
-            // interesting things here
-            for( ChunkMap::const_iterator it = oldChunkMap.begin(); it != oldChunkMap.end(); it++ ){
-
-                ChunkPtr oldC = it->second;
-                ChunkPtr c( new Chunk( this, oldC->getMin(),
-                                             oldC->getMax(),
-                                             oldC->getShard(),
-                                             oldC->getLastmod() ) );
-
-                c->setBytesWritten( oldC->getBytesWritten() );
-
-                chunkMap.insert( make_pair( oldC->getMax(), c ) );
-            }
+            chunkMap = oldChunkMap;
+            chunkManagerChunksReused.increment( oldChunkMap.size() );
 
             // Also get any minor versions stored for reload
-            oldManager->getMarkedMinorVersions( minorVersions );
+            _lineage->getMarkedMinorVersions( minorVersions );
 
             LOG(2) << "loading chunk manager for collection " << _ns
                    << " using old chunk manager w/ version " << _version.toString()
@@ -932,6 +1096,9 @@ namespace mongo {
         int diffsApplied = differ.calculateConfigDiff( config, minorVersions );
         if( diffsApplied > 0 ){
 
+            chunkManagerChunksFetched.increment( diffsApplied );
+            _lineage->forgetMarkedMinorVersions( minorVersions );
+
             LOG(2) << "loaded " << diffsApplied << " chunks into new chunk manager for " << _ns
                    << " with version " << _version << endl;
 
@@ -983,18 +1150,43 @@ namespace mongo {
     }
 
     ChunkManagerPtr ChunkManager::reload(bool force) const {
-        return grid.getDBConfig(getns())->getChunkManager(getns(), force);
+        return _lineage->reload(force);
     }
 
     void ChunkManager::markMinorForReload( ChunkVersion majorVersion ) const {
-        _splitHeuristics.markMinorForReload( getns(), majorVersion );
+        _lineage->markMinorForReload( majorVersion );
     }
 
     void ChunkManager::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) const {
+        _lineage->getMarkedMinorVersions( minorVersions );
+    }
+
+    ChunkManagerLineage::ChunkManagerLineage( const string& ns, const ShardKeyPattern& key )
+        : _ns( ns ), _key( key ) {
+    }
+
+    int ChunkManagerLineage::getCurrentDesiredChunkSize() const {
+        return desiredChunkSize( _numChunks.load() );
+    }
+
+    ChunkManagerPtr ChunkManagerLineage::reload(bool force) const {
+        return grid.getDBConfig(_ns)->getChunkManager(_ns, force);
+    }
+
+    void ChunkManagerLineage::markMinorForReload( ChunkVersion majorVersion ) const {
+        _splitHeuristics.markMinorForReload( _ns, majorVersion );
+    }
+
+    void ChunkManagerLineage::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) const {
         _splitHeuristics.getMarkedMinorVersions( minorVersions );
     }
 
-    void ChunkManager::SplitHeuristics::markMinorForReload( const string& ns, ChunkVersion majorVersion ) {
+    void ChunkManagerLineage::forgetMarkedMinorVersions(
+            const set<ChunkVersion>& minorVersions ) const {
+        _splitHeuristics.forgetMarkedMinorVersions( minorVersions );
+    }
+
+    void ChunkManagerLineage::SplitHeuristics::markMinorForReload( const string& ns, ChunkVersion majorVersion ) {
 
         // When we get a stale minor version, it means that some *other* mongos has just split a
         // chunk into a number of smaller parts, so we shouldn't need reload the data needed to
@@ -1032,13 +1224,22 @@ namespace mongo {
             grid.getDBConfig( ns )->getChunkManagerIfExists( ns, true, true );
     }
 
-    void ChunkManager::SplitHeuristics::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) {
+    void ChunkManagerLineage::SplitHeuristics::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) {
         scoped_lock lk( _staleMinorSetMutex );
         for( set<ChunkVersion>::iterator it = _staleMinorSet.begin(); it != _staleMinorSet.end(); it++ ){
             minorVersions.insert( *it );
         }
     }
 
+    void ChunkManagerLineage::SplitHeuristics::forgetMarkedMinorVersions(
+            const set<ChunkVersion>& minorVersions ) {
+        scoped_lock lk( _staleMinorSetMutex );
+        for( set<ChunkVersion>::const_iterator it = minorVersions.begin();
+             it != minorVersions.end(); ++it ){
+            _staleMinorSet.erase( *it );
+        }
+    }
+
     bool ChunkManager::_isValid(const ChunkMap& chunkMap) {
 #define ENSURE(x) do { if(!(x)) { log() << "ChunkManager::_isValid failed: " #x << endl; return false; } } while(0)
 
@@ -1192,11 +1393,38 @@ namespace mongo {
         _version = ChunkVersion( 0, 0, version.epoch() );
     }
 
+    void ChunkManager::_buildRoutingTable() {
+        vector<BSONObj> keys;
+        vector<ChunkPtr> chunks;
+        keys.reserve(_chunkMap.size());
+        chunks.reserve(_chunkMap.size());
+        for (ChunkMap::const_iterator it = _chunkMap.begin(); it != _chunkMap.end(); ++it) {
+            keys.push_back(it->first);
+            chunks.push_back(it->second);
+        }
+
+        // These members are const for thread-safety, like the ChunkMap they are built from.
+        if (const_cast<ChunkRoutingTable&>(_routingTable).build(keys)) {
+            const_cast<vector<ChunkPtr>&>(_routingChunks).swap(chunks);
+        }
+        else {
+            LOG(1) << "shard key values of " << _ns << " can't be normalized,"
+                   << " chunk lookups will use the chunk map" << endl;
+        }
+    }
+
     ChunkPtr ChunkManager::findIntersectingChunk( const BSONObj& point ) const {
         {
             BSONObj foo;
             ChunkPtr c;
-            {
+            const int index = _routingTable.upperBound( point );
+            if (index >= 0) {
+                if (static_cast<size_t>(index) < _routingChunks.size()) {
+                    c = _routingChunks[index];
+                    foo = c->getMax();
+                }
+            }
+            else {
                 ChunkMap::const_iterator it = _chunkMap.upper_bound( point );
                 if (it != _chunkMap.end()) {
                     foo = it->first;
@@ -1241,7 +1469,9 @@ namespace mongo {
         return ChunkPtr();
     }
 
-    void ChunkManager::getShardsForQuery( set<Shard>& shards , const BSONObj& query ) const {
+    void ChunkManager::getShardsForQuery( set<Shard>& shards,
+                                          const BSONObj& query,
+                                          bool isWrite ) const {
         CanonicalQuery* canonicalQuery = NULL;
         Status status = CanonicalQuery::canonicalize(
                             _ns,
@@ -1273,6 +1503,12 @@ namespace mongo {
         //   => Ranges { a : 1, b : 3 } => { a : 2, b : 4 }
         BoundList ranges = KeyPattern::flattenBounds(_key.key(), bounds);
 
+        // A query on one exact shard key value counts as an access to that key's chunk
+        if ( ranges.size() == 1 && ranges.front().first.woCompare( ranges.front().second ) == 0 ) {
+            findIntersectingChunk( ranges.front().first )->noteAccess( ranges.front().first,
+                                                                      isWrite );
+        }
+
         for ( BoundList::const_iterator it=ranges.begin(); it != ranges.end(); ++it ){
             getShardsForRange( shards, it->first /*min*/, it->second /*max*/ );
 
@@ -1289,6 +1525,27 @@ namespace mongo {
         }
     }
 
+    void ChunkManager::splitHotChunks() const {
+        if ( !Chunk::ShouldAutoSplit )
+            return;
+
+        vector<BSONObj> hotChunkMins;
+        chunkLoadTracker.takeHotChunks( _ns, &hotChunkMins );
+
+        for ( vector<BSONObj>::const_iterator it = hotChunkMins.begin();
+              it != hotChunkMins.end(); ++it ) {
+
+            ChunkPtr chunk = findIntersectingChunk( *it );
+            if ( chunk->getMin().woCompare( *it ) != 0 ) {
+                // split since it was flagged, the pieces will be tracked on their own
+                chunkLoadTracker.forget( _ns, *it );
+                continue;
+            }
+
+            chunk->splitOnLoad();
+        }
+    }
+
     void ChunkManager::getShardsForRange( set<Shard>& shards,
                                           const BSONObj& min,
                                           const BSONObj& max ) const {
@@ -1566,7 +1823,7 @@ namespace mongo {
         return ss.str();
     }
 
-    void ChunkRangeManager::assertValid() const {
+    void ChunkRangeManager::assertValid(const ChunkMap& chunks) const {
         if (_ranges.empty())
             return;
 
@@ -1592,7 +1849,6 @@ namespace mongo {
             }
 
             // Make sure we match the original chunks
-            const ChunkMap chunks = _ranges.begin()->second->getManager()->_chunkMap;
             for ( ChunkMap::const_iterator i=chunks.begin(); i!=chunks.end(); ++i ) {
                 const ChunkPtr chunk = i->second;
 
@@ -1622,7 +1878,7 @@ namespace mongo {
         _ranges.clear();
         _insertRange(chunks.begin(), chunks.end());
 
-        DEV assertValid();
+        DEV assertValid(chunks);
     }
 
     void ChunkRangeManager::_insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end) {
@@ -1638,33 +1894,14 @@ namespace mongo {
     }
 
     int ChunkManager::getCurrentDesiredChunkSize() const {
-        // split faster in early chunks helps spread out an initial load better
-        const int minChunkSize = 1 << 20;  // 1 MBytes
-
-        int splitThreshold = Chunk::MaxChunkSize;
-
-        int nc = numChunks();
-
-        if ( nc <= 1 ) {
-            return 1024;
-        }
-        else if ( nc < 3 ) {
-            return minChunkSize / 2;
-        }
-        else if ( nc < 10 ) {
-            splitThreshold = max( splitThreshold / 4 , minChunkSize );
-        }
-        else if ( nc < 20 ) {
-            splitThreshold = max( splitThreshold / 2 , minChunkSize );
-        }
-
-        return splitThreshold;
+        return desiredChunkSize( numChunks() );
     }
-    
+
     /** This is for testing only, just setting up minimal basic defaults. */
     ChunkManager::ChunkManager() :
     _unique(),
     _chunkRanges(),
+    _lineage( new ChunkManagerLineage( _ns, _key ) ),
     _mutex( "ChunkManager" ),
     _sequenceNumber()
     {}
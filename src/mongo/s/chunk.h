@@ -32,6 +32,7 @@
 
 #include "mongo/base/string_data.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/s/chunk_routing_table.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/shardkey.h"
@@ -45,6 +46,7 @@ namespace mongo {
     class Chunk;
     class ChunkRange;
     class ChunkManager;
+    class ChunkManagerLineage;
     class ChunkObjUnitTest;
     struct WriteConcernOptions;
 
@@ -65,6 +67,8 @@ namespace mongo {
      */
     class Chunk : boost::noncopyable {
     public:
+        // The chunk belongs to the lineage of 'info', and outlives 'info' if a reload of it
+        // takes the chunk over
         Chunk( const ChunkManager * info , BSONObj from);
         Chunk( const ChunkManager * info ,
                const BSONObj& min,
@@ -124,6 +128,23 @@ namespace mongo {
          */
         bool splitIfShould( long dataWritten ) const;
 
+        /**
+         * Records an operation on this chunk for the shard key 'shardKey' in chunkLoadTracker.
+         * Flags the chunk as hot if its rate reaches chunkLoadSplitOpsPerSec; the caller splits
+         * it later with ChunkManager::splitHotChunks(), outside of targeting.  Does nothing
+         * unless chunkLoadTracking is set or load-based splitting is enabled.
+         */
+        void noteAccess( const BSONObj& shardKey, bool isWrite ) const;
+
+        /**
+         * Splits this chunk at the median of the shard keys its recent operations accessed, so
+         * that the load rather than the data is halved.  The chunk's load tracking starts over
+         * whether or not the split happens.
+         *
+         * @return if the chunk was split
+         */
+        bool splitOnLoad() const;
+
         /**
          * Splits this chunk at a non-specificed split key to be chosen by the mongod holding this chunk.
          *
@@ -164,6 +185,14 @@ namespace mongo {
          */
         void pickSplitVector( std::vector<BSONObj>& splitPoints , int chunkSize , int maxPoints = 0, int maxObjs = 0) const;
 
+        /**
+         * Asks the mongod holding this chunk for the key that divides 'accessSample' in two,
+         * snapped to a key present in the chunk.
+         *
+         * @param medianKey the key that divides the accesses, if there is one, or empty
+         */
+        void pickLoadMedianKey( const std::vector<BSONObj>& accessSample, BSONObj& medianKey ) const;
+
         //
         // migration support
         //
@@ -189,8 +218,9 @@ namespace mongo {
         /**
          * @return size of shard in bytes
          *  talks to mongod to do this
+         * @param maxSize the shard stops counting once the size passes this, 0 for no limit
          */
-        long getPhysicalSize() const;
+        long long getPhysicalSize( long long maxSize = MaxChunkSize + 1 ) const;
 
         /**
          * marks this chunk as a jumbo chunk
@@ -234,14 +264,15 @@ namespace mongo {
 
         std::string getns() const;
         Shard getShard() const { return _shard; }
-        const ChunkManager* getManager() const { return _manager; }
+        const ChunkManagerLineage* getLineage() const { return _lineage; }
         
 
     private:
 
         // main shard info
         
-        const ChunkManager * _manager;
+        // kept alive by every ChunkManager holding this chunk
+        const ChunkManagerLineage * _lineage;
 
         BSONObj _min;
         BSONObj _max;
@@ -282,7 +313,6 @@ namespace mongo {
 
     class ChunkRange {
     public:
-        const ChunkManager* getManager() const { return _manager; }
         Shard getShard() const { return _shard; }
 
         const BSONObj& getMin() const { return _min; }
@@ -297,27 +327,23 @@ namespace mongo {
         bool containsPoint( const BSONObj& point ) const;
 
         ChunkRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end)
-            : _manager(begin->second->getManager())
-            , _shard(begin->second->getShard())
+            : _shard(begin->second->getShard())
             , _min(begin->second->getMin())
             , _max(boost::prior(end)->second->getMax()) {
             verify( begin != end );
 
-            DEV while (begin != end) {
-                verify(begin->second->getManager() == _manager);
-                verify(begin->second->getShard() == _shard);
-                ++begin;
+            DEV for (ChunkMap::const_iterator it = begin; it != end; ++it) {
+                verify(it->second->getLineage() == begin->second->getLineage());
+                verify(it->second->getShard() == _shard);
             }
         }
 
         // Merge min and max (must be adjacent ranges)
         ChunkRange(const ChunkRange& min, const ChunkRange& max)
-            : _manager(min.getManager())
-            , _shard(min.getShard())
+            : _shard(min.getShard())
             , _min(min.getMin())
             , _max(max.getMax()) {
             verify(min.getShard() == max.getShard());
-            verify(min.getManager() == max.getManager());
             verify(min.getMax() == max.getMin());
         }
 
@@ -326,7 +352,6 @@ namespace mongo {
         }
 
     private:
-        const ChunkManager* _manager;
         const Shard _shard;
         const BSONObj _min;
         const BSONObj _max;
@@ -342,7 +367,7 @@ namespace mongo {
         void reloadAll(const ChunkMap& chunks);
 
         // Slow operation -- wrap with DEV
-        void assertValid() const;
+        void assertValid(const ChunkMap& chunks) const;
 
         ChunkRangeMap::const_iterator upper_bound(const BSONObj& o) const { return _ranges.upper_bound(o); }
         ChunkRangeMap::const_iterator lower_bound(const BSONObj& o) const { return _ranges.lower_bound(o); }
@@ -354,6 +379,93 @@ namespace mongo {
         ChunkRangeMap _ranges;
     };
 
+    /**
+     * What the chunks of a collection need from their ChunkManager: the namespace, shard key and
+     * epoch, the chunk count that split thresholds scale with, and the split heuristics.  It
+     * doesn't change when a ChunkManager is reloaded from an older one of the same epoch, so
+     * the reloaded manager shares it with the older one and takes over the older one's Chunk
+     * objects as they are, creating new ones only for the chunks that changed.
+     */
+    class ChunkManagerLineage : boost::noncopyable {
+    public:
+        ChunkManagerLineage( const std::string& ns, const ShardKeyPattern& key );
+
+        const std::string& getns() const { return _ns; }
+
+        const ShardKeyPattern& getShardKey() const { return _key; }
+
+        // Set by the first manager of the lineage once it has loaded, before it is shared
+        const OID& getEpoch() const { return _epoch; }
+        void setEpoch( const OID& epoch ) { _epoch = epoch; }
+
+        // Chunk count of the manager of the lineage that loaded last
+        void setNumChunks( int numChunks ) { _numChunks.store( numChunks ); }
+
+        int getCurrentDesiredChunkSize() const;
+
+        ChunkManagerPtr reload(bool force=true) const;
+
+        void markMinorForReload( ChunkVersion majorVersion ) const;
+        void getMarkedMinorVersions( std::set<ChunkVersion>& minorVersions ) const;
+
+        // Called once a reload picked up 'minorVersions', so later reloads skip them
+        void forgetMarkedMinorVersions( const std::set<ChunkVersion>& minorVersions ) const;
+
+    private:
+        const std::string _ns;
+        const ShardKeyPattern _key;
+        OID _epoch;
+        AtomicInt32 _numChunks;
+
+        //
+        // Split Heuristic info
+        //
+
+
+        class SplitHeuristics {
+        public:
+
+            SplitHeuristics() :
+                _splitTickets( maxParallelSplits ),
+                _staleMinorSetMutex( "SplitHeuristics::staleMinorSet" ),
+                _staleMinorCount( 0 ) {}
+
+            void markMinorForReload( const std::string& ns, ChunkVersion majorVersion );
+            void getMarkedMinorVersions( std::set<ChunkVersion>& minorVersions );
+            void forgetMarkedMinorVersions( const std::set<ChunkVersion>& minorVersions );
+
+            TicketHolder _splitTickets;
+
+            mutex _staleMinorSetMutex;
+
+            // mutex protects below
+            int _staleMinorCount;
+            std::set<ChunkVersion> _staleMinorSet;
+
+            // Test whether we should split once data * splitTestFactor > chunkSize (approximately)
+            static const int splitTestFactor = 5;
+            // Maximum number of parallel threads requesting a split
+            static const int maxParallelSplits = 5;
+
+            // The idea here is that we're over-aggressive on split testing by a factor of
+            // splitTestFactor, so we can safely wait until we get to splitTestFactor invalid splits
+            // before changing.  Unfortunately, we also potentially over-request the splits by a
+            // factor of maxParallelSplits, but since the factors are identical it works out
+            // (for now) for parallel or sequential oversplitting.
+            // TODO: Make splitting a separate thread with notifications?
+            static const int staleMinorReloadThreshold = maxParallelSplits;
+
+        };
+
+        mutable SplitHeuristics _splitHeuristics;
+
+        //
+        // End split heuristics
+        //
+
+        friend class Chunk;
+    };
+
     /* config.sharding
          { ns: 'alleyinsider.fs.chunks' ,
            key: { ts : 1 } ,
@@ -437,7 +549,19 @@ namespace mongo {
 
         ChunkPtr findChunkOnServer( const Shard& shard ) const;
 
-        void getShardsForQuery( std::set<Shard>& shards , const BSONObj& query ) const;
+        /**
+         * 'isWrite' is true when the query selects the documents of an update or delete, which
+         * is how an exact shard key match is counted in chunkLoadTracker.
+         */
+        void getShardsForQuery( std::set<Shard>& shards,
+                                const BSONObj& query,
+                                bool isWrite = false ) const;
+
+        /**
+         * Splits the chunks of this collection that chunkLoadTracker flagged hot, at their load
+         * median.
+         */
+        void splitHotChunks() const;
         void getAllShards( std::set<Shard>& all ) const;
         /** @param shards set to the shards covered by the interval [min, max], see SERVER-4791 */
         void getShardsForRange( std::set<Shard>& shards, const BSONObj& min, const BSONObj& max ) const;
@@ -502,6 +626,9 @@ namespace mongo {
                                     ShardVersionMap& shardVersions, ChunkManagerPtr oldManager);
         static bool _isValid(const ChunkMap& chunks);
 
+        // builds _routingTable and _routingChunks from _chunkMap
+        void _buildRoutingTable();
+
         // end helpers
 
         // All members should be const for thread-safety
@@ -512,6 +639,12 @@ namespace mongo {
         const ChunkMap _chunkMap;
         const ChunkRangeManager _chunkRanges;
 
+        // Flat copy of _chunkMap for findIntersectingChunk(); the i-th chunk in _routingChunks is
+        // the one bounded above by the i-th key in _routingTable.  Unbuilt if the shard key
+        // values can't be normalized, in which case lookups use _chunkMap.
+        const ChunkRoutingTable _routingTable;
+        const std::vector<ChunkPtr> _routingChunks;
+
         const std::set<Shard> _shards;
 
         const ShardVersionMap _shardVersions; // max version per shard
@@ -523,57 +656,14 @@ namespace mongo {
         // cleared after loading chunks
         ChunkManagerPtr _oldManager;
 
+        // shared with _oldManager if its chunks were taken over, see ChunkManagerLineage
+        shared_ptr<ChunkManagerLineage> _lineage;
+
         mutable mutex _mutex; // only used with _nsLock
 
         const unsigned long long _sequenceNumber;
 
-        //
-        // Split Heuristic info
-        //
-
-
-        class SplitHeuristics {
-        public:
-
-            SplitHeuristics() :
-                _splitTickets( maxParallelSplits ),
-                _staleMinorSetMutex( "SplitHeuristics::staleMinorSet" ),
-                _staleMinorCount( 0 ) {}
-
-            void markMinorForReload( const std::string& ns, ChunkVersion majorVersion );
-            void getMarkedMinorVersions( std::set<ChunkVersion>& minorVersions );
-
-            TicketHolder _splitTickets;
-
-            mutex _staleMinorSetMutex;
-
-            // mutex protects below
-            int _staleMinorCount;
-            std::set<ChunkVersion> _staleMinorSet;
-
-            // Test whether we should split once data * splitTestFactor > chunkSize (approximately)
-            static const int splitTestFactor = 5;
-            // Maximum number of parallel threads requesting a split
-            static const int maxParallelSplits = 5;
-
-            // The idea here is that we're over-aggressive on split testing by a factor of
-            // splitTestFactor, so we can safely wait until we get to splitTestFactor invalid splits
-            // before changing.  Unfortunately, we also potentially over-request the splits by a
-            // factor of maxParallelSplits, but since the factors are identical it works out
-            // (for now) for parallel or sequential oversplitting.
-            // TODO: Make splitting a separate thread with notifications?
-            static const int staleMinorReloadThreshold = maxParallelSplits;
-
-        };
-
-        mutable SplitHeuristics _splitHeuristics;
-
-        //
-        // End split heuristics
-        //
-
         friend class Chunk;
-        friend class ChunkRangeManager; // only needed for CRM::assertValid()
         static AtomicUInt32 NextSequenceNumber;
         
         /** Just for testing */
@@ -613,7 +703,7 @@ namespace mongo {
         Chunk _c;
     };
     */
-    inline std::string Chunk::genID() const { return genID(_manager->getns(), _min); }
+    inline std::string Chunk::genID() const { return genID(_lineage->getns(), _min); }
 
     bool setShardVersion( DBClientBase & conn,
                           const std::string& ns,
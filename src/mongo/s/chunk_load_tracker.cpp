@@ -0,0 +1,278 @@
+/**
+ * Copyright (C) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_load_tracker.h"
+
+#include <cmath>
+
+namespace mongo {
+
+    namespace {
+        // Rebase the scaled counts once accesses weigh 2^64 times an access at the epoch, well
+        // before doubles lose range.
+        const double kMaxWeightExponent = 64;
+
+        const double kLn2 = 0.69314718055994530942;
+    }
+
+    ChunkLoadTracker chunkLoadTracker( 1024, 60 * 1000, 64 );
+
+    BSONObj ChunkLoadTracker::ChunkLoad::toBSON() const {
+        BSONObjBuilder b;
+        b.append( "ns", ns );
+        b.append( "min", min );
+        b.append( "opsPerSec", opsPerSec );
+        b.append( "errorOpsPerSec", errorOpsPerSec );
+        b.appendNumber( "reads", reads );
+        b.appendNumber( "writes", writes );
+        return b.obj();
+    }
+
+    ChunkLoadTracker::ChunkLoadTracker( size_t capacity,
+                                        long long halfLifeMillis,
+                                        size_t sampleSize )
+        : _capacity( capacity ),
+          _halfLifeMillis( halfLifeMillis ),
+          _sampleSize( sampleSize ),
+          _mutex( "ChunkLoadTracker" ),
+          _epochMillis( 0 ),
+          _random( 17 ) {
+        verify( _capacity > 0 );
+        verify( _halfLifeMillis > 0 );
+    }
+
+    double ChunkLoadTracker::_weightConst( long long nowMillis ) const {
+        return pow( 2.0, static_cast<double>( nowMillis - _epochMillis ) / _halfLifeMillis );
+    }
+
+    double ChunkLoadTracker::_weight( long long nowMillis ) {
+        if ( _entries.empty() ) {
+            _epochMillis = nowMillis;
+            return 1;
+        }
+
+        const double exponent = static_cast<double>( nowMillis - _epochMillis ) / _halfLifeMillis;
+        if ( exponent < kMaxWeightExponent )
+            return pow( 2.0, exponent );
+
+        // Scaling every count by the same factor keeps their order, so the index is rebuilt in
+        // place.
+        const double factor = pow( 2.0, exponent );
+        CountIndex rebased;
+        for ( EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i ) {
+            i->second.scaledCount /= factor;
+            i->second.scaledError /= factor;
+            i->second.indexPos = rebased.insert( std::make_pair( i->second.scaledCount, i ) );
+        }
+        _index.swap( rebased );
+        _epochMillis = nowMillis;
+        return 1;
+    }
+
+    double ChunkLoadTracker::_toOpsPerSec( double scaledCount, long long nowMillis ) const {
+        // At a steady rate r the decayed count converges to r * halfLife / ln(2).
+        const double count = scaledCount / _weightConst( nowMillis );
+        return count * kLn2 * 1000 / _halfLifeMillis;
+    }
+
+    void ChunkLoadTracker::_sampleKey( Entry* entry, const BSONObj& shardKey ) {
+        entry->seen++;
+
+        if ( _sampleSize == 0 || shardKey.isEmpty() )
+            return;
+
+        // reservoir sampling keeps every access equally likely to be in the sample
+        if ( entry->sample.size() < _sampleSize ) {
+            entry->sample.push_back( shardKey.getOwned() );
+            return;
+        }
+
+        const unsigned long long slot =
+            static_cast<unsigned long long>( _random.nextInt64() ) % entry->seen;
+        if ( slot < _sampleSize ) {
+            entry->sample[slot] = shardKey.getOwned();
+        }
+    }
+
+    double ChunkLoadTracker::noteAccess( const string& ns,
+                                         const BSONObj& chunkMin,
+                                         const BSONObj& shardKey,
+                                         bool isWrite,
+                                         long long nowMillis ) {
+        scoped_lock lk( _mutex );
+
+        const double weight = _weight( nowMillis );
+        const ChunkId id( ns, chunkMin );
+
+        EntryMap::iterator it = _entries.find( id );
+        if ( it == _entries.end() ) {
+            double inherited = 0;
+            if ( _entries.size() >= _capacity ) {
+                inherited = _index.begin()->first;
+                _erase( _index.begin()->second );
+            }
+
+            Entry entry;
+            entry.scaledCount = inherited;
+            entry.scaledError = inherited;
+            entry.reads = 0;
+            entry.writes = 0;
+            entry.seen = 0;
+            entry.hot = false;
+
+            it = _entries.insert( std::make_pair( ChunkId( ns, chunkMin.getOwned() ),
+                                                  entry ) ).first;
+        }
+        else {
+            _index.erase( it->second.indexPos );
+        }
+
+        Entry& entry = it->second;
+        entry.scaledCount += weight;
+        if ( isWrite )
+            entry.writes++;
+        else
+            entry.reads++;
+        _sampleKey( &entry, shardKey );
+
+        entry.indexPos = _index.insert( std::make_pair( entry.scaledCount, it ) );
+
+        return _toOpsPerSec( entry.scaledCount - entry.scaledError, nowMillis );
+    }
+
+    double ChunkLoadTracker::getOpsPerSec( const string& ns,
+                                           const BSONObj& chunkMin,
+                                           long long nowMillis ) const {
+        scoped_lock lk( _mutex );
+
+        EntryMap::const_iterator it = _entries.find( ChunkId( ns, chunkMin ) );
+        if ( it == _entries.end() )
+            return 0;
+
+        return _toOpsPerSec( it->second.scaledCount, nowMillis );
+    }
+
+    void ChunkLoadTracker::getHottest( const string& ns,
+                                       size_t limit,
+                                       long long nowMillis,
+                                       vector<ChunkLoad>* hottest ) const {
+        scoped_lock lk( _mutex );
+
+        for ( CountIndex::const_reverse_iterator i = _index.rbegin();
+              i != _index.rend() && hottest->size() < limit; ++i ) {
+
+            const ChunkId& id = i->second->first;
+            const Entry& entry = i->second->second;
+            if ( !ns.empty() && id.first != ns )
+                continue;
+
+            ChunkLoad load;
+            load.ns = id.first;
+            load.min = id.second;
+            load.opsPerSec = _toOpsPerSec( entry.scaledCount, nowMillis );
+            load.errorOpsPerSec = _toOpsPerSec( entry.scaledError, nowMillis );
+            load.reads = entry.reads;
+            load.writes = entry.writes;
+            hottest->push_back( load );
+        }
+    }
+
+    void ChunkLoadTracker::getAccessSample( const string& ns,
+                                            const BSONObj& chunkMin,
+                                            vector<BSONObj>* sample ) const {
+        scoped_lock lk( _mutex );
+
+        EntryMap::const_iterator it = _entries.find( ChunkId( ns, chunkMin ) );
+        if ( it == _entries.end() )
+            return;
+
+        sample->insert( sample->end(), it->second.sample.begin(), it->second.sample.end() );
+    }
+
+    void ChunkLoadTracker::forget( const string& ns, const BSONObj& chunkMin ) {
+        scoped_lock lk( _mutex );
+
+        EntryMap::iterator it = _entries.find( ChunkId( ns, chunkMin ) );
+        if ( it == _entries.end() )
+            return;
+
+        _erase( it );
+    }
+
+    void ChunkLoadTracker::_erase( EntryMap::iterator it ) {
+        if ( it->second.hot )
+            _numHot.subtractAndFetch( 1 );
+
+        _index.erase( it->second.indexPos );
+        _entries.erase( it );
+    }
+
+    void ChunkLoadTracker::markHot( const string& ns, const BSONObj& chunkMin ) {
+        scoped_lock lk( _mutex );
+
+        EntryMap::iterator it = _entries.find( ChunkId( ns, chunkMin ) );
+        if ( it == _entries.end() || it->second.hot )
+            return;
+
+        it->second.hot = true;
+        _numHot.addAndFetch( 1 );
+    }
+
+    void ChunkLoadTracker::takeHotChunks( const string& ns, vector<BSONObj>* chunkMins ) {
+        scoped_lock lk( _mutex );
+
+        if ( _numHot.load() == 0 )
+            return;
+
+        // entries are ordered by namespace first
+        for ( EntryMap::iterator it = _entries.lower_bound( ChunkId( ns, BSONObj() ) );
+              it != _entries.end() && it->first.first == ns; ++it ) {
+            if ( !it->second.hot )
+                continue;
+
+            it->second.hot = false;
+            _numHot.subtractAndFetch( 1 );
+            chunkMins->push_back( it->first.second );
+        }
+    }
+
+    size_t ChunkLoadTracker::numTracked() const {
+        scoped_lock lk( _mutex );
+        return _entries.size();
+    }
+
+    void ChunkLoadTracker::clear() {
+        scoped_lock lk( _mutex );
+        _index.clear();
+        _entries.clear();
+        _numHot.store( 0 );
+    }
+
+} // namespace mongo
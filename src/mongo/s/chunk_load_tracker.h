@@ -0,0 +1,184 @@
+/**
+ * Copyright (C) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Approximate rate of operations per chunk, as seen by this mongos.
+     *
+     * The tracker is a Space-Saving sketch with exponentially decaying counters: it remembers at
+     * most 'capacity' chunks and, when a new chunk shows up while full, replaces the one with the
+     * lowest decayed count.  The newcomer inherits that count as its possible overestimate, so
+     * the hottest chunks are always tracked and their rates are never underestimated.
+     *
+     * For every tracked chunk it also keeps a uniform sample of the shard keys that were
+     * accessed, which is used to split a hot chunk at its load median.
+     *
+     * All methods are thread safe.  Time is passed in by the caller, in milliseconds.
+     */
+    class ChunkLoadTracker : boost::noncopyable {
+    public:
+
+        struct ChunkLoad {
+            std::string ns;
+            BSONObj min;
+            // decayed operations per second, including the overestimate
+            double opsPerSec;
+            // how much of 'opsPerSec' may come from chunks evicted before this one was tracked
+            double errorOpsPerSec;
+            long long reads;
+            long long writes;
+
+            BSONObj toBSON() const;
+        };
+
+        /**
+         * @param capacity number of chunks tracked at once
+         * @param halfLifeMillis time after which an access counts half as much
+         * @param sampleSize number of accessed shard keys remembered per chunk
+         */
+        ChunkLoadTracker( size_t capacity, long long halfLifeMillis, size_t sampleSize );
+
+        /**
+         * Records an access to the chunk starting at 'chunkMin' for the shard key 'shardKey'.
+         *
+         * @return a lower bound of the decayed operation rate of the chunk, in operations per
+         *         second; the overestimate inherited from evicted chunks is left out
+         */
+        double noteAccess( const std::string& ns,
+                           const BSONObj& chunkMin,
+                           const BSONObj& shardKey,
+                           bool isWrite,
+                           long long nowMillis );
+
+        /**
+         * @return the decayed operation rate of the chunk, 0 if it isn't tracked
+         */
+        double getOpsPerSec( const std::string& ns,
+                             const BSONObj& chunkMin,
+                             long long nowMillis ) const;
+
+        /**
+         * Fills 'hottest' with the 'limit' chunks with the highest rates, hottest first.  If 'ns'
+         * is not empty only chunks of that collection are reported.
+         */
+        void getHottest( const std::string& ns,
+                         size_t limit,
+                         long long nowMillis,
+                         std::vector<ChunkLoad>* hottest ) const;
+
+        /**
+         * Fills 'sample' with the shard keys sampled for the chunk, in no particular order.
+         */
+        void getAccessSample( const std::string& ns,
+                              const BSONObj& chunkMin,
+                              std::vector<BSONObj>* sample ) const;
+
+        /**
+         * Stops tracking a chunk, after it was split or it couldn't be.
+         */
+        void forget( const std::string& ns, const BSONObj& chunkMin );
+
+        /**
+         * Flags a tracked chunk as hot, to be split by whoever next calls takeHotChunks().
+         */
+        void markHot( const std::string& ns, const BSONObj& chunkMin );
+
+        /**
+         * Moves the mins of the hot chunks of 'ns' into 'chunkMins' and clears their flags.
+         */
+        void takeHotChunks( const std::string& ns, std::vector<BSONObj>* chunkMins );
+
+        /** @return true if any chunk is flagged hot; cheap, doesn't take the lock */
+        bool hasHotChunks() const { return _numHot.loadRelaxed() > 0; }
+
+        /** @return number of chunks currently tracked */
+        size_t numTracked() const;
+
+        void clear();
+
+    private:
+        typedef std::pair<std::string, BSONObj> ChunkId;
+
+        struct Entry;
+        typedef std::map<ChunkId, Entry> EntryMap;
+        // scaled count -> entry, lowest first; the eviction order
+        typedef std::multimap<double, EntryMap::iterator> CountIndex;
+
+        struct Entry {
+            // Counts are kept scaled to '_epochMillis' so that decay never has to touch them:
+            // the count at time t is scaledCount / 2^((t - epoch) / halfLife).
+            double scaledCount;
+            double scaledError;
+            long long reads;
+            long long writes;
+            long long seen;
+            bool hot;
+            std::vector<BSONObj> sample;
+            CountIndex::iterator indexPos;
+        };
+
+        // weight of an access at 'nowMillis' relative to the epoch, rebasing if it grows too big
+        double _weight( long long nowMillis );
+        double _weightConst( long long nowMillis ) const;
+
+        double _toOpsPerSec( double scaledCount, long long nowMillis ) const;
+
+        void _sampleKey( Entry* entry, const BSONObj& shardKey );
+
+        void _erase( EntryMap::iterator it );
+
+        const size_t _capacity;
+        const long long _halfLifeMillis;
+        const size_t _sampleSize;
+
+        mutable mongo::mutex _mutex;
+        long long _epochMillis;
+        EntryMap _entries;
+        CountIndex _index;
+        PseudoRandom _random;
+        AtomicInt32 _numHot;
+    };
+
+    // the tracker of this mongos
+    extern ChunkLoadTracker chunkLoadTracker;
+
+} // namespace mongo
@@ -0,0 +1,182 @@
+/**
+ * Copyright (C) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_load_tracker.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::ChunkLoadTracker;
+    using std::vector;
+
+    const long long kHalfLifeMillis = 1000;
+
+    BSONObj chunkMin( int x ) {
+        return BSON( "x" << x );
+    }
+
+    TEST(ChunkLoadTracker, SteadyRate) {
+        ChunkLoadTracker tracker( 16, kHalfLifeMillis, 8 );
+
+        // 100 writes a second for 20 half-lives
+        long long now = 1000000;
+        for ( int i = 0; i < 2000; i++, now += 10 ) {
+            tracker.noteAccess( "foo.bar", chunkMin( 0 ), BSON( "x" << i ), true, now );
+        }
+
+        ASSERT_APPROX_EQUAL( 100, tracker.getOpsPerSec( "foo.bar", chunkMin( 0 ), now ), 2 );
+
+        // an idle half-life halves the rate
+        ASSERT_APPROX_EQUAL( 50,
+                             tracker.getOpsPerSec( "foo.bar", chunkMin( 0 ),
+                                                   now + kHalfLifeMillis ),
+                             1 );
+
+        ASSERT_EQUALS( 0, tracker.getOpsPerSec( "foo.bar", chunkMin( 1 ), now ) );
+        ASSERT_EQUALS( 0, tracker.getOpsPerSec( "foo.baz", chunkMin( 0 ), now ) );
+    }
+
+    TEST(ChunkLoadTracker, HotChunkSurvivesEviction) {
+        ChunkLoadTracker tracker( 4, kHalfLifeMillis, 8 );
+
+        long long now = 1000000;
+        for ( int i = 0; i < 500; i++, now += 10 ) {
+            tracker.noteAccess( "foo.bar", chunkMin( 0 ), BSON( "x" << i ), false, now );
+        }
+
+        // a stream of cold chunks only ever displaces the coldest entry
+        for ( int i = 1; i < 100; i++ ) {
+            tracker.noteAccess( "foo.bar", chunkMin( i ), chunkMin( i ), false, now );
+        }
+
+        ASSERT_EQUALS( 4U, tracker.numTracked() );
+
+        vector<ChunkLoadTracker::ChunkLoad> hottest;
+        tracker.getHottest( "", 10, now, &hottest );
+        ASSERT_EQUALS( 4U, hottest.size() );
+        ASSERT_EQUALS( chunkMin( 0 ), hottest[0].min );
+        ASSERT_EQUALS( 500, hottest[0].reads );
+        ASSERT_EQUALS( 0, hottest[0].writes );
+        ASSERT_EQUALS( 0, hottest[0].errorOpsPerSec );
+
+        // the others inherited the count of the chunks they replaced
+        for ( size_t i = 1; i < hottest.size(); i++ ) {
+            ASSERT_GREATER_THAN( hottest[i].errorOpsPerSec, 0 );
+            ASSERT_LESS_THAN( hottest[i].opsPerSec, hottest[0].opsPerSec );
+        }
+
+        hottest.clear();
+        tracker.getHottest( "foo.baz", 10, now, &hottest );
+        ASSERT( hottest.empty() );
+    }
+
+    TEST(ChunkLoadTracker, AccessSample) {
+        ChunkLoadTracker tracker( 4, kHalfLifeMillis, 16 );
+
+        long long now = 1000000;
+        for ( int i = 0; i < 1000; i++ ) {
+            tracker.noteAccess( "foo.bar", chunkMin( 0 ), BSON( "x" << i ), true, now );
+        }
+
+        vector<BSONObj> sample;
+        tracker.getAccessSample( "foo.bar", chunkMin( 0 ), &sample );
+        ASSERT_EQUALS( 16U, sample.size() );
+
+        for ( size_t i = 0; i < sample.size(); i++ ) {
+            ASSERT_GREATER_THAN_OR_EQUALS( sample[i]["x"].numberInt(), 0 );
+            ASSERT_LESS_THAN( sample[i]["x"].numberInt(), 1000 );
+        }
+
+        // the sample isn't just the first keys seen
+        int lateKeys = 0;
+        for ( size_t i = 0; i < sample.size(); i++ ) {
+            if ( sample[i]["x"].numberInt() >= 500 )
+                lateKeys++;
+        }
+        ASSERT_GREATER_THAN( lateKeys, 0 );
+
+        tracker.forget( "foo.bar", chunkMin( 0 ) );
+        sample.clear();
+        tracker.getAccessSample( "foo.bar", chunkMin( 0 ), &sample );
+        ASSERT( sample.empty() );
+        ASSERT_EQUALS( 0U, tracker.numTracked() );
+    }
+
+    TEST(ChunkLoadTracker, HotChunks) {
+        ChunkLoadTracker tracker( 4, kHalfLifeMillis, 8 );
+
+        const long long now = 1000000;
+        tracker.noteAccess( "foo.bar", chunkMin( 0 ), chunkMin( 0 ), true, now );
+        tracker.noteAccess( "foo.bar", chunkMin( 1 ), chunkMin( 1 ), true, now );
+        tracker.noteAccess( "foo.baz", chunkMin( 0 ), chunkMin( 0 ), true, now );
+        ASSERT( !tracker.hasHotChunks() );
+
+        tracker.markHot( "foo.bar", chunkMin( 1 ) );
+        tracker.markHot( "foo.bar", chunkMin( 1 ) );
+        tracker.markHot( "foo.baz", chunkMin( 0 ) );
+        // not tracked, ignored
+        tracker.markHot( "foo.bar", chunkMin( 2 ) );
+        ASSERT( tracker.hasHotChunks() );
+
+        vector<BSONObj> hot;
+        tracker.takeHotChunks( "foo.bar", &hot );
+        ASSERT_EQUALS( 1U, hot.size() );
+        ASSERT_EQUALS( chunkMin( 1 ), hot[0] );
+        ASSERT( tracker.hasHotChunks() );
+
+        hot.clear();
+        tracker.takeHotChunks( "foo.bar", &hot );
+        ASSERT( hot.empty() );
+
+        // forgetting a hot chunk clears its flag
+        tracker.forget( "foo.baz", chunkMin( 0 ) );
+        ASSERT( !tracker.hasHotChunks() );
+    }
+
+    TEST(ChunkLoadTracker, RebaseKeepsRates) {
+        ChunkLoadTracker tracker( 4, kHalfLifeMillis, 8 );
+
+        // far enough apart that the scaled counts have to be rebased in between
+        long long now = 1000000;
+        for ( int round = 0; round < 3; round++ ) {
+            for ( int i = 0; i < 1000; i++, now += 10 ) {
+                tracker.noteAccess( "foo.bar", chunkMin( 0 ), chunkMin( 0 ), true, now );
+                tracker.noteAccess( "foo.bar", chunkMin( 1 ), chunkMin( 1 ), true, now );
+            }
+
+            ASSERT_APPROX_EQUAL( 100, tracker.getOpsPerSec( "foo.bar", chunkMin( 0 ), now ), 2 );
+            ASSERT_APPROX_EQUAL( 100, tracker.getOpsPerSec( "foo.bar", chunkMin( 1 ), now ), 2 );
+
+            now += 100 * kHalfLifeMillis;
+        }
+    }
+
+} // namespace
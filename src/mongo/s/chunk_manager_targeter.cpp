@@ -110,12 +110,14 @@ namespace mongo {
                                         << _manager->getShardKey().key() );
             }
 
-            ChunkPtr chunk = _manager->findChunkForDoc( doc );
+            BSONObj shardKey = _manager->getShardKey().extractKeyFromQueryOrDoc( doc );
+            ChunkPtr chunk = _manager->findIntersectingChunk( shardKey );
             *endpoint = new ShardEndpoint( chunk->getShard().getName(),
                                            _manager->getVersion( chunk->getShard() ) );
 
             // Track autosplit stats for sharded collections
             _stats->chunkSizeDelta[chunk->getMin()] += doc.objsize();
+            chunk->noteAccess( shardKey, true );
         }
 
         return Status::OK();
@@ -318,7 +320,8 @@ namespace mongo {
         set<Shard> shards;
         if ( _manager ) {
             try {
-                _manager->getShardsForQuery( shards, query );
+                // only updates and deletes are targeted by query here
+                _manager->getShardsForQuery( shards, query, true );
             } catch ( const DBException& ex ) {
                 return ex.toStatus();
             }
@@ -343,7 +346,9 @@ namespace mongo {
         invariant(NULL != _manager);
         dassert(_manager->hasShardKey(doc));
 
-        ChunkPtr chunk = _manager->findChunkForDoc(doc);
+        BSONObj shardKey = _manager->getShardKey().extractKeyFromQueryOrDoc(doc);
+        ChunkPtr chunk = _manager->findIntersectingChunk(shardKey);
+        chunk->noteAccess(shardKey, true);
 
         Shard shard = chunk->getShard();
         *endpoint = new ShardEndpoint(shard.getName(),
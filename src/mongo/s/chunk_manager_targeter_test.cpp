@@ -32,6 +32,7 @@
 #include "mongo/s/chunk.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace {
 
@@ -520,4 +521,162 @@ namespace {
         CheckBoundList(list, expectedList);
     }
 
+    //
+    // ChunkRoutingTable
+    //
+
+    int sign(int x) {
+        return x < 0 ? -1 : (x > 0 ? 1 : 0);
+    }
+
+    // The normalized form must order keys exactly as woCompare does.
+    TEST(ChunkRoutingTableTest, EncodingMatchesWoCompare) {
+        BSONArrayBuilder valuesBuilder;
+        valuesBuilder << MINKEY;
+        valuesBuilder.appendNull();
+        valuesBuilder.append(-5LL);
+        valuesBuilder.append(-4.0);
+        valuesBuilder.append(0);
+        valuesBuilder.append(-0.0);
+        valuesBuilder.append(3);
+        valuesBuilder.append(3LL);
+        valuesBuilder.append(4.0);
+        valuesBuilder.append(1LL << 40);
+        valuesBuilder.append(std::numeric_limits<long long>::max());
+        valuesBuilder.append(std::numeric_limits<long long>::min());
+        valuesBuilder.append("");
+        valuesBuilder.append("a");
+        valuesBuilder.append(StringData("a\0", 2));
+        valuesBuilder.append(StringData("a\0b", 3));
+        valuesBuilder.append("ab");
+        valuesBuilder.append("b");
+        valuesBuilder.append(OID("000000000000000000000000"));
+        valuesBuilder.append(OID("0000000000000000000000ff"));
+        valuesBuilder.append(false);
+        valuesBuilder.append(true);
+        valuesBuilder.appendDate(Date_t(-1));
+        valuesBuilder.appendDate(Date_t(1000));
+        valuesBuilder << MAXKEY;
+        const BSONArray values = valuesBuilder.arr();
+
+        vector<BSONObj> keys;
+        BSONForEach(a, values) {
+            BSONForEach(b, values) {
+                BSONObjBuilder key;
+                key.appendAs(a, "a");
+                key.appendAs(b, "b");
+                keys.push_back(key.obj());
+            }
+        }
+
+        vector<string> fieldNames;
+        fieldNames.push_back("a");
+        fieldNames.push_back("b");
+        for (size_t i = 0; i < keys.size(); i++) {
+            string left;
+            ASSERT(ChunkRoutingTable::encodeKey(keys[i], fieldNames, &left));
+            for (size_t j = 0; j < keys.size(); j++) {
+                string right;
+                ASSERT(ChunkRoutingTable::encodeKey(keys[j], fieldNames, &right));
+                ASSERT_EQUALS(sign(keys[i].woCompare(keys[j])), sign(left.compare(right)));
+            }
+        }
+    }
+
+    TEST(ChunkRoutingTableTest, UnsupportedKeys) {
+        vector<string> noNames;
+        string out;
+        ASSERT_FALSE(ChunkRoutingTable::encodeKey(BSON("a" << 1.5), noNames, &out));
+        ASSERT_FALSE(ChunkRoutingTable::encodeKey(BSON("a" << 1e300), noNames, &out));
+        ASSERT_FALSE(ChunkRoutingTable::encodeKey(BSON("a" << BSON("b" << 1)), noNames, &out));
+        ASSERT_FALSE(ChunkRoutingTable::encodeKey(BSON("a" << Timestamp), noNames, &out));
+
+        // A table with an unsupported bound is left unbuilt and routes nothing.
+        vector<BSONObj> keys;
+        keys.push_back(BSON("a" << 1));
+        keys.push_back(BSON("a" << 2.5));
+        ChunkRoutingTable table;
+        ASSERT_FALSE(table.build(keys));
+        ASSERT_EQUALS(-1, table.upperBound(BSON("a" << 1)));
+    }
+
+    TEST(ChunkRoutingTableTest, UpperBound) {
+        vector<BSONObj> keys;
+        keys.push_back(BSON("a" << 0));
+        keys.push_back(BSON("a" << 10));
+        keys.push_back(BSON("a" << "x"));
+        keys.push_back(BSON("a" << MAXKEY));
+
+        ChunkRoutingTable table;
+        ASSERT(table.build(keys));
+        ASSERT_EQUALS(4U, table.size());
+
+        ASSERT_EQUALS(0, table.upperBound(BSON("a" << MINKEY)));
+        ASSERT_EQUALS(0, table.upperBound(BSON("a" << -1)));
+        ASSERT_EQUALS(1, table.upperBound(BSON("a" << 0)));
+        ASSERT_EQUALS(1, table.upperBound(BSON("a" << 9.0)));
+        ASSERT_EQUALS(2, table.upperBound(BSON("a" << 10LL)));
+        ASSERT_EQUALS(2, table.upperBound(BSON("a" << "w")));
+        ASSERT_EQUALS(3, table.upperBound(BSON("a" << "x")));
+        ASSERT_EQUALS(4, table.upperBound(BSON("a" << MAXKEY)));
+
+        // Points the table can't normalize or with other field names are left to the caller.
+        ASSERT_EQUALS(-1, table.upperBound(BSON("a" << 0.5)));
+        ASSERT_EQUALS(-1, table.upperBound(BSON("b" << 1)));
+        ASSERT_EQUALS(-1, table.upperBound(BSON("a" << 1 << "b" << 1)));
+    }
+
+    /**
+     * Compares lookups/sec of the routing table against the ChunkMap it replaces, for hashed
+     * shard keys (NumberLong) at several collection sizes.
+     */
+    TEST(ChunkRoutingTableTest, LookupBenchmark) {
+        const int kLookups = 200 * 1000;
+        const int sizes[] = { 1000, 100 * 1000, 1000 * 1000 };
+
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            const int numChunks = sizes[s];
+            const long long step = std::numeric_limits<long long>::max() / numChunks * 2;
+
+            vector<BSONObj> keys;
+            map<BSONObj, int, BSONObjCmp> chunkMap;
+            long long bound = std::numeric_limits<long long>::min();
+            for (int i = 0; i < numChunks - 1; i++) {
+                bound += step;
+                keys.push_back(BSON("a" << bound));
+                chunkMap[keys.back()] = i;
+            }
+            keys.push_back(BSON("a" << MAXKEY));
+            chunkMap[keys.back()] = numChunks - 1;
+
+            ChunkRoutingTable table;
+            ASSERT(table.build(keys));
+
+            vector<BSONObj> points;
+            points.reserve(kLookups);
+            for (int i = 0; i < kLookups; i++) {
+                long long point = (static_cast<long long>(rand()) << 32) ^ rand();
+                points.push_back(BSON("a" << (i % 2 ? point : -point)));
+            }
+
+            long long checksum = 0;
+            Timer mapTimer;
+            for (int i = 0; i < kLookups; i++) {
+                checksum += chunkMap.upper_bound(points[i])->second;
+            }
+            const long long mapMicros = std::max(1LL, mapTimer.micros());
+
+            Timer tableTimer;
+            for (int i = 0; i < kLookups; i++) {
+                checksum -= table.upperBound(points[i]);
+            }
+            const long long tableMicros = std::max(1LL, tableTimer.micros());
+
+            ASSERT_EQUALS(0, checksum);
+            log() << "chunk routing with " << numChunks << " chunks: chunk map "
+                  << kLookups * 1000000LL / mapMicros << " lookups/sec, routing table "
+                  << kLookups * 1000000LL / tableMicros << " lookups/sec";
+        }
+    }
+
 } // end namespace
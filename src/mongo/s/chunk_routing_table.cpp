@@ -0,0 +1,217 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_routing_table.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace mongo {
+
+namespace {
+
+    // Doubles are only normalized when they are integers small enough to be exact, so that they
+    // order the same way against NumberLongs as woCompare()'s conversion to double does.
+    const double kMaxExactDouble = 9007199254740992.0; // 2^53
+
+    void appendBigEndian64(unsigned long long value, std::string* out) {
+        char buf[8];
+        for (int i = 7; i >= 0; i--) {
+            buf[i] = static_cast<char>(value & 0xff);
+            value >>= 8;
+        }
+        out->append(buf, sizeof(buf));
+    }
+
+    // Flipping the sign bit makes signed values sort correctly as unsigned bytes.
+    void appendSigned64(long long value, std::string* out) {
+        appendBigEndian64(static_cast<unsigned long long>(value) ^ (1ULL << 63), out);
+    }
+
+    /**
+     * Strings compare by their bytes with a shorter prefix first.  Embedded NULs are escaped as
+     * 00 ff and the end is marked with 00 00, which sorts below any continuation.
+     */
+    void appendString(const char* str, int len, std::string* out) {
+        const char* end = str + len;
+        for (const char* p = str; p != end; ++p) {
+            out->push_back(*p);
+            if (*p == '\0')
+                out->push_back('\xff');
+        }
+        out->push_back('\0');
+        out->push_back('\0');
+    }
+
+    bool appendElement(const BSONElement& elem, std::string* out) {
+        // Types that woCompare() doesn't order by value within their canonical type must not be
+        // normalized, nor must types whose canonical type shares a slot with one of those.
+        switch (elem.type()) {
+        case MinKey:
+        case MaxKey:
+        case jstNULL:
+        case NumberInt:
+        case NumberLong:
+        case NumberDouble:
+        case String:
+        case Symbol:
+        case jstOID:
+        case Bool:
+        case Date:
+            break;
+        default:
+            return false;
+        }
+
+        out->push_back(static_cast<char>(elem.canonicalType() + 1));
+
+        switch (elem.type()) {
+        case NumberInt:
+            appendSigned64(elem._numberInt(), out);
+            return true;
+        case NumberLong:
+            appendSigned64(elem._numberLong(), out);
+            return true;
+        case NumberDouble: {
+            const double d = elem._numberDouble();
+            if (!(std::fabs(d) < kMaxExactDouble) || d != std::floor(d))
+                return false;
+            appendSigned64(static_cast<long long>(d), out);
+            return true;
+        }
+        case String:
+        case Symbol:
+            appendString(elem.valuestr(), elem.valuestrsize() - 1, out);
+            return true;
+        case jstOID:
+            out->append(elem.value(), OID::kOIDSize);
+            return true;
+        case Bool:
+            out->push_back(elem.boolean() ? 1 : 0);
+            return true;
+        case Date:
+            appendSigned64(elem.date().millis, out);
+            return true;
+        default:
+            // MinKey, MaxKey and null are fully described by their type.
+            return true;
+        }
+    }
+
+    int compareEncoded(const char* l, size_t lLen, const char* r, size_t rLen) {
+        const int res = memcmp(l, r, std::min(lLen, rLen));
+        if (res)
+            return res;
+        return lLen < rLen ? -1 : (lLen == rLen ? 0 : 1);
+    }
+
+} // namespace
+
+    ChunkRoutingTable::ChunkRoutingTable() : _built(false) {}
+
+    bool ChunkRoutingTable::encodeKey(const BSONObj& key,
+                                      const std::vector<std::string>& fieldNames,
+                                      std::string* out) {
+        size_t i = 0;
+        BSONObjIterator it(key);
+        while (it.more()) {
+            const BSONElement elem = it.next();
+            if (!fieldNames.empty()) {
+                if (i == fieldNames.size() || fieldNames[i] != elem.fieldName())
+                    return false;
+                i++;
+            }
+            if (!appendElement(elem, out))
+                return false;
+        }
+        return fieldNames.empty() || i == fieldNames.size();
+    }
+
+    bool ChunkRoutingTable::build(const std::vector<BSONObj>& sortedKeys) {
+        _built = false;
+        _fieldNames.clear();
+        _keys.clear();
+        _offsets.clear();
+
+        if (sortedKeys.empty())
+            return false;
+
+        BSONObjIterator it(sortedKeys.front());
+        while (it.more())
+            _fieldNames.push_back(it.next().fieldName());
+
+        _offsets.reserve(sortedKeys.size() + 1);
+        _offsets.push_back(0);
+        for (size_t i = 0; i < sortedKeys.size(); i++) {
+            if (!encodeKey(sortedKeys[i], _fieldNames, &_keys)) {
+                _fieldNames.clear();
+                _keys.clear();
+                _offsets.clear();
+                return false;
+            }
+            _offsets.push_back(_keys.size());
+        }
+
+        _built = true;
+        return true;
+    }
+
+    int ChunkRoutingTable::upperBound(const BSONObj& point) const {
+        if (!_built)
+            return -1;
+
+        std::string encoded;
+        if (!encodeKey(point, _fieldNames, &encoded))
+            return -1;
+
+        const char* keys = _keys.data();
+        const unsigned* offsets = &_offsets[0];
+
+        // Find the first bound greater than the point.
+        size_t low = 0;
+        size_t count = size();
+        while (count > 0) {
+            const size_t half = count / 2;
+            const size_t mid = low + half;
+            const int cmp = compareEncoded(keys + offsets[mid], offsets[mid + 1] - offsets[mid],
+                                           encoded.data(), encoded.size());
+            if (cmp <= 0) {
+                low = mid + 1;
+                count -= half + 1;
+            }
+            else {
+                count = half;
+            }
+        }
+
+        return static_cast<int>(low);
+    }
+
+} // namespace mongo
@@ -0,0 +1,89 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * An immutable, flat index over the upper bounds of a collection's chunks, used to route a
+     * shard key to its chunk without walking the ChunkMap.
+     *
+     * Bounds are stored back to back in one buffer in a normalized binary form whose memcmp()
+     * order matches BSONObj::woCompare(), so a lookup is a binary search over contiguous memory
+     * with no BSON parsing per probe.  Only common shard key types can be normalized (see
+     * encodeKey()); if any bound cannot be, the table stays unbuilt and callers fall back to
+     * the ChunkMap.
+     */
+    class ChunkRoutingTable {
+    public:
+        ChunkRoutingTable();
+
+        /**
+         * Builds the table from chunk upper bounds in ascending order.  Returns false, leaving
+         * the table unbuilt, if some bound cannot be normalized.
+         */
+        bool build(const std::vector<BSONObj>& sortedKeys);
+
+        bool isBuilt() const { return _built; }
+
+        size_t size() const { return _offsets.empty() ? 0 : _offsets.size() - 1; }
+
+        /**
+         * Returns the index of the first bound greater than 'point', which is size() if there is
+         * none, or -1 if the table is not built or 'point' cannot be normalized.
+         */
+        int upperBound(const BSONObj& point) const;
+
+        /**
+         * Appends the normalized form of 'key' to 'out'.  Returns false if some field has a type
+         * that isn't normalized (non-integral or very large doubles, Timestamp, objects, arrays,
+         * binary data and the like), in which case 'out' is left in an unspecified state.
+         * If 'fieldNames' is non-empty, the field names of 'key' must match it as well.
+         */
+        static bool encodeKey(const BSONObj& key,
+                              const std::vector<std::string>& fieldNames,
+                              std::string* out);
+
+    private:
+        bool _built;
+
+        // Field names shared by every bound, which points must match to be routed by the table.
+        std::vector<std::string> _fieldNames;
+
+        // Bound i occupies [_offsets[i], _offsets[i + 1]) of _keys.
+        std::string _keys;
+        std::vector<unsigned> _offsets;
+    };
+
+} // namespace mongo
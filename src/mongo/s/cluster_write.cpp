@@ -35,6 +35,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/base/status.h"
+#include "mongo/s/chunk_load_tracker.h"
 #include "mongo/s/chunk_manager_targeter.h"
 #include "mongo/s/config.h"
 #include "mongo/s/dbclient_multi_command.h"
@@ -138,6 +139,10 @@ namespace mongo {
 
             chunk->splitIfShould( it->second );
         }
+
+        if ( chunkLoadTracker.hasHotChunks() ) {
+            chunkManager->splitHotChunks();
+        }
     }
 
     /**
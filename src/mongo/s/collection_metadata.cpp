@@ -199,6 +199,7 @@ namespace mongo {
         metadata->_pendingMap.erase( pending.getMin() );
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangeBounds = this->_rangeBounds;
         metadata->_shardVersion = _shardVersion;
         metadata->_collVersion = _collVersion;
 
@@ -234,6 +235,7 @@ namespace mongo {
         metadata->_pendingMap = this->_pendingMap;
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangeBounds = this->_rangeBounds;
         metadata->_shardVersion = _shardVersion;
         metadata->_collVersion = _collVersion;
 
@@ -424,6 +426,7 @@ namespace mongo {
         metadata->_pendingMap = this->_pendingMap;
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangeBounds = this->_rangeBounds;
         metadata->_shardVersion = newShardVersion;
         metadata->_collVersion =
                 newShardVersion > _collVersion ? newShardVersion : this->_collVersion;
@@ -449,6 +452,17 @@ namespace mongo {
             return false;
         }
 
+        // Most shards own a single contiguous range of a collection
+        if ( _rangesMap.size() == 1 ) {
+            RangeMap::const_iterator it = _rangesMap.begin();
+            return rangeContains( it->first, it->second, key );
+        }
+
+        const int bound = _rangeBounds.upperBound( key );
+        if ( bound >= 0 ) {
+            return bound % 2 == 1;
+        }
+
         RangeMap::const_iterator it = _rangesMap.upper_bound( key );
         if ( it != _rangesMap.begin() ) it--;
 
@@ -714,6 +728,26 @@ namespace mongo {
         dassert(!min.isEmpty());
 
         _rangesMap.insert(make_pair(min, max));
+
+        fillRangeBounds();
+    }
+
+    void CollectionMetadata::fillRangeBounds() {
+        if (_rangesMap.size() <= 1) {
+            _rangeBounds = ChunkRoutingTable();
+            return;
+        }
+
+        vector<BSONObj> bounds;
+        bounds.reserve(_rangesMap.size() * 2);
+        for (RangeMap::const_iterator it = _rangesMap.begin(); it != _rangesMap.end(); ++it) {
+            bounds.push_back(it->first);
+            bounds.push_back(it->second);
+        }
+
+        // Leaves the table unbuilt if some bound can't be normalized, keyBelongsToMe then uses
+        // the map
+        _rangeBounds.build(bounds);
     }
 
     void CollectionMetadata::fillKeyPatternFields() {
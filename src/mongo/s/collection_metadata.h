@@ -32,6 +32,7 @@
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/field_ref_set.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/s/chunk_routing_table.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/range_arithmetic.h"
 #include "mongo/s/type_chunk.h"
@@ -299,6 +300,11 @@ namespace mongo {
         // installations.
         RangeMap _rangesMap;
 
+        // The bounds of _rangesMap flattened in order, min0 max0 min1 max1 ..., so keyBelongsToMe
+        // can binary search normalized keys instead of walking the map.  A key is ours if the
+        // first bound above it is a max.  Only built when there is more than one range.
+        ChunkRoutingTable _rangeBounds;
+
         /**
          * Returns true if this metadata was loaded with all necessary information.
          */
@@ -309,6 +315,11 @@ namespace mongo {
          */
         void fillRanges();
 
+        /**
+         * Builds _rangeBounds from _rangesMap
+         */
+        void fillRangeBounds();
+
         /**
          * Creates the _keyField* local data
          */
@@ -40,7 +40,9 @@
 #include "mongo/s/type_chunk.h"
 #include "mongo/s/type_collection.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/log.h"
 #include "mongo/util/net/hostandport.h"
+#include "mongo/util/timer.h"
 
 namespace {
 
@@ -58,11 +60,13 @@ namespace {
     using mongo::MetadataLoader;
     using mongo::MINKEY;
     using mongo::OID;
+    using mongo::RangeMap;
     using mongo::ChunkVersion;
     using mongo::MockConnRegistry;
     using mongo::MockRemoteDBServer;
     using mongo::RangeVector;
     using mongo::Status;
+    using mongo::Timer;
     using std::auto_ptr;
     using std::make_pair;
     using std::string;
@@ -1231,6 +1235,16 @@ namespace {
         ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << MAXKEY)) );
     }
 
+    TEST_F(ThreeChunkWithRangeGapFixture, ShardOwnsDocWithOtherTypes) {
+        // Non-integral doubles can't be normalized and take the RangeMap path
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << 19.5)) );
+        ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << 29.5)) );
+
+        // Strings sort after all numbers, so they are in the last range
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << "abc")) );
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << MINKEY)) );
+    }
+
     TEST_F(ThreeChunkWithRangeGapFixture, GetNextFromEmpty) {
         ChunkType nextChunk;
         ASSERT( getCollMetadata().getNextChunk( getCollMetadata().getMinKey(), &nextChunk ) );
@@ -1412,4 +1426,89 @@ namespace {
         ASSERT( !errMsg.empty() );
     }
 
+    /**
+     * Compares lookups/sec of keyBelongsToMe against the RangeMap lookup it used to do for every
+     * document, with the shard owning every other chunk so no ranges coalesce.
+     */
+    TEST(CollectionMetadataBenchmark, KeyBelongsToMe) {
+        const int kLookups = 200 * 1000;
+        const int sizes[] = { 100, 10 * 1000 };
+
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            const int numChunks = sizes[s];
+
+            MockRemoteDBServer dummyConfig( CONFIG_HOST_PORT );
+            mongo::ConnectionString::setConnectionHook( MockConnRegistry::get()->getConnStrHook() );
+            MockConnRegistry::get()->addServer( &dummyConfig );
+
+            OID epoch = OID::gen();
+
+            CollectionType collType;
+            collType.setNS( "test.foo" );
+            collType.setKeyPattern( BSON("a" << 1) );
+            collType.setUnique( false );
+            collType.setUpdatedAt( 1ULL );
+            collType.setEpoch( epoch );
+            dummyConfig.insert( CollectionType::ConfigNS, collType.toBSON() );
+
+            RangeMap ownedRanges;
+            for ( int i = 0; i < numChunks; i++ ) {
+                BSONObj min = i == 0 ? BSON("a" << MINKEY) : BSON("a" << i * 10);
+                BSONObj max = i == numChunks - 1 ? BSON("a" << MAXKEY) : BSON("a" << (i + 1) * 10);
+                string shard = i % 2 == 0 ? "shard0000" : "shard0001";
+
+                ChunkType chunkType;
+                chunkType.setNS( "test.foo" );
+                chunkType.setShard( shard );
+                chunkType.setMin( min );
+                chunkType.setMax( max );
+                chunkType.setVersion( ChunkVersion( 1, i, epoch ) );
+                chunkType.setName( OID::gen().toString() );
+                dummyConfig.insert( ChunkType::ConfigNS, chunkType.toBSON() );
+
+                if ( shard == "shard0000" ) {
+                    ownedRanges.insert( make_pair( min, max ) );
+                }
+            }
+
+            CollectionMetadata metadata;
+            ConnectionString configLoc( (HostAndPort( CONFIG_HOST_PORT )) );
+            MetadataLoader loader( configLoc );
+            Status status = loader.makeCollectionMetadata( "test.foo",
+                                                           "shard0000",
+                                                           NULL,
+                                                           &metadata );
+            ASSERT( status.isOK() );
+
+            vector<BSONObj> keys;
+            keys.reserve( kLookups );
+            for ( int i = 0; i < kLookups; i++ ) {
+                keys.push_back( BSON("a" << rand() % ( numChunks * 10 + 20 ) - 10) );
+            }
+
+            int mapOwned = 0;
+            Timer mapTimer;
+            for ( int i = 0; i < kLookups; i++ ) {
+                RangeMap::const_iterator it = ownedRanges.upper_bound( keys[i] );
+                if ( it != ownedRanges.begin() ) it--;
+                if ( rangeContains( it->first, it->second, keys[i] ) ) mapOwned++;
+            }
+            const long long mapMicros = std::max( 1LL, mapTimer.micros() );
+
+            int metadataOwned = 0;
+            Timer metadataTimer;
+            for ( int i = 0; i < kLookups; i++ ) {
+                if ( metadata.keyBelongsToMe( keys[i] ) ) metadataOwned++;
+            }
+            const long long metadataMicros = std::max( 1LL, metadataTimer.micros() );
+
+            ASSERT_EQUALS( mapOwned, metadataOwned );
+            mongo::log() << "keyBelongsToMe with " << numChunks / 2 << " owned ranges: range map "
+                  << kLookups * 1000000LL / mapMicros << " lookups/sec, metadata "
+                  << kLookups * 1000000LL / metadataMicros << " lookups/sec";
+
+            MockConnRegistry::get()->clear();
+        }
+    }
+
 } // unnamed namespace
@@ -53,6 +53,7 @@
 #include "mongo/db/write_concern.h"
 #include "mongo/db/write_concern_options.h"
 #include "mongo/s/chunk.h"
+#include "mongo/s/chunk_load_tracker.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/cluster_write.h"
 #include "mongo/s/config.h"
@@ -1202,6 +1203,48 @@ namespace mongo {
             }
         } listShardsCmd;
 
+        class HotChunksCmd : public GridAdminCmd {
+        public:
+            HotChunksCmd() : GridAdminCmd("hotChunks") { }
+            virtual void help( stringstream& help ) const {
+                help << "list the chunks this mongos routes the most operations to\n"
+                     << "{ hotChunks : 1 , ns : <optional collection> , limit : <default 10> }";
+            }
+            virtual void addRequiredPrivileges(const std::string& dbname,
+                                               const BSONObj& cmdObj,
+                                               std::vector<Privilege>* out) {
+                ActionSet actions;
+                actions.addAction(ActionType::serverStatus);
+                out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+            }
+            bool run(OperationContext* txn, const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+                const string ns = cmdObj.getStringField( "ns" );
+
+                long long limit = 10;
+                BSONElement limitElem = cmdObj["limit"];
+                if ( !limitElem.eoo() ) {
+                    if ( !limitElem.isNumber() || limitElem.numberLong() <= 0 ) {
+                        errmsg = "limit must be a positive number";
+                        return false;
+                    }
+                    limit = limitElem.numberLong();
+                }
+
+                vector<ChunkLoadTracker::ChunkLoad> hottest;
+                chunkLoadTracker.getHottest( ns, limit, curTimeMillis64(), &hottest );
+
+                BSONArrayBuilder chunks( result.subarrayStart( "chunks" ) );
+                for ( vector<ChunkLoadTracker::ChunkLoad>::const_iterator it = hottest.begin();
+                      it != hottest.end(); ++it ) {
+                    chunks.append( it->toBSON() );
+                }
+                chunks.done();
+
+                result.appendNumber( "tracked", static_cast<long long>( chunkLoadTracker.numTracked() ) );
+                return true;
+            }
+        } hotChunksCmd;
+
         /* a shard is a single mongod server or a replica pair.  add it (them) to the cluster as a storage partition. */
         class AddShard : public GridAdminCmd {
         public:
@@ -144,6 +144,12 @@ namespace mongo {
     bool DBConfig::isSharded( const string& ns ) {
         if ( ! _shardingEnabled )
             return false;
+
+        RoutingSnapshotPtr snapshot = _getSnapshot();
+        if ( snapshot ) {
+            return snapshot->shardingEnabled && snapshot->managers.count( ns ) > 0;
+        }
+
         scoped_lock lk( _lock );
         return _isSharded( ns );
     }
@@ -185,6 +191,7 @@ namespace mongo {
 
         scoped_lock lk( _lock );
         _shardingEnabled = true;
+        _publishSnapshot();
         if( save ) _save();
     }
 
@@ -228,6 +235,7 @@ namespace mongo {
             cm->createFirstChunks( configServer.getPrimary().getConnString(),
                                    getPrimary(), initPoints, initShards );
             ci.shard( cm );
+            _publishSnapshot();
 
             _save();
 
@@ -289,6 +297,7 @@ namespace mongo {
         }
 
         ci.unshard();
+        _publishSnapshot();
         _save( false, true );
         return true;
     }
@@ -298,12 +307,24 @@ namespace mongo {
 
         // The logic here is basically that at any time, our collection can become sharded or unsharded
         // via a command.  If we're not sharded, we want to send data to the primary, if sharded, we want
-        // to send data to the correct chunks, and we can't check both w/o the lock.
+        // to send data to the correct chunks, and we can't check both w/o a consistent view - the
+        // routing snapshot, or the lock until the first snapshot is published.
 
         manager.reset();
         primary.reset();
 
-        {
+        RoutingSnapshotPtr snapshot = _getSnapshot();
+        if ( snapshot ) {
+            // Both answers come from the same snapshot, so they can't disagree
+            map<string,ChunkManagerPtr>::const_iterator i = snapshot->managers.find( ns );
+            if ( snapshot->shardingEnabled && i != snapshot->managers.end() ) {
+                manager = i->second;
+            }
+            else {
+                primary.reset( new Shard( snapshot->primary ) );
+            }
+        }
+        else {
             scoped_lock lk( _lock );
 
             Collections::iterator i = _collections.find( ns );
@@ -354,6 +375,15 @@ namespace mongo {
         ChunkVersion oldVersion;
         ChunkManagerPtr oldManager;
 
+        if ( ! ( shouldReload || forceReload ) ) {
+            RoutingSnapshotPtr snapshot = _getSnapshot();
+            if ( snapshot ) {
+                map<string,ChunkManagerPtr>::const_iterator i = snapshot->managers.find( ns );
+                if ( i != snapshot->managers.end() )
+                    return i->second;
+            }
+        }
+
         {
             scoped_lock lk( _lock );
             
@@ -478,6 +508,7 @@ namespace mongo {
 
         if ( shouldReset ){
             ci.resetCM( temp.release() );
+            _publishSnapshot();
         }
         
         uassert( 15883 , str::stream() << "not sharded after chunk manager reset : " << ns , ci.isSharded() );
@@ -487,6 +518,7 @@ namespace mongo {
     void DBConfig::setPrimary( const std::string& s ) {
         scoped_lock lk( _lock );
         _primary.reset( s );
+        _publishSnapshot();
         _save();
     }
 
@@ -566,6 +598,8 @@ namespace mongo {
 
         conn.done();
 
+        _publishSnapshot();
+
         return true;
     }
 
@@ -605,6 +639,21 @@ namespace mongo {
         }
     }
 
+    void DBConfig::_publishSnapshot() {
+        // Collections are few per database and this only runs when the metadata changes, so
+        // copying the pointers is cheaper than making every lookup take the lock
+        boost::shared_ptr<RoutingSnapshot> snapshot( new RoutingSnapshot() );
+        snapshot->shardingEnabled = _shardingEnabled;
+        snapshot->primary = _primary;
+
+        for ( Collections::const_iterator i = _collections.begin(); i != _collections.end(); ++i ) {
+            if ( i->second.isSharded() )
+                snapshot->managers[ i->first ] = i->second.getCM();
+        }
+
+        boost::atomic_store( &_snapshot, RoutingSnapshotPtr( snapshot ) );
+    }
+
     bool DBConfig::reload() {
         bool successful = false;
 
@@ -35,6 +35,9 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
+#include <map>
+
 #include "mongo/client/dbclient_rs.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/shard.h"
@@ -99,6 +102,22 @@ namespace mongo {
 
         typedef std::map<std::string,CollectionInfo> Collections;
 
+        /**
+         * What routing needs to know about this database, as of one point in time.  Never changes
+         * once published: every change to the collections, the primary or the sharding state
+         * builds a new snapshot and swaps it in whole, so that lookups don't wait on _lock.
+         */
+        struct RoutingSnapshot {
+            RoutingSnapshot() : shardingEnabled( false ) {}
+
+            bool shardingEnabled;
+            Shard primary;
+            // sharded collections only
+            std::map<std::string,ChunkManagerPtr> managers;
+        };
+
+        typedef boost::shared_ptr<const RoutingSnapshot> RoutingSnapshotPtr;
+
     public:
 
         DBConfig( std::string name )
@@ -196,6 +215,18 @@ namespace mongo {
         bool _reload();
         void _save( bool db = true, bool coll = true );
 
+        /**
+         * Rebuilds the routing snapshot from the current state.  Must hold _lock.
+         */
+        void _publishSnapshot();
+
+        /**
+         * @return the current routing snapshot, or NULL if the database hasn't been loaded
+         */
+        RoutingSnapshotPtr _getSnapshot() const {
+            return boost::atomic_load( &_snapshot );
+        }
+
         std::string _name; // e.g. "alleyinsider"
         Shard _primary; // e.g. localhost , mongo.foo.com:9999
         bool _shardingEnabled;
@@ -205,7 +236,10 @@ namespace mongo {
 
         Collections _collections;
 
-        mutable mongo::mutex _lock; // TODO: change to r/w lock ??
+        // Read with boost::atomic_load, replaced under _lock with boost::atomic_store
+        RoutingSnapshotPtr _snapshot;
+
+        mutable mongo::mutex _lock; // serializes changes, routing reads go through _snapshot
         mutable mongo::mutex _hitConfigServerLock;
     };
 
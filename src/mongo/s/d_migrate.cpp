@@ -70,6 +70,7 @@
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/logger/ramlog.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -77,6 +78,7 @@
 #include "mongo/s/distlock.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/type_chunk.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/elapsed_tracker.h"
 #include "mongo/util/exit.h"
@@ -98,6 +100,12 @@ namespace {
     const int kDefaultWTimeoutMs = 60 * 1000;
     const WriteConcernOptions DefaultWriteConcern(2, WriteConcernOptions::NONE, kDefaultWTimeoutMs);
 
+    // _migrateClone batches the recipient keeps requested ahead of the one it is applying
+    const size_t kCloneBatchesInFlight = 2;
+
+    // Cloned documents the recipient applies per write lock acquisition
+    const int kCloneDocsPerWriteLock = 128;
+
     /**
      * Returns the default write concern for migration cleanup (at donor shard) and
      * cloning documents (at recipient shard).
@@ -128,7 +136,8 @@ namespace mongo {
     public:
         MoveTimingHelper( const string& where , const string& ns , BSONObj min , BSONObj max ,
                           int total , string* cmdErrmsg )
-            : _where( where ) , _ns( ns ) , _next( 0 ) , _total( total ) , _cmdErrmsg( cmdErrmsg ) {
+            : _where( where ) , _ns( ns ) , _next( 0 ) , _total( total ) , _lastStepMillis( 0 ) ,
+              _cmdErrmsg( cmdErrmsg ) {
             _b.append( "min" , min );
             _b.append( "max" , max );
         }
@@ -167,7 +176,8 @@ namespace mongo {
             else
                 warning() << "op is null in MoveTimingHelper::done" << migrateLog;
 
-            _b.appendNumber( s , _t.millis() );
+            _lastStepMillis = _t.millis();
+            _b.appendNumber( s , _lastStepMillis );
             _t.reset();
 
 #if 0
@@ -179,6 +189,22 @@ namespace mongo {
 #endif
         }
 
+        /**
+         * Records how much data moved during the step that was just completed, so the
+         * changelog entry shows per-phase throughput alongside the step timings.
+         */
+        void noteThroughput( const StringData& phase , long long docs , long long bytes ) {
+            BSONObjBuilder b( _b.subobjStart( phase ) );
+            b.appendNumber( "docs" , docs );
+            b.appendNumber( "bytes" , bytes );
+            b.appendNumber( "millis" , _lastStepMillis );
+            // Avoid dividing by zero for steps that finish within the timer resolution
+            const long long millis = std::max( _lastStepMillis , 1 );
+            b.appendNumber( "docsPerSec" , docs * 1000 / millis );
+            b.appendNumber( "bytesPerSec" , bytes * 1000 / millis );
+            b.done();
+        }
+
     private:
         Timer _t;
 
@@ -187,6 +213,7 @@ namespace mongo {
 
         int _next;
         int _total; // expected # of steps
+        int _lastStepMillis;
 
         const string* _cmdErrmsg;
 
@@ -225,6 +252,8 @@ namespace mongo {
             _active = false;
             _inCriticalSection = false;
             _memoryUsed = 0;
+            _clonedDocs = 0;
+            _clonedBytes = 0;
         }
 
         /**
@@ -256,6 +285,9 @@ namespace mongo {
             verify( _reload.size() == 0 );
             verify( _memoryUsed == 0 );
 
+            _clonedDocs = 0;
+            _clonedBytes = 0;
+
             _active = true;
             return true;
         }
@@ -551,6 +583,8 @@ namespace mongo {
                     }
                     
                     a.append( o );
+                    _clonedDocs++;
+                    _clonedBytes += o.objsize();
                 }
                 
                 _cloneLocs.erase( _cloneLocs.begin() , i );
@@ -578,6 +612,13 @@ namespace mongo {
 
         long long mbUsed() const { return _memoryUsed / ( 1024 * 1024 ); }
 
+        /** Documents and bytes handed to the recipient through _migrateClone so far. */
+        void getClonedStats( long long* docs , long long* bytes ) {
+            scoped_spinlock lk( _trackerLocks );
+            *docs = _clonedDocs;
+            *bytes = _clonedBytes;
+        }
+
         bool getInCriticalSection() const {
             scoped_lock l(_mutex);
             return _inCriticalSection;
@@ -630,6 +671,10 @@ namespace mongo {
         // updates applied by 1 thread in a write lock
         set<DiskLoc> _cloneLocs;
 
+        // progress of the initial clone, protected by _trackerLocks
+        long long _clonedDocs;
+        long long _clonedBytes;
+
         list<BSONObj> _reload; // objects that were modified that must be recloned
         list<BSONObj> _deleted; // objects deleted during clone that should be deleted later
         long long _memoryUsed; // bytes in _reload + _deleted
@@ -1199,6 +1244,12 @@ namespace mongo {
                 txn->checkForInterrupt();
             }
             timing.done(4);
+            {
+                long long clonedDocs;
+                long long clonedBytes;
+                migrateFromStatus.getClonedStats( &clonedDocs , &clonedBytes );
+                timing.noteThroughput( "clone" , clonedDocs , clonedBytes );
+            }
             MONGO_FP_PAUSE_WHILE(moveChunkHangAtStep4);
 
             // 5.
@@ -1596,6 +1647,78 @@ namespace mongo {
     MONGO_FP_DECLARE(migrateThreadHangAtStep4);
     MONGO_FP_DECLARE(migrateThreadHangAtStep5);
 
+    /**
+     * Keeps up to 'maxInFlight' _migrateClone batches requested ahead of the recipient, so the
+     * next batch is on the wire (and being read off disk by the donor) while the current one
+     * is applied locally.
+     *
+     * The fetch thread owns 'conn' until the donor returns an empty batch or an error; the
+     * destructor stops and joins it, so 'conn' may be reused once this goes out of scope.
+     */
+    class CloneBatchPrefetcher : boost::noncopyable {
+    public:
+        CloneBatchPrefetcher( DBClientBase* conn , size_t maxInFlight )
+            : _conn( conn ) , _batches( maxInFlight ) {
+            _thread.reset( new boost::thread( stdx::bind( &CloneBatchPrefetcher::_run , this ) ) );
+        }
+
+        ~CloneBatchPrefetcher() {
+            _stopRequested.store( 1 );
+            // Unblock the fetch thread if it is waiting for room in the queue
+            BSONObj discarded;
+            while ( !_thread->timed_join( boost::posix_time::milliseconds( 10 ) ) ) {
+                _batches.tryPop( discarded );
+            }
+        }
+
+        /**
+         * Waits for the next batch.  The result is the raw _migrateClone response; a response
+         * with an empty "objects" array or without "ok" set is the last one returned.
+         */
+        BSONObj next() {
+            return _batches.blockingPop();
+        }
+
+    private:
+        void _run() {
+            Client::initThread( "migrateCloneFetcher" );
+            if (getGlobalAuthorizationManager()->isAuthEnabled()) {
+                cc().getAuthorizationSession()->grantInternalAuthorization();
+            }
+
+            while ( !_stopRequested.load() ) {
+                BSONObj res;
+                try {
+                    _conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res );
+                    res = res.getOwned();
+
+                    // Check the reply here: anything thrown out of this thread would terminate
+                    // the process, whereas a failed reply just fails the migration.
+                    if ( res["ok"].trueValue() && !res["objects"].isABSONObj() ) {
+                        string errmsg = str::stream() << "_migrateClone reply has no objects: "
+                                                      << res;
+                        res = BSON( "ok" << 0 << "errmsg" << errmsg );
+                    }
+                }
+                catch ( const std::exception& e ) {
+                    res = BSON( "ok" << 0 << "errmsg" << e.what() );
+                }
+
+                _batches.push( res );
+
+                if ( !res["ok"].trueValue() || res["objects"].Obj().isEmpty() )
+                    break;
+            }
+
+            cc().shutdown();
+        }
+
+        DBClientBase* const _conn;
+        BlockingQueue<BSONObj> _batches;
+        AtomicUInt32 _stopRequested;
+        scoped_ptr<boost::thread> _thread;
+    };
+
     class MigrateStatus {
     public:
         enum State {
@@ -1665,6 +1788,10 @@ namespace mongo {
                 }
             }
 
+            if ( !pendingIndexSpecs.empty() ) {
+                _cleanupPendingIndexes(txn);
+            }
+
             setActive( false );
         }
 
@@ -1707,9 +1834,12 @@ namespace mongo {
                 ctx.commit();
             }
 
-            {                
+            vector<BSONObj> immediateIndexSpecs;
+            pendingIndexSpecs.clear();
+
+            {
                 // 1. copy indexes
-                
+
                 vector<BSONObj> indexSpecs;
                 {
                     const std::list<BSONObj> indexes = conn->getIndexSpecs(ns);
@@ -1743,40 +1873,34 @@ namespace mongo {
                         return;
                     }
 
-                    Status status = indexer.init(indexSpecs);
-                    if ( !status.isOK() ) {
-                        errmsg = str::stream() << "failed to create index before migrating data. "
-                                               << " error: " << status.toString();
-                        warning() << errmsg;
-                        setState(FAIL);
-                        return;
+                    // The collection is empty, so secondary indexes can be built in bulk once
+                    // the initial clone is done rather than maintained for every cloned
+                    // document.  The shard key index is needed now by the range deleter in
+                    // step 2, and unique indexes must reject duplicates as documents arrive.
+                    for (size_t i = 0; i < indexSpecs.size(); i++) {
+                        const BSONObj& spec = indexSpecs[i];
+                        if (spec["unique"].trueValue() ||
+                            shardKeyPattern.isPrefixOf(spec["key"].Obj())) {
+                            immediateIndexSpecs.push_back(spec);
+                        }
+                        else {
+                            pendingIndexSpecs.push_back(spec);
+                        }
                     }
 
-                    status = indexer.insertAllDocumentsInCollection();
-                    if ( !status.isOK() ) {
-                        errmsg = str::stream() << "failed to create index before migrating data. "
-                                               << " error: " << status.toString();
+                    if (!immediateIndexSpecs.empty() &&
+                        !_buildIndexes_inlock(txn, db, collection, immediateIndexSpecs,
+                                              &errmsg)) {
                         warning() << errmsg;
                         setState(FAIL);
                         return;
                     }
-
-                    WriteUnitOfWork wunit(txn);
-                    indexer.commit();
-
-                    for (size_t i = 0; i < indexSpecs.size(); i++) {
-                        // make sure to create index on secondaries as well
-                        repl::logOp(txn, "i", db->getSystemIndexesName().c_str(), indexSpecs[i],
-                                       NULL, NULL, true /* fromMigrate */);
-                    }
-
-                    wunit.commit();
                 }
-
-                timing.done(1);
-                MONGO_FP_PAUSE_WHILE(migrateThreadHangAtStep1);
             }
 
+            timing.done(1);
+            MONGO_FP_PAUSE_WHILE(migrateThreadHangAtStep1);
+
             {
                 // 2. delete any data already in range
                 RangeDeleterOptions deleterOptions(KeyRange(ns,
@@ -1836,9 +1960,12 @@ namespace mongo {
                 // 3. initial bulk clone
                 setState(CLONE);
 
+                // gets arrays of objects to copy, in disk order
+                CloneBatchPrefetcher prefetcher( conn.get() , kCloneBatchesInFlight );
+
                 while ( true ) {
-                    BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    BSONObj res = prefetcher.next();
+                    if ( !res["ok"].trueValue() ) {
                         setState(FAIL);
                         errmsg = "_migrateClone failed: ";
                         errmsg += res.toString();
@@ -1861,30 +1988,38 @@ namespace mongo {
                             return;
                         }
 
-                        BSONObj o = i.next().Obj();
+                        // Apply the batch in groups under one write lock and one commit,
+                        // instead of taking the lock for every document
+                        int appliedThisGroup = 0;
                         {
                             Client::WriteContext cx(txn, ns );
 
-                            BSONObj localDoc;
-                            if ( willOverrideLocalId( txn, cx.ctx().db(), o, &localDoc ) ) {
-                                string errMsg =
-                                    str::stream() << "cannot migrate chunk, local document "
-                                    << localDoc
-                                    << " has same _id as cloned "
-                                    << "remote document " << o;
+                            while ( i.more() && appliedThisGroup < kCloneDocsPerWriteLock ) {
+                                BSONObj o = i.next().Obj();
+
+                                BSONObj localDoc;
+                                if ( willOverrideLocalId( txn, cx.ctx().db(), o, &localDoc ) ) {
+                                    string errMsg =
+                                        str::stream() << "cannot migrate chunk, local document "
+                                        << localDoc
+                                        << " has same _id as cloned "
+                                        << "remote document " << o;
 
-                                warning() << errMsg << endl;
+                                    warning() << errMsg << endl;
 
-                                // Exception will abort migration cleanly
-                                uasserted( 16976, errMsg );
+                                    // Exception will abort migration cleanly
+                                    uasserted( 16976, errMsg );
+                                }
+
+                                Helpers::upsert( txn, ns, o, true );
+                                appliedThisGroup++;
+                                clonedBytes += o.objsize();
                             }
 
-                            Helpers::upsert( txn, ns, o, true );
                             cx.commit();
                         }
-                        thisTime++;
-                        numCloned++;
-                        clonedBytes += o.objsize();
+                        thisTime += appliedThisGroup;
+                        numCloned += appliedThisGroup;
 
                         if (writeConcern.shouldWaitForOtherNodes() && thisTime > 0) {
                             repl::ReplicationCoordinator::StatusAndDuration replStatus =
@@ -1906,7 +2041,29 @@ namespace mongo {
                         break;
                 }
 
+                // One index per lock acquisition, so other operations on the database get in
+                // between builds and an abort is noticed without waiting for all of them.
+                // Whatever is left on any exit is dealt with by _cleanupPendingIndexes().
+                while ( !pendingIndexSpecs.empty() ) {
+                    if ( getState() == ABORT ) {
+                        errmsg = str::stream() << "Migration abort requested while "
+                                               << "building indexes";
+                        error() << errmsg << migrateLog;
+                        return;
+                    }
+
+                    if ( !_buildIndexes( txn,
+                                         vector<BSONObj>( 1, pendingIndexSpecs.front() ),
+                                         &errmsg ) ) {
+                        warning() << errmsg;
+                        setState(FAIL);
+                        return;
+                    }
+                    pendingIndexSpecs.erase( pendingIndexSpecs.begin() );
+                }
+
                 timing.done(3);
+                timing.noteThroughput( "clone" , numCloned , clonedBytes );
                 MONGO_FP_PAUSE_WHILE(migrateThreadHangAtStep3);
             }
 
@@ -2156,6 +2313,107 @@ namespace mongo {
             return didAnything;
         }
 
+        /**
+         * Builds indexes the donor has and we lack, and replicates their creation to
+         * secondaries.  The build holds the database lock exclusively, since index builds
+         * cannot yield in this tree, but can be interrupted with killOp.
+         */
+        bool _buildIndexes( OperationContext* txn,
+                            const vector<BSONObj>& indexSpecs,
+                            string* errmsg ) {
+            Lock::DBLock lk(txn->lockState(),  nsToDatabaseSubstring(ns), newlm::MODE_X);
+            Client::Context ctx(txn,  ns);
+            Database* db = ctx.db();
+            Collection* collection = db->getCollection( txn, ns );
+            if ( !collection ) {
+                *errmsg = str::stream() << "collection dropped during migration: " << ns;
+                return false;
+            }
+
+            return _buildIndexes_inlock( txn, db, collection, indexSpecs, errmsg );
+        }
+
+        /**
+         * Called when a migration ends before the indexes put off until after the clone were
+         * built.  Left as is, the cloned documents would lack those indexes, and every later
+         * migration to this shard would fail its index check before its preCleanup could
+         * remove them.  So the indexes are built now, or if that fails the cloned range is
+         * removed instead.
+         */
+        void _cleanupPendingIndexes( OperationContext* txn ) {
+            try {
+                string errMsg;
+                if ( _buildIndexes( txn, pendingIndexSpecs, &errMsg ) ) {
+                    pendingIndexSpecs.clear();
+                    return;
+                }
+                warning() << "could not build indexes left by failed migration: " << errMsg
+                          << migrateLog;
+            }
+            catch ( const std::exception& e ) {
+                warning() << "could not build indexes left by failed migration: " << e.what()
+                          << migrateLog;
+            }
+            pendingIndexSpecs.clear();
+
+            try {
+                RangeDeleterOptions deleterOptions(KeyRange(ns,
+                                                            min.getOwned(),
+                                                            max.getOwned(),
+                                                            shardKeyPattern));
+                deleterOptions.writeConcern = writeConcern;
+                deleterOptions.waitForOpenCursors = false;
+                deleterOptions.fromMigrate = true;
+                deleterOptions.onlyRemoveOrphanedDocs = true;
+                deleterOptions.removeSaverReason = "postCleanup";
+
+                string errMsg;
+                if (!getDeleter()->deleteNow(txn, deleterOptions, &errMsg)) {
+                    warning() << "could not remove range of failed migration: " << errMsg
+                              << migrateLog;
+                }
+            }
+            catch ( const std::exception& e ) {
+                warning() << "could not remove range of failed migration: " << e.what()
+                          << migrateLog;
+            }
+        }
+
+        bool _buildIndexes_inlock( OperationContext* txn,
+                                   Database* db,
+                                   Collection* collection,
+                                   const vector<BSONObj>& indexSpecs,
+                                   string* errmsg ) {
+            MultiIndexBlock indexer(txn, collection);
+            indexer.allowInterruption();
+
+            Status status = indexer.init(indexSpecs);
+            if ( !status.isOK() ) {
+                *errmsg = str::stream() << "failed to create index for migrating data. "
+                                        << " error: " << status.toString();
+                return false;
+            }
+
+            status = indexer.insertAllDocumentsInCollection();
+            if ( !status.isOK() ) {
+                *errmsg = str::stream() << "failed to create index for migrating data. "
+                                        << " error: " << status.toString();
+                return false;
+            }
+
+            WriteUnitOfWork wunit(txn);
+            indexer.commit();
+
+            for (size_t i = 0; i < indexSpecs.size(); i++) {
+                // make sure to create index on secondaries as well
+                repl::logOp(txn, "i", db->getSystemIndexesName().c_str(), indexSpecs[i],
+                               NULL, NULL, true /* fromMigrate */);
+            }
+
+            wunit.commit();
+            return true;
+        }
+
         /**
          * Checks if an upsert of a remote document will override a local document with the same _id
          * but in a different range on this shard.
@@ -2281,6 +2539,9 @@ namespace mongo {
         long long numSteady;
         WriteConcernOptions writeConcern;
 
+        // secondary indexes the recipient still has to build after the initial clone
+        vector<BSONObj> pendingIndexSpecs;
+
         // protects state
         mutable mutex stateMutex;
         State state;
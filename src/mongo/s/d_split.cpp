@@ -32,6 +32,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
@@ -226,6 +227,10 @@ namespace mongo {
                  "  \n"
                  "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, force: true }\n"
                  "  'force' will produce one split point even if data is small; defaults to false\n"
+                 "  \n"
+                 "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, accessSample: [{x:12}, ...] }\n"
+                 "  'accessSample' returns the existing key nearest the median of the sampled keys, so that a\n"
+                 "  chunk hot with operations splits its load rather than its data in half\n"
                  "NOTE: This command may take a while to run";
         }
         virtual Status checkAuthForCommand(ClientBasic* client,
@@ -241,6 +246,71 @@ namespace mongo {
         virtual std::string parseNs(const string& dbname, const BSONObj& cmdObj) const {
             return parseNsFullyQualified(dbname, cmdObj);
         }
+
+        /**
+         * Finds the first existing key at or after the median of the sampled keys in
+         * [chunkMin, chunkMax). 'indexMax' is the upper bound of the chunk in index key format.
+         * Leaves 'loadKey' empty if no key strictly inside the chunk qualifies.
+         */
+        static bool findLoadMedianKey( OperationContext* txn,
+                                       Collection* collection,
+                                       IndexDescriptor* idx,
+                                       const BSONObj& keyPattern,
+                                       const BSONObj& chunkMin,
+                                       const BSONObj& chunkMax,
+                                       const BSONObj& accessSample,
+                                       const BSONObj& indexMax,
+                                       BSONObj* loadKey,
+                                       string& errmsg ) {
+
+            vector<BSONObj> sample;
+            BSONObjIterator it( accessSample );
+            while ( it.more() ) {
+                BSONElement keyElem = it.next();
+                if ( keyElem.type() != Object ) {
+                    errmsg = "accessSample must be an array of shard keys";
+                    return false;
+                }
+
+                BSONObj key = keyElem.Obj().extractFields( keyPattern );
+                if ( key.woCompare( chunkMin, keyPattern ) < 0 )
+                    continue;
+                if ( !chunkMax.isEmpty() && key.woCompare( chunkMax, keyPattern ) >= 0 )
+                    continue;
+
+                sample.push_back( key.getOwned() );
+            }
+
+            if ( sample.empty() )
+                return true;
+
+            BSONObjCmp keyOrder( keyPattern );
+            std::sort( sample.begin(), sample.end(), keyOrder );
+            const BSONObj& median = sample[ sample.size() / 2 ];
+
+            // The median itself may no longer exist, so split at the first key from there on
+            KeyPattern kp( idx->keyPattern() );
+            const BSONObj scanMin = Helpers::toKeyFormat( kp.extendRangeBound( median, false ) );
+
+            auto_ptr<PlanExecutor> exec(
+                InternalPlanner::indexScan(txn, collection, idx, scanMin, indexMax,
+                                           false, InternalPlanner::FORWARD));
+
+            BSONObj currKey;
+            while ( PlanExecutor::ADVANCED == exec->getNext( &currKey, NULL ) ) {
+                BSONObj key = prettyKey( idx->keyPattern(), currKey.getOwned() )
+                                  .extractFields( keyPattern );
+
+                // a split at the chunk's own lower bound would leave one side empty
+                if ( key.woCompare( chunkMin, keyPattern ) > 0 ) {
+                    *loadKey = key.getOwned();
+                    break;
+                }
+            }
+
+            return true;
+        }
+
         bool run(OperationContext* txn, const string& dbname, BSONObj& jsobj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
 
             //
@@ -299,6 +369,10 @@ namespace mongo {
                              keyPattern.clientReadable().toString();
                     return false;
                 }
+                // the bounds as given, before they are turned into index keys
+                const BSONObj chunkMin = min.getOwned();
+                const BSONObj chunkMax = max.getOwned();
+
                 // extend min to get (min, MinKey, MinKey, ....)
                 KeyPattern kp( idx->keyPattern() );
                 min = Helpers::toKeyFormat( kp.extendRangeBound ( min, false ) );
@@ -310,6 +384,24 @@ namespace mongo {
                     max = Helpers::toKeyFormat( kp.extendRangeBound( max, false ) );
                 }
 
+                // A sample of the keys operations touched asks for the one key that splits the
+                // chunk's load in half, whatever the data size
+                BSONElement accessSampleElem = jsobj[ "accessSample" ];
+                if ( accessSampleElem.type() == Array ) {
+                    BSONObj loadKey;
+                    if ( !findLoadMedianKey( txn, collection, idx, keyPattern, chunkMin, chunkMax,
+                                             accessSampleElem.Obj(), max, &loadKey, errmsg ) ) {
+                        return false;
+                    }
+
+                    if ( !loadKey.isEmpty() ) {
+                        splitKeys.push_back( loadKey );
+                    }
+
+                    result.append( "splitKeys" , splitKeys );
+                    return true;
+                }
+
                 const long long recCount = collection->numRecords(txn);
                 const long long dataSize = collection->dataSize(txn);
 
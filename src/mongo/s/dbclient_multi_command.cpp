@@ -38,6 +38,7 @@
 #include "mongo/s/write_ops/batch_downconvert.h"
 #include "mongo/s/write_ops/dbclient_safe_writer.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/socket_poll.h"
 
 namespace mongo {
 
@@ -156,7 +157,10 @@ namespace mongo {
             it != _pendingCommands.end(); ++it ) {
 
             PendingCommand* command = *it;
-            dassert( NULL == command->conn );
+
+            // Commands may be added and sent while earlier ones are still outstanding, skip
+            // anything which was already sent (or failed to send)
+            if ( NULL != command->conn || !command->status.isOK() ) continue;
 
             try {
                 dassert( command->endpoint.type() == ConnectionString::MASTER ||
@@ -201,10 +205,62 @@ namespace mongo {
         return static_cast<int>( _pendingCommands.size() );
     }
 
+    DBClientMultiCommand::PendingQueue::iterator DBClientMultiCommand::_nextReady() {
+
+        dassert( !_pendingCommands.empty() );
+
+        // Only the oldest outstanding command for each endpoint may be received next, so that
+        // responses for an endpoint come back in the order the commands were added
+        vector<PendingQueue::iterator> candidates;
+        vector<pollfd> pollFds;
+        set<string> seenEndpoints;
+
+        for ( PendingQueue::iterator it = _pendingCommands.begin();
+            it != _pendingCommands.end(); ++it ) {
+
+            PendingCommand* command = *it;
+            if ( !seenEndpoints.insert( command->endpoint.toString() ).second ) continue;
+
+            // Failed sends and legacy writes (done synchronously on recv) never wait on the
+            // network for a response
+            if ( !command->status.isOK() ) return it;
+            if ( !hasBatchWriteFeature( command->conn )
+                 && isBatchWriteCommand( command->cmdObj ) ) return it;
+
+            DBClientConnection* conn = dynamic_cast<DBClientConnection*>( command->conn );
+            if ( NULL == conn ) return it;
+
+            pollfd pollFd;
+            pollFd.fd = conn->port().psock->rawFD();
+            pollFd.events = POLLIN;
+            pollFd.revents = 0;
+
+            candidates.push_back( it );
+            pollFds.push_back( pollFd );
+        }
+
+        if ( candidates.size() == 1u || !isPollSupported() ) return candidates.front();
+
+        // Wait for any endpoint to have its response waiting.  On timeout or error, fall back to
+        // the oldest command and let the recv report whatever went wrong.
+        int numReady = socketPoll( &pollFds.front(),
+                                   pollFds.size(),
+                                   _timeoutMillis > 0 ? _timeoutMillis : -1 );
+
+        if ( numReady > 0 ) {
+            for ( size_t i = 0; i < pollFds.size(); ++i ) {
+                if ( pollFds[i].revents != 0 ) return candidates[i];
+            }
+        }
+
+        return candidates.front();
+    }
+
     Status DBClientMultiCommand::recvAny( ConnectionString* endpoint, BSONSerializable* response ) {
 
-        scoped_ptr<PendingCommand> command( _pendingCommands.front() );
-        _pendingCommands.pop_front();
+        PendingQueue::iterator readyIt = _nextReady();
+        scoped_ptr<PendingCommand> command( *readyIt );
+        _pendingCommands.erase( readyIt );
 
         *endpoint = command->endpoint;
         if ( !command->status.isOK() ) return command->status;
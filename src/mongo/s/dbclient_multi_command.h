@@ -56,6 +56,10 @@ namespace mongo {
 
         int numPending() const;
 
+        /**
+         * Returns a response from any endpoint which has one waiting, in the order commands were
+         * added for any single endpoint.
+         */
         Status recvAny( ConnectionString* endpoint, BSONSerializable* response );
 
         void setTimeoutMillis( int milliSecs );
@@ -82,6 +86,11 @@ namespace mongo {
         };
 
         typedef std::deque<PendingCommand*> PendingQueue;
+
+        // Returns the outstanding command to receive next, preferring one whose response is
+        // already waiting
+        PendingQueue::iterator _nextReady();
+
         PendingQueue _pendingCommands;
         int _timeoutMillis;
     };
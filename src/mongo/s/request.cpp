@@ -41,6 +41,7 @@
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/s/chunk.h"
+#include "mongo/s/chunk_load_tracker.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/config.h"
 #include "mongo/s/cursors.h"
@@ -88,6 +89,28 @@ namespace mongo {
         grid.getDBConfig( getns() );
     }
 
+    /**
+     * Splits the chunks of 'ns' that queries flagged hot. Runs once the reply is out so that the
+     * query that tipped a chunk over doesn't wait for the split.
+     */
+    static void splitHotChunksIfNeeded( const string& ns ) {
+        if ( !Chunk::ShouldAutoSplit || !chunkLoadTracker.hasHotChunks() )
+            return;
+
+        try {
+            DBConfigPtr config = grid.getDBConfig( ns, false );
+            if ( !config )
+                return;
+
+            ChunkManagerPtr manager = config->getChunkManagerIfExists( ns );
+            if ( manager )
+                manager->splitHotChunks();
+        }
+        catch ( const DBException& ex ) {
+            warning() << "could not split hot chunks of " << ns << causedBy( ex ) << endl;
+        }
+    }
+
     void Request::process( int attempt ) {
         init();
         int op = _m.operation();
@@ -123,6 +146,7 @@ namespace mongo {
             }
             else {
                 STRATEGY->queryOp( *this );
+                splitHotChunksIfNeeded( getns() );
             }
 
             globalOpCounters.gotOp( op , iscmd );
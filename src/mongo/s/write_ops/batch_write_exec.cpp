@@ -33,13 +33,14 @@
 #include "mongo/s/write_ops/batch_write_exec.h"
 
 #include "mongo/base/error_codes.h"
-#include "mongo/base/owned_pointer_map.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/dbclientinterface.h" // ConnectionString (header-only)
 #include "mongo/s/write_ops/batch_write_op.h"
 #include "mongo/s/write_ops/write_error_detail.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -55,12 +56,27 @@ namespace mongo {
     namespace {
 
         //
-        // Map which allows associating ConnectionString hosts with TargetedWriteBatches
-        // This is needed since the dispatcher only returns hosts with responses.
+        // Child batches for a single host, waiting to be sent or out on the network.  The
+        // dispatcher only returns hosts with responses, so in-flight batches are kept in send
+        // order to match responses back up.
         //
 
+        struct InFlightBatch {
+            InFlightBatch( TargetedWriteBatch* batch, long long sentMicros ) :
+                batch( batch ), sentMicros( sentMicros ) {
+            }
+
+            TargetedWriteBatch* batch;
+            long long sentMicros;
+        };
+
+        struct HostBatchQueue {
+            std::deque<TargetedWriteBatch*> queued;
+            std::deque<InFlightBatch> inFlight;
+        };
+
         // TODO: Unordered map?
-        typedef OwnedPointerMap<ConnectionString, TargetedWriteBatch> OwnedHostBatchMap;
+        typedef std::map<ConnectionString, HostBatchQueue> HostBatchQueueMap;
     }
 
     static void buildErrorFrom( const Status& status, WriteErrorDetail* error ) {
@@ -85,10 +101,47 @@ namespace mongo {
         return false;
     }
 
+    // Helper to add queued batches for a host to the dispatcher, up to the in-flight limit.
+    // Returns the number of batches added, which still need to be sent.
+    static int dispatchQueuedBatches( const BatchedCommandRequest& clientRequest,
+                                      const BatchWriteOp& batchOp,
+                                      const ConnectionString& shardHost,
+                                      size_t maxInFlight,
+                                      HostBatchQueue* hostQueue,
+                                      MultiCommandDispatch* dispatcher ) {
+
+        int numAdded = 0;
+        while ( !hostQueue->queued.empty() && hostQueue->inFlight.size() < maxInFlight ) {
+
+            TargetedWriteBatch* nextBatch = hostQueue->queued.front();
+            hostQueue->queued.pop_front();
+
+            BatchedCommandRequest request( clientRequest.getBatchType() );
+            batchOp.buildBatchRequest( *nextBatch, &request );
+
+            // Internally we use full namespaces for request/response, but we send the
+            // command to a database with the collection name in the request.
+            NamespaceString nss( request.getNS() );
+            request.setNS( nss.coll() );
+
+            LOG( 4 ) << "sending write batch to " << shardHost.toString() << ": "
+                     << request.toString() << endl;
+
+            dispatcher->addCommand( shardHost, nss.db(), request );
+            hostQueue->inFlight.push_back( InFlightBatch( nextBatch, curTimeMicros64() ) );
+            ++numAdded;
+        }
+
+        return numAdded;
+    }
+
     // The number of times we'll try to continue a batch op if no progress is being made
     // This only applies when no writes are occurring and metadata is not changing on reload
     static const int kMaxRoundsWithoutProgress( 5 );
 
+    // The number of unordered child batches which may be outstanding to a single host at once
+    static const size_t kMaxInFlightBatchesPerHost( 2 );
+
     void BatchWriteExec::executeBatch( const BatchedCommandRequest& clientRequest,
                                        BatchedCommandResponse* clientResponse ) {
 
@@ -151,161 +204,150 @@ namespace mongo {
             //
             // Send all child batches
             //
+            // Batches are queued per host and each host's queue is drained independently: as
+            // soon as a host answers, its next batch goes out, so a slow shard only holds up its
+            // own writes.  Ordered batches keep at most one batch outstanding per host.
+            //
 
-            size_t numSent = 0;
-            size_t numToSend = childBatches.size();
-            bool remoteMetadataChanging = false;
-            while ( numSent != numToSend ) {
-
-                // Collect batches out on the network, mapped by endpoint
-                OwnedHostBatchMap ownedPendingBatches;
-                OwnedHostBatchMap::MapType& pendingBatches = ownedPendingBatches.mutableMap();
-
-                //
-                // Send side
-                //
-
-                // Get as many batches as we can at once
-                for ( vector<TargetedWriteBatch*>::iterator it = childBatches.begin();
-                    it != childBatches.end(); ++it ) {
-
-                    //
-                    // Collect the info needed to dispatch our targeted batch
-                    //
-
-                    TargetedWriteBatch* nextBatch = *it;
-                    // If the batch is NULL, we sent it previously, so skip
-                    if ( nextBatch == NULL ) continue;
-
-                    // Figure out what host we need to dispatch our targeted batch
-                    ConnectionString shardHost;
-                    Status resolveStatus = _resolver->chooseWriteHost( nextBatch->getEndpoint()
-                                                                           .shardName,
-                                                                       &shardHost );
-                    if ( !resolveStatus.isOK() ) {
-
-                        ++_stats->numResolveErrors;
-
-                        // Record a resolve failure
-                        // TODO: It may be necessary to refresh the cache if stale, or maybe just
-                        // cancel and retarget the batch
-                        WriteErrorDetail error;
-                        buildErrorFrom( resolveStatus, &error );
-
-                        LOG( 4 ) << "unable to send write batch to " << shardHost.toString()
-                                 << causedBy( resolveStatus.toString() ) << endl;
-
-                        batchOp.noteBatchError( *nextBatch, error );
-
-                        // We're done with this batch
-                        // Clean up when we can't resolve a host
-                        delete *it;
-                        *it = NULL;
-                        --numToSend;
-                        continue;
-                    }
+            const size_t maxInFlightPerHost =
+                clientRequest.getOrdered() ? 1u : kMaxInFlightBatchesPerHost;
+            const long long targetedMicros = curTimeMicros64();
 
-                    // If we already have a batch for this host, wait until the next time
-                    OwnedHostBatchMap::MapType::iterator pendingIt = pendingBatches.find( shardHost );
-                    if ( pendingIt != pendingBatches.end() ) continue;
+            HostBatchQueueMap hostQueues;
+            bool remoteMetadataChanging = false;
 
-                    //
-                    // We now have all the info needed to dispatch the batch
-                    //
+            for ( vector<TargetedWriteBatch*>::iterator it = childBatches.begin();
+                it != childBatches.end(); ++it ) {
 
-                    BatchedCommandRequest request( clientRequest.getBatchType() );
-                    batchOp.buildBatchRequest( *nextBatch, &request );
+                TargetedWriteBatch* nextBatch = *it;
 
-                    // Internally we use full namespaces for request/response, but we send the
-                    // command to a database with the collection name in the request.
-                    NamespaceString nss( request.getNS() );
-                    request.setNS( nss.coll() );
+                // Figure out what host we need to dispatch our targeted batch
+                ConnectionString shardHost;
+                Status resolveStatus = _resolver->chooseWriteHost( nextBatch->getEndpoint()
+                                                                       .shardName,
+                                                                   &shardHost );
+                if ( !resolveStatus.isOK() ) {
 
-                    LOG( 4 ) << "sending write batch to " << shardHost.toString() << ": "
-                             << request.toString() << endl;
+                    ++_stats->numResolveErrors;
 
-                    _dispatcher->addCommand( shardHost, nss.db(), request );
+                    // Record a resolve failure
+                    // TODO: It may be necessary to refresh the cache if stale, or maybe just
+                    // cancel and retarget the batch
+                    WriteErrorDetail error;
+                    buildErrorFrom( resolveStatus, &error );
 
-                    // Indicate we're done by setting the batch to NULL
-                    // We'll only get duplicate hostEndpoints if we have broadcast and non-broadcast
-                    // endpoints for the same host, so this should be pretty efficient without
-                    // moving stuff around.
-                    *it = NULL;
+                    LOG( 4 ) << "unable to send write batch to " << shardHost.toString()
+                             << causedBy( resolveStatus.toString() ) << endl;
 
-                    // Recv-side is responsible for cleaning up the nextBatch when used
-                    pendingBatches.insert( make_pair( shardHost, nextBatch ) );
+                    batchOp.noteBatchError( *nextBatch, error );
+                    continue;
                 }
 
-                // Send them all out
-                _dispatcher->sendAll();
-                numSent += pendingBatches.size();
+                hostQueues[shardHost].queued.push_back( nextBatch );
+            }
+
+            //
+            // Send side
+            //
+
+            for ( HostBatchQueueMap::iterator it = hostQueues.begin(); it != hostQueues.end();
+                ++it ) {
+                dispatchQueuedBatches( clientRequest,
+                                       batchOp,
+                                       it->first,
+                                       maxInFlightPerHost,
+                                       &it->second,
+                                       _dispatcher );
+            }
 
-                //
-                // Recv side
-                //
+            // Send them all out
+            _dispatcher->sendAll();
 
-                while ( _dispatcher->numPending() > 0 ) {
+            //
+            // Recv side
+            //
 
-                    // Get the response
-                    ConnectionString shardHost;
-                    BatchedCommandResponse response;
-                    Status dispatchStatus = _dispatcher->recvAny( &shardHost, &response );
+            while ( _dispatcher->numPending() > 0 ) {
 
-                    // Get the TargetedWriteBatch to find where to put the response
-                    dassert( pendingBatches.find( shardHost ) != pendingBatches.end() );
-                    TargetedWriteBatch* batch = pendingBatches.find( shardHost )->second;
+                // Get the response
+                ConnectionString shardHost;
+                BatchedCommandResponse response;
+                Status dispatchStatus = _dispatcher->recvAny( &shardHost, &response );
+                const long long recvMicros = curTimeMicros64();
 
-                    if ( dispatchStatus.isOK() ) {
+                // Responses for a host arrive in the order its batches were sent, so the oldest
+                // in-flight batch is the one this response belongs to
+                dassert( hostQueues.find( shardHost ) != hostQueues.end() );
+                HostBatchQueue& hostQueue = hostQueues.find( shardHost )->second;
+                dassert( !hostQueue.inFlight.empty() );
+                const InFlightBatch inFlight = hostQueue.inFlight.front();
+                hostQueue.inFlight.pop_front();
+                TargetedWriteBatch* batch = inFlight.batch;
 
-                        TrackedErrors trackedErrors;
-                        trackedErrors.startTracking( ErrorCodes::StaleShardVersion );
+                _stats->noteBatchLatency( shardHost,
+                                          inFlight.sentMicros - targetedMicros,
+                                          recvMicros - inFlight.sentMicros );
 
-                        LOG( 4 ) << "write results received from " << shardHost.toString() << ": "
-                                 << response.toString() << endl;
+                if ( dispatchStatus.isOK() ) {
 
-                        // Dispatch was ok, note response
-                        batchOp.noteBatchResponse( *batch, response, &trackedErrors );
+                    TrackedErrors trackedErrors;
+                    trackedErrors.startTracking( ErrorCodes::StaleShardVersion );
 
-                        // Note if anything was stale
-                        const vector<ShardError*>& staleErrors =
-                            trackedErrors.getErrors( ErrorCodes::StaleShardVersion );
+                    LOG( 4 ) << "write results received from " << shardHost.toString() << ": "
+                             << response.toString() << endl;
 
-                        if ( staleErrors.size() > 0 ) {
-                            noteStaleResponses( staleErrors, _targeter );
-                            ++_stats->numStaleBatches;
-                        }
+                    // Dispatch was ok, note response
+                    batchOp.noteBatchResponse( *batch, response, &trackedErrors );
 
-                        // Remember if the shard is actively changing metadata right now
-                        if ( isShardMetadataChanging( staleErrors ) ) {
-                            remoteMetadataChanging = true;
-                        }
+                    // Note if anything was stale
+                    const vector<ShardError*>& staleErrors =
+                        trackedErrors.getErrors( ErrorCodes::StaleShardVersion );
 
-                        // Remember that we successfully wrote to this shard
-                        // NOTE: This will record lastOps for shards where we actually didn't update
-                        // or delete any documents, which preserves old behavior but is conservative
-                        _stats->noteWriteAt( shardHost,
-                                             response.isLastOpSet() ? 
-                                             response.getLastOp() : OpTime(),
-                                             response.isElectionIdSet() ?
-                                             response.getElectionId() : OID());
+                    if ( staleErrors.size() > 0 ) {
+                        noteStaleResponses( staleErrors, _targeter );
+                        ++_stats->numStaleBatches;
                     }
-                    else {
 
-                        // Error occurred dispatching, note it
+                    // Remember if the shard is actively changing metadata right now
+                    if ( isShardMetadataChanging( staleErrors ) ) {
+                        remoteMetadataChanging = true;
+                    }
 
-                        stringstream msg;
-                        msg << "write results unavailable from " << shardHost.toString()
-                            << causedBy( dispatchStatus.toString() );
+                    // Remember that we successfully wrote to this shard
+                    // NOTE: This will record lastOps for shards where we actually didn't update
+                    // or delete any documents, which preserves old behavior but is conservative
+                    _stats->noteWriteAt( shardHost,
+                                         response.isLastOpSet() ? 
+                                         response.getLastOp() : OpTime(),
+                                         response.isElectionIdSet() ?
+                                         response.getElectionId() : OID());
+                }
+                else {
 
-                        WriteErrorDetail error;
-                        buildErrorFrom( Status( ErrorCodes::RemoteResultsUnavailable, msg.str() ),
-                                        &error );
+                    // Error occurred dispatching, note it
 
-                        LOG( 4 ) << "unable to receive write results from " << shardHost.toString()
-                                 << causedBy( dispatchStatus.toString() ) << endl;
+                    stringstream msg;
+                    msg << "write results unavailable from " << shardHost.toString()
+                        << causedBy( dispatchStatus.toString() );
 
-                        batchOp.noteBatchError( *batch, error );
-                    }
+                    WriteErrorDetail error;
+                    buildErrorFrom( Status( ErrorCodes::RemoteResultsUnavailable, msg.str() ),
+                                    &error );
+
+                    LOG( 4 ) << "unable to receive write results from " << shardHost.toString()
+                             << causedBy( dispatchStatus.toString() ) << endl;
+
+                    batchOp.noteBatchError( *batch, error );
+                }
+
+                // Keep the host busy with its next queued batch, if any
+                if ( dispatchQueuedBatches( clientRequest,
+                                            batchOp,
+                                            shardHost,
+                                            maxInFlightPerHost,
+                                            &hostQueue,
+                                            _dispatcher ) > 0 ) {
+                    _dispatcher->sendAll();
                 }
             }
 
@@ -388,4 +430,18 @@ namespace mongo {
     const HostOpTimeMap& BatchWriteExecStats::getWriteOpTimes() const {
         return _writeOpTimes;
     }
+
+    void BatchWriteExecStats::noteBatchLatency( const ConnectionString& host,
+                                                long long queueMicros,
+                                                long long roundTripMicros ) {
+        HostBatchLatency& latency = _hostLatencies[host];
+        ++latency.numBatches;
+        latency.totalQueueMicros += queueMicros;
+        latency.totalRoundTripMicros += roundTripMicros;
+        latency.maxRoundTripMicros = std::max( latency.maxRoundTripMicros, roundTripMicros );
+    }
+
+    const HostLatencyMap& BatchWriteExecStats::getHostLatencies() const {
+        return _hostLatencies;
+    }
 }
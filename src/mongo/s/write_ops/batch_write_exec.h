@@ -105,6 +105,26 @@ namespace mongo {
 
     typedef std::map<ConnectionString, HostOpTime> HostOpTimeMap;
 
+    /**
+     * Latency of the child batches sent to a single host while executing a client batch.
+     */
+    struct HostBatchLatency {
+        HostBatchLatency() :
+            numBatches( 0 ), totalQueueMicros( 0 ), totalRoundTripMicros( 0 ),
+            maxRoundTripMicros( 0 ) {
+        }
+
+        // Number of child batches answered by the host
+        int numBatches;
+        // Time batches spent targeted but waiting for an in-flight slot to the host
+        long long totalQueueMicros;
+        // Time from sending a batch to receiving its response
+        long long totalRoundTripMicros;
+        long long maxRoundTripMicros;
+    };
+
+    typedef std::map<ConnectionString, HostBatchLatency> HostLatencyMap;
+
     class BatchWriteExecStats {
     public:
 
@@ -116,6 +136,12 @@ namespace mongo {
 
         const HostOpTimeMap& getWriteOpTimes() const;
 
+        void noteBatchLatency( const ConnectionString& host,
+                               long long queueMicros,
+                               long long roundTripMicros );
+
+        const HostLatencyMap& getHostLatencies() const;
+
         // Expose via helpers if this gets more complex
 
         // Number of round trips required for the batch
@@ -130,5 +156,6 @@ namespace mongo {
     private:
 
         HostOpTimeMap _writeOpTimes;
+        HostLatencyMap _hostLatencies;
     };
 }
@@ -146,6 +146,39 @@ namespace {
         ASSERT_EQUALS( stats.numRounds, 1 );
     }
 
+    TEST(BatchWriteExecTests, ManyOpsPipelined) {
+
+        //
+        // Unordered writes needing several child batches to one host are all sent in a single
+        // round, with latency recorded for each batch
+        //
+
+        NamespaceString nss( "foo.bar" );
+
+        MockSingleShardBackend backend( nss );
+
+        BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+        request.setNS( nss.ns() );
+        request.setOrdered( false );
+        request.setWriteConcern( BSONObj() );
+        for ( size_t i = 0; i < 2 * BatchedCommandRequest::kMaxWriteBatchSize + 500u; ++i ) {
+            request.getInsertRequest()->addToDocuments( BSON( "x" << static_cast<int>( i ) ) );
+        }
+
+        BatchedCommandResponse response;
+        backend.exec->executeBatch( request, &response );
+        ASSERT( response.getOk() );
+
+        const BatchWriteExecStats& stats = backend.exec->getStats();
+        ASSERT_EQUALS( stats.numRounds, 1 );
+
+        const HostLatencyMap& latencies = stats.getHostLatencies();
+        ASSERT_EQUALS( latencies.size(), 1u );
+        ASSERT_EQUALS( latencies.begin()->first.toString(), backend.shardHost.toString() );
+        ASSERT_EQUALS( latencies.begin()->second.numBatches, 3 );
+        ASSERT_GREATER_THAN_OR_EQUALS( latencies.begin()->second.maxRoundTripMicros, 0 );
+    }
+
     //
     // Test retryable errors
     //
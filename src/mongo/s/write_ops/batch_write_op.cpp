@@ -175,6 +175,22 @@ namespace mongo {
         }
     }
 
+    // Helper to determine whether adding a write would push a single batch over the limits
+    static bool wouldMakeBatchTooBig(const BatchSize& batchSize, int writeSizeBytes) {
+
+        if (batchSize.numOps >= static_cast<int>(BatchedCommandRequest::kMaxWriteBatchSize)) {
+            // Too many items in batch
+            return true;
+        }
+
+        if (batchSize.sizeBytes + writeSizeBytes > BSONObjMaxUserSize) {
+            // Batch would be too big
+            return true;
+        }
+
+        return false;
+    }
+
     // Helper to determine whether a number of targeted writes require a new targeted batch
     static bool wouldMakeBatchesTooBig(const vector<TargetedWrite*>& writes,
                                        int writeSizeBytes,
@@ -190,45 +206,72 @@ namespace mongo {
                 continue;
             }
 
-            const BatchSize& batchSize = seenIt->second;
-
-            if (batchSize.numOps >= static_cast<int>(BatchedCommandRequest::kMaxWriteBatchSize)) {
-                // Too many items in batch
+            if (wouldMakeBatchTooBig(seenIt->second, writeSizeBytes)) {
                 return true;
             }
+        }
 
-            if (batchSize.sizeBytes + writeSizeBytes > BSONObjMaxUserSize) {
-                // Batch would be too big
-                return true;
+        return false;
+    }
+
+    // Helper to move batches which can't take a write any more out of the map, so that new
+    // batches are started for their endpoints.  The full batches are complete and can be sent.
+    static void closeFullBatches(const vector<TargetedWrite*>& writes,
+                                 int writeSizeBytes,
+                                 TargetedBatchMap* batchMap,
+                                 TargetedBatchSizeMap* batchSizes,
+                                 vector<TargetedWriteBatch*>* closedBatches) {
+
+        for (vector<TargetedWrite*>::const_iterator it = writes.begin(); it != writes.end(); ++it) {
+
+            const TargetedWrite* write = *it;
+            TargetedBatchSizeMap::iterator seenIt = batchSizes->find(&write->endpoint);
+
+            if (seenIt == batchSizes->end() || !wouldMakeBatchTooBig(seenIt->second,
+                                                                     writeSizeBytes)) {
+                continue;
             }
+
+            // Erase the map entries before the batch leaves, since the keys point into it
+            TargetedBatchMap::iterator batchIt = batchMap->find(&write->endpoint);
+            TargetedWriteBatch* batch = batchIt->second;
+            batchSizes->erase(seenIt);
+            batchMap->erase(batchIt);
+            closedBatches->push_back(batch);
         }
+    }
 
-        return false;
+    // Helper function to cancel all the write ops of a targeted batch
+    static void cancelBatchWrites( const WriteErrorDetail& why,
+                                   WriteOp* writeOps,
+                                   const TargetedWriteBatch& batch ) {
+
+        const vector<TargetedWrite*>& writes = batch.getWrites();
+
+        for ( vector<TargetedWrite*>::const_iterator writeIt = writes.begin();
+            writeIt != writes.end(); ++writeIt ) {
+
+            TargetedWrite* write = *writeIt;
+
+            // NOTE: We may repeatedly cancel a write op here, but that's fast and we want to
+            // cancel before erasing the TargetedWrite* (which owns the cancelled targeting
+            // info) for reporting reasons.
+            writeOps[write->writeOpRef.first].cancelWrites( &why );
+        }
     }
 
-    // Helper function to cancel all the write ops of targeted batches in a map
+    // Helper function to cancel all the write ops of targeted batches in a map, along with any
+    // batches which were already closed
     static void cancelBatches( const WriteErrorDetail& why,
                                WriteOp* writeOps,
-                               TargetedBatchMap* batchMap ) {
-
-        set<WriteOp*> targetedWriteOps;
+                               TargetedBatchMap* batchMap,
+                               vector<TargetedWriteBatch*>* closedBatches ) {
 
         // Collect all the writeOps that are currently targeted
         for ( TargetedBatchMap::iterator it = batchMap->begin(); it != batchMap->end(); ) {
 
             TargetedWriteBatch* batch = it->second;
-            const vector<TargetedWrite*>& writes = batch->getWrites();
-
-            for ( vector<TargetedWrite*>::const_iterator writeIt = writes.begin();
-                writeIt != writes.end(); ++writeIt ) {
-
-                TargetedWrite* write = *writeIt;
-
-                // NOTE: We may repeatedly cancel a write op here, but that's fast and we want to
-                // cancel before erasing the TargetedWrite* (which owns the cancelled targeting
-                // info) for reporting reasons.
-                writeOps[write->writeOpRef.first].cancelWrites( &why );
-            }
+            cancelBatchWrites( why, writeOps, *batch );
 
             // Note that we need to *erase* first, *then* delete, since the map keys are ptrs from
             // the values
@@ -236,6 +279,13 @@ namespace mongo {
             delete batch;
         }
         batchMap->clear();
+
+        for ( vector<TargetedWriteBatch*>::iterator it = closedBatches->begin();
+            it != closedBatches->end(); ++it ) {
+            cancelBatchWrites( why, writeOps, **it );
+            delete *it;
+        }
+        closedBatches->clear();
     }
 
     Status BatchWriteOp::targetBatch( const NSTargeter& targeter,
@@ -245,7 +295,8 @@ namespace mongo {
         //
         // Targeting of unordered batches is fairly simple - each remaining write op is targeted,
         // and each of those targeted writes are grouped into a batch for a particular shard
-        // endpoint.
+        // endpoint.  When a batch for an endpoint fills up, it is closed and a new one started,
+        // so that all the remaining writes are targeted at once and can be pipelined per host.
         //
         // Targeting of ordered batches is a bit more complex - to respect the ordering of the
         // batch, we can only send:
@@ -279,6 +330,8 @@ namespace mongo {
 
         TargetedBatchMap batchMap;
         TargetedBatchSizeMap batchSizes;
+        // Full unordered batches which no longer accept writes
+        vector<TargetedWriteBatch*> closedBatches;
 
         int numTargetErrors = 0;
 
@@ -309,7 +362,7 @@ namespace mongo {
 
                     // Cancel current batch state with an error
 
-                    cancelBatches( targetError, _writeOps, &batchMap );
+                    cancelBatches( targetError, _writeOps, &batchMap, &closedBatches );
                     dassert( batchMap.empty() );
                     return targetStatus;
                 }
@@ -358,8 +411,13 @@ namespace mongo {
             int writeSizeBytes = getWriteSizeBytes(writeOp);
             if (wouldMakeBatchesTooBig(writes, writeSizeBytes, batchSizes)) {
                 invariant(!batchMap.empty());
-                writeOp.cancelWrites(NULL);
-                break;
+
+                if (ordered) {
+                    writeOp.cancelWrites(NULL);
+                    break;
+                }
+
+                closeFullBatches(writes, writeSizeBytes, &batchMap, &batchSizes, &closedBatches);
             }
 
             //
@@ -406,8 +464,13 @@ namespace mongo {
         //
 
         for ( TargetedBatchMap::iterator it = batchMap.begin(); it != batchMap.end(); ++it ) {
+            closedBatches.push_back( it->second );
+        }
 
-            TargetedWriteBatch* batch = it->second;
+        for ( vector<TargetedWriteBatch*>::iterator it = closedBatches.begin();
+            it != closedBatches.end(); ++it ) {
+
+            TargetedWriteBatch* batch = *it;
 
             if ( batch->getWrites().empty() )
                 continue;
@@ -1761,6 +1761,47 @@ namespace {
         ASSERT(batchOp.isFinished());
     }
 
+    TEST(WriteOpLimitTests, TooManyOpsUnordered) {
+
+        //
+        // Unordered batch of 1002 documents - the full batch is closed off and a second one
+        // started, so everything is targeted at once
+        //
+
+        NamespaceString nss("foo.bar");
+        ShardEndpoint endpoint("shard", ChunkVersion::IGNORED());
+        MockNSTargeter targeter;
+        initTargeterFullRange(nss, endpoint, &targeter);
+
+        BatchedCommandRequest request(BatchedCommandRequest::BatchType_Delete);
+        request.setNS(nss.ns());
+        request.setOrdered(false);
+
+        // Add 2 more than the maximum to the batch
+        for (size_t i = 0; i < BatchedCommandRequest::kMaxWriteBatchSize + 2u; ++i) {
+            request.getDeleteRequest()->addToDeletes(buildDelete(BSON( "x" << 2 ), 0));
+        }
+
+        BatchWriteOp batchOp;
+        batchOp.initClientRequest(&request);
+
+        OwnedPointerVector<TargetedWriteBatch> targetedOwned;
+        vector<TargetedWriteBatch*>& targeted = targetedOwned.mutableVector();
+        Status status = batchOp.targetBatch(targeter, false, &targeted);
+        ASSERT(status.isOK());
+        ASSERT_EQUALS(targeted.size(), 2u);
+        ASSERT_EQUALS(targeted[0]->getWrites().size(), 1000u);
+        ASSERT_EQUALS(targeted[1]->getWrites().size(), 2u);
+
+        BatchedCommandResponse response;
+        buildResponse(1, &response);
+
+        batchOp.noteBatchResponse(*targeted[0], response, NULL);
+        ASSERT(!batchOp.isFinished());
+        batchOp.noteBatchResponse(*targeted[1], response, NULL);
+        ASSERT(batchOp.isFinished());
+    }
+
     TEST(WriteOpLimitTests, UpdateOverheadIncluded) {
 
         //
@@ -41,10 +41,13 @@
 #include "mongo/util/file.h"
 #include "mongo/util/log.h"
 #include "mongo/util/text.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
     long long Scope::_lastVersion = 1;
 
+    FunctionCacheStats functionCacheStats;
+
 namespace {
     // 2 GB is the largest support Javascript file size.
     const fileofs kMaxJsFileLength = fileofs(2) * 1024 * 1024 * 1024;
@@ -58,6 +61,7 @@ namespace {
 
     Scope::Scope() : _localDBName(""),
                      _loadedVersion(0),
+                     _lastFunctionNumber(0),
                      _numTimesUsed(0),
                      _lastRetIsNativeCode(false) {
     }
@@ -247,16 +251,58 @@ namespace {
             }
         }
 
-        FunctionCacheMap::iterator i = _cachedFunctions.find(code);
-        if (i != _cachedFunctions.end())
-            return i->second;
+        ScriptingFunction func = _cachedFunctions.find(code);
+        if (func) {
+            functionCacheStats.hits.increment();
+            return func;
+        }
+        functionCacheStats.misses.increment();
+
         // NB: we calculate the function number for v8 so the cache can be utilized to
         //     lookup the source on an exception, but SpiderMonkey uses the value
-        //     returned by JS_CompileFunction.
-        ScriptingFunction defaultFunctionNumber = getFunctionCache().size() + 1;
-        ScriptingFunction& actualFunctionNumber = _cachedFunctions[code];
-        actualFunctionNumber = _createFunction(code, defaultFunctionNumber);
-        return actualFunctionNumber;
+        //     returned by JS_CompileFunction.  Numbers are never reused, as evicted
+        //     functions leave gaps.
+        Timer t;
+        func = _createFunction(code, ++_lastFunctionNumber);
+        functionCacheStats.compileMicros.increment(t.micros());
+
+        ScriptingFunction evicted = _cachedFunctions.insert(code, func);
+        if (evicted) {
+            functionCacheStats.evictions.increment();
+            _releaseFunction(evicted);
+        }
+        return func;
+    }
+
+    ScriptingFunction FunctionCache::find(const StringData& code) {
+        Index::iterator i = _index.find(code);
+        if (i == _index.end())
+            return 0;
+
+        // move to the front of the recency list
+        _entries.splice(_entries.begin(), _entries, i->second);
+        return i->second->second;
+    }
+
+    ScriptingFunction FunctionCache::insert(const StringData& code, ScriptingFunction func) {
+        ScriptingFunction evicted = 0;
+        if (_index.size() >= kMaxSize) {
+            evicted = _entries.back().second;
+            _index.erase(StringData(_entries.back().first));
+            _entries.pop_back();
+        }
+
+        _entries.push_front(std::make_pair(code.toString(), func));
+        _index[StringData(_entries.front().first)] = _entries.begin();
+        return evicted;
+    }
+
+    std::string FunctionCache::getSource(ScriptingFunction func) const {
+        for (Entries::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            if (it->second == func)
+                return it->first;
+        }
+        return "";
     }
 
     namespace JSFiles {
@@ -416,12 +462,14 @@ namespace {
         }
 
     protected:
-        FunctionCacheMap& getFunctionCache() { return _real->getFunctionCache(); }
+        FunctionCache& getFunctionCache() { return _real->getFunctionCache(); }
 
         ScriptingFunction _createFunction(const char* code, ScriptingFunction functionNumber = 0) {
             return _real->_createFunction(code, functionNumber);
         }
 
+        void _releaseFunction(ScriptingFunction func) { _real->_releaseFunction(func); }
+
     private:
         string _pool;
         boost::shared_ptr<Scope> _real;
@@ -29,13 +29,65 @@
 
 #pragma once
 
+#include <list>
+
+#include "mongo/base/counter.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
     typedef unsigned long long ScriptingFunction;
     typedef BSONObj (*NativeFunction)(const BSONObj& args, void* data);
-    typedef std::map<std::string, ScriptingFunction> FunctionCacheMap;
+
+    /**
+     * The compiled functions of a Scope, looked up by a hash of their source.  Once kMaxSize
+     * functions are cached, the least recently used one is evicted for each new function.
+     */
+    class FunctionCache {
+        MONGO_DISALLOW_COPYING(FunctionCache);
+    public:
+        static const size_t kMaxSize = 1000;
+
+        FunctionCache() {}
+
+        /**
+         * @return the function compiled from 'code', or 0 if it isn't cached
+         */
+        ScriptingFunction find(const StringData& code);
+
+        /**
+         * Caches 'func' as the function compiled from 'code', which must not be cached yet.
+         * @return the function evicted to make room, or 0 if nothing was evicted
+         */
+        ScriptingFunction insert(const StringData& code, ScriptingFunction func);
+
+        /**
+         * @return the source 'func' was compiled from, or an empty string if it isn't cached
+         */
+        std::string getSource(ScriptingFunction func) const;
+
+        size_t size() const { return _index.size(); }
+
+    private:
+        typedef std::list<std::pair<std::string, ScriptingFunction> > Entries;
+        typedef unordered_map<StringData, Entries::iterator, StringData::Hasher> Index;
+
+        Entries _entries; // most recently used first
+        Index _index; // keys refer to the source strings in _entries
+    };
+
+    /**
+     * Function cache statistics across all scopes in the process.
+     */
+    struct FunctionCacheStats {
+        Counter64 hits;
+        Counter64 misses;
+        Counter64 evictions;
+        Counter64 compileMicros; // time spent compiling on misses
+    };
+
+    extern FunctionCacheStats functionCacheStats;
 
     class DBClientWithCommands;
     class DBClientBase;
@@ -175,15 +227,22 @@ namespace mongo {
 
     protected:
         friend class PooledScope;
-        virtual FunctionCacheMap& getFunctionCache() { return _cachedFunctions; }
+        virtual FunctionCache& getFunctionCache() { return _cachedFunctions; }
         virtual ScriptingFunction _createFunction(const char* code,
                                                   ScriptingFunction functionNumber = 0) = 0;
 
+        /**
+         * Called when a function is evicted from the function cache.  Engines may free it, so
+         * it must not be invoked afterwards.
+         */
+        virtual void _releaseFunction(ScriptingFunction func) {}
+
         std::string _localDBName;
         long long _loadedVersion;
         std::set<std::string> _storedNames;
         static long long _lastVersion;
-        FunctionCacheMap _cachedFunctions;
+        FunctionCache _cachedFunctions;
+        ScriptingFunction _lastFunctionNumber;
         int _numTimesUsed;
         bool _lastRetIsNativeCode; // v8 only: set to true if eval'd script returns a native func
     };
@@ -594,6 +594,11 @@ namespace mongo {
 
     V8Scope::~V8Scope() {
         unregisterOpId();
+        {
+            v8::Locker l(_isolate);
+            v8::Isolate::Scope iscope(_isolate);
+            _funcs.clear();
+        }
     }
 
     bool V8Scope::hasOutOfMemoryException() {
@@ -949,14 +954,7 @@ namespace mongo {
             // find the source script based on the resource name supplied to v8::Script::Compile().
             // this is accomplished by converting the integer after the '_funcs' prefix.
             unsigned int funcNum = str::toUnsigned(resourceNameString.substr(6));
-            for (map<string, ScriptingFunction>::iterator it = getFunctionCache().begin();
-                 it != getFunctionCache().end();
-                 ++it) {
-                if (it->second == funcNum) {
-                    code = it->first;
-                    break;
-                }
-            }
+            code = getFunctionCache().getSource(funcNum);
             if (!code.empty()) {
                 // append surrounding code (padded with up to 20 characters on each side)
                 int startPos = message->GetStartPosition();
@@ -1057,16 +1055,27 @@ namespace mongo {
     ScriptingFunction V8Scope::_createFunction(const char* raw, ScriptingFunction functionNumber) {
         V8_SIMPLE_HEADER
         v8::Local<v8::Value> ret = __createFunction(raw, functionNumber);
-        v8::Eternal<v8::Value> f(_isolate, ret);
         uassert(10232, "not a function", ret->IsFunction());
-        _funcs.push_back(f);
+        _funcs[functionNumber].Reset(_isolate, ret);
         return functionNumber;
     }
 
+    void V8Scope::_releaseFunction(ScriptingFunction func) {
+        V8_SIMPLE_HEADER
+        // the function is also referenced by the global it was compiled into
+        string fn = str::stream() << "_funcs" << func;
+        getGlobal()->ForceDelete(v8StringData(fn));
+        FunctionMap::iterator it = _funcs.find(func);
+        if (it == _funcs.end())
+            return;
+        it->second.Reset();
+        _funcs.erase(it);
+    }
+
     void V8Scope::setFunction(const char* field, const char* code) {
         V8_SIMPLE_HEADER
         getGlobal()->ForceSet(v8StringData(field),
-                          __createFunction(code, getFunctionCache().size() + 1));
+                          __createFunction(code, ++_lastFunctionNumber));
     }
 
     void V8Scope::rename(const char * from, const char * to) {
@@ -1081,7 +1090,9 @@ namespace mongo {
     int V8Scope::invoke(ScriptingFunction func, const BSONObj* argsObject, const BSONObj* recv,
                         int timeoutMs, bool ignoreReturn, bool readOnlyArgs, bool readOnlyRecv) {
         V8_SIMPLE_HEADER
-        v8::Local<v8::Value> funcValue = _funcs[func-1].Get(_isolate);
+        FunctionMap::const_iterator funcIt = _funcs.find(func);
+        uassert(18911, "function is no longer cached", funcIt != _funcs.end());
+        v8::Local<v8::Value> funcValue = v8::Local<v8::Value>::New(_isolate, funcIt->second);
         v8::TryCatch try_catch;
         v8::Local<v8::Value> result;
 
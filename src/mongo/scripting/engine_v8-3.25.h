@@ -246,6 +246,7 @@ namespace mongo {
                                                         v8Function func,
                                                         v8::Local<v8::ObjectTemplate>& proto);
         v8::Local<v8::FunctionTemplate> createV8Function(v8Function func);
+        virtual void _releaseFunction(ScriptingFunction func);
         virtual ScriptingFunction _createFunction(const char* code,
                                                   ScriptingFunction functionNumber = 0);
         v8::Local<v8::Function> __createFunction(const char* code,
@@ -455,7 +456,11 @@ namespace mongo {
         v8::Eternal<v8::Context> _context;
         v8::Eternal<v8::Object> _global;
         string _error;
-        std::vector<v8::Eternal<v8::Value> > _funcs;
+        // compiled functions by number; numbers are never reused, so evicted ones are erased.
+        // Emptied by ~V8Scope, the handles can't be reset once the isolate is gone.
+        typedef v8::Persistent<v8::Value, v8::CopyablePersistentTraits<v8::Value> > FunctionHandle;
+        typedef unordered_map<ScriptingFunction, FunctionHandle> FunctionMap;
+        FunctionMap _funcs;
 
         enum ConnectState { NOT, LOCAL, EXTERNAL };
         ConnectState _connectState;
@@ -78,12 +78,27 @@ namespace mongo {
         return holder ? holder->_obj : BSONObj();
     }
 
-    static v8::Handle<v8::Object> unwrapObject(V8Scope* scope, const v8::Handle<v8::Object>& obj) {
+    /**
+     * Returns the plain object holding the values that were read from or written to a wrapped
+     * BSON object.  It is only created when first needed, so a document whose fields are just
+     * read once never allocates it; pass create=false to get an empty handle in that case.
+     */
+    static v8::Handle<v8::Object> unwrapObject(V8Scope* scope,
+                                               const v8::Handle<v8::Object>& obj,
+                                               bool create = true) {
         // Warning: can't throw exceptions in this context.
         if (!scope->LazyBsonFT()->HasInstance(obj))
             return v8::Handle<v8::Object>();
 
-        return obj->GetInternalField(1).As<v8::Object>();
+        v8::Handle<v8::Value> realObject = obj->GetInternalField(1);
+        if (realObject->IsObject())
+            return realObject.As<v8::Object>();
+        if (!create)
+            return v8::Handle<v8::Object>();
+
+        v8::Handle<v8::Object> newObject = v8::Object::New();
+        obj->SetInternalField(1, newObject);
+        return newObject;
     }
 
     void V8Scope::wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly) {
@@ -94,7 +109,7 @@ namespace mongo {
         holder->_readOnly = readOnly;
         holder->_scope = this;
         obj->SetInternalField(0, v8::External::New(holder)); // Holder
-        obj->SetInternalField(1, v8::Object::New()); // Object
+        obj->SetInternalField(1, v8::Undefined()); // Object, see unwrapObject()
         v8::Persistent<v8::Object> p = v8::Persistent<v8::Object>::New(obj);
         bsonHolderTracker.track(p, holder);
     }
@@ -105,20 +120,20 @@ namespace mongo {
         v8::Handle<v8::Value> val;
         try {
             V8Scope* scope = getScope(info.GetIsolate());
-            v8::Handle<v8::Object> realObject = unwrapObject(scope, info.Holder());
-            if (realObject.IsEmpty()) return v8::Handle<v8::Value>();
-            if (realObject->HasOwnProperty(name)) {
+            BSONHolder* holder = unwrapHolder(scope, info.Holder());
+            if (!holder) return v8::Handle<v8::Value>();
+            v8::Handle<v8::Object> realObject = unwrapObject(scope, info.Holder(), false);
+            if (!realObject.IsEmpty() && realObject->HasOwnProperty(name)) {
                 // value already cached or added
                 return handle_scope.Close(realObject->Get(name));
             }
 
-            string key = toSTLString(name);
-            BSONHolder* holder = unwrapHolder(scope, info.Holder());
-            if (!holder || holder->_removed.count(key))
+            V8String key(name);
+            if (holder->isRemoved(key))
                 return handle_scope.Close(v8::Handle<v8::Value>());
 
-            BSONObj obj = holder->_obj;
-            BSONElement elmt = obj.getField(key.c_str());
+            const BSONObj& obj = holder->_obj;
+            BSONElement elmt = obj.getField(key);
             if (elmt.eoo())
                 return handle_scope.Close(v8::Handle<v8::Value>());
 
@@ -126,7 +141,7 @@ namespace mongo {
 
             if (obj.objsize() > 128 || val->IsObject()) {
                 // Only cache if expected to help (large BSON) or is required due to js semantics
-                realObject->Set(name, val);
+                unwrapObject(scope, info.Holder())->Set(name, val);
             }
 
             if (elmt.type() == mongo::Object || elmt.type() == mongo::Array) {
@@ -179,7 +194,7 @@ namespace mongo {
         for (BSONObjIterator it(obj); it.more();) {
             const BSONElement& f = it.next();
             StringData sname (f.fieldName(), f.fieldNameSize()-1);
-            if (holder->_removed.count(sname.toString()))
+            if (holder->isRemoved(sname))
                 continue;
 
             v8::Handle<v8::String> name = scope->v8StringData(sname);
@@ -188,8 +203,8 @@ namespace mongo {
         }
 
 
-        v8::Handle<v8::Object> realObject = unwrapObject(scope, info.Holder());
-        if (realObject.IsEmpty()) return v8::Handle<v8::Array>();
+        v8::Handle<v8::Object> realObject = unwrapObject(scope, info.Holder(), false);
+        if (realObject.IsEmpty()) return handle_scope.Close(out);
         v8::Handle<v8::Array> fields = realObject->GetOwnPropertyNames();
         const int len = fields->Length();
         for (int field=0; field < len; field++) {
@@ -222,25 +237,23 @@ namespace mongo {
         v8::Handle<v8::Value> val;
         try {
             V8Scope* scope = getScope(info.GetIsolate());
-            v8::Handle<v8::Object> realObject = unwrapObject(scope, info.Holder());
-            if (realObject.IsEmpty()) return v8::Handle<v8::Value>();
-            if (realObject->Has(index)) {
+            BSONHolder* holder = unwrapHolder(scope, info.Holder());
+            if (!holder) return v8::Handle<v8::Value>();
+            v8::Handle<v8::Object> realObject = unwrapObject(scope, info.Holder(), false);
+            if (!realObject.IsEmpty() && realObject->Has(index)) {
                 // value already cached or added
                 return handle_scope.Close(realObject->Get(index));
             }
             string key = str::stream() << index;
-
-            BSONHolder* holder = unwrapHolder(scope, info.Holder());
-            if (!holder) return v8::Handle<v8::Value>();
-            if (holder->_removed.count(key))
+            if (holder->isRemoved(key))
                 return handle_scope.Close(v8::Handle<v8::Value>());
 
-            BSONObj obj = holder->_obj;
+            const BSONObj& obj = holder->_obj;
             BSONElement elmt = obj.getField(key);
             if (elmt.eoo())
                 return handle_scope.Close(v8::Handle<v8::Value>());
             val = scope->mongoToV8Element(elmt, holder->_readOnly);
-            realObject->Set(index, val);
+            unwrapObject(scope, info.Holder())->Set(index, val);
 
             if (elmt.type() == mongo::Object || elmt.type() == mongo::Array) {
                 // if accessing a subobject, it may get modified and base obj would not know
@@ -885,14 +898,7 @@ namespace mongo {
             // find the source script based on the resource name supplied to v8::Script::Compile().
             // this is accomplished by converting the integer after the '_funcs' prefix.
             unsigned int funcNum = str::toUnsigned(resourceNameString.substr(6));
-            for (map<string, ScriptingFunction>::iterator it = getFunctionCache().begin();
-                 it != getFunctionCache().end();
-                 ++it) {
-                if (it->second == funcNum) {
-                    code = it->first;
-                    break;
-                }
-            }
+            code = getFunctionCache().getSource(funcNum);
             if (!code.empty()) {
                 // append surrounding code (padded with up to 20 characters on each side)
                 int startPos = message->GetStartPosition();
@@ -995,14 +1001,26 @@ namespace mongo {
         v8::Local<v8::Value> ret = __createFunction(raw, functionNumber);
         v8::Persistent<v8::Value> f = v8::Persistent<v8::Value>::New(ret);
         uassert(10232, "not a function", f->IsFunction());
-        _funcs.push_back(f);
+        _funcs[functionNumber] = f;
         return functionNumber;
     }
 
+    void V8Scope::_releaseFunction(ScriptingFunction func) {
+        V8_SIMPLE_HEADER
+        // the function is also referenced by the global it was compiled into
+        string fn = str::stream() << "_funcs" << func;
+        _global->ForceDelete(v8::String::New(fn.c_str()));
+        FunctionMap::iterator it = _funcs.find(func);
+        if (it == _funcs.end())
+            return;
+        it->second.Dispose();
+        _funcs.erase(it);
+    }
+
     void V8Scope::setFunction(const char* field, const char* code) {
         V8_SIMPLE_HEADER
         _global->ForceSet(v8StringData(field),
-                          __createFunction(code, getFunctionCache().size() + 1));
+                          __createFunction(code, ++_lastFunctionNumber));
     }
 
     void V8Scope::rename(const char * from, const char * to) {
@@ -1016,7 +1034,9 @@ namespace mongo {
     int V8Scope::invoke(ScriptingFunction func, const BSONObj* argsObject, const BSONObj* recv,
                         int timeoutMs, bool ignoreReturn, bool readOnlyArgs, bool readOnlyRecv) {
         V8_SIMPLE_HEADER
-        v8::Handle<v8::Value> funcValue = _funcs[func-1];
+        FunctionMap::const_iterator funcIt = _funcs.find(func);
+        uassert(18911, "function is no longer cached", funcIt != _funcs.end());
+        v8::Handle<v8::Value> funcValue = funcIt->second;
         v8::TryCatch try_catch;
         v8::Local<v8::Value> result;
 
@@ -240,6 +240,7 @@ namespace mongo {
                                                         v8Function func,
                                                         v8::Handle<v8::ObjectTemplate>& proto);
         v8::Handle<v8::FunctionTemplate> createV8Function(v8Function func);
+        virtual void _releaseFunction(ScriptingFunction func);
         virtual ScriptingFunction _createFunction(const char* code,
                                                   ScriptingFunction functionNumber = 0);
         v8::Local<v8::Function> __createFunction(const char* code,
@@ -437,7 +438,9 @@ namespace mongo {
         v8::Persistent<v8::Context> _context;
         v8::Persistent<v8::Object> _global;
         std::string _error;
-        std::vector<v8::Persistent<v8::Value> > _funcs;
+        // compiled functions by number; numbers are never reused, so evicted ones are erased
+        typedef unordered_map<ScriptingFunction, v8::Persistent<v8::Value> > FunctionMap;
+        FunctionMap _funcs;
 
         enum ConnectState { NOT, LOCAL, EXTERNAL };
         ConnectState _connectState;
@@ -560,6 +563,9 @@ namespace mongo {
                 // if v8 is still up, send hint to GC
                 v8::V8::AdjustAmountOfExternalAllocatedMemory(-_obj.objsize());
         }
+        bool isRemoved(const StringData& key) const {
+            return !_removed.empty() && _removed.count(key.toString());
+        }
         V8Scope* _scope;
         BSONObj _obj;
         bool _modified;
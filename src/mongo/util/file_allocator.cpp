@@ -194,6 +194,14 @@ namespace mongo {
 #endif
 
 #if defined(__linux__)
+        // allocates the blocks as unwritten extents, so nothing is written and reads of the
+        // new file see zeroes.  unlike posix_fallocate, this never falls back to writing a byte
+        // per block when the filesystem can't do it, so we get to pick the fallback below.
+        if ( fallocate(fd, 0, 0, size) == 0 )
+            return;
+
+        LOG(1) << "FileAllocator: fallocate failed: " << errnoWithDescription() << endl;
+
         int ret = posix_fallocate(fd,0,size);
         if ( ret == 0 )
             return;
@@ -242,6 +250,16 @@ namespace mongo {
         }
     }
 
+    FileAllocator::Stats FileAllocator::getStats() const {
+        scoped_lock lk( _pendingMutex );
+        return _stats;
+    }
+
+    int FileAllocator::queueDepth() const {
+        scoped_lock lk( _pendingMutex );
+        return static_cast<int>( _pending.size() );
+    }
+
     bool FileAllocator::hasFailed() const {
         return _failed;
     }
@@ -357,11 +375,20 @@ namespace mongo {
                     }
                     flushMyDirectory(name);
 
+                    const long long micros = t.micros();
                     log() << "done allocating datafile " << name << ", "
                           << "size: " << size/1024/1024 << "MB, "
-                          << " took " << ((double)t.millis())/1000.0 << " secs"
+                          << " took " << ((double)micros)/1000000.0 << " secs"
                           << endl;
 
+                    {
+                        scoped_lock lk( fa->_pendingMutex );
+                        fa->_stats.allocations++;
+                        fa->_stats.totalMicros += micros;
+                        fa->_stats.lastMicros = micros;
+                        fa->_stats.maxMicros = std::max( fa->_stats.maxMicros, micros );
+                    }
+
                     // no longer in a failed state. allow new writers.
                     fa->_failed = false;
                 }
@@ -380,6 +407,7 @@ namespace mongo {
                     }
                     scoped_lock lk( fa->_pendingMutex );
                     fa->_failed = true;
+                    fa->_stats.failures++;
                     // not erasing from pending
                     fa->_pendingUpdated.notify_all();
                     
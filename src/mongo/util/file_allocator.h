@@ -70,6 +70,20 @@ namespace mongo {
 
         static void ensureLength(int fd, long size);
 
+        /** counters describing the allocations done so far */
+        struct Stats {
+            Stats() : allocations(0), failures(0), totalMicros(0), lastMicros(0), maxMicros(0) {}
+            long long allocations;
+            long long failures;
+            long long totalMicros;  // time spent allocating, excluding time queued
+            long long lastMicros;
+            long long maxMicros;
+        };
+        Stats getStats() const;
+
+        /** @return the number of files queued or being allocated */
+        int queueDepth() const;
+
         /** @return the singleton */
         static FileAllocator * get();
         
@@ -102,6 +116,7 @@ namespace mongo {
         static unsigned long long _uniqueNumber;
 
         bool _failed;
+        Stats _stats; // protected by _pendingMutex
 
         static FileAllocator* _instance;
 
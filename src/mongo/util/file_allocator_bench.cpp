@@ -88,6 +88,8 @@ class FileAllocatorBenchmark {
 public:
     FileAllocatorBenchmark(const BenchmarkParams& params)
         : _fa(FileAllocator::get())
+        , _pipelinedMicros(0)
+        , _maxQueueDepth(0)
         , _params(params) {
         _fa->start();
 
@@ -135,6 +137,8 @@ public:
 
         _fa->waitUntilFinished();
 
+        runPipelined();
+
         if (!_params.quiet) {
             textReport();
         }
@@ -145,6 +149,29 @@ public:
     }
 
 private:
+    /**
+     * Queue all files at once, the way the server preallocates data files ahead of need, and
+     * time how long the allocator takes to drain the queue.
+     */
+    void runPipelined() {
+        const ptime::ptime start = ptime::microsec_clock::universal_time();
+        for (int n = 0; n < _params.ntrials; ++n) {
+            const std::string fileName = str::stream() << "garbage-pipelined-" << n;
+            file::path filePath = _params.path / fileName;
+            _files.push_back(filePath);
+            long size = static_cast<long>(_params.bytes);
+            _fa->requestAllocation(filePath.string(), size);
+        }
+        _maxQueueDepth = _fa->queueDepth();
+        _fa->waitUntilFinished();
+        const ptime::ptime end = ptime::microsec_clock::universal_time();
+        _pipelinedMicros = (end - start).total_microseconds();
+
+        if (_fa->hasFailed()) {
+            std::cerr << "Pipelined allocation failed" << std::endl;
+        }
+    }
+
     struct benchResults {
         micros_t avg;
         micros_t max;
@@ -175,6 +202,10 @@ private:
         printResult("avg", results.avg, _params.bytes);
         printResult("max", results.max, _params.bytes);
         printResult("min", results.min, _params.bytes);
+
+        std::cout << "Pipelined allocation of " << _params.ntrials << " files (queue depth "
+                  << _maxQueueDepth << "): " << std::endl;
+        printResult("total", _pipelinedMicros, _params.bytes * _params.ntrials);
     }
 
     void addResult(BSONObjBuilder& obj, const std::string& name,
@@ -194,6 +225,13 @@ private:
         addResult(obj, "max", results.max, _params.bytes);
         addResult(obj, "min", results.min, _params.bytes);
 
+        {
+            BSONObjBuilder pipelined(obj.subobjStart("pipelined"));
+            pipelined.append("queueDepth", _maxQueueDepth);
+            addResult(pipelined, "total", _pipelinedMicros, _params.bytes * _params.ntrials);
+            pipelined.done();
+        }
+
         obj.append("raw", _results);
 
         const std::string outStr = obj.done().toString();
@@ -213,6 +251,8 @@ private:
 
     FileAllocator* const _fa;
     std::vector<micros_t> _results;
+    micros_t _pipelinedMicros;
+    int _maxQueueDepth;
     std::vector<file::path> _files;
 
     const BenchmarkParams& _params;
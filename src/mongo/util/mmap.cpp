@@ -202,6 +202,89 @@ namespace {
         return thingsToFlush.size();
     }
 
+    /*static*/ unsigned long long MongoFile::trickleFlushAll( unsigned long long maxBytes ) {
+        // as in _flushAll(), claim the ranges of every file under the lock, and start their
+        // writeback without it so that a full device queue doesn't hold up opening and closing
+        // files
+        OwnedPointerVector<Flushable> thingsToFlushWrapper;
+        vector<Flushable*>& thingsToFlush = thingsToFlushWrapper.mutableVector();
+        unsigned long long claimed = 0;
+        {
+            LockMongoFilesShared lk;
+            for ( set<MongoFile*>::iterator i = mmfiles.begin();
+                  i != mmfiles.end() && claimed < maxBytes;
+                  i++ ) {
+                Flushable* f = (*i)->prepareTrickleFlush( maxBytes - claimed, &claimed );
+                if ( f )
+                    thingsToFlush.push_back( f );
+            }
+        }
+
+        for ( size_t i = 0; i < thingsToFlush.size(); i++ ) {
+            thingsToFlush[i]->flush();
+        }
+
+        return claimed;
+    }
+
+    void MemoryMappedFile::noteDirty( unsigned long long ofs, unsigned len ) {
+        if ( len == 0 )
+            return;
+        const size_t first = ofs / DirtyChunkSize;
+        const size_t last = ( ofs + len - 1 ) / DirtyChunkSize;
+
+        SimpleMutex::scoped_lock lk( _dirtyMutex );
+        if ( _dirtyChunks.empty() )
+            _dirtyChunks.resize( ( this->len + DirtyChunkSize - 1 ) / DirtyChunkSize );
+        dassert( last < _dirtyChunks.size() );
+        for ( size_t i = first; i <= last; i++ ) {
+            if ( !_dirtyChunks[i] ) {
+                _dirtyChunks[i] = true;
+                _numDirtyChunks++;
+            }
+        }
+    }
+
+    void MemoryMappedFile::clearDirty() {
+        SimpleMutex::scoped_lock lk( _dirtyMutex );
+        if ( _numDirtyChunks == 0 )
+            return;
+        _dirtyChunks.assign( _dirtyChunks.size(), false );
+        _numDirtyChunks = 0;
+    }
+
+    unsigned long long MemoryMappedFile::claimDirtyRanges( unsigned long long maxBytes,
+                                                           RangeVector* ranges ) {
+        unsigned long long claimed = 0;
+        SimpleMutex::scoped_lock lk( _dirtyMutex );
+        while ( claimed < maxBytes && _numDirtyChunks > 0 ) {
+            // a chunk written again once claimed is simply marked dirty again
+            const size_t nChunks = _dirtyChunks.size();
+            size_t i = _trickleCursor % nChunks;
+            while ( !_dirtyChunks[i] )
+                i = ( i + 1 ) % nChunks;
+
+            const unsigned long long budget = maxBytes - claimed;
+            const size_t maxChunks = std::max<size_t>( 1, budget / DirtyChunkSize );
+            const size_t first = i;
+            size_t n = 0;
+            while ( i < nChunks && _dirtyChunks[i] && n < maxChunks ) {
+                _dirtyChunks[i] = false;
+                i++;
+                n++;
+            }
+            _numDirtyChunks -= n;
+            _trickleCursor = i % nChunks;
+
+            const unsigned long long ofs = static_cast<unsigned long long>( first ) * DirtyChunkSize;
+            const unsigned long long bytes =
+                std::min<unsigned long long>( n * DirtyChunkSize, len - ofs );
+            ranges->push_back( std::make_pair( ofs, bytes ) );
+            claimed += bytes;
+        }
+        return claimed;
+    }
+
     void MongoFile::created() {
         LockMongoFilesExclusive lk;
         mmfiles.insert(this);
@@ -36,6 +36,7 @@
 #include <boost/thread/xtime.hpp>
 
 #include "mongo/client/export_macros.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/concurrency/rwlock.h"
 #include "mongo/util/goodies.h"
 
@@ -119,6 +120,12 @@ namespace mongo {
         static void (*notifyPostFlush)();
 
         static int flushAll( bool sync ); // returns n flushed
+
+        /** starts writeback of up to maxBytes of the ranges written since the last flush, across
+            all files, without waiting for it to complete.
+            @return bytes submitted
+        */
+        static unsigned long long trickleFlushAll( unsigned long long maxBytes );
         static long long totalMappedLength();
         static void closeAllFiles( std::stringstream &message );
 
@@ -141,6 +148,14 @@ namespace mongo {
          */
         virtual Flushable * prepareFlush() = 0;
 
+        /** see trickleFlushAll().  claims up to maxBytes of the ranges written since the last
+            flush, adding their length to *bytes.  returns an object which starts their writeback,
+            to be called without the files lock held, or NULL if there is nothing to write back.
+            like prepareFlush()'s, it has to fail nicely if the file gets closed.
+        */
+        virtual Flushable* prepareTrickleFlush( unsigned long long maxBytes,
+                                                unsigned long long* bytes ) { return NULL; }
+
         void created(); /* subclass must call after create */
 
         /* subclass must call in destructor (or at close).
@@ -209,6 +224,15 @@ namespace mongo {
         void flush(bool sync);
         virtual Flushable * prepareFlush();
 
+        /** granularity at which writes are remembered for prepareTrickleFlush() */
+        static const unsigned DirtyChunkSize = 1024 * 1024;
+
+        /** note that [ofs, ofs+len) was written through the write view, so that
+            prepareTrickleFlush() can start writing it back ahead of the next full flush.
+            threadsafe.
+        */
+        void noteDirty( unsigned long long ofs, unsigned len );
+
         long shortLength() const          { return (long) len; }
         unsigned long long length() const { return len; }
         HANDLE getFd() const              { return fd; }
@@ -218,6 +242,16 @@ namespace mongo {
         void* createReadOnlyMap();
         void* createPrivateMap();
 
+        /** ask for [p, p+len) to be backed by transparent huge pages where the kernel can.
+            @return false if unsupported on this platform or refused
+        */
+        static bool adviseHugePages(void *p, unsigned long long len);
+
+        /** start reading [p, p+len) in ahead of its use, without waiting for it.
+            @return false if unsupported on this platform or refused
+        */
+        static bool adviseWillNeed(const void *p, unsigned long long len);
+
         /** make the private map range writable (necessary for our windows implementation) */
         static void makeWritable(void *, unsigned len)
 #if defined(_WIN32)
@@ -228,14 +262,36 @@ namespace mongo {
 
         virtual uint64_t getUniqueId() const { return _uniqueId; }
 
+    protected:
+        virtual Flushable* prepareTrickleFlush( unsigned long long maxBytes,
+                                                unsigned long long* bytes );
+
     private:
         static void updateLength( const char *filename, unsigned long long &length );
 
+        /** [ofs, ofs+length) ranges of the file */
+        typedef std::vector<std::pair<unsigned long long, unsigned long long> > RangeVector;
+
+        /** marks up to maxBytes of dirty chunks clean, appending them to ranges as runs.
+            @return bytes claimed
+        */
+        unsigned long long claimDirtyRanges( unsigned long long maxBytes, RangeVector* ranges );
+
+        /** forget all noted writes; called when the whole file is about to be flushed */
+        void clearDirty();
+
         HANDLE fd;
         HANDLE maphandle;
         std::vector<void *> views;
         unsigned long long len;
         const uint64_t _uniqueId;
+
+        // one bit per DirtyChunkSize of the file, set by noteDirty() and cleared as the chunk
+        // is flushed
+        SimpleMutex _dirtyMutex;
+        std::vector<bool> _dirtyChunks;
+        size_t _numDirtyChunks;
+        size_t _trickleCursor; // where the next claimDirtyRanges() resumes scanning
 #ifdef _WIN32
         // NOTE: Locking Order:
         // LockMongoFilesShared must be taken before _flushMutex if both are taken
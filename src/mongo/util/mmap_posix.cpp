@@ -60,7 +60,11 @@ namespace mongo {
         
     
 
-    MemoryMappedFile::MemoryMappedFile() : _uniqueId(mmfNextId.fetchAndAdd(1)) {
+    MemoryMappedFile::MemoryMappedFile()
+        : _uniqueId(mmfNextId.fetchAndAdd(1)),
+          _dirtyMutex("MemoryMappedFile::dirty"),
+          _numDirtyChunks(0),
+          _trickleCursor(0) {
         fd = 0;
         maphandle = 0;
         len = 0;
@@ -73,6 +77,7 @@ namespace mongo {
             munmap(*i,len);
         }
         views.clear();
+        clearDirty();
 
         if ( fd )
             ::close(fd);
@@ -149,6 +154,24 @@ namespace mongo {
     }
 #endif
 
+    bool MemoryMappedFile::adviseHugePages(void *p, unsigned long long len) {
+#if defined(MADV_HUGEPAGE)
+        return madvise(p, len, MADV_HUGEPAGE) == 0;
+#else
+        return false;
+#endif
+    }
+
+    bool MemoryMappedFile::adviseWillNeed(const void *p, unsigned long long len) {
+#if defined(__sunos__)
+        return false;
+#else
+        void* start = _pageAlign(const_cast<void*>(p));
+        len += reinterpret_cast<size_t>(p) - reinterpret_cast<size_t>(start);
+        return madvise(start, len, MADV_WILLNEED) == 0;
+#endif
+    }
+
     void* MemoryMappedFile::map(const char *filename, unsigned long long &length, int options) {
         // length may be updated by callee.
         setFilename(filename);
@@ -253,6 +276,9 @@ namespace mongo {
         if ( views.empty() || fd == 0 )
             return;
 
+        if ( sync )
+            clearDirty();
+
         bool useFsync = sync && !ProcessInfo::preferMsyncOverFSync();
 
         if ( useFsync ?
@@ -310,9 +336,60 @@ namespace mongo {
     };
 
     MemoryMappedFile::Flushable * MemoryMappedFile::prepareFlush() {
+        clearDirty();
         return new PosixFlushable( this, viewForFlushing(), fd, len);
     }
 
+    class PosixTrickleFlushable : public MemoryMappedFile::Flushable {
+    public:
+        PosixTrickleFlushable( void* view,
+                               HANDLE fd,
+                               const std::string& filename,
+                               std::vector<std::pair<unsigned long long,
+                                                     unsigned long long> >& ranges )
+            : _view( view ), _fd( fd ), _filename( filename ) {
+            _ranges.swap( ranges );
+        }
+
+        void flush() {
+            for ( size_t i = 0; i < _ranges.size(); i++ ) {
+                const unsigned long long ofs = _ranges[i].first;
+                const unsigned long long length = _ranges[i].second;
+#if defined(__linux__)
+                // unlike msync this only queues the pages for writeback; it neither waits for
+                // the io nor walks the whole mapping
+                const bool ok = sync_file_range( _fd, ofs, length, SYNC_FILE_RANGE_WRITE ) == 0;
+#else
+                // ofs is a multiple of DirtyChunkSize, so page aligned
+                const bool ok = msync( static_cast<char*>( _view ) + ofs, length, MS_ASYNC ) == 0;
+#endif
+                if ( ok )
+                    continue;
+
+                // not fatal, the next full flush writes this range and reports any error.  the
+                // file may also have been closed since we were unlocked.
+                LOG(1) << "trickle flush of " << _filename << " failed at " << ofs << ": "
+                       << errnoWithDescription();
+                return;
+            }
+        }
+
+    private:
+        void* _view;
+        HANDLE _fd;
+        std::string _filename;
+        std::vector<std::pair<unsigned long long, unsigned long long> > _ranges;
+    };
+
+    MemoryMappedFile::Flushable* MemoryMappedFile::prepareTrickleFlush(
+            unsigned long long maxBytes, unsigned long long* bytes ) {
+        RangeVector ranges;
+        *bytes += claimDirtyRanges( maxBytes, &ranges );
+        if ( ranges.empty() || views.empty() || fd == 0 )
+            return NULL;
+        return new PosixTrickleFlushable( viewForFlushing(), fd, filename(), ranges );
+    }
+
 
 } // namespace mongo
 
@@ -137,7 +137,10 @@ namespace mongo {
     }
 
     MemoryMappedFile::MemoryMappedFile()
-        : _uniqueId(mmfNextId.fetchAndAdd(1)) {
+        : _uniqueId(mmfNextId.fetchAndAdd(1)),
+          _dirtyMutex("MemoryMappedFile::dirty"),
+          _numDirtyChunks(0),
+          _trickleCursor(0) {
         fd = 0;
         maphandle = 0;
         len = 0;
@@ -155,6 +158,7 @@ namespace mongo {
             UnmapViewOfFile(*i);
         }
         views.clear();
+        clearDirty();
         if ( maphandle )
             CloseHandle(maphandle);
         maphandle = 0;
@@ -569,14 +573,88 @@ namespace mongo {
     void MemoryMappedFile::flush(bool sync) {
         uassert(13056, "Async flushing not supported on windows", sync);
         if( !views.empty() ) {
+            clearDirty();
             WindowsFlushable f(this, viewForFlushing(), fd, _uniqueId, filename(), _flushMutex);
             f.flush();
         }
     }
 
     MemoryMappedFile::Flushable * MemoryMappedFile::prepareFlush() {
+        clearDirty();
         return new WindowsFlushable(this, viewForFlushing(), fd, _uniqueId,
                                     filename(), _flushMutex);
     }
 
+    bool MemoryMappedFile::adviseHugePages(void *p, unsigned long long len) {
+        // large pages on windows need SeLockMemoryPrivilege and can't back file mappings
+        return false;
+    }
+
+    bool MemoryMappedFile::adviseWillNeed(const void *p, unsigned long long len) {
+        // PrefetchVirtualMemory would do, but it only exists from windows 8 / server 2012
+        return false;
+    }
+
+    class WindowsTrickleFlushable : public MemoryMappedFile::Flushable {
+    public:
+        WindowsTrickleFlushable( MemoryMappedFile* theFile,
+                                 void* view,
+                                 const uint64_t id,
+                                 const std::string& filename,
+                                 boost::mutex& flushMutex,
+                                 std::vector<std::pair<unsigned long long,
+                                                       unsigned long long> >& ranges )
+            : _theFile(theFile), _view(view), _id(id), _filename(filename),
+              _flushMutex(flushMutex) {
+            _ranges.swap(ranges);
+        }
+
+        void flush() {
+            {
+                LockMongoFilesShared mmfilesLock;
+
+                std::set<MongoFile*> mmfs = MongoFile::getAllFiles();
+                std::set<MongoFile*>::const_iterator it = mmfs.find(_theFile);
+                if ( it == mmfs.end() || (*it)->getUniqueId() != _id ) {
+                    // this was deleted while we were unlocked
+                    return;
+                }
+
+                // Hold the flush mutex to ensure the file is not closed during flush
+                _flushMutex.lock();
+            }
+
+            boost::lock_guard<boost::mutex> lk(_flushMutex, boost::adopt_lock_t());
+
+            for ( size_t i = 0; i < _ranges.size(); i++ ) {
+                // without FlushFileBuffers this only starts writing the dirty pages back
+                if ( !FlushViewOfFile(static_cast<char*>(_view) + _ranges[i].first,
+                                      static_cast<SIZE_T>(_ranges[i].second)) ) {
+                    // not fatal, the next full flush writes this range and reports any error
+                    LOG(1) << "trickle flush of " << _filename << " failed at "
+                           << _ranges[i].first << ": " << errnoWithDescription();
+                    return;
+                }
+            }
+        }
+
+    private:
+        MemoryMappedFile* _theFile; // this may be deleted while we are running
+        void* _view;
+        const uint64_t _id;
+        std::string _filename;
+        boost::mutex& _flushMutex;
+        std::vector<std::pair<unsigned long long, unsigned long long> > _ranges;
+    };
+
+    MemoryMappedFile::Flushable* MemoryMappedFile::prepareTrickleFlush(
+            unsigned long long maxBytes, unsigned long long* bytes ) {
+        RangeVector ranges;
+        *bytes += claimDirtyRanges( maxBytes, &ranges );
+        if ( ranges.empty() || views.empty() )
+            return NULL;
+        return new WindowsTrickleFlushable(this, viewForFlushing(), _uniqueId, filename(),
+                                           _flushMutex, ranges);
+    }
+
 }
@@ -97,6 +97,28 @@ namespace mongo {
          */
         bool hasNumaEnabled() const { return sysInfo().hasNuma; }
 
+        /**
+         * Interleave memory allocated by the calling thread, and by threads it starts afterwards,
+         * across all NUMA nodes.  Like running under numactl --interleave=all, this also covers
+         * page cache pages faulted in through shared file mappings.
+         * @return false if unsupported or the call failed
+         */
+        static bool interleaveAcrossNumaNodes();
+
+        /**
+         * Restrict the calling thread to the CPUs of NUMA node 'node'.
+         * @return false if unsupported or the call failed
+         */
+        static bool bindThreadToNumaNode(int node);
+
+        /**
+         * Prefer node 'node' for the anonymous pages later allocated in [start, start+len), such
+         * as the copy on write pages of a private mapping.  Pages of MAP_SHARED file mappings
+         * are not affected.
+         * @return false if unsupported or the call failed
+         */
+        static bool preferNumaNode(void* start, size_t len, int node);
+
         /**
          * Determine if file zeroing is necessary for newly allocated data files.
          */
@@ -159,6 +159,18 @@ namespace mongo {
         return true;
     }
 
+    bool ProcessInfo::interleaveAcrossNumaNodes() {
+        return false;
+    }
+
+    bool ProcessInfo::bindThreadToNumaNode(int node) {
+        return false;
+    }
+
+    bool ProcessInfo::preferNumaNode(void* start, size_t len, int node) {
+        return false;
+    }
+
     bool ProcessInfo::blockCheckSupported() {
         return true;
     }
@@ -31,7 +31,9 @@
 #include <iostream>
 #include <stdio.h>
 #include <unistd.h>
+#include <sched.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <gnu/libc-version.h>
 #include <sys/utsname.h>
 
@@ -372,6 +374,38 @@ namespace mongo {
             return 0;
         }
 
+        /**
+        * Parse a sysfs list such as "0-3,8,10-11" (as found in
+        * /sys/devices/system/node/online and nodeN/cpulist) into the numbers it names
+        */
+        static bool parseSysfsList( const string& list, vector<int>* out ) {
+            out->clear();
+            size_t pos = 0;
+            while ( pos < list.size() ) {
+                size_t end = list.find( ',', pos );
+                if ( end == string::npos )
+                    end = list.size();
+                const string item = list.substr( pos, end - pos );
+                pos = end + 1;
+                if ( item.empty() )
+                    continue;
+
+                int first = 0;
+                int last = 0;
+                const size_t dash = item.find( '-' );
+                if ( !parseNumberFromString( item.substr( 0, dash ), &first ).isOK() )
+                    return false;
+                if ( dash == string::npos )
+                    last = first;
+                else if ( !parseNumberFromString( item.substr( dash + 1 ), &last ).isOK() )
+                    return false;
+
+                for ( int i = first; i <= last; i++ )
+                    out->push_back( i );
+            }
+            return !out->empty();
+        }
+
     };
 
 
@@ -403,6 +437,9 @@ namespace mongo {
 
         LinuxProc p(_pid);
         info.appendNumber("page_faults", static_cast<long long>(p._maj_flt) );
+        // faults that were satisfied without io; with huge pages each one maps far more memory,
+        // so this is the number to watch when comparing page sizes
+        info.appendNumber("minor_page_faults", static_cast<long long>(p._min_flt) );
     }
 
     /**
@@ -480,6 +517,68 @@ namespace mongo {
         return false;
     }
 
+    namespace {
+        // from linux/mempolicy.h; called through syscall() so that we don't depend on libnuma
+        const int kMPolPreferred = 1;
+        const int kMPolInterleave = 3;
+        const unsigned long kMaxNumaNodes = 1024;
+
+        typedef vector<unsigned long> NodeMask;
+
+        void addToNodeMask( NodeMask* mask, int node ) {
+            const size_t bitsPerWord = sizeof(unsigned long) * 8;
+            mask->resize( std::max( mask->size(), node / bitsPerWord + 1 ) );
+            (*mask)[node / bitsPerWord] |= 1UL << ( node % bitsPerWord );
+        }
+    }
+
+    bool ProcessInfo::interleaveAcrossNumaNodes() {
+        vector<int> nodes;
+        if ( !LinuxSysHelper::parseSysfsList(
+                 LinuxSysHelper::readLineFromFile( "/sys/devices/system/node/online" ), &nodes ) ) {
+            return false;
+        }
+
+        NodeMask mask;
+        for ( size_t i = 0; i < nodes.size(); i++ ) {
+            if ( nodes[i] < 0 || static_cast<unsigned long>( nodes[i] ) >= kMaxNumaNodes )
+                return false;
+            addToNodeMask( &mask, nodes[i] );
+        }
+        return syscall( SYS_set_mempolicy, kMPolInterleave, &mask.front(),
+                        mask.size() * sizeof(unsigned long) * 8 + 1 ) == 0;
+    }
+
+    bool ProcessInfo::bindThreadToNumaNode(int node) {
+        if ( node < 0 || static_cast<unsigned long>( node ) >= kMaxNumaNodes )
+            return false;
+
+        char fname[64];
+        sprintf( fname, "/sys/devices/system/node/node%d/cpulist", node );
+        vector<int> cpus;
+        if ( !LinuxSysHelper::parseSysfsList( LinuxSysHelper::readLineFromFile( fname ), &cpus ) )
+            return false;
+
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        for ( size_t i = 0; i < cpus.size(); i++ ) {
+            if ( cpus[i] < 0 || cpus[i] >= CPU_SETSIZE )
+                return false;
+            CPU_SET( cpus[i], &set );
+        }
+        return sched_setaffinity( 0, sizeof(set), &set ) == 0;
+    }
+
+    bool ProcessInfo::preferNumaNode(void* start, size_t len, int node) {
+        if ( node < 0 || static_cast<unsigned long>( node ) >= kMaxNumaNodes )
+            return false;
+
+        NodeMask mask;
+        addToNodeMask( &mask, node );
+        return syscall( SYS_mbind, start, len, kMPolPreferred, &mask.front(),
+                        mask.size() * sizeof(unsigned long) * 8 + 1, 0 ) == 0;
+    }
+
     bool ProcessInfo::blockCheckSupported() {
         return true;
     }
@@ -59,6 +59,18 @@ namespace mongo {
         return false;
     }
 
+    bool ProcessInfo::interleaveAcrossNumaNodes() {
+        return false;
+    }
+
+    bool ProcessInfo::bindThreadToNumaNode(int node) {
+        return false;
+    }
+
+    bool ProcessInfo::preferNumaNode(void* start, size_t len, int node) {
+        return false;
+    }
+
     bool ProcessInfo::blockCheckSupported() {
         return false;
     }